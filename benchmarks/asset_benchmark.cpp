@@ -0,0 +1,66 @@
+#include "profiling/culling_benchmark.hpp"
+#include "profiling/job_scaling_benchmark.hpp"
+#include "profiling/light_benchmark.hpp"
+#include "profiling/load_benchmark.hpp"
+#include "profiling/occlusion_benchmark.hpp"
+#include "profiling/transform_benchmark.hpp"
+#include "profiling/traversal_benchmark.hpp"
+#include "scene/scene_generator.hpp"
+
+#include <iostream>
+#include <string>
+
+// The loader benchmark without the renderer, for machines without a GPU:
+//   asset_benchmark <path to .gltf/.glb> [--iterations N --out results.json --baseline previous.json ...]
+//   asset_benchmark --generate-scene <path to .gltf/.glb> [--meshes N --instances N ...]
+//   asset_benchmark --traversal-benchmark [--iterations N --roots N --fanout N --depth N --meshlets N]
+//   asset_benchmark --transform-benchmark [--iterations N --threads N --roots N --fanout N --depth N]
+//   asset_benchmark --culling-benchmark [--iterations N --clusters N --threads N]
+//   asset_benchmark --occlusion-benchmark [--iterations N --clusters N --occluders N --threads N]
+//   asset_benchmark --light-benchmark [--iterations N --threads N]
+//   asset_benchmark --job-scaling-benchmark [--iterations N --threads N --clusters N --lights N]
+int main(int argc, char* argv[])
+{
+	if (argc >= 3 && std::string{ argv[1] } == "--generate-scene")
+	{
+		return SceneGenerator::write(std::cout, argv[2], SceneGenerator::parseArguments(std::cout, argc, argv, 3)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--traversal-benchmark")
+	{
+		return TraversalBenchmark::run(std::cout, TraversalBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--transform-benchmark")
+	{
+		return TransformBenchmark::run(std::cout, TransformBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--culling-benchmark")
+	{
+		return CullingBenchmark::run(std::cout, CullingBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--occlusion-benchmark")
+	{
+		return OcclusionBenchmark::run(std::cout, OcclusionBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--light-benchmark")
+	{
+		return LightBenchmark::run(std::cout, LightBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string{ argv[1] } == "--job-scaling-benchmark")
+	{
+		return JobScalingBenchmark::run(std::cout, JobScalingBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+	}
+
+	if (argc < 2)
+	{
+		std::cerr << "Usage: asset_benchmark <path to .gltf/.glb> [options], --generate-scene <path> [options], --traversal-benchmark, --transform-benchmark, --culling-benchmark, --occlusion-benchmark, --light-benchmark or --job-scaling-benchmark [options]\n";
+		return 1;
+	}
+
+	return LoadBenchmark::run(std::cout, argv[1], LoadBenchmark::parseArguments(std::cout, argc, argv, 2)) ? 0 : 1;
+}
\ No newline at end of file
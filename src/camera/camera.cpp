@@ -15,7 +15,12 @@ void Camera::move(const glm::vec3& displacement)
 
 Camera::Frustum Camera::getViewFrustum(const glm::mat4& proj)
 {
-	glm::mat4 mat{ proj * getViewMatrix() };
+	return getFrustum(proj * getViewMatrix());
+}
+
+Camera::Frustum Camera::getFrustum(const glm::mat4& viewProj)
+{
+	const glm::mat4& mat{ viewProj };
 
 	Frustum frustum{};
 
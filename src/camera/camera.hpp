@@ -30,6 +30,9 @@ public:
 
 	Frustum getViewFrustum(const glm::mat4& proj);
 
+	// Extracts normalized planes from any view-projection matrix, e.g. a shadow cascade's
+	static Frustum getFrustum(const glm::mat4& viewProj);
+
 	glm::mat4 getViewMatrix();
 
 	glm::vec3 mPos{};
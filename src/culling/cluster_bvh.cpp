@@ -0,0 +1,264 @@
+#include "cluster_bvh.hpp"
+
+#include "../camera/camera.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <algorithm> // for nth_element & max
+#include <cassert>
+#include <cstddef> // for size_t
+#include <numeric> // for iota
+#include <vector>
+
+
+
+namespace
+{
+	struct BuildNode
+	{
+		glm::vec4 boundingSphere{};
+
+		int left{ -1 };
+		int right{ -1 };
+
+		// The whole subtree's clusters, for inner nodes too
+		GLuint firstCluster{};
+		GLuint clusterCount{};
+	};
+
+	glm::vec4 mergeSpheres(const glm::vec4& a, const glm::vec4& b)
+	{
+		glm::vec3 offset{ glm::vec3{ b } - glm::vec3{ a } };
+		float distance{ glm::length(offset) };
+
+		if (distance + b.w <= a.w)
+		{
+			return a;
+		}
+		if (distance + a.w <= b.w)
+		{
+			return b;
+		}
+
+		float radius{ (distance + a.w + b.w) * 0.5f };
+		glm::vec3 center{ glm::vec3{ a } + offset * ((radius - a.w) / distance) };
+
+		return { center, radius };
+	}
+
+	// The far plane is ignored, same as in the shaders, since the projection is infinite
+	bool sphereIsOnFrustum(const Camera::Frustum& frustum, const glm::vec4& sphere)
+	{
+		auto isOnOrForwardPlane{ [&sphere](const glm::vec4& plane) {
+				return glm::dot(glm::vec3{ plane }, glm::vec3{ sphere }) + plane.w > -sphere.w;
+			} };
+
+		return isOnOrForwardPlane(frustum.left) &&
+			isOnOrForwardPlane(frustum.right) &&
+			isOnOrForwardPlane(frustum.near) &&
+			isOnOrForwardPlane(frustum.top) &&
+			isOnOrForwardPlane(frustum.bottom);
+	}
+
+	// Conservative: a sphere that only touches a plane isn't inside
+	bool sphereIsInsideFrustum(const Camera::Frustum& frustum, const glm::vec4& sphere)
+	{
+		auto isForwardPlane{ [&sphere](const glm::vec4& plane) {
+				return glm::dot(glm::vec3{ plane }, glm::vec3{ sphere }) + plane.w > sphere.w;
+			} };
+
+		return isForwardPlane(frustum.left) &&
+			isForwardPlane(frustum.right) &&
+			isForwardPlane(frustum.near) &&
+			isForwardPlane(frustum.top) &&
+			isForwardPlane(frustum.bottom);
+	}
+
+	int buildRecursive(std::vector<BuildNode>& nodes, std::vector<GLuint>& clusterIndices,
+		const std::vector<glm::vec4>& clusterSpheres, GLuint first, GLuint count)
+	{
+		int nodeIndex{ static_cast<int>(nodes.size()) };
+		nodes.push_back({});
+
+		if (count <= ClusterBvh::maxLeafClusters)
+		{
+			glm::vec3 min{ clusterSpheres[clusterIndices[first]] };
+			glm::vec3 max{ min };
+			for (GLuint i{ first }; i < first + count; ++i)
+			{
+				min = glm::min(min, glm::vec3{ clusterSpheres[clusterIndices[i]] });
+				max = glm::max(max, glm::vec3{ clusterSpheres[clusterIndices[i]] });
+			}
+
+			glm::vec3 center{ (min + max) * 0.5f };
+			float radius{ 0.0f };
+			for (GLuint i{ first }; i < first + count; ++i)
+			{
+				const glm::vec4& sphere{ clusterSpheres[clusterIndices[i]] };
+				radius = std::max(radius, glm::length(glm::vec3{ sphere } - center) + sphere.w);
+			}
+
+			nodes[nodeIndex].boundingSphere = { center, radius };
+			nodes[nodeIndex].firstCluster = first;
+			nodes[nodeIndex].clusterCount = count;
+
+			return nodeIndex;
+		}
+
+		glm::vec3 min{ clusterSpheres[clusterIndices[first]] };
+		glm::vec3 max{ min };
+		for (GLuint i{ first }; i < first + count; ++i)
+		{
+			min = glm::min(min, glm::vec3{ clusterSpheres[clusterIndices[i]] });
+			max = glm::max(max, glm::vec3{ clusterSpheres[clusterIndices[i]] });
+		}
+
+		nodes[nodeIndex].firstCluster = first;
+		nodes[nodeIndex].clusterCount = count;
+
+		glm::vec3 extent{ max - min };
+		int axis{ extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2) };
+
+		// Median split keeps the tree balanced, which bounds the number of level dispatches on the GPU
+		GLuint half{ count / 2 };
+		std::nth_element(clusterIndices.begin() + first, clusterIndices.begin() + first + half,
+			clusterIndices.begin() + first + count, [&](GLuint a, GLuint b) {
+				return clusterSpheres[a][axis] < clusterSpheres[b][axis];
+			});
+
+		int left{ buildRecursive(nodes, clusterIndices, clusterSpheres, first, half) };
+		int right{ buildRecursive(nodes, clusterIndices, clusterSpheres, first + half, count - half) };
+
+		nodes[nodeIndex].left = left;
+		nodes[nodeIndex].right = right;
+		nodes[nodeIndex].boundingSphere = mergeSpheres(nodes[left].boundingSphere, nodes[right].boundingSphere);
+
+		return nodeIndex;
+	}
+}
+
+
+
+void ClusterBvh::build(const std::vector<glm::vec4>& clusterSpheres)
+{
+	mNodes.clear();
+	mSubtreeClusters.clear();
+	mLevelNodeCounts.clear();
+	mLevelOffsets.clear();
+
+	mClusterSpheres = clusterSpheres;
+
+	mClusterIndices.resize(clusterSpheres.size());
+	std::iota(mClusterIndices.begin(), mClusterIndices.end(), 0);
+
+	if (clusterSpheres.empty())
+	{
+		return;
+	}
+
+	std::vector<BuildNode> buildNodes{};
+	buildNodes.reserve((clusterSpheres.size() / maxLeafClusters + 1) * 2);
+	buildRecursive(buildNodes, mClusterIndices, clusterSpheres, 0, static_cast<GLuint>(clusterSpheres.size()));
+
+	// Linearize breadth-first so that each level is contiguous and siblings are adjacent
+	mNodes.resize(buildNodes.size());
+	mSubtreeClusters.resize(buildNodes.size());
+
+	std::vector<int> currentLevel{ 0 };
+	std::vector<int> nextLevel{};
+	GLuint nextNode{ 1 };
+
+	while (!currentLevel.empty())
+	{
+		mLevelOffsets.push_back(nextNode - static_cast<GLuint>(currentLevel.size()));
+		mLevelNodeCounts.push_back(static_cast<GLuint>(currentLevel.size()));
+
+		for (std::size_t i{ 0 }; i < currentLevel.size(); ++i)
+		{
+			const BuildNode& buildNode{ buildNodes[currentLevel[i]] };
+			Node& node{ mNodes[mLevelOffsets.back() + i] };
+
+			node.boundingSphere = buildNode.boundingSphere;
+			mSubtreeClusters[mLevelOffsets.back() + i] = { buildNode.firstCluster, buildNode.clusterCount };
+
+			if (buildNode.left != -1)
+			{
+				node.firstChild = nextNode;
+				node.childCount = 2;
+				nextNode += 2;
+
+				nextLevel.push_back(buildNode.left);
+				nextLevel.push_back(buildNode.right);
+			}
+			else
+			{
+				node.firstCluster = buildNode.firstCluster;
+				node.clusterCount = buildNode.clusterCount;
+			}
+		}
+
+		currentLevel.swap(nextLevel);
+		nextLevel.clear();
+	}
+
+	// bvh_cull.comp has a queue header for exactly maxLevels levels
+	assert(mLevelNodeCounts.size() <= maxLevels);
+}
+
+void ClusterBvh::cull(const Camera::Frustum& frustum, std::vector<GLuint>& visibleClusters) const
+{
+	if (mNodes.empty())
+	{
+		return;
+	}
+
+	std::vector<GLuint> stack{ 0 };
+	stack.reserve(mLevelNodeCounts.size() * 2);
+
+	while (!stack.empty())
+	{
+		const GLuint nodeIndex{ stack.back() };
+		const Node& node{ mNodes[nodeIndex] };
+		stack.pop_back();
+
+		if (!sphereIsOnFrustum(frustum, node.boundingSphere))
+		{
+			continue;
+		}
+
+		// Every cluster sphere lies within the node's, so none of them can fail a plane either
+		if (sphereIsInsideFrustum(frustum, node.boundingSphere))
+		{
+			const glm::uvec2& subtree{ mSubtreeClusters[nodeIndex] };
+			visibleClusters.insert(visibleClusters.end(), mClusterIndices.begin() + subtree.x,
+				mClusterIndices.begin() + subtree.x + subtree.y);
+			continue;
+		}
+
+		for (GLuint i{ node.firstChild }; i < node.firstChild + node.childCount; ++i)
+		{
+			stack.push_back(i);
+		}
+
+		for (GLuint i{ node.firstCluster }; i < node.firstCluster + node.clusterCount; ++i)
+		{
+			if (sphereIsOnFrustum(frustum, mClusterSpheres[mClusterIndices[i]]))
+			{
+				visibleClusters.push_back(mClusterIndices[i]);
+			}
+		}
+	}
+}
+
+void ClusterBvh::cullFlat(const Camera::Frustum& frustum, const std::vector<glm::vec4>& clusterSpheres,
+	std::vector<GLuint>& visibleClusters)
+{
+	for (std::size_t i{ 0 }; i < clusterSpheres.size(); ++i)
+	{
+		if (sphereIsOnFrustum(frustum, clusterSpheres[i]))
+		{
+			visibleClusters.push_back(static_cast<GLuint>(i));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../camera/camera.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// Binary BVH over world space cluster bounding spheres. Built once on the CPU at load time and
+// traversed level by level on the GPU (bvh_cull.comp), so subtrees outside the view are rejected
+// without ever touching their clusters.
+class ClusterBvh final
+{
+public:
+
+	// Set on bvh_cull.comp's queue entries & candidate clusters whose parent node is fully inside the frustum, so their
+	// frustum test is skipped. Node & cluster IDs stay below it
+	static constexpr GLuint insideFrustumBit{ 0x80000000u };
+
+	// Mirrors the std430 layout in bvh_cull.comp
+	struct Node
+	{
+		glm::vec4 boundingSphere{};
+
+		GLuint firstChild{};
+		GLuint childCount{};
+
+		// Range into mClusterIndices. Only leaves have clusters
+		GLuint firstCluster{};
+		GLuint clusterCount{};
+	};
+
+	static constexpr int maxLeafClusters{ 16 };
+
+	// Median splits halve the clusters every level, so 2^32 clusters need at most 1 + log2(2^32 / maxLeafClusters)
+	// levels and build() never goes deeper than this
+	static constexpr int maxLevels{ 32 };
+
+	ClusterBvh() = default;
+
+	void build(const std::vector<glm::vec4>& clusterSpheres);
+
+	// CPU reference traversal. Appends the scene cluster IDs of every cluster that passes the frustum test. Nodes fully
+	// inside the frustum emit their whole subtree without testing it further
+	void cull(const Camera::Frustum& frustum, std::vector<GLuint>& visibleClusters) const;
+
+	// Flat baseline that tests every cluster, as cluster_batch.comp does without the BVH
+	static void cullFlat(const Camera::Frustum& frustum, const std::vector<glm::vec4>& clusterSpheres,
+		std::vector<GLuint>& visibleClusters);
+
+	// Breadth-first: the root is node 0 and each node's children are contiguous
+	std::vector<Node> mNodes{};
+
+	// Scene cluster IDs, permuted so that every leaf references a contiguous range
+	std::vector<GLuint> mClusterIndices{};
+
+	std::vector<GLuint> mLevelNodeCounts{};
+	std::vector<GLuint> mLevelOffsets{};
+
+	// Kept for the CPU reference path
+	std::vector<glm::vec4> mClusterSpheres{};
+
+	// Every node's subtree clusters, which are contiguous in mClusterIndices: x is the first, y the count. Lets the CPU
+	// path emit a node that's fully inside the frustum in one go
+	std::vector<glm::uvec2> mSubtreeClusters{};
+};
@@ -0,0 +1,295 @@
+#include "frustum_culler.hpp"
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+#include "../model/transform_kernel.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define HAS_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h> // for __cpuid & __cpuidex
+#endif
+
+// Lets the AVX2 path be compiled into builds that don't enable AVX2 everywhere. MSVC allows the intrinsics anyway
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <vector>
+
+
+
+namespace
+{
+	constexpr float paddingRadius{ -1e30f };
+
+	std::size_t roundUpTo32(std::size_t n)
+	{
+		return (n + 31) & ~std::size_t{ 31 };
+	}
+
+	bool cpuSupportsAvx2()
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4]{};
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		// The OS must also save the upper halves of the registers
+		__cpuid(info, 1);
+		const bool osSavesYmm{ (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6 };
+
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+}
+
+
+
+void FrustumCuller::setClusters(const std::vector<glm::vec4>& boundingSpheres, const std::vector<GLuint>& transformIndices)
+{
+	mClusterCount = boundingSpheres.size();
+	std::size_t paddedCount{ roundUpTo32(mClusterCount) };
+
+	mCenterX.assign(paddedCount, 0.0f);
+	mCenterY.assign(paddedCount, 0.0f);
+	mCenterZ.assign(paddedCount, 0.0f);
+	mRadius.assign(paddedCount, paddingRadius);
+	mTransformIndices.assign(paddedCount, 0);
+
+	for (std::size_t i{ 0 }; i < mClusterCount; ++i)
+	{
+		mCenterX[i] = boundingSpheres[i].x;
+		mCenterY[i] = boundingSpheres[i].y;
+		mCenterZ[i] = boundingSpheres[i].z;
+		mRadius[i] = boundingSpheres[i].w;
+		mTransformIndices[i] = transformIndices[i];
+	}
+
+	mWorldCenterX.assign(paddedCount, 0.0f);
+	mWorldCenterY.assign(paddedCount, 0.0f);
+	mWorldCenterZ.assign(paddedCount, 0.0f);
+	mWorldRadius.assign(paddedCount, paddingRadius);
+}
+
+void FrustumCuller::updateWorldSpheres(JobSystem& jobSystem, const std::vector<glm::mat4>& transforms)
+{
+	jobSystem.parallelFor(mClusterCount, chunkSize, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			const glm::mat4& transform{ transforms[mTransformIndices[i]] };
+
+			glm::vec4 center{ transform * glm::vec4{ mCenterX[i], mCenterY[i], mCenterZ[i], 1.0f } };
+
+			mWorldCenterX[i] = center.x;
+			mWorldCenterY[i] = center.y;
+			mWorldCenterZ[i] = center.z;
+			mWorldRadius[i] = mRadius[i] * TransformKernel::getMaxScale(transform);
+		}
+		});
+}
+
+void FrustumCuller::cull(JobSystem& jobSystem, const Camera::Frustum& frustum, std::vector<std::uint32_t>& visibilityBitmask,
+	Path path) const
+{
+	visibilityBitmask.resize(roundUpTo32(mClusterCount) / 32);
+
+	// Never run AVX2 on a CPU without it
+	if (path > getBestPath())
+	{
+		path = getBestPath();
+	}
+
+	jobSystem.parallelFor(roundUpTo32(mClusterCount), chunkSize, [&](std::size_t first, std::size_t last) {
+#if defined(HAS_SSE2)
+		if (path == Path::avx2)
+		{
+			cullChunkAvx2(frustum, first, last, visibilityBitmask.data());
+			return;
+		}
+		if (path == Path::sse)
+		{
+			cullChunkSse(frustum, first, last, visibilityBitmask.data());
+			return;
+		}
+#endif
+		cullChunkScalar(frustum, first, last, visibilityBitmask.data());
+		});
+}
+
+void FrustumCuller::cullScalar(const Camera::Frustum& frustum, std::vector<std::uint32_t>& visibilityBitmask) const
+{
+	visibilityBitmask.assign(roundUpTo32(mClusterCount) / 32, 0);
+
+	// The far plane is ignored, same as in the shaders, since the projection is infinite
+	const glm::vec4 planes[]{ frustum.left, frustum.right, frustum.near, frustum.top, frustum.bottom };
+
+	for (std::size_t i{ 0 }; i < mClusterCount; ++i)
+	{
+		bool isVisible{ true };
+		for (const auto& plane : planes)
+		{
+			float distance{ plane.x * mWorldCenterX[i] + plane.y * mWorldCenterY[i] + plane.z * mWorldCenterZ[i] + plane.w };
+			isVisible = isVisible && distance > -mWorldRadius[i];
+		}
+
+		if (isVisible)
+		{
+			visibilityBitmask[i / 32] |= std::uint32_t{ 1 } << (i % 32);
+		}
+	}
+}
+
+std::vector<glm::vec4> FrustumCuller::getWorldSpheres() const
+{
+	std::vector<glm::vec4> spheres(mClusterCount);
+	for (std::size_t i{ 0 }; i < mClusterCount; ++i)
+	{
+		spheres[i] = { mWorldCenterX[i], mWorldCenterY[i], mWorldCenterZ[i], mWorldRadius[i] };
+	}
+
+	return spheres;
+}
+
+FrustumCuller::Path FrustumCuller::getBestPath()
+{
+#if defined(HAS_SSE2)
+	static const Path bestPath{ cpuSupportsAvx2() ? Path::avx2 : Path::sse };
+	return bestPath;
+#else
+	return Path::scalar;
+#endif
+}
+
+
+
+void FrustumCuller::cullChunkScalar(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const
+{
+	const glm::vec4 planes[]{ frustum.left, frustum.right, frustum.near, frustum.top, frustum.bottom };
+
+	for (std::size_t i{ first }; i < last; i += 32)
+	{
+		std::uint32_t word{ 0 };
+
+		for (std::size_t n{ 0 }; n < 32; ++n)
+		{
+			bool isVisible{ true };
+			for (const auto& plane : planes)
+			{
+				float distance{ plane.x * mWorldCenterX[i + n] + plane.y * mWorldCenterY[i + n] + plane.z * mWorldCenterZ[i + n] + plane.w };
+				isVisible = isVisible && distance > -mWorldRadius[i + n];
+			}
+
+			word |= static_cast<std::uint32_t>(isVisible) << n;
+		}
+
+		visibilityBitmask[i / 32] = word;
+	}
+}
+
+#if defined(HAS_SSE2)
+// The SIMD paths add in the same order as the scalar ones, so they round the same and agree on every sphere
+void FrustumCuller::cullChunkSse(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const
+{
+	const glm::vec4 planes[]{ frustum.left, frustum.right, frustum.near, frustum.top, frustum.bottom };
+	constexpr int planeCount{ 5 };
+
+	__m128 planeX[planeCount]{};
+	__m128 planeY[planeCount]{};
+	__m128 planeZ[planeCount]{};
+	__m128 planeW[planeCount]{};
+	for (int p{ 0 }; p < planeCount; ++p)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	for (std::size_t i{ first }; i < last; i += 32)
+	{
+		std::uint32_t word{ 0 };
+
+		for (std::size_t n{ 0 }; n < 32; n += 4)
+		{
+			__m128 x{ _mm_loadu_ps(&mWorldCenterX[i + n]) };
+			__m128 y{ _mm_loadu_ps(&mWorldCenterY[i + n]) };
+			__m128 z{ _mm_loadu_ps(&mWorldCenterZ[i + n]) };
+			__m128 negativeRadius{ _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&mWorldRadius[i + n])) };
+
+			__m128 visible{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+			for (int p{ 0 }; p < planeCount; ++p)
+			{
+				__m128 distance{ _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+					_mm_mul_ps(planeZ[p], z)), planeW[p]) };
+				visible = _mm_and_ps(visible, _mm_cmpgt_ps(distance, negativeRadius));
+			}
+
+			word |= static_cast<std::uint32_t>(_mm_movemask_ps(visible)) << n;
+		}
+
+		visibilityBitmask[i / 32] = word;
+	}
+}
+
+AVX2_TARGET void FrustumCuller::cullChunkAvx2(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const
+{
+	const glm::vec4 planes[]{ frustum.left, frustum.right, frustum.near, frustum.top, frustum.bottom };
+	constexpr int planeCount{ 5 };
+
+	__m256 planeX[planeCount]{};
+	__m256 planeY[planeCount]{};
+	__m256 planeZ[planeCount]{};
+	__m256 planeW[planeCount]{};
+	for (int p{ 0 }; p < planeCount; ++p)
+	{
+		planeX[p] = _mm256_set1_ps(planes[p].x);
+		planeY[p] = _mm256_set1_ps(planes[p].y);
+		planeZ[p] = _mm256_set1_ps(planes[p].z);
+		planeW[p] = _mm256_set1_ps(planes[p].w);
+	}
+
+	for (std::size_t i{ first }; i < last; i += 32)
+	{
+		std::uint32_t word{ 0 };
+
+		for (std::size_t n{ 0 }; n < 32; n += 8)
+		{
+			__m256 x{ _mm256_loadu_ps(&mWorldCenterX[i + n]) };
+			__m256 y{ _mm256_loadu_ps(&mWorldCenterY[i + n]) };
+			__m256 z{ _mm256_loadu_ps(&mWorldCenterZ[i + n]) };
+			__m256 negativeRadius{ _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&mWorldRadius[i + n])) };
+
+			__m256 visible{ _mm256_castsi256_ps(_mm256_set1_epi32(-1)) };
+			for (int p{ 0 }; p < planeCount; ++p)
+			{
+				__m256 distance{ _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+					_mm256_mul_ps(planeZ[p], z)), planeW[p]) };
+				visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+			}
+
+			word |= static_cast<std::uint32_t>(_mm256_movemask_ps(visible)) << n;
+		}
+
+		visibilityBitmask[i / 32] = word;
+	}
+}
+#endif
\ No newline at end of file
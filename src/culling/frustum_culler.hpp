@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <vector>
+
+// CPU frustum culling of cluster bounding spheres, for tooling, shadow cascade setup and as a fallback
+// when the GPU path isn't available. Bounds are stored as structure-of-arrays and tested 8 (AVX2) or
+// 4 (SSE) at a time, in parallel over chunks on the job system. AVX2 is picked at run time when the CPU has it.
+class FrustumCuller final
+{
+public:
+
+	// Multiple of 32 so that each chunk owns whole words of the visibility bitmask
+	static constexpr std::size_t chunkSize{ 16384 };
+
+	// Ways cull() can test the spheres. All of them give the same bits
+	enum class Path { scalar, sse, avx2 };
+
+	FrustumCuller() = default;
+
+	void setClusters(const std::vector<glm::vec4>& boundingSpheres, const std::vector<GLuint>& transformIndices);
+
+	// Must be called after setClusters and whenever a transform changes
+	void updateWorldSpheres(JobSystem& jobSystem, const std::vector<glm::mat4>& transforms);
+
+	// Writes the same layout as mVisibilityBitmaskSsbo: bit n of word i is cluster (i * 32 + n). Paths the CPU
+	// doesn't have fall back to getBestPath()
+	void cull(JobSystem& jobSystem, const Camera::Frustum& frustum, std::vector<std::uint32_t>& visibilityBitmask,
+		Path path = getBestPath()) const;
+
+	// Scalar baseline for cull()
+	void cullScalar(const Camera::Frustum& frustum, std::vector<std::uint32_t>& visibilityBitmask) const;
+
+	std::vector<glm::vec4> getWorldSpheres() const;
+
+	// AVX2 if the CPU has it, else SSE where the build targets it
+	static Path getBestPath();
+
+	std::size_t mClusterCount{ 0 };
+
+	// Local space bounds. Padded to a multiple of 32
+	std::vector<float> mCenterX{};
+	std::vector<float> mCenterY{};
+	std::vector<float> mCenterZ{};
+	std::vector<float> mRadius{};
+	std::vector<GLuint> mTransformIndices{};
+
+	// World space bounds. Padding entries have a hugely negative radius so they never pass a plane test
+	std::vector<float> mWorldCenterX{};
+	std::vector<float> mWorldCenterY{};
+	std::vector<float> mWorldCenterZ{};
+	std::vector<float> mWorldRadius{};
+
+private:
+
+	void cullChunkScalar(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const;
+	void cullChunkSse(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const;
+	void cullChunkAvx2(const Camera::Frustum& frustum, std::size_t first, std::size_t last, std::uint32_t* visibilityBitmask) const;
+};
\ No newline at end of file
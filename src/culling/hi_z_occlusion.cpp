@@ -0,0 +1,269 @@
+#include "hi_z_occlusion.hpp"
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+#include "frustum_culler.hpp"
+
+#include "glm/glm.hpp"
+
+#include <algorithm> // for clamp, max & min
+#include <atomic>
+#include <bit> // for bit_width
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <utility> // for move()
+#include <vector>
+
+
+
+namespace
+{
+	// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere. Michael Mara, Morgan McGuire. 2013.
+	// c is the view space center with z flipped to point forward. Writes uv bounds: min x, min y, max x, max y
+	bool projectSphereView(const glm::vec3& c, float r, float zNear, float P00, float P11, glm::vec4& aabb)
+	{
+		if (c.z < r + zNear)
+		{
+			return false;
+		}
+
+		glm::vec3 cr{ c * r };
+		float czr2{ c.z * c.z - r * r };
+
+		float vx{ std::sqrt(c.x * c.x + czr2) };
+		float minX{ (vx * c.x - cr.z) / (vx * c.z + cr.x) };
+		float maxX{ (vx * c.x + cr.z) / (vx * c.z - cr.x) };
+
+		float vy{ std::sqrt(c.y * c.y + czr2) };
+		float minY{ (vy * c.y - cr.z) / (vy * c.z + cr.y) };
+		float maxY{ (vy * c.y + cr.z) / (vy * c.z - cr.y) };
+
+		aabb = glm::vec4{ minX * P00, minY * P11, maxX * P00, maxY * P11 } * 0.5f + 0.5f;
+
+		return true;
+	}
+
+	// Inclusive range of level 0 texels under the bounds. False if it's entirely off screen
+	bool getPixelBounds(const glm::vec4& aabb, glm::ivec2 size, glm::ivec2& min, glm::ivec2& max)
+	{
+		min = glm::max(glm::ivec2{ glm::floor(glm::vec2{ aabb.x, aabb.y } * glm::vec2{ size }) }, glm::ivec2{ 0 });
+		max = glm::min(glm::ivec2{ glm::ceil(glm::vec2{ aabb.z, aabb.w } * glm::vec2{ size }) } - 1, size - 1);
+
+		return min.x <= max.x && min.y <= max.y;
+	}
+}
+
+
+
+float HiZOcclusion::Results::getFalseVisibleRate() const
+{
+	return hiddenSpheres > 0 ? static_cast<float>(falseVisible) / hiddenSpheres : 0.0f;
+}
+
+void HiZOcclusion::setDepth(std::vector<float> depth, int width, int height)
+{
+	mLevels.clear();
+	mLevelSizes.clear();
+
+	mLevels.push_back(std::move(depth));
+	mLevelSizes.push_back({ width, height });
+
+	// Same level count as the hi-z texture: floor(log2(max(width, height))) + 1
+	const int levelCount{ static_cast<int>(std::bit_width(static_cast<unsigned int>(std::max(width, height)))) };
+	for (int level{ 1 }; level < levelCount; ++level)
+	{
+		glm::ivec2 lastSize{ mLevelSizes.back() };
+		glm::ivec2 size{ glm::max(lastSize / 2, glm::ivec2{ 1 }) };
+
+		// depth_downsample.comp widens every texel's footprint by a row or column when the last level is odd
+		glm::ivec2 footprint{ 2 + (lastSize.x & 1), 2 + (lastSize.y & 1) };
+
+		std::vector<float> depths(static_cast<std::size_t>(size.x) * size.y);
+		for (int y{ 0 }; y < size.y; ++y)
+		{
+			for (int x{ 0 }; x < size.x; ++x)
+			{
+				float minDepth{ 1.0f };
+				for (int j{ 0 }; j < footprint.y; ++j)
+				{
+					for (int i{ 0 }; i < footprint.x; ++i)
+					{
+						minDepth = std::min(minDepth, getTexel(level - 1, { 2 * x + i, 2 * y + j }));
+					}
+				}
+
+				depths[static_cast<std::size_t>(y) * size.x + x] = minDepth;
+			}
+		}
+
+		mLevels.push_back(std::move(depths));
+		mLevelSizes.push_back(size);
+	}
+}
+
+bool HiZOcclusion::isSphereOccluded(const glm::vec4& viewSphere, float P00, float P11, float zNear, Method method) const
+{
+	glm::vec3 c{ viewSphere.x, viewSphere.y, -viewSphere.z };
+	float r{ viewSphere.w };
+
+	glm::vec4 aabb{};
+	if (mLevels.empty() || !projectSphereView(c, r, zNear, P00, P11, aabb))
+	{
+		return false;
+	}
+
+	// Reverse-Z: the sphere's nearest point has the largest depth it can produce
+	const float sphereDepth{ zNear / (c.z - r) };
+	const int maxLevel{ static_cast<int>(mLevels.size()) - 1 };
+
+	float depth{};
+	if (method == Method::centered)
+	{
+		// The old shader swapped the y bounds, which made the height negative
+		float width{ (aabb.z - aabb.x) * mLevelSizes[0].x };
+		float height{ (aabb.y - aabb.w) * mLevelSizes[0].y };
+
+		int level{ static_cast<int>(std::ceil(std::log2(std::max(width, height)))) + 1 };
+		level = std::clamp(level, 0, maxLevel);
+
+		glm::vec2 center{ glm::vec2{ aabb.x + aabb.z, aabb.y + aabb.w } * 0.5f * glm::vec2{ mLevelSizes[level] } };
+
+		auto sample{ [&](glm::ivec2 coords) {
+			if (coords.x < 0 || coords.y < 0)
+			{
+				coords = { 0, 0 };
+			}
+			return getTexel(level, glm::min(coords, mLevelSizes[level] - 1));
+			} };
+
+		glm::ivec2 coords0{ glm::floor(center) };
+		glm::ivec2 coords1{ glm::ceil(center) };
+		depth = std::min(std::min(sample(coords0), sample({ coords0.x, coords1.y })),
+			std::min(sample(coords1), sample({ coords1.x, coords0.y })));
+	}
+	else
+	{
+		glm::ivec2 min{};
+		glm::ivec2 max{};
+		if (!getPixelBounds(aabb, mLevelSizes[0], min, max))
+		{
+			return false;
+		}
+
+		// Any n texels in a row touch at most 2 texels of the level where n <= 2^level. One level finer is often enough too
+		int extent{ std::max(max.x - min.x, max.y - min.y) + 1 };
+		int level{ std::max(static_cast<int>(std::bit_width(static_cast<unsigned int>(extent - 1))) - 1, 0) };
+		if ((max.x >> level) - (min.x >> level) > 1 || (max.y >> level) - (min.y >> level) > 1)
+		{
+			++level;
+		}
+		level = std::min(level, maxLevel);
+
+		glm::ivec2 levelMin{ glm::min(min >> level, mLevelSizes[level] - 1) };
+		glm::ivec2 levelMax{ glm::min(max >> level, mLevelSizes[level] - 1) };
+
+		depth = std::min(std::min(getTexel(level, levelMin), getTexel(level, levelMax)),
+			std::min(getTexel(level, { levelMin.x, levelMax.y }), getTexel(level, { levelMax.x, levelMin.y })));
+	}
+
+	return sphereDepth < depth;
+}
+
+bool HiZOcclusion::isSphereOccludedReference(const glm::vec4& viewSphere, float P00, float P11, float zNear) const
+{
+	glm::vec3 c{ viewSphere.x, viewSphere.y, -viewSphere.z };
+	float r{ viewSphere.w };
+
+	glm::vec4 aabb{};
+	glm::ivec2 min{};
+	glm::ivec2 max{};
+	if (mLevels.empty() || !projectSphereView(c, r, zNear, P00, P11, aabb) || !getPixelBounds(aabb, mLevelSizes[0], min, max))
+	{
+		return false;
+	}
+
+	const float sphereDepth{ zNear / (c.z - r) };
+
+	for (int y{ min.y }; y <= max.y; ++y)
+	{
+		const float* row{ &mLevels[0][static_cast<std::size_t>(y) * mLevelSizes[0].x] };
+		for (int x{ min.x }; x <= max.x; ++x)
+		{
+			if (row[x] <= sphereDepth)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+HiZOcclusion::Results HiZOcclusion::measure(JobSystem& jobSystem, const FrustumCuller& frustumCuller, const Camera::Frustum& frustum,
+	const glm::mat4& view, const glm::mat4& proj, float zNear, Method method) const
+{
+	std::vector<std::uint32_t> visibilityBitmask{};
+	frustumCuller.cull(jobSystem, frustum, visibilityBitmask);
+
+	std::vector<std::size_t> clusters{};
+	for (std::size_t cluster{ 0 }; cluster < frustumCuller.mClusterCount; ++cluster)
+	{
+		if (visibilityBitmask[cluster / 32] & (1u << (cluster % 32)))
+		{
+			clusters.push_back(cluster);
+		}
+	}
+
+	std::atomic<int> testedSpheres{ 0 };
+	std::atomic<int> hiddenSpheres{ 0 };
+	std::atomic<int> falseVisible{ 0 };
+	std::atomic<int> falseOccluded{ 0 };
+
+	jobSystem.parallelFor(clusters.size(), 0, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			std::size_t cluster{ clusters[i] };
+			glm::vec4 center{ view * glm::vec4{ frustumCuller.mWorldCenterX[cluster], frustumCuller.mWorldCenterY[cluster],
+				frustumCuller.mWorldCenterZ[cluster], 1.0f } };
+			glm::vec4 viewSphere{ glm::vec3{ center }, frustumCuller.mWorldRadius[cluster] };
+
+			if (-viewSphere.z < viewSphere.w + zNear)
+			{
+				continue;
+			}
+
+			++testedSpheres;
+
+			bool hidden{ isSphereOccludedReference(viewSphere, proj[0][0], proj[1][1], zNear) };
+			bool occluded{ isSphereOccluded(viewSphere, proj[0][0], proj[1][1], zNear, method) };
+
+			if (hidden)
+			{
+				++hiddenSpheres;
+			}
+
+			if (hidden && !occluded)
+			{
+				++falseVisible;
+			}
+			else if (!hidden && occluded)
+			{
+				++falseOccluded;
+			}
+		}
+		});
+
+	return { testedSpheres, hiddenSpheres, falseVisible, falseOccluded };
+}
+
+float HiZOcclusion::getTexel(int level, glm::ivec2 coords) const
+{
+	// Out of bounds image loads return 0, the farthest depth
+	if (coords.x < 0 || coords.y < 0 || coords.x >= mLevelSizes[level].x || coords.y >= mLevelSizes[level].y)
+	{
+		return 0.0f;
+	}
+
+	return mLevels[level][static_cast<std::size_t>(coords.y) * mLevelSizes[level].x + coords.x];
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+#include "frustum_culler.hpp"
+
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// CPU copy of the hi-z occlusion test in bvh_cull.comp & cluster_batch.comp, run on a captured depth buffer.
+// The pyramid is built like depth_downsample.comp: reverse-Z, so each texel keeps the minimum (farthest) depth
+// below it, with odd rows and columns folded into the last texel of the next level.
+// measure() compares the test against a per pixel ground truth to find how many hidden clusters it lets through.
+class HiZOcclusion final
+{
+public:
+
+	enum class Method
+	{
+		// The old shader test: a 2x2 block around the center of the bounds, one level coarser than the bounds need.
+		// Height was ignored when picking the level, so it isn't conservative
+		centered,
+
+		// The current shader test: the finest level where the bounds cover at most 2x2 texels
+		conservative,
+	};
+
+	struct Results
+	{
+		int testedSpheres{ 0 }; // Inside the frustum and past the near plane
+		int hiddenSpheres{ 0 }; // Occluded by every pixel under their projected bounds
+
+		int falseVisible{ 0 }; // Hidden, but kept by the test
+		int falseOccluded{ 0 }; // Not hidden, but culled by the test. Always 0 for a conservative test
+
+		float getFalseVisibleRate() const;
+	};
+
+	// depth is renderWidth * renderHeight floats, bottom row first, as read back with glGetTextureImage
+	void setDepth(std::vector<float> depth, int width, int height);
+
+	// viewSphere is in view space (looking down -z). P00 and P11 are the projection's x and y scales
+	bool isSphereOccluded(const glm::vec4& viewSphere, float P00, float P11, float zNear, Method method) const;
+
+	// Tests every full resolution pixel under the sphere's bounds
+	bool isSphereOccludedReference(const glm::vec4& viewSphere, float P00, float P11, float zNear) const;
+
+	// Frustum culls with frustumCuller, then runs both the test and the reference on the clusters left
+	Results measure(JobSystem& jobSystem, const FrustumCuller& frustumCuller, const Camera::Frustum& frustum,
+		const glm::mat4& view, const glm::mat4& proj, float zNear, Method method) const;
+
+	// Level 0 is the depth buffer itself
+	std::vector<std::vector<float>> mLevels{};
+	std::vector<glm::ivec2> mLevelSizes{};
+
+private:
+
+	float getTexel(int level, glm::ivec2 coords) const;
+};
\ No newline at end of file
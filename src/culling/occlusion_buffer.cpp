@@ -0,0 +1,256 @@
+#include "occlusion_buffer.hpp"
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+#include "frustum_culler.hpp"
+
+#include "glm/glm.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_BUFFER_SSE
+#include <immintrin.h>
+#endif
+
+#include <algorithm> // for fill, max, min & swap
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <utility> // for move()
+#include <vector>
+
+
+
+void OcclusionBuffer::resize(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+	mStride = (width + 3) & ~3;
+
+	mDepth.assign(static_cast<std::size_t>(mStride) * mHeight, 0.0f);
+}
+
+void OcclusionBuffer::setOccluders(std::vector<glm::vec3> triangles)
+{
+	mOccluderTriangles = std::move(triangles);
+}
+
+void OcclusionBuffer::rasterize(const glm::mat4& viewProj)
+{
+	std::fill(mDepth.begin(), mDepth.end(), 0.0f);
+
+	const glm::vec2 size{ static_cast<float>(mWidth), static_cast<float>(mHeight) };
+
+	for (std::size_t i{ 0 }; i + 2 < mOccluderTriangles.size(); i += 3)
+	{
+		glm::vec3 screen[3]{};
+		float depth{ 1.0f };
+		bool isClipped{ false };
+
+		for (int n{ 0 }; n < 3; ++n)
+		{
+			glm::vec4 clip{ viewProj * glm::vec4{ mOccluderTriangles[i + n], 1.0f } };
+
+			// Dropping an occluder is always safe, so triangles crossing the near plane are skipped instead of clipped
+			if (clip.w <= clip.z || clip.w <= 0.0f)
+			{
+				isClipped = true;
+				break;
+			}
+
+			glm::vec3 ndc{ glm::vec3{ clip } / clip.w };
+			screen[n] = { (glm::vec2{ ndc } * 0.5f + 0.5f) * size, ndc.z };
+			depth = std::min(depth, ndc.z);
+		}
+
+		if (!isClipped)
+		{
+			rasterizeTriangle(screen[0], screen[1], screen[2], depth);
+		}
+	}
+}
+
+bool OcclusionBuffer::isSphereOccluded(const glm::vec4& viewSphere, float P00, float P11, float zNear) const
+{
+	// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere. Michael Mara, Morgan McGuire. 2013
+	glm::vec3 c{ viewSphere.x, viewSphere.y, -viewSphere.z };
+	float r{ viewSphere.w };
+
+	if (c.z < r + zNear)
+	{
+		return false;
+	}
+
+	glm::vec3 cr{ c * r };
+	float czr2{ c.z * c.z - r * r };
+
+	float vx{ std::sqrt(c.x * c.x + czr2) };
+	float minX{ (vx * c.x - cr.z) / (vx * c.z + cr.x) };
+	float maxX{ (vx * c.x + cr.z) / (vx * c.z - cr.x) };
+
+	float vy{ std::sqrt(c.y * c.y + czr2) };
+	float minY{ (vy * c.y - cr.z) / (vy * c.z + cr.y) };
+	float maxY{ (vy * c.y + cr.z) / (vy * c.z - cr.y) };
+
+	// clip space -> pixels
+	int x0{ std::max(0, static_cast<int>(std::floor((minX * P00 * 0.5f + 0.5f) * mWidth))) };
+	int x1{ std::min(mWidth - 1, static_cast<int>(std::ceil((maxX * P00 * 0.5f + 0.5f) * mWidth))) };
+	int y0{ std::max(0, static_cast<int>(std::floor((minY * P11 * 0.5f + 0.5f) * mHeight))) };
+	int y1{ std::min(mHeight - 1, static_cast<int>(std::ceil((maxY * P11 * 0.5f + 0.5f) * mHeight))) };
+
+	if (x0 > x1 || y0 > y1)
+	{
+		return false;
+	}
+
+	float sphereDepth{ zNear / (c.z - r) };
+
+	for (int y{ y0 }; y <= y1; ++y)
+	{
+		const float* row{ &mDepth[static_cast<std::size_t>(y) * mStride] };
+		for (int x{ x0 }; x <= x1; ++x)
+		{
+			if (row[x] <= sphereDepth)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void OcclusionBuffer::cull(JobSystem& jobSystem, const FrustumCuller& frustumCuller, const Camera::Frustum& frustum,
+	const glm::mat4& view, const glm::mat4& proj, float zNear, std::vector<std::uint32_t>& visibilityBitmask) const
+{
+	frustumCuller.cull(jobSystem, frustum, visibilityBitmask);
+
+	constexpr std::size_t wordsPerChunk{ FrustumCuller::chunkSize / 32 };
+
+	jobSystem.parallelFor(visibilityBitmask.size(), wordsPerChunk, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			std::uint32_t word{ visibilityBitmask[i] };
+
+			for (std::uint32_t n{ 0 }; n < 32; ++n)
+			{
+				std::uint32_t bit{ std::uint32_t{ 1 } << n };
+				if (!(word & bit))
+				{
+					continue;
+				}
+
+				std::size_t cluster{ i * 32 + n };
+				glm::vec4 center{ view * glm::vec4{ frustumCuller.mWorldCenterX[cluster],
+					frustumCuller.mWorldCenterY[cluster], frustumCuller.mWorldCenterZ[cluster], 1.0f } };
+
+				if (isSphereOccluded({ glm::vec3{ center }, frustumCuller.mWorldRadius[cluster] }, proj[0][0], proj[1][1], zNear))
+				{
+					word &= ~bit;
+				}
+			}
+
+			visibilityBitmask[i] = word;
+		}
+		});
+}
+
+
+
+void OcclusionBuffer::rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float depth)
+{
+	float area{ (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) };
+	if (area == 0.0f)
+	{
+		return;
+	}
+
+	// Both faces occlude, so just make the winding consistent
+	if (area < 0.0f)
+	{
+		std::swap(v1, v2);
+	}
+
+	int minX{ std::max(0, static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x))))) };
+	int maxX{ std::min(mWidth - 1, static_cast<int>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x))))) };
+	int minY{ std::max(0, static_cast<int>(std::floor(std::min(v0.y, std::min(v1.y, v2.y))))) };
+	int maxY{ std::min(mHeight - 1, static_cast<int>(std::ceil(std::max(v0.y, std::max(v1.y, v2.y))))) };
+
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	// Edge functions in the form a * x + b * y + c, positive inside the triangle. Pixels centered on an edge are covered,
+	// so the triangles of a mesh leave no gaps along their shared edges, and covering a pixel twice is harmless
+	const glm::vec3 edges[3]
+	{
+		{ v0.y - v1.y, v1.x - v0.x, v0.x * v1.y - v0.y * v1.x },
+		{ v1.y - v2.y, v2.x - v1.x, v1.x * v2.y - v1.y * v2.x },
+		{ v2.y - v0.y, v0.x - v2.x, v2.x * v0.y - v2.y * v0.x },
+	};
+
+#if defined(OCCLUSION_BUFFER_SSE)
+	const __m128 pixelOffsets{ _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f) };
+	const __m128 depth4{ _mm_set1_ps(depth) };
+	const __m128 zero{ _mm_setzero_ps() };
+
+	__m128 edgeA[3]{};
+	for (int e{ 0 }; e < 3; ++e)
+	{
+		edgeA[e] = _mm_set1_ps(edges[e].x);
+	}
+
+	for (int y{ minY }; y <= maxY; ++y)
+	{
+		float pixelY{ y + 0.5f };
+
+		__m128 edgeRow[3]{};
+		for (int e{ 0 }; e < 3; ++e)
+		{
+			edgeRow[e] = _mm_set1_ps(edges[e].y * pixelY + edges[e].z);
+		}
+
+		float* row{ &mDepth[static_cast<std::size_t>(y) * mStride] };
+
+		for (int x{ minX & ~3 }; x <= maxX; x += 4)
+		{
+			__m128 pixelX{ _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets) };
+
+			__m128 inside{ _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), edgeRow[0]), zero) };
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), edgeRow[1]), zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), edgeRow[2]), zero));
+
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 oldDepth{ _mm_loadu_ps(row + x) };
+			__m128 newDepth{ _mm_max_ps(oldDepth, depth4) };
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+		}
+	}
+#else
+	for (int y{ minY }; y <= maxY; ++y)
+	{
+		float pixelY{ y + 0.5f };
+		float* row{ &mDepth[static_cast<std::size_t>(y) * mStride] };
+
+		for (int x{ minX }; x <= maxX; ++x)
+		{
+			float pixelX{ x + 0.5f };
+
+			bool inside{ true };
+			for (const auto& edge : edges)
+			{
+				inside = inside && (edge.x * pixelX + edge.y * pixelY + edge.z >= 0.0f);
+			}
+
+			if (inside)
+			{
+				row[x] = std::max(row[x], depth);
+			}
+		}
+	}
+#endif
+}
\ No newline at end of file
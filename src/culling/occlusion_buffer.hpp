@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
+#include "frustum_culler.hpp"
+
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <vector>
+
+// Low resolution software rasterized depth buffer of a few large occluders, used to produce a visibility
+// set without any GPU feedback (first frame, camera cuts, disocclusion). Depth is reverse-Z like the main
+// depth buffer, so larger is closer and the buffer clears to 0.
+class OcclusionBuffer final
+{
+public:
+
+	OcclusionBuffer() = default;
+	OcclusionBuffer(int width, int height)
+	{
+		resize(width, height);
+	}
+
+	void resize(int width, int height);
+
+	// World space triangle list, three vertices per triangle
+	void setOccluders(std::vector<glm::vec3> triangles);
+
+	// Each triangle is written at the depth of its farthest vertex, which keeps the buffer conservative
+	// without interpolating depth per pixel
+	void rasterize(const glm::mat4& viewProj);
+
+	// viewSphere is in view space (looking down -z). P00 and P11 are the projection's x and y scales
+	bool isSphereOccluded(const glm::vec4& viewSphere, float P00, float P11, float zNear) const;
+
+	// Frustum culls with frustumCuller, then clears the bits of clusters hidden behind the rasterized occluders.
+	// The output uses the same layout as mVisibilityBitmaskSsbo
+	void cull(JobSystem& jobSystem, const FrustumCuller& frustumCuller, const Camera::Frustum& frustum, const glm::mat4& view,
+		const glm::mat4& proj, float zNear, std::vector<std::uint32_t>& visibilityBitmask) const;
+
+	int mWidth{ 0 };
+	int mHeight{ 0 };
+
+	// Rows are padded to a multiple of 4 floats for SIMD
+	int mStride{ 0 };
+	std::vector<float> mDepth{};
+
+	std::vector<glm::vec3> mOccluderTriangles{};
+
+private:
+
+	void rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float depth);
+};
\ No newline at end of file
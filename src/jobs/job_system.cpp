@@ -0,0 +1,179 @@
+#include "job_system.hpp"
+
+#include <algorithm> // for max
+#include <atomic>
+#include <cstddef> // for size_t
+#include <memory> // for make_unique()
+#include <mutex>
+#include <thread>
+#include <utility> // for move()
+#include <vector>
+
+
+
+namespace
+{
+	// Set on worker threads. Several job systems can exist at once (e.g. for scaling benchmarks), so the owner is kept too
+	thread_local const JobSystem* tOwner{ nullptr };
+	thread_local int tQueueIndex{ 0 };
+}
+
+
+
+JobSystem::JobSystem(int threadCount)
+{
+	threadCount = std::max(threadCount, 1);
+
+	for (int i{ 0 }; i < threadCount; ++i)
+	{
+		mQueues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	// The thread that waits is the last one
+	for (int i{ 1 }; i < threadCount; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock{ mSleepMutex };
+		mStopping = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::run(Job job, Counter* counter, const Counter* dependency)
+{
+	if (counter)
+	{
+		++*counter;
+	}
+
+	WorkQueue& queue{ *mQueues[getQueueIndex()] };
+	{
+		std::lock_guard lock{ queue.mutex };
+		queue.jobs.push_back({ std::move(job), counter, dependency });
+	}
+
+	++mQueuedJobCount;
+
+	// Taking the lock orders this against a worker checking mQueuedJobCount right before it sleeps
+	{
+		std::lock_guard lock{ mSleepMutex };
+	}
+	mWakeCondition.notify_one();
+}
+
+void JobSystem::wait(const Counter& counter)
+{
+	const int queueIndex{ getQueueIndex() };
+
+	while (counter.load() > 0)
+	{
+		if (!tryRunJob(queueIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+int JobSystem::getThreadCount() const
+{
+	return static_cast<int>(mQueues.size());
+}
+
+void JobSystem::workerLoop(int queueIndex)
+{
+	tOwner = this;
+	tQueueIndex = queueIndex;
+
+	while (!mStopping)
+	{
+		if (tryRunJob(queueIndex))
+		{
+			continue;
+		}
+
+		// Jobs are queued but none could run, e.g. they're all waiting on a dependency
+		if (mQueuedJobCount > 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock lock{ mSleepMutex };
+		mWakeCondition.wait(lock, [this]() { return mStopping || mQueuedJobCount > 0; });
+	}
+}
+
+bool JobSystem::tryRunJob(int queueIndex)
+{
+	QueuedJob job{};
+	bool found{ false };
+
+	{
+		WorkQueue& queue{ *mQueues[queueIndex] };
+		std::lock_guard lock{ queue.mutex };
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Start with the next queue so thieves spread out instead of all hitting queue 0
+	for (std::size_t i{ 1 }; !found && i < mQueues.size(); ++i)
+	{
+		WorkQueue& victim{ *mQueues[(queueIndex + i) % mQueues.size()] };
+		std::lock_guard lock{ victim.mutex };
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	--mQueuedJobCount;
+
+	// Not ready yet. Goes to the stealing end, so it's picked up again after the work it depends on
+	if (job.dependency && job.dependency->load() > 0)
+	{
+		WorkQueue& queue{ *mQueues[queueIndex] };
+		{
+			std::lock_guard lock{ queue.mutex };
+			queue.jobs.push_front(std::move(job));
+		}
+		++mQueuedJobCount;
+
+		return false;
+	}
+
+	job.job();
+
+	if (job.counter)
+	{
+		--*job.counter;
+	}
+
+	return true;
+}
+
+int JobSystem::getQueueIndex() const
+{
+	return tOwner == this ? tQueueIndex : 0;
+}
\ No newline at end of file
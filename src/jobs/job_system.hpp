@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm> // for max & min
+#include <atomic>
+#include <condition_variable>
+#include <cstddef> // for std::size_t
+#include <deque>
+#include <functional>
+#include <memory> // for unique_ptr
+#include <mutex>
+#include <thread>
+#include <type_traits> // for remove_reference_t
+#include <vector>
+
+// Work-stealing thread pool owned by the application and shared by loading and the CPU side of each frame.
+// Every worker has its own deque: it pushes and pops its jobs at the back, and idle workers steal from the front
+// of the others. Threads that aren't workers queue into a shared deque and run jobs themselves while they wait.
+class JobSystem final
+{
+public:
+
+	// Number of unfinished jobs started with it
+	using Counter = std::atomic<int>;
+
+	using Job = std::function<void()>;
+
+	// threadCount includes the thread that waits, so 1 runs every job on the waiting thread
+	explicit JobSystem(int threadCount = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)));
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Jobs still queued are dropped
+	~JobSystem();
+
+	// counter, if any, goes up now and back down once job has run. job doesn't start before dependency reaches 0
+	void run(Job job, Counter* counter = nullptr, const Counter* dependency = nullptr);
+
+	// Runs queued jobs on the calling thread until counter reaches 0. Can be called from inside a job
+	void wait(const Counter& counter);
+
+	// Calls function(first, last) on ranges of at most grainSize covering [0, count), and returns once all of them
+	// have run. A grainSize of 0 makes about 4 ranges per thread
+	template <typename Function>
+	void parallelFor(std::size_t count, std::size_t grainSize, Function&& function);
+
+	int getThreadCount() const;
+
+private:
+
+	struct QueuedJob
+	{
+		Job job{};
+		Counter* counter{};
+		const Counter* dependency{};
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex{};
+		std::deque<QueuedJob> jobs{};
+	};
+
+	void workerLoop(int queueIndex);
+
+	// Pops from the back of the thread's own queue, or steals from the front of another
+	bool tryRunJob(int queueIndex);
+
+	int getQueueIndex() const;
+
+	// Index 0 is shared by every thread that isn't a worker
+	std::vector<std::unique_ptr<WorkQueue>> mQueues{};
+	std::vector<std::thread> mWorkers{};
+
+	std::atomic<int> mQueuedJobCount{ 0 };
+	std::atomic<bool> mStopping{ false };
+
+	std::mutex mSleepMutex{};
+	std::condition_variable mWakeCondition{};
+};
+
+
+
+template <typename Function>
+void JobSystem::parallelFor(std::size_t count, std::size_t grainSize, Function&& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (grainSize == 0)
+	{
+		grainSize = std::max<std::size_t>(count / (static_cast<std::size_t>(getThreadCount()) * 4), 1);
+	}
+
+	// Each job only captures a reference to this and where it starts, which fits in std::function's small buffer, so
+	// queuing a job doesn't allocate
+	struct Range
+	{
+		std::remove_reference_t<Function>& function;
+		std::size_t grainSize{};
+		std::size_t count{};
+	};
+	const Range range{ function, grainSize, count };
+
+	Counter counter{ 0 };
+	for (std::size_t first{ 0 }; first < count; first += grainSize)
+	{
+		run([&range, first]() { range.function(first, std::min(first + range.grainSize, range.count)); }, &counter);
+	}
+
+	wait(counter);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "light_clusters.hpp"
+
+#include "light_grid.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <algorithm> // for max
+#include <cstddef> // for size_t
+#include <utility> // for move()
+#include <vector>
+
+
+
+LightClusters::LightClusters()
+{
+	glCreateBuffers(1, &mFroxelBoundsSsbo);
+	glNamedBufferStorage(mFroxelBoundsSsbo, LightGrid::froxelCount * sizeof(LightGrid::FroxelBounds), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateBuffers(1, &mFroxelLightCountsSsbo);
+	glNamedBufferStorage(mFroxelLightCountsSsbo, LightGrid::froxelCount * sizeof(GLuint), nullptr, GL_NONE);
+
+	glCreateBuffers(1, &mFroxelLightIndicesSsbo);
+	glNamedBufferStorage(mFroxelLightIndicesSsbo, LightGrid::froxelCount * LightGrid::maxLightsPerFroxel * sizeof(GLuint), nullptr, GL_NONE);
+
+	const GLuint zero{ 0 };
+	glCreateBuffers(1, &mLightCullStatsSsbo);
+	glNamedBufferStorage(mLightCullStatsSsbo, sizeof(GLuint), &zero, GL_NONE);
+
+	setLights({});
+}
+
+LightClusters::~LightClusters()
+{
+	glDeleteBuffers(1, &mLightsSsbo);
+	glDeleteBuffers(1, &mFroxelBoundsSsbo);
+	glDeleteBuffers(1, &mFroxelLightCountsSsbo);
+	glDeleteBuffers(1, &mFroxelLightIndicesSsbo);
+	glDeleteBuffers(1, &mLightCullStatsSsbo);
+}
+
+void LightClusters::setProjection(const glm::mat4& proj, float zNear)
+{
+	mGrid.setProjection(proj, zNear);
+
+	glNamedBufferSubData(mFroxelBoundsSsbo, 0, LightGrid::froxelCount * sizeof(LightGrid::FroxelBounds), mGrid.mFroxelBounds.data());
+}
+
+void LightClusters::setLights(std::vector<LightGrid::Light> lights)
+{
+	mGrid.mLights = std::move(lights);
+
+	// The SSBO can't be empty, so there's always room for at least one light
+	if (mGrid.mLights.size() > mLightsCapacity || mLightsSsbo == 0)
+	{
+		glDeleteBuffers(1, &mLightsSsbo);
+
+		mLightsCapacity = std::max(mGrid.mLights.size(), std::size_t{ 1 });
+		glCreateBuffers(1, &mLightsSsbo);
+		glNamedBufferStorage(mLightsSsbo, mLightsCapacity * sizeof(LightGrid::Light), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+
+	if (!mGrid.mLights.empty())
+	{
+		glNamedBufferSubData(mLightsSsbo, 0, mGrid.mLights.size() * sizeof(LightGrid::Light), mGrid.mLights.data());
+	}
+}
\ No newline at end of file
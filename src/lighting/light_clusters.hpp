@@ -0,0 +1,43 @@
+#pragma once
+
+#include "light_grid.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <vector>
+
+// The GL side of clustered lighting: uploads mGrid's lights & froxel bounds, and light_cull.comp writes the list of
+// lights touching each froxel, so shading only loops over the lights of the pixel's froxel. Everything CPU-side,
+// including the reference binning, is in mGrid.
+class LightClusters final
+{
+public:
+
+	LightClusters();
+
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	~LightClusters();
+
+	// Rebuilds mGrid's froxel bounds, see LightGrid::setProjection
+	void setProjection(const glm::mat4& proj, float zNear);
+
+	void setLights(std::vector<LightGrid::Light> lights);
+
+	LightGrid mGrid{};
+
+	GLuint mLightsSsbo{};
+	GLuint mFroxelBoundsSsbo{};
+	GLuint mFroxelLightCountsSsbo{};
+	GLuint mFroxelLightIndicesSsbo{};
+
+	// One uint: the froxels light_cull.comp had to drop lights from. Clear it before each dispatch
+	GLuint mLightCullStatsSsbo{};
+
+private:
+
+	std::size_t mLightsCapacity{ 0 };
+};
\ No newline at end of file
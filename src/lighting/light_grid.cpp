@@ -0,0 +1,160 @@
+#include "light_grid.hpp"
+
+#include "../jobs/job_system.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <algorithm> // for max
+#include <atomic>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+	bool sphereIntersectsAabb(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max)
+	{
+		glm::vec3 closest{ glm::clamp(center, min, max) };
+		glm::vec3 offset{ closest - center };
+
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+}
+
+
+
+void LightGrid::setProjection(const glm::mat4& proj, float zNear)
+{
+	mZNear = zNear;
+
+	const float tanHalfX{ 1.0f / proj[0][0] };
+	const float tanHalfY{ 1.0f / proj[1][1] };
+
+	for (int z{ 0 }; z < slices; ++z)
+	{
+		float sliceNear{ mZNear * std::pow(mLightingDistance / mZNear, static_cast<float>(z) / slices) };
+		float sliceFar{ mZNear * std::pow(mLightingDistance / mZNear, static_cast<float>(z + 1) / slices) };
+
+		for (int y{ 0 }; y < tilesY; ++y)
+		{
+			float ndcY0{ static_cast<float>(y) / tilesY * 2.0f - 1.0f };
+			float ndcY1{ static_cast<float>(y + 1) / tilesY * 2.0f - 1.0f };
+
+			for (int x{ 0 }; x < tilesX; ++x)
+			{
+				float ndcX0{ static_cast<float>(x) / tilesX * 2.0f - 1.0f };
+				float ndcX1{ static_cast<float>(x + 1) / tilesX * 2.0f - 1.0f };
+
+				glm::vec3 min{ 1e30f };
+				glm::vec3 max{ -1e30f };
+				for (float depth : { sliceNear, sliceFar })
+				{
+					for (float ndcX : { ndcX0, ndcX1 })
+					{
+						for (float ndcY : { ndcY0, ndcY1 })
+						{
+							glm::vec3 corner{ ndcX * tanHalfX * depth, ndcY * tanHalfY * depth, -depth };
+							min = glm::min(min, corner);
+							max = glm::max(max, corner);
+						}
+					}
+				}
+
+				mFroxelBounds[(z * tilesY + y) * tilesX + x] = { glm::vec4{ min, 0.0f }, glm::vec4{ max, 0.0f } };
+			}
+		}
+	}
+}
+
+std::size_t LightGrid::binLights(JobSystem& jobSystem, const glm::mat4& view, std::vector<GLuint>& froxelLightCounts,
+	std::vector<GLuint>& froxelLightIndices) const
+{
+	froxelLightCounts.assign(froxelCount, 0);
+	froxelLightIndices.resize(static_cast<std::size_t>(froxelCount) * maxLightsPerFroxel);
+
+	std::vector<glm::vec4> viewLights(mLights.size());
+	for (std::size_t i{ 0 }; i < mLights.size(); ++i)
+	{
+		viewLights[i] = { glm::vec3{ view * glm::vec4{ mLights[i].position, 1.0f } }, mLights[i].radius };
+	}
+
+	// Same order as the shader, and both keep the first maxLightsPerFroxel lights by index, so the lists are identical
+	// even when a froxel overflows
+	std::atomic<std::size_t> overflowingFroxels{ 0 };
+	jobSystem.parallelFor(froxelCount, 0, [&](std::size_t firstFroxel, std::size_t lastFroxel) {
+		std::size_t overflowing{ 0 };
+		for (std::size_t froxel{ firstFroxel }; froxel < lastFroxel; ++froxel)
+		{
+			glm::vec3 min{ mFroxelBounds[froxel].min };
+			glm::vec3 max{ mFroxelBounds[froxel].max };
+
+			// Once the froxel is full, only one more light has to be found to know it overflows
+			GLuint count{ 0 };
+			bool overflows{ false };
+			for (std::size_t i{ 0 }; i < viewLights.size() && !overflows; ++i)
+			{
+				if (sphereIntersectsAabb(glm::vec3{ viewLights[i] }, viewLights[i].w, min, max))
+				{
+					if (count < maxLightsPerFroxel)
+					{
+						froxelLightIndices[froxel * maxLightsPerFroxel + count] = static_cast<GLuint>(i);
+						++count;
+					}
+					else
+					{
+						overflows = true;
+					}
+				}
+			}
+
+			froxelLightCounts[froxel] = count;
+			overflowing += overflows ? 1 : 0;
+		}
+		overflowingFroxels.fetch_add(overflowing, std::memory_order_relaxed);
+		});
+
+	return overflowingFroxels.load(std::memory_order_relaxed);
+}
+
+std::vector<LightGrid::Light> LightGrid::generateRandomLights(std::size_t count, const glm::vec4& boundingSphere, std::uint32_t seed)
+{
+	std::mt19937 generator{ seed };
+	std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float> hue{ 0.0f, 1.0f };
+
+	// Keep the total lit volume about the same no matter the count
+	float radius{ std::max(boundingSphere.w / std::cbrt(static_cast<float>(std::max(count, std::size_t{ 1 }))) * 1.5f, 0.5f) };
+
+	std::vector<Light> lights(count);
+	for (auto& light : lights)
+	{
+		glm::vec3 offset{};
+		do
+		{
+			offset = { unit(generator), unit(generator), unit(generator) };
+		} while (glm::dot(offset, offset) > 1.0f);
+
+		light.position = glm::vec3{ boundingSphere } + offset * boundingSphere.w;
+		light.radius = radius;
+		light.color = glm::clamp(glm::abs(glm::fract(hue(generator) + glm::vec3{ 1.0f, 2.0f / 3.0f, 1.0f / 3.0f }) * 6.0f - 3.0f) - 1.0f,
+			0.0f, 1.0f);
+		light.intensity = 2.0f;
+	}
+
+	return lights;
+}
+
+float LightGrid::getSliceScale() const
+{
+	return slices / std::log(mLightingDistance / mZNear);
+}
+
+float LightGrid::getSliceBias() const
+{
+	return -slices * std::log(mZNear) / std::log(mLightingDistance / mZNear);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <vector>
+
+// The CPU side of clustered lighting, without GL. The view frustum is split into froxels (screen tiles x
+// exponential depth slices) and each froxel gets the list of point & spot lights touching it, with the same rules
+// as light_cull.comp. LightClusters uploads the lights & froxel bounds for the shader.
+class LightGrid final
+{
+public:
+
+	static constexpr int tilesX{ 16 };
+	static constexpr int tilesY{ 9 };
+	static constexpr int slices{ 24 };
+	static constexpr int froxelCount{ tilesX * tilesY * slices };
+
+	// Lights past this are dropped from the froxel and the froxel is counted as overflowing. Keeps the index buffer a
+	// fixed size
+	static constexpr int maxLightsPerFroxel{ 128 };
+
+	// Matches the Light struct in light_cull.comp & lighting.frag
+	struct Light
+	{
+		glm::vec3 position{};
+		float radius{ 1.0f };
+
+		glm::vec3 color{ 1.0f };
+		float intensity{ 1.0f };
+
+		// Point lights have a cone cosine of -1, i.e. the whole sphere
+		glm::vec3 direction{ 0.0f, -1.0f, 0.0f };
+		float spotCosOuter{ -1.0f };
+	};
+
+	struct FroxelBounds
+	{
+		glm::vec4 min{};
+		glm::vec4 max{};
+	};
+
+	LightGrid()
+		: mFroxelBounds(froxelCount)
+	{
+	}
+
+	// Only the projection's x & y scales and zNear are used, which also covers the infinite reverse-Z projection.
+	// Slices are spaced exponentially from zNear to mLightingDistance
+	void setProjection(const glm::mat4& proj, float zNear);
+
+	// Fills the same buffers as light_cull.comp: froxelLightCounts[f] lights at froxelLightIndices[f * maxLightsPerFroxel].
+	// A light is in a froxel when its sphere touches the froxel's view space AABB, boundary included, and each
+	// froxel keeps the first maxLightsPerFroxel of them in light order. Returns how many froxels dropped lights
+	std::size_t binLights(JobSystem& jobSystem, const glm::mat4& view, std::vector<GLuint>& froxelLightCounts,
+		std::vector<GLuint>& froxelLightIndices) const;
+
+	// Lights with random colors, spread uniformly through a sphere, for benchmarking
+	static std::vector<Light> generateRandomLights(std::size_t count, const glm::vec4& boundingSphere, std::uint32_t seed = 1);
+
+	// Used by the shading pass to find a fragment's slice: floor(log(viewDepth) * sliceScale + sliceBias)
+	float getSliceScale() const;
+	float getSliceBias() const;
+
+	float mLightingDistance{ 500.0f };
+
+	float mZNear{ 0.25f };
+
+	std::vector<Light> mLights{};
+	std::vector<FroxelBounds> mFroxelBounds{};
+};
\ No newline at end of file
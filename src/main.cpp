@@ -1,6 +1,20 @@
 #include "camera/camera.hpp"
+#include "culling/hi_z_occlusion.hpp"
+#include "jobs/job_system.hpp"
+#include "lighting/light_clusters.hpp"
+#include "lighting/light_grid.hpp"
+#include "model/mesh_codec.hpp"
+#include "model/meshlet_builder.hpp"
 #include "model/model.hpp"
+#include "model/model_asset.hpp"
+#include "profiling/load_benchmark.hpp"
+#include "rendering/render_target_pool.hpp"
 #include "scene/scene.hpp"
+#include "scene/scene_generator.hpp"
+#include "shadow/cascaded_shadow_map.hpp"
+#include "transparency/fragment_lists.hpp"
+#include "upscaling/dynamic_resolution.hpp"
+#include "upscaling/temporal_upscaler.hpp"
 
 #define SDL_MAIN_HANDLED
 #include "SDL/SDL.h"
@@ -21,15 +35,22 @@
 
 #include "meshoptimizer/meshoptimizer.h"
 
+#include <algorithm> // for equal, max & min
+#include <bit> // for popcount
 #include <cmath> // for cbrt and ceil
 #include <chrono>
+#include <cstddef> // for size_t & ptrdiff_t
 #include <cstdint>
 #include <filesystem>
 #include <iostream>
+#include <iterator> // for size
+#include <optional>
 #include <unordered_map>
 #include <string>
+#include <thread>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 
 
@@ -75,6 +96,45 @@ void message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GL
 struct Stats
 {
     float frameTime{};
+
+    float cpuBvhCullTime{};
+    float cpuFlatCullTime{};
+    int cpuVisibleClusters{};
+
+    float cpuSimdCullTime{};
+    float cpuScalarCullTime{};
+
+    float cpuOcclusionRasterTime{};
+    float cpuOcclusionCullTime{};
+    int cpuOcclusionVisibleClusters{};
+
+    float gpuLightCullTime{};
+    float cpuLightBinTime{};
+    int lightBinMismatches{};
+    float averageFroxelLights{};
+    int gpuOverflowingFroxels{};
+    int cpuOverflowingFroxels{};
+
+    float gpuOpaqueTime{};
+
+    float gpuCullTime{};
+    int gpuVisibleClusters{};
+    float cullOutputSize{};
+
+    float gpuTransparentTime{};
+    GLuint transparentFragments{};
+
+    float gpuFrameTime{};
+
+    // Hi-z test against the per pixel reference, on the last captured depth buffer
+    HiZOcclusion::Results hiZResults{};
+    HiZOcclusion::Results centeredHiZResults{};
+
+    // CPU frustum cull + occlusion cull + light binning, with 1, 2, ... threads
+    std::vector<float> jobScalingTimes{};
+
+    // Every model's vertices & meshlet indices through the mesh codec, summed
+    MeshCodec::BenchmarkResults meshCodecResults{};
 };
 
 
@@ -91,8 +151,34 @@ glm::mat4 infiniteReversePerspective(float fovY, float aspect, float zNear)
 
 
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Offline comparison of meshlet build settings: --meshlet-report <path to .gltf/.glb>
+    if (argc >= 3 && std::string{ argv[1] } == "--meshlet-report")
+    {
+        MeshletBuilder::writeReport(std::cout, argv[2], MeshletBuilder::getReportSettings());
+        return 0;
+    }
+
+    // Synthetic scenes for scaling tests: --generate-scene <path to .gltf/.glb> [--meshes N --instances N ...]
+    if (argc >= 3 && std::string{ argv[1] } == "--generate-scene")
+    {
+        return SceneGenerator::write(std::cout, argv[2], SceneGenerator::parseArguments(std::cout, argc, argv, 3)) ? 0 : -1;
+    }
+
+    // Every preset of SceneGenerator::getCorpusSettings(): --generate-corpus <directory>
+    if (argc >= 3 && std::string{ argv[1] } == "--generate-corpus")
+    {
+        return SceneGenerator::writeCorpus(std::cout, argv[2]) ? 0 : -1;
+    }
+
+    // Headless timing of every loader stage as JSON: --load-benchmark <path to .gltf/.glb> [--out results.json
+    // --baseline previous.json --label <commit> ...]. Fails when a stage regressed against the baseline
+    if (argc >= 3 && std::string{ argv[1] } == "--load-benchmark")
+    {
+        return LoadBenchmark::run(std::cout, argv[2], LoadBenchmark::parseArguments(std::cout, argc, argv, 3)) ? 0 : -1;
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
     {
         std::cerr << "Failed to initialize SDL2.\n";
@@ -102,11 +188,12 @@ int main()
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-    constexpr int screenWidth{ 1440 };
-    constexpr int screenHeight{ 810 };
+    // The window's size, which everything is upscaled to. Changes when the window is resized
+    int screenWidth{ 1440 };
+    int screenHeight{ 810 };
 
     SDL_Window* window{ SDL_CreateWindow("Hello world!",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, screenWidth, screenHeight, SDL_WINDOW_OPENGL) };
+        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, screenWidth, screenHeight, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE) };
     if (!window)
     {
         std::cerr << "Failed to create window.\n";
@@ -139,6 +226,28 @@ int main()
     ImGui_ImplSDL2_InitForOpenGL(window, glContext);
     ImGui_ImplOpenGL3_Init();
 
+    // Declared before everything that owns GL objects, so their destructors run while the context still exists
+    struct Shutdown
+    {
+        SDL_Window* window{};
+        SDL_GLContext glContext{};
+
+        ~Shutdown()
+        {
+            ImGui_ImplOpenGL3_Shutdown();
+            ImGui_ImplSDL2_Shutdown();
+            ImGui::DestroyContext();
+
+            SDL_GL_DeleteContext(glContext);
+            SDL_DestroyWindow(window);
+            SDL_QuitSubSystem(SDL_INIT_VIDEO);
+            SDL_Quit();
+        }
+    } shutdown{ window, glContext };
+
+    JobSystem jobSystem{};
+    std::cout << "Job system running on " << jobSystem.getThreadCount() << " threads\n";
+
 
 
     SceneObject sceneObject{};
@@ -149,16 +258,60 @@ int main()
         //{.name{"bistro"}, .path{ "../../assets/Bistro2.glb" } },
         { .name{"cubes"}, .path{ "../../assets/cubes.glb" } },
     };
-    sceneObject.loadModels(modelLoadInfos);
-    sceneObject.initGlMemory();
+
+    // Any other scene, e.g. a generated one, in place of the default assets: --scene <path to .gltf/.glb>
+    if (argc >= 3 && std::string{ argv[1] } == "--scene")
+    {
+        const std::filesystem::path scenePath{ std::filesystem::absolute(argv[2]) };
+        modelLoadInfos = { { .name{ "scene" }, .path{ scenePath }, .directory{ scenePath.parent_path() } } };
+    }
+    sceneObject.loadModels(jobSystem, modelLoadInfos);
+    // The shadow cascades are the only secondary views
+    sceneObject.initGlMemory(jobSystem, CascadedShadowMap::maxCascades);
+    sceneObject.writeMemoryReport(std::cout);
 
     sceneObject.mShaderPrograms["uber"] = { "../../src/shaders/uber.vert", "../../src/shaders/uber.frag" };
+    sceneObject.mShaderPrograms["uber_masked"] = { .vsPath{ "../../src/shaders/uber.vert" }, .fsPath{ "../../src/shaders/uber.frag" },
+        .defines{ "ALPHA_MASK" } };
+    sceneObject.mShaderPrograms["depth_prepass"] = { .vsPath{ "../../src/shaders/uber.vert" } };
     sceneObject.mShaderPrograms["transparent"] = { "../../src/shaders/uber.vert", "../../src/shaders/transparent.frag" };
+    sceneObject.mShaderPrograms["transparent_fragment_lists"] = { .vsPath{ "../../src/shaders/uber.vert" },
+        .fsPath{ "../../src/shaders/transparent.frag" }, .defines{ "FRAGMENT_LISTS" } };
+    sceneObject.mShaderPrograms["transparent_sorted"] = { .vsPath{ "../../src/shaders/uber.vert" },
+        .fsPath{ "../../src/shaders/transparent.frag" }, .defines{ "SORTED_BLEND", "PER_CLUSTER_DRAWS" } };
+    sceneObject.mShaderPrograms["blend_sort"] = { .computePath{ "../../src/shaders/blend_sort.comp" } };
+    sceneObject.mShaderPrograms["blend_sort_global_merge"] = { .computePath{ "../../src/shaders/blend_sort.comp" },
+        .defines{ "GLOBAL_MERGE" } };
+    sceneObject.mShaderPrograms["blend_sort_local_merge"] = { .computePath{ "../../src/shaders/blend_sort.comp" },
+        .defines{ "LOCAL_MERGE" } };
+    sceneObject.mShaderPrograms["blend_sort_draws"] = { .computePath{ "../../src/shaders/blend_sort.comp" },
+        .defines{ "WRITE_DRAWS" } };
+    sceneObject.mShaderPrograms["oit_resolve"] = { "../../src/shaders/comp.vert", "../../src/shaders/oit_resolve.frag" };
+    sceneObject.mShaderPrograms["temporal_upscale"] = { "../../src/shaders/comp.vert", "../../src/shaders/temporal_upscale.frag" };
     sceneObject.mShaderPrograms["comp"] = { "../../src/shaders/comp.vert", "../../src/shaders/comp.frag" };
+    sceneObject.mShaderPrograms["comp_sorted"] = { .vsPath{ "../../src/shaders/comp.vert" }, .fsPath{ "../../src/shaders/comp.frag" },
+        .defines{ "SORTED_BLEND" } };
     sceneObject.mShaderPrograms["lighting"] = { "../../src/shaders/comp.vert", "../../src/shaders/lighting.frag" };
     sceneObject.mShaderPrograms["occluder_batch"] = { .computePath{ "../../src/shaders/occluder_batch.comp" } };
     sceneObject.mShaderPrograms["cluster_batch"] = { .computePath{ "../../src/shaders/cluster_batch.comp" } };
     sceneObject.mShaderPrograms["depth_downsample"] = { .computePath{ "../../src/shaders/depth_downsample.comp" }};
+    sceneObject.mShaderPrograms["bvh_cull"] = { .computePath{ "../../src/shaders/bvh_cull.comp" } };
+    sceneObject.mShaderPrograms["shadow"] = { "../../src/shaders/uber.vert", "../../src/shaders/shadow.frag" };
+    sceneObject.mShaderPrograms["view_batch"] = { .computePath{ "../../src/shaders/view_batch.comp" } };
+    sceneObject.mShaderPrograms["light_cull"] = { .computePath{ "../../src/shaders/light_cull.comp" } };
+    sceneObject.mShaderPrograms["visibility"] = { "../../src/shaders/uber.vert", "../../src/shaders/visibility.frag" };
+    sceneObject.mShaderPrograms["visibility_masked"] = { .vsPath{ "../../src/shaders/uber.vert" },
+        .fsPath{ "../../src/shaders/visibility.frag" }, .defines{ "ALPHA_MASK" } };
+    sceneObject.mShaderPrograms["visibility_resolve"] = { "../../src/shaders/comp.vert", "../../src/shaders/visibility_resolve.frag" };
+
+    // Everything that writes or reads the opaque & alpha masked streams also comes in a per cluster draw command variant
+    for (const char* name : { "occluder_batch", "cluster_batch", "uber", "uber_masked", "depth_prepass",
+        "visibility", "visibility_masked", "visibility_resolve" })
+    {
+        auto shaderProgram{ sceneObject.mShaderPrograms.at(name) };
+        shaderProgram.defines.push_back("PER_CLUSTER_DRAWS");
+        sceneObject.mShaderPrograms[std::string{ name } + "_per_cluster"] = shaderProgram;
+    }
     sceneObject.linkShaderPrograms();
 
     Camera camera({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f });
@@ -197,66 +350,186 @@ int main()
     GLuint opaqueFBO{};
     glCreateFramebuffers(1, &opaqueFBO);
 
-    GLuint opaqueTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &opaqueTexture);
-    glTextureStorage2D(opaqueTexture, 1, GL_RGBA16F, screenWidth, screenHeight);
-    GLuint normalTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &normalTexture);
-    glTextureStorage2D(normalTexture, 1, GL_RGBA16F, screenWidth, screenHeight); // todo: find better formats (after srgb)
-    GLuint depthTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
-    glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, screenWidth, screenHeight);
-
-    glNamedFramebufferTexture(opaqueFBO, GL_COLOR_ATTACHMENT0, opaqueTexture,   0);
-    glNamedFramebufferTexture(opaqueFBO, GL_COLOR_ATTACHMENT1, normalTexture,   0);
-    glNamedFramebufferTexture(opaqueFBO, GL_DEPTH_ATTACHMENT,  depthTexture,    0);
-
     GLenum drawBuffersG[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
     glNamedFramebufferDrawBuffers(opaqueFBO, 2, drawBuffersG);
 
+    // Visibility buffer mode draws opaque geometry here instead, then resolves materials into opaqueFBO
+    GLuint visibilityFBO{};
+    glCreateFramebuffers(1, &visibilityFBO);
+
     GLuint transparentFBO{};
     glCreateFramebuffers(1, &transparentFBO);
 
-    GLuint accumTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &accumTexture);
-    glTextureStorage2D(accumTexture, 1, GL_RGBA16F, screenWidth, screenHeight);
-    GLuint revealTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &revealTexture);
-    glTextureStorage2D(revealTexture, 1, GL_R8, screenWidth, screenHeight);
-
-    glNamedFramebufferTexture(transparentFBO, GL_COLOR_ATTACHMENT0, accumTexture, 0);
-    glNamedFramebufferTexture(transparentFBO, GL_COLOR_ATTACHMENT1, revealTexture, 0);
-    glNamedFramebufferTexture(transparentFBO, GL_DEPTH_ATTACHMENT, depthTexture, 0);
-
     GLenum drawBuffers[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
     glNamedFramebufferDrawBuffers(transparentFBO, 2, drawBuffers);
 
+    // Lighting and the transparent composite land here, then get upscaled to the window
+    GLuint sceneColorFBO{};
+    glCreateFramebuffers(1, &sceneColorFBO);
+
+    // Fixed budget for the per pixel fragment lists, head pointers included. About 5 layers per pixel at 1080p
+    constexpr std::size_t fragmentListBudget{ 128 * 1024 * 1024 };
+
+    // Everything rendered per pixel is at the internal render resolution, which dynamic resolution changes at runtime.
+    // Textures come from renderTargetPool, and are only valid until the next createRenderTargets()
+    RenderTargetPool renderTargetPool{};
+    GLuint opaqueTexture{};
+    GLuint normalTexture{};
+    GLuint depthTexture{};
+    GLuint visibilityTexture{};
+    GLuint accumTexture{};
+    GLuint revealTexture{};
     GLuint hiZTexture{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &hiZTexture);
-    glTextureStorage2D(hiZTexture, std::floor(std::log2(std::max(screenWidth, screenHeight))) + 1, GL_R32F, screenWidth, screenHeight);
+    GLuint sceneColorTexture{};
+    GLuint fragmentListHeadTexture{};
+    std::optional<FragmentLists> fragmentLists{};
 
-    GLuint shadowFBO{};
-    glCreateFramebuffers(1, &shadowFBO);
+    // The passes render targets live through, in the order the frame runs them. Targets with the same description that
+    // aren't alive at the same time share a texture, e.g. the visibility buffer and the fragment list heads
+    enum RenderPass : int
+    {
+        opaqueFirstPass, hiZPass, opaqueSecondPass, visibilityResolvePass, shadowPass, transparentPass, lightingPass,
+        compositePass, upscalePass
+    };
+
+    auto createRenderTargets{ [&](int width, int height) {
+        fragmentLists.reset();
+        renderTargetPool.clear();
+
+        auto acquire{ [&](GLenum format, int firstPass, int lastPass, int levels = 1, GLenum filter = GL_NEAREST) {
+            return renderTargetPool.acquire({ .internalFormat{ format }, .width{ width }, .height{ height }, .levels{ levels },
+                .filter{ filter } }, firstPass, lastPass);
+            } };
+
+        // Read until the end of the frame, after the upscale, by the hi-z depth capture
+        depthTexture = acquire(GL_DEPTH_COMPONENT32F, opaqueFirstPass, upscalePass);
+        opaqueTexture = acquire(GL_RGBA16F, opaqueFirstPass, lightingPass);
+        normalTexture = acquire(GL_RGBA16F, opaqueFirstPass, lightingPass); // todo: find better formats (after srgb)
+        visibilityTexture = acquire(GL_R32UI, opaqueFirstPass, visibilityResolvePass);
+
+        // Culling reads its size through textureSize, so occlusion tests follow the render resolution.
+        // Only rebuilt while the view frustum updates, and culled against as it is otherwise, so it has to survive
+        // the whole frame and into the next one
+        hiZTexture = acquire(GL_R32F, opaqueFirstPass, upscalePass, static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1);
+
+        accumTexture = acquire(GL_RGBA16F, transparentPass, compositePass);
+        revealTexture = acquire(GL_R8, transparentPass, compositePass);
+        fragmentListHeadTexture = acquire(GL_R32UI, transparentPass, compositePass);
+
+        sceneColorTexture = acquire(GL_RGBA16F, lightingPass, upscalePass, 1, GL_LINEAR);
+
+        glNamedFramebufferTexture(opaqueFBO, GL_COLOR_ATTACHMENT0, opaqueTexture,   0);
+        glNamedFramebufferTexture(opaqueFBO, GL_COLOR_ATTACHMENT1, normalTexture,   0);
+        glNamedFramebufferTexture(opaqueFBO, GL_DEPTH_ATTACHMENT,  depthTexture,    0);
+
+        glNamedFramebufferTexture(visibilityFBO, GL_COLOR_ATTACHMENT0, visibilityTexture, 0);
+        glNamedFramebufferTexture(visibilityFBO, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+
+        glNamedFramebufferTexture(transparentFBO, GL_COLOR_ATTACHMENT0, accumTexture, 0);
+        glNamedFramebufferTexture(transparentFBO, GL_COLOR_ATTACHMENT1, revealTexture, 0);
+        glNamedFramebufferTexture(transparentFBO, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+
+        glNamedFramebufferTexture(sceneColorFBO, GL_COLOR_ATTACHMENT0, sceneColorTexture, 0);
+
+        fragmentLists.emplace(fragmentListHeadTexture, width, height, fragmentListBudget);
+        } };
+
+    DynamicResolution dynamicResolution{ screenWidth, screenHeight };
+    int renderWidth{ dynamicResolution.getRenderWidth() };
+    int renderHeight{ dynamicResolution.getRenderHeight() };
+    createRenderTargets(renderWidth, renderHeight);
+
+    TemporalUpscaler temporalUpscaler{ screenWidth, screenHeight };
+
+    // Whole frame GPU time, which dynamic resolution keeps under its target
+    GLuint frameTimeQueries[2]{};
+    glCreateQueries(GL_TIMESTAMP, 2, frameTimeQueries);
+    bool frameTimeQueriesPending{ false };
+    bool dynamicResolutionEnabled{ false };
+    bool temporalUpscaling{ true };
+    float fixedRenderScale{ 1.0f };
+
+    CascadedShadowMap cascadedShadowMap{ 2048 };
+
+    LightClusters lightClusters{};
+    glm::mat4 lightClustersProj{ 0.0f };
+
+    GLuint lightCullQuery{};
+    glCreateQueries(GL_TIME_ELAPSED, 1, &lightCullQuery);
+    bool lightCullQueryPending{ false };
+
+    // Opaque geometry + material shading. The first query covers the occluder draw, the second the main draw
+    GLuint opaqueQueries[2]{};
+    glCreateQueries(GL_TIME_ELAPSED, 2, opaqueQueries);
+    bool opaqueQueriesPending{ false };
+
+    // Culling writes either the visible clusters' indices (index rewrite) or one draw command per visible cluster.
+    // The first query covers occluder_batch, the second BVH culling + cluster_batch
+    GLuint cullQueries[2]{};
+    glCreateQueries(GL_TIME_ELAPSED, 2, cullQueries);
+    bool cullQueriesPending{ false };
+    bool perClusterDraws{ false };
+    bool culledWithPerClusterDraws{ false };
+    bool readBackCullOutput{ false };
+
+    // With ARB_texture_filter_minmax a single bilinear tap returns the farthest depth of a 2x2 hi-z block
+    GLuint hiZMinSampler{};
+    if (GLAD_GL_ARB_texture_filter_minmax)
+    {
+        glCreateSamplers(1, &hiZMinSampler);
+        glSamplerParameteri(hiZMinSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+        glSamplerParameteri(hiZMinSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glSamplerParameteri(hiZMinSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(hiZMinSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(hiZMinSampler, GL_TEXTURE_REDUCTION_MODE_ARB, GL_MIN);
+    }
+    bool useHiZMinSampler{ hiZMinSampler != 0 };
 
-    GLuint shadowMap{};
-    glCreateTextures(GL_TEXTURE_2D, 1, &shadowMap);
-    glTextureStorage2D(shadowMap, 1, GL_DEPTH_COMPONENT32F, 1024, 1024);
+    HiZOcclusion hiZOcclusion{};
+    bool captureHiZDepth{ false };
+    bool visibilityBufferMode{ false };
+    bool depthPrepass{ false };
 
-    glNamedFramebufferTexture(shadowFBO, GL_DEPTH_ATTACHMENT, shadowMap, 0);
+    // Weighted blended OIT is order independent but approximate. Fragment lists sort per pixel within a memory budget,
+    // sorted clusters blend exactly in back to front cluster order but break where clusters interleave
+    enum TransparencyMode : int { weightedBlendedOit, fragmentListOit, sortedClusterBlending };
+    int transparencyMode{ weightedBlendedOit };
+    bool readBackFragmentCount{ false };
 
-    //glNamedFramebufferDrawBuffer(shadowFBO, GL_DEPTH_ATTACHMENT);
+    // The first query covers the blend sort and the transparent draw, the second the resolve/composite
+    GLuint transparentQueries[2]{};
+    glCreateQueries(GL_TIME_ELAPSED, 2, transparentQueries);
+    bool transparentQueriesPending{ false };
 
     double lastTime{ SDL_GetTicks64() * 0.001 };
 
     Stats stats{};
     bool updateViewFrustum{ true };
+    bool bvhCulling{ true };
+    bool cpuReferenceCulling{ false };
+
+    // The GPU has no visibility history on the first frame, so it's seeded from the CPU occlusion buffer
+    bool seedVisibility{ true };
+    bool alwaysSeedVisibility{ false };
+    int occlusionBufferResolution{ 2 };
+    constexpr int occlusionBufferResolutions[][2]{ { 64, 36 }, { 128, 72 }, { 256, 144 }, { 512, 288 } };
     int hiZDisplayLevel{ 0 };
 
+    int lightCountIndex{ 2 };
+    constexpr int lightCounts[]{ 0, 10, 100, 1000, 10000 };
+    bool cpuReferenceLightBinning{ false };
+    bool measureJobScaling{ false };
+    bool measureMeshCodec{ false };
+    const glm::vec4 sceneBoundingSphere{ sceneObject.mClusterBvh.mNodes.empty() ? glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f }
+        : sceneObject.mClusterBvh.mNodes.front().boundingSphere };
+    lightClusters.setLights(LightGrid::generateRandomLights(lightCounts[lightCountIndex], sceneBoundingSphere));
+
     glm::mat4 hiZView{ 1.0f };
 
     char selectedProgram[512]{};
 
     bool quit{ false };
+    bool outputResized{ false };
     while (!quit)
     {
         const double currentTime{ SDL_GetTicks64() * 0.001 };
@@ -276,6 +549,12 @@ int main()
             {
                 keyStates[e.key.keysym.sym] = (e.type == SDL_KEYDOWN);
             }
+            else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED && e.window.data1 > 0 && e.window.data2 > 0)
+            {
+                screenWidth = e.window.data1;
+                screenHeight = e.window.data2;
+                outputResized = true;
+            }
         }
 
         // Using operator[] is fine since the state will default to false
@@ -328,24 +607,61 @@ int main()
 
         auto start{ std::chrono::system_clock::now() };
 
+        // Last frame's GPU time picks this frame's render resolution
+        if (frameTimeQueriesPending)
+        {
+            GLuint64 frameStart{};
+            GLuint64 frameEnd{};
+            glGetQueryObjectui64v(frameTimeQueries[0], GL_QUERY_RESULT, &frameStart);
+            glGetQueryObjectui64v(frameTimeQueries[1], GL_QUERY_RESULT, &frameEnd);
+            stats.gpuFrameTime = (frameEnd - frameStart) / 1e6f;
+        }
+
+        // Evaluated separately so the scale still updates on frames where the window was resized
+        bool renderSizeChanged{ dynamicResolutionEnabled ? dynamicResolution.update(stats.gpuFrameTime) : dynamicResolution.setScale(fixedRenderScale) };
+        if (outputResized)
+        {
+            renderSizeChanged = dynamicResolution.setOutputSize(screenWidth, screenHeight) || renderSizeChanged;
+            temporalUpscaler.resize(screenWidth, screenHeight);
+            outputResized = false;
+        }
+
+        if (renderSizeChanged)
+        {
+            renderWidth = dynamicResolution.getRenderWidth();
+            renderHeight = dynamicResolution.getRenderHeight();
+            createRenderTargets(renderWidth, renderHeight);
+        }
+
+        glQueryCounter(frameTimeQueries[0], GL_TIMESTAMP);
+
         const glm::vec3 lightDirection{ glm::normalize(glm::vec3{ -2.0f, 8.0f, 1.0f }) };
-        const glm::mat4 lightView{ glm::lookAt(lightDirection, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
-        const glm::mat4 lightProj{ glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -10.0f, 20.0f) };
-        const glm::mat4 lightProjView{ lightProj * lightView };
 
         glm::mat4 view{ camera.getViewMatrix() };
-        auto proj{ glm::perspective(camera.mFov, 16.0f / 9.0f, camera.mZNear, camera.mZFar) };
-        proj = glm::infinitePerspective(camera.mFov, 16.0f/ 9.0f, camera.mZNear);
-        proj = infiniteReversePerspective(camera.mFov, 16.0f / 9.0f, camera.mZNear);
+        const float aspectRatio{ static_cast<float>(screenWidth) / screenHeight };
+        auto proj{ glm::perspective(camera.mFov, aspectRatio, camera.mZNear, camera.mZFar) };
+        proj = glm::infinitePerspective(camera.mFov, aspectRatio, camera.mZNear);
+        proj = infiniteReversePerspective(camera.mFov, aspectRatio, camera.mZNear);
         auto s{ glm::scale(glm::mat4{ 1.0f }, glm::vec3{ 1.0f }) };
-        auto tp{ proj * view };
+
+        // Only rasterization is jittered. Culling, light binning and reprojection keep the stable projection
+        const glm::vec2 jitter{ temporalUpscaling ? temporalUpscaler.getJitter() : glm::vec2{ 0.0f } };
+        auto tp{ TemporalUpscaler::jitterProjection(proj, jitter, renderWidth, renderHeight) * view };
 
         if (updateViewFrustum)
         {
             hiZView = view;
         }
 
-        glViewport(0, 0, screenWidth, screenHeight);
+        cascadedShadowMap.update(view, proj, camera.mZNear, lightDirection);
+
+        if (proj != lightClustersProj)
+        {
+            lightClusters.setProjection(proj, camera.mZNear);
+            lightClustersProj = proj;
+        }
+
+        glViewport(0, 0, renderWidth, renderHeight);
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
@@ -368,36 +684,329 @@ int main()
             }
         }
         ImGui::Checkbox("update view frustum", &updateViewFrustum);
+        ImGui::Checkbox("bvh culling", &bvhCulling);
+        ImGui::Checkbox("cpu reference culling", &cpuReferenceCulling);
+        if (cpuReferenceCulling)
+        {
+            ImGui::Text("cpu bvh cull %f ms", stats.cpuBvhCullTime);
+            ImGui::Text("cpu flat cull %f ms", stats.cpuFlatCullTime);
+            ImGui::Text("cpu visible clusters %d / %d", stats.cpuVisibleClusters, sceneObject.mClusterCount);
+            ImGui::Text("cpu simd cull %f ms (%f clusters/ns)", stats.cpuSimdCullTime,
+                stats.cpuSimdCullTime > 0.0f ? sceneObject.mClusterCount / (stats.cpuSimdCullTime * 1e6f) : 0.0f);
+            ImGui::Text("cpu scalar cull %f ms (%f clusters/ns)", stats.cpuScalarCullTime,
+                stats.cpuScalarCullTime > 0.0f ? sceneObject.mClusterCount / (stats.cpuScalarCullTime * 1e6f) : 0.0f);
+        }
+        if (hiZMinSampler != 0)
+        {
+            ImGui::Checkbox("hi-z min reduction sampler", &useHiZMinSampler);
+        }
+        if (ImGui::Button("measure hi-z false visible rate"))
+        {
+            captureHiZDepth = true;
+        }
+        if (stats.hiZResults.testedSpheres > 0)
+        {
+            ImGui::Text("hidden clusters %d / %d", stats.hiZResults.hiddenSpheres, stats.hiZResults.testedSpheres);
+            ImGui::Text("hi-z false visible %.1f%% (%d), false occluded %d", stats.hiZResults.getFalseVisibleRate() * 100.0f,
+                stats.hiZResults.falseVisible, stats.hiZResults.falseOccluded);
+            ImGui::Text("old centered test: false visible %.1f%% (%d), false occluded %d",
+                stats.centeredHiZResults.getFalseVisibleRate() * 100.0f, stats.centeredHiZResults.falseVisible,
+                stats.centeredHiZResults.falseOccluded);
+        }
+        ImGui::Checkbox("seed visibility from cpu occlusion", &alwaysSeedVisibility);
+        if (ImGui::Combo("occlusion buffer resolution", &occlusionBufferResolution, "64x36\0" "128x72\0" "256x144\0" "512x288\0"))
+        {
+            sceneObject.mOcclusionBuffer.resize(occlusionBufferResolutions[occlusionBufferResolution][0],
+                occlusionBufferResolutions[occlusionBufferResolution][1]);
+        }
+        if (alwaysSeedVisibility)
+        {
+            ImGui::Text("cpu occlusion raster %f ms", stats.cpuOcclusionRasterTime);
+            ImGui::Text("cpu occlusion cull %f ms", stats.cpuOcclusionCullTime);
+            ImGui::Text("cpu occlusion visible clusters %d / %d", stats.cpuOcclusionVisibleClusters, sceneObject.mClusterCount);
+        }
+        ImGui::Checkbox("visibility buffer", &visibilityBufferMode);
+        ImGui::Checkbox("depth prepass", &depthPrepass);
+        ImGui::Text("gpu opaque pass %f ms (%s)", stats.gpuOpaqueTime, visibilityBufferMode ? "visibility buffer" : "g-buffer");
+        ImGui::Checkbox("per-cluster draw commands", &perClusterDraws);
+        ImGui::Text("gpu culling %f ms (%s)", stats.gpuCullTime, perClusterDraws ? "draw commands" : "index rewrite");
+        ImGui::Checkbox("read back culling output (stalls)", &readBackCullOutput);
+        if (readBackCullOutput)
+        {
+            ImGui::Text("gpu visible clusters %d / %d (%.1f%%)", stats.gpuVisibleClusters, sceneObject.mClusterCount,
+                sceneObject.mClusterCount > 0 ? 100.0f * stats.gpuVisibleClusters / sceneObject.mClusterCount : 0.0f);
+            ImGui::Text("culling output %f MB", stats.cullOutputSize);
+        }
+        ImGui::Checkbox("temporal upscaling", &temporalUpscaling);
+        ImGui::Checkbox("dynamic resolution", &dynamicResolutionEnabled);
+        if (dynamicResolutionEnabled)
+        {
+            ImGui::SliderFloat("target gpu frame time (ms)", &dynamicResolution.mTargetFrameTime, 2.0f, 33.3f);
+        }
+        else
+        {
+            ImGui::SliderFloat("render scale", &fixedRenderScale, dynamicResolution.mMinScale, dynamicResolution.mMaxScale);
+        }
+        ImGui::Text("gpu frame %f ms, rendering at %dx%d (%.0f%%)", stats.gpuFrameTime, renderWidth, renderHeight,
+            dynamicResolution.mScale * 100.0f);
+        ImGui::Text("render targets %.1f MiB (%.1f MiB unaliased, peak %.1f MiB), %d textures for %d targets",
+            renderTargetPool.mAllocatedBytes / 1048576.0f, renderTargetPool.mRequestedBytes / 1048576.0f,
+            renderTargetPool.mPeakBytes / 1048576.0f, renderTargetPool.mTextureCount, renderTargetPool.mRequestCount);
+        ImGui::Combo("transparency", &transparencyMode, "weighted blended\0" "fragment lists\0" "sorted clusters\0");
+        ImGui::Text("gpu transparency %f ms", stats.gpuTransparentTime);
+        if (transparencyMode == fragmentListOit)
+        {
+            ImGui::Checkbox("read back fragment count (stalls)", &readBackFragmentCount);
+            if (readBackFragmentCount)
+            {
+                ImGui::Text("transparent fragments %u / %u (%u dropped)", stats.transparentFragments, fragmentLists->mNodeCapacity,
+                    stats.transparentFragments - std::min(stats.transparentFragments, fragmentLists->mNodeCapacity));
+            }
+        }
+        if (ImGui::Combo("point lights", &lightCountIndex, "0\0" "10\0" "100\0" "1000\0" "10000\0"))
+        {
+            lightClusters.setLights(LightGrid::generateRandomLights(lightCounts[lightCountIndex], sceneBoundingSphere));
+        }
+        ImGui::Text("gpu light cull %f ms", stats.gpuLightCullTime);
+        ImGui::Text("froxels dropping lights %d / %d", stats.gpuOverflowingFroxels, LightGrid::froxelCount);
+        ImGui::Checkbox("cpu reference light binning", &cpuReferenceLightBinning);
+        if (cpuReferenceLightBinning)
+        {
+            ImGui::Text("cpu light binning %f ms", stats.cpuLightBinTime);
+            ImGui::Text("froxels differing from gpu %d / %d", stats.lightBinMismatches, LightGrid::froxelCount);
+            ImGui::Text("average lights per froxel %f", stats.averageFroxelLights);
+            ImGui::Text("cpu froxels dropping lights %d / %d", stats.cpuOverflowingFroxels, LightGrid::froxelCount);
+        }
+        if (ImGui::Button("measure job system scaling"))
+        {
+            measureJobScaling = true;
+        }
+        for (std::size_t i{ 0 }; i < stats.jobScalingTimes.size(); ++i)
+        {
+            ImGui::Text("%zu threads: cpu culling + light binning %f ms (%.2fx)", i + 1, stats.jobScalingTimes[i],
+                stats.jobScalingTimes[i] > 0.0f ? stats.jobScalingTimes[0] / stats.jobScalingTimes[i] : 0.0f);
+        }
+        if (ImGui::Button("measure mesh codec"))
+        {
+            measureMeshCodec = true;
+        }
+        if (stats.meshCodecResults.groupCount > 0)
+        {
+            const auto& results{ stats.meshCodecResults };
+            ImGui::Text("mesh codec %.1f MiB -> %.1f MiB (%.2fx), %d groups%s", (results.vertexBytes + results.indexBytes) / 1048576.0f,
+                (results.encodedVertexBytes + results.encodedIndexBytes) / 1048576.0f, results.getCompressionRatio(),
+                results.groupCount, results.matches ? "" : ", MISMATCH");
+            ImGui::Text("encode %f ms, decode %f ms on %d threads (%.2f GB/s)", results.encodeTime, results.decodeTime,
+                results.threadCount, results.getDecodeGigabytesPerSecond());
+        }
         ImGui::End();
 
+        if (cpuReferenceCulling)
+        {
+            Camera::Frustum viewFrustum{ camera.getViewFrustum(proj) };
+            std::vector<GLuint> visibleClusters{};
+            visibleClusters.reserve(sceneObject.mClusterCount);
+
+            auto cullStart{ std::chrono::high_resolution_clock::now() };
+            sceneObject.mClusterBvh.cull(viewFrustum, visibleClusters);
+            auto cullEnd{ std::chrono::high_resolution_clock::now() };
+            stats.cpuBvhCullTime = std::chrono::duration_cast<std::chrono::microseconds>(cullEnd - cullStart).count() / 1000.0f;
+            stats.cpuVisibleClusters = static_cast<int>(visibleClusters.size());
+
+            visibleClusters.clear();
+
+            cullStart = std::chrono::high_resolution_clock::now();
+            ClusterBvh::cullFlat(viewFrustum, sceneObject.mClusterBvh.mClusterSpheres, visibleClusters);
+            cullEnd = std::chrono::high_resolution_clock::now();
+            stats.cpuFlatCullTime = std::chrono::duration_cast<std::chrono::microseconds>(cullEnd - cullStart).count() / 1000.0f;
+
+            std::vector<std::uint32_t> visibilityBitmask{};
+
+            cullStart = std::chrono::high_resolution_clock::now();
+            sceneObject.mFrustumCuller.cull(jobSystem, viewFrustum, visibilityBitmask);
+            cullEnd = std::chrono::high_resolution_clock::now();
+            stats.cpuSimdCullTime = std::chrono::duration_cast<std::chrono::nanoseconds>(cullEnd - cullStart).count() / 1e6f;
+
+            cullStart = std::chrono::high_resolution_clock::now();
+            sceneObject.mFrustumCuller.cullScalar(viewFrustum, visibilityBitmask);
+            cullEnd = std::chrono::high_resolution_clock::now();
+            stats.cpuScalarCullTime = std::chrono::duration_cast<std::chrono::nanoseconds>(cullEnd - cullStart).count() / 1e6f;
+        }
+
+        // Same CPU work on a fresh job system per thread count. Uses the occlusion buffer as last rasterized
+        if (measureJobScaling)
         {
-            SceneObject::IndirectDraw indirectDraw{};
-            void* map{ glMapNamedBuffer(sceneObject.mIndirectDrawBuffer, GL_WRITE_ONLY) };
-            std::memcpy(map, &indirectDraw, sizeof(SceneObject::IndirectDraw));
-            glUnmapNamedBuffer(sceneObject.mIndirectDrawBuffer);
+            const Camera::Frustum viewFrustum{ camera.getViewFrustum(proj) };
+            const int maxThreads{ static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+            constexpr int iterations{ 8 };
+
+            stats.jobScalingTimes.clear();
+            for (int threadCount{ 1 }; threadCount <= maxThreads; ++threadCount)
+            {
+                JobSystem benchmarkJobs{ threadCount };
+                std::vector<std::uint32_t> visibilityBitmask{};
+                std::vector<GLuint> froxelLightCounts{};
+                std::vector<GLuint> froxelLightIndices{};
+
+                auto benchmarkStart{ std::chrono::high_resolution_clock::now() };
+                for (int i{ 0 }; i < iterations; ++i)
+                {
+                    sceneObject.mFrustumCuller.cull(benchmarkJobs, viewFrustum, visibilityBitmask);
+                    sceneObject.mOcclusionBuffer.cull(benchmarkJobs, sceneObject.mFrustumCuller, viewFrustum, view, proj,
+                        camera.mZNear, visibilityBitmask);
+                    lightClusters.mGrid.binLights(benchmarkJobs, view, froxelLightCounts, froxelLightIndices);
+                }
+                auto benchmarkEnd{ std::chrono::high_resolution_clock::now() };
+
+                stats.jobScalingTimes.push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(benchmarkEnd - benchmarkStart).count() / 1000.0f / iterations);
+            }
+
+            measureJobScaling = false;
+        }
+
+        if (measureMeshCodec)
+        {
+            stats.meshCodecResults = {};
+            stats.meshCodecResults.matches = true;
+            for (const auto& [name, model] : sceneObject.mModels)
+            {
+                const MeshCodec::BenchmarkResults results{ MeshCodec::benchmark(jobSystem, model.mAsset.mVertices.data(),
+                    sizeof(ModelAsset::Vertex), model.mAsset.mIndices.data(), model.mAsset.mMeshletRanges) };
+
+                stats.meshCodecResults.groupCount += results.groupCount;
+                stats.meshCodecResults.vertexBytes += results.vertexBytes;
+                stats.meshCodecResults.indexBytes += results.indexBytes;
+                stats.meshCodecResults.encodedVertexBytes += results.encodedVertexBytes;
+                stats.meshCodecResults.encodedIndexBytes += results.encodedIndexBytes;
+                stats.meshCodecResults.encodeTime += results.encodeTime;
+                stats.meshCodecResults.decodeTime += results.decodeTime;
+                stats.meshCodecResults.threadCount = results.threadCount;
+                stats.meshCodecResults.matches = stats.meshCodecResults.matches && results.matches;
+            }
+
+            measureMeshCodec = false;
+        }
+
+        {
+            // Last frame's culling results, read before they're reset. Waits for the GPU to finish that frame
+            if (readBackCullOutput)
+            {
+                std::vector<std::uint32_t> visibilityBitmask(sceneObject.mVisibilityBitmaskSize / sizeof(std::uint32_t));
+                glGetNamedBufferSubData(sceneObject.mVisibilityBitmaskSsbo, 0, sceneObject.mVisibilityBitmaskSize, visibilityBitmask.data());
+
+                stats.gpuVisibleClusters = 0;
+                for (auto word : visibilityBitmask)
+                {
+                    stats.gpuVisibleClusters += std::popcount(word);
+                }
+
+                // Only what the opaque & alpha masked streams wrote. Blend clusters are rewritten in both modes
+                std::size_t outputSize{ 0 };
+                if (culledWithPerClusterDraws)
+                {
+                    SceneObject::ClusterDrawCounts clusterDrawCounts{};
+                    glGetNamedBufferSubData(sceneObject.mClusterDrawCountBuffer, 0, sizeof(clusterDrawCounts), &clusterDrawCounts);
+                    for (auto count : clusterDrawCounts.counts)
+                    {
+                        outputSize += count * sizeof(SceneObject::IndirectDraw);
+                    }
+                }
+                else
+                {
+                    SceneObject::IndirectDraw indirectDraws[SceneObject::drawCommandCount]{};
+                    glGetNamedBufferSubData(sceneObject.mIndirectDrawBuffer, 0, sizeof(indirectDraws), indirectDraws);
+                    for (const auto& indirectDraw : indirectDraws)
+                    {
+                        outputSize += indirectDraw.count * sizeof(GLuint);
+                    }
+                }
+                stats.cullOutputSize = outputSize / (1024.0f * 1024.0f);
+            }
+
+            if (cullQueriesPending)
+            {
+                GLuint64 occluderTime{};
+                GLuint64 mainTime{};
+                glGetQueryObjectui64v(cullQueries[0], GL_QUERY_RESULT, &occluderTime);
+                glGetQueryObjectui64v(cullQueries[1], GL_QUERY_RESULT, &mainTime);
+                stats.gpuCullTime = (occluderTime + mainTime) / 1e6f;
+            }
+
+            culledWithPerClusterDraws = perClusterDraws;
+
+            if (transparentQueriesPending)
+            {
+                GLuint64 drawTime{};
+                GLuint64 resolveTime{};
+                glGetQueryObjectui64v(transparentQueries[0], GL_QUERY_RESULT, &drawTime);
+                glGetQueryObjectui64v(transparentQueries[1], GL_QUERY_RESULT, &resolveTime);
+                stats.gpuTransparentTime = (drawTime + resolveTime) / 1e6f;
+            }
+
+            // Last frame's, including the fragments that didn't fit
+            if (transparencyMode == fragmentListOit && readBackFragmentCount)
+            {
+                glGetNamedBufferSubData(fragmentLists->mNodeCountSsbo, 0, sizeof(GLuint), &stats.transparentFragments);
+            }
+
+            // Variant of a stream program for the current draw mode
+            auto getStreamProgram{ [&](const std::string& name) {
+                return sceneObject.mShaderPrograms.at(perClusterDraws ? name + "_per_cluster" : name).program;
+                } };
+
+            sceneObject.resetDrawCommands();
 
             if (updateViewFrustum)
             {
                 Camera::Frustum viewFrustum{ camera.getViewFrustum(proj) };
-                map = glMapNamedBuffer(sceneObject.mViewFrustumSsbo, GL_WRITE_ONLY);
+                void* map{ glMapNamedBuffer(sceneObject.mViewFrustumSsbo, GL_WRITE_ONLY) };
                 std::memcpy(map, &viewFrustum, sizeof(Camera::Frustum));
                 glUnmapNamedBuffer(sceneObject.mViewFrustumSsbo);
             }
 
-            glUseProgram(sceneObject.mShaderPrograms.at("occluder_batch").program);
+            if (seedVisibility || alwaysSeedVisibility)
+            {
+                auto seedStart{ std::chrono::high_resolution_clock::now() };
+                sceneObject.mOcclusionBuffer.rasterize(tp);
+                auto seedRasterized{ std::chrono::high_resolution_clock::now() };
+
+                std::vector<std::uint32_t> visibilityBitmask{};
+                sceneObject.mOcclusionBuffer.cull(jobSystem, sceneObject.mFrustumCuller, camera.getViewFrustum(proj), view, proj,
+                    camera.mZNear, visibilityBitmask);
+                auto seedEnd{ std::chrono::high_resolution_clock::now() };
+
+                sceneObject.seedVisibility(visibilityBitmask);
+                seedVisibility = false;
+
+                stats.cpuOcclusionRasterTime = std::chrono::duration_cast<std::chrono::microseconds>(seedRasterized - seedStart).count() / 1000.0f;
+                stats.cpuOcclusionCullTime = std::chrono::duration_cast<std::chrono::microseconds>(seedEnd - seedRasterized).count() / 1000.0f;
+                stats.cpuOcclusionVisibleClusters = 0;
+                for (auto word : visibilityBitmask)
+                {
+                    stats.cpuOcclusionVisibleClusters += std::popcount(word);
+                }
+            }
+
+            sceneObject.resetClusterCulling();
 
-            auto loc{ glGetUniformLocation(sceneObject.mShaderPrograms.at("occluder_batch").program, "clusterCount") };
+            glUseProgram(getStreamProgram("occluder_batch"));
+
+            auto loc{ glGetUniformLocation(getStreamProgram("occluder_batch"), "clusterCount") };
             glUniform1ui(loc, sceneObject.mClusterCount);
 
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mIbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mIndirectDrawBuffer);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mClustersSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mWriteIbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, perClusterDraws ? sceneObject.mClusterDrawBuffer : sceneObject.mWriteIbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, sceneObject.mMaterialsSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, sceneObject.mVisibilityBitmaskSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, sceneObject.mLastVisibilityBitmaskSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, sceneObject.mClusterDrawCountBuffer);
 
+            glBeginQuery(GL_TIME_ELAPSED, cullQueries[0]);
             glDispatchCompute(std::ceil(std::cbrt(sceneObject.mClusterCount)), 
                 std::ceil(std::cbrt(sceneObject.mClusterCount)), std::ceil(std::cbrt(sceneObject.mClusterCount) / 64.0f));
+            glEndQuery(GL_TIME_ELAPSED);
 
             GLsync occluderBatchFence{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE) };
 
@@ -411,27 +1020,127 @@ int main()
             glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            glBindVertexArray(sceneObject.mVao);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mWriteIbo);
-            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mIndirectDrawBuffer);
+            // Both opaque passes draw the same write IBO, so they either both shade (uber) or both write triangle ids
+            const GLuint opaqueTarget{ visibilityBufferMode ? visibilityFBO : opaqueFBO };
+            const bool usePrepass{ depthPrepass && !visibilityBufferMode };
 
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMaterialsSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mVbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mTransformsSsbo);
+            // Each pass draws the opaque stream with early-Z, then the alpha masked stream. With the prepass the
+            // first pass only lays down opaque depth, which is all the Hi-Z needs, and the second pass shades every
+            // opaque pixel once with GL_EQUAL
+            auto drawOpaquePass{ [&](bool isSecondPass) {
+                const int opaqueDraw{ isSecondPass ? SceneObject::opaqueSecondPassDraw : SceneObject::opaqueFirstPassDraw };
+                const int maskedDraw{ isSecondPass ? SceneObject::maskedSecondPassDraw : SceneObject::maskedFirstPassDraw };
 
-            glUseProgram(sceneObject.mShaderPrograms.at("uber").program);
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "transform") };
-            glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(tp));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "view") };
-            glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "camPos") };
-            glUniform3fv(loc, 1, glm::value_ptr(camera.mPos));
+                // Draw commands (and the write IBO) come from the culling shaders
+                glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+
+                if (perClusterDraws)
+                {
+                    glBindVertexArray(sceneObject.mClusterDrawVao);
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mClusterDrawBuffer);
+                    glBindBuffer(GL_PARAMETER_BUFFER, sceneObject.mClusterDrawCountBuffer);
+                }
+                else
+                {
+                    glBindVertexArray(sceneObject.mVao);
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mWriteIbo);
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mIndirectDrawBuffer);
+                }
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMaterialsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mVbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mTransformsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, sceneObject.mIndirectDrawBuffer);
+
+                auto useOpaqueProgram{ [&](const char* name, int drawCommand) {
+                    const GLuint program{ getStreamProgram(name) };
+                    glUseProgram(program);
+                    glUniformMatrix4fv(glGetUniformLocation(program, "transform"), 1, GL_FALSE, glm::value_ptr(tp));
+                    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+                    glUniform3fv(glGetUniformLocation(program, "camPos"), 1, glm::value_ptr(camera.mPos));
+                    glUniform1ui(glGetUniformLocation(program, "drawCommand"), drawCommand);
+                    } };
+
+                auto getCommandOffset{ [](int drawCommand) {
+                    return reinterpret_cast<const void*>(drawCommand * sizeof(SceneObject::IndirectDraw));
+                    } };
+
+                // Index rewrite draws one command. Per cluster draws read the GPU written count of the command's region
+                auto drawStream{ [&](int drawCommand) {
+                    if (perClusterDraws)
+                    {
+                        // mIbo holds the packed meshlet indices, which GL reads natively as unsigned bytes
+                        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_BYTE,
+                            getCommandOffset(sceneObject.mClusterDrawFirsts[drawCommand]), drawCommand * sizeof(GLuint),
+                            sceneObject.mClusterDrawCapacities[drawCommand], 0);
+                    }
+                    else
+                    {
+                        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, getCommandOffset(drawCommand));
+                    }
+                    } };
+
+                if (usePrepass)
+                {
+                    useOpaqueProgram("depth_prepass", opaqueDraw);
+                    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                    drawStream(opaqueDraw);
+                    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+                    if (isSecondPass)
+                    {
+                        // Both opaque commands are adjacent, so one multi-draw shades the clusters of both passes.
+                        // Per cluster draws keep the passes in separate regions and need a draw each
+                        useOpaqueProgram("uber", opaqueDraw);
+                        glDepthFunc(GL_EQUAL);
+                        glDepthMask(GL_FALSE);
+                        if (perClusterDraws)
+                        {
+                            drawStream(SceneObject::opaqueFirstPassDraw);
+                            drawStream(SceneObject::opaqueSecondPassDraw);
+                        }
+                        else
+                        {
+                            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                getCommandOffset(SceneObject::opaqueFirstPassDraw), 2, 0);
+                        }
+                        glDepthFunc(GL_GREATER);
+                        glDepthMask(GL_TRUE);
+                    }
+                }
+                else
+                {
+                    useOpaqueProgram(visibilityBufferMode ? "visibility" : "uber", opaqueDraw);
+                    drawStream(opaqueDraw);
+                }
+
+                useOpaqueProgram(visibilityBufferMode ? "visibility_masked" : "uber_masked", maskedDraw);
+                drawStream(maskedDraw);
+                } };
+
+            if (visibilityBufferMode)
+            {
+                GLuint visibilityClearValue[4]{};
+                glClearNamedFramebufferuiv(visibilityFBO, GL_COLOR, 0, visibilityClearValue);
+                glBindFramebuffer(GL_FRAMEBUFFER, visibilityFBO);
+            }
+
+            if (opaqueQueriesPending)
+            {
+                GLuint64 occluderTime{};
+                GLuint64 mainTime{};
+                glGetQueryObjectui64v(opaqueQueries[0], GL_QUERY_RESULT, &occluderTime);
+                glGetQueryObjectui64v(opaqueQueries[1], GL_QUERY_RESULT, &mainTime);
+                stats.gpuOpaqueTime = (occluderTime + mainTime) / 1e6f;
+            }
 
             glWaitSync(occluderBatchFence, GL_NONE, GL_TIMEOUT_IGNORED);
             glDeleteSync(occluderBatchFence);
 
-            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+            glBeginQuery(GL_TIME_ELAPSED, opaqueQueries[0]);
+            drawOpaquePass(false);
+            glEndQuery(GL_TIME_ELAPSED);
 
             if (updateViewFrustum)
             {
@@ -439,19 +1148,19 @@ int main()
 
                 glCopyImageSubData(depthTexture, GL_TEXTURE_2D, 0, 0, 0, 0,
                     hiZTexture, GL_TEXTURE_2D, 0, 0, 0, 0,
-                    screenWidth, screenHeight, 1);
+                    renderWidth, renderHeight, 1);
 
                 GLsync occluderDrawFence{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE) };
 
                 glUseProgram(sceneObject.mShaderPrograms.at("depth_downsample").program);
 
-                int hiZWidth{ screenWidth };
-                int hiZHeight{ screenHeight };
+                int hiZWidth{ renderWidth };
+                int hiZHeight{ renderHeight };
 
                 glWaitSync(occluderDrawFence, GL_NONE, GL_TIMEOUT_IGNORED);
                 glDeleteSync(occluderDrawFence);
 
-                for (int i{ 0 }; i < std::floor(std::log2(std::max(screenWidth, screenHeight))); ++i)
+                for (int i{ 0 }; i < std::floor(std::log2(std::max(renderWidth, renderHeight))); ++i)
                 {
                     glBindImageTexture(0, hiZTexture, i, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
                     glBindImageTexture(1, hiZTexture, i + 1, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
@@ -473,47 +1182,110 @@ int main()
             }
 
             // todo: cleanup glViewport, glEnable
-            glViewport(0, 0, screenWidth, screenHeight);
+            glViewport(0, 0, renderWidth, renderHeight);
+
+            glBeginQuery(GL_TIME_ELAPSED, cullQueries[1]);
+
+            const bool useBvh{ bvhCulling && sceneObject.mBvhLevelCount > 0 };
+            if (useBvh)
+            {
+                glUseProgram(sceneObject.mShaderPrograms.at("bvh_cull").program);
+
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "levelCount");
+                glUniform1ui(loc, sceneObject.mBvhLevelCount);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "projectionMatrix");
+                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(proj));
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "zNear");
+                glUniform1f(loc, camera.mZNear);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "viewMatrix");
+                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(hiZView));
+
+                glBindTextureUnit(0, hiZTexture);
+                glBindSampler(0, useHiZMinSampler ? hiZMinSampler : 0);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "hiZ");
+                glUniform1i(loc, 0);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "minReductionSampler");
+                glUniform1i(loc, useHiZMinSampler);
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mBvhNodesSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mBvhQueueSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mBvhClusterIndicesSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mCandidateClustersSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, sceneObject.mViewFrustumSsbo);
+
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, sceneObject.mBvhQueueSsbo);
+
+                glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("bvh_cull").program, "level");
+                for (GLuint level{ 0 }; level < sceneObject.mBvhLevelCount; ++level)
+                {
+                    glUniform1ui(loc, level);
 
-            map = glMapNamedBuffer(sceneObject.mIndirectDrawBuffer, GL_WRITE_ONLY);
-            std::memcpy(map, &indirectDraw, sizeof(SceneObject::IndirectDraw));
-            glUnmapNamedBuffer(sceneObject.mIndirectDrawBuffer);
+                    // Each level's dispatch size was written by the previous level
+                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+                    glDispatchComputeIndirect(level * sizeof(SceneObject::DispatchIndirect));
+                }
 
-            map = glMapNamedBuffer(sceneObject.mIndirectBlendDrawBuffer, GL_WRITE_ONLY);
-            std::memcpy(map, &indirectDraw, sizeof(SceneObject::IndirectDraw));
-            glUnmapNamedBuffer(sceneObject.mIndirectBlendDrawBuffer);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+            }
 
-            glUseProgram(sceneObject.mShaderPrograms.at("cluster_batch").program);
+            glUseProgram(getStreamProgram("cluster_batch"));
 
-            loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("cluster_batch").program, "clusterCount");
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "clusterCount");
             glUniform1ui(loc, sceneObject.mClusterCount);
-            loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("cluster_batch").program, "projectionMatrix");
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "useCandidateList");
+            glUniform1i(loc, useBvh);
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "projectionMatrix");
             glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(proj));
-            loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("cluster_batch").program, "zNear");
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "zNear");
             glUniform1f(loc, camera.mZNear);
-            loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("cluster_batch").program, "viewMatrix");
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "viewMatrix");
             glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(hiZView));
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "sortBlendClusters");
+            glUniform1i(loc, transparencyMode == sortedClusterBlending);
 
             glBindTextureUnit(0, hiZTexture);
-            loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("cluster_batch").program, "hiZ");
+            glBindSampler(0, useHiZMinSampler ? hiZMinSampler : 0);
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "hiZ");
             glUniform1i(loc, 0);
+            loc = glGetUniformLocation(getStreamProgram("cluster_batch"), "minReductionSampler");
+            glUniform1i(loc, useHiZMinSampler);
 
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mIbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mIndirectDrawBuffer);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mClustersSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mWriteIbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, perClusterDraws ? sceneObject.mClusterDrawBuffer : sceneObject.mWriteIbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, sceneObject.mIndirectBlendDrawBuffer);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, sceneObject.mWriteBlendIbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, sceneObject.mMaterialsSsbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, sceneObject.mViewFrustumSsbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, sceneObject.mTransformsSsbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, sceneObject.mVisibilityBitmaskSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, sceneObject.mLastVisibilityBitmaskSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, sceneObject.mCandidateClustersSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, sceneObject.mClusterDrawCountBuffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, sceneObject.mBlendSortSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, sceneObject.mTransformScalesSsbo);
             
             // todo: is this fine?
             glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 
-            glDispatchCompute(std::ceil(std::cbrt(sceneObject.mClusterCount)),
-                std::ceil(std::cbrt(sceneObject.mClusterCount)), std::ceil(std::cbrt(sceneObject.mClusterCount) / 64.0f));
+            if (useBvh)
+            {
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, sceneObject.mCandidateClustersSsbo);
+                glDispatchComputeIndirect(0);
+            }
+            else
+            {
+                glDispatchCompute(std::ceil(std::cbrt(sceneObject.mClusterCount)),
+                    std::ceil(std::cbrt(sceneObject.mClusterCount)), std::ceil(std::cbrt(sceneObject.mClusterCount) / 64.0f));
+            }
+
+            glBindSampler(0, 0);
+
+            glEndQuery(GL_TIME_ELAPSED);
+            cullQueriesPending = true;
 
             GLsync clusterBatchFence{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE) };
 
@@ -522,34 +1294,156 @@ int main()
             glDepthMask(GL_TRUE);
             glDisable(GL_BLEND);
 
-            glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+            glBindFramebuffer(GL_FRAMEBUFFER, opaqueTarget);
+
+            glWaitSync(clusterBatchFence, GL_NONE, GL_TIMEOUT_IGNORED);
+            glDeleteSync(clusterBatchFence);
 
-            glBindVertexArray(sceneObject.mVao);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mWriteIbo);
-            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mIndirectDrawBuffer);
+            glBeginQuery(GL_TIME_ELAPSED, opaqueQueries[1]);
 
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMaterialsSsbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mVbo);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mTransformsSsbo);
+            drawOpaquePass(true);
 
-            glUseProgram(sceneObject.mShaderPrograms.at("uber").program);
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "transform") };
-            glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(tp));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "view") };
-            glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("uber").program, "camPos") };
-            glUniform3fv(loc, 1, glm::value_ptr(camera.mPos));
+            // Visibility buffer material pass: shade every covered pixel exactly once into the same targets uber.frag writes
+            if (visibilityBufferMode)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, opaqueFBO);
+                glDisable(GL_DEPTH_TEST);
+                glDepthMask(GL_FALSE);
 
-            glWaitSync(clusterBatchFence, GL_NONE, GL_TIMEOUT_IGNORED);
-            glDeleteSync(clusterBatchFence);
+                const GLuint resolveProgram{ getStreamProgram("visibility_resolve") };
+                glUseProgram(resolveProgram);
+                loc = { glGetUniformLocation(resolveProgram, "transform") };
+                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(tp));
+
+                glBindTextureUnit(0, visibilityTexture);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, perClusterDraws ? sceneObject.mIbo : sceneObject.mWriteIbo);
+
+                glBindVertexArray(screenQuadVAO);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+
+                glEnable(GL_DEPTH_TEST);
+                glDepthMask(GL_TRUE);
+            }
+
+            glEndQuery(GL_TIME_ELAPSED);
+            opaqueQueriesPending = true;
+
+            // Shadow cascades. All cascades are culled in one pass over the clusters, each one only draws the casters it covers
+            {
+                Camera::Frustum viewFrustums[SceneObject::maxMultiViews]{};
+                int viewCount{ 0 };
+                for (int i{ 0 }; i < cascadedShadowMap.mCascadeCount; ++i)
+                {
+                    viewFrustums[viewCount++] = cascadedShadowMap.mCascades[i].frustum;
+                }
+                sceneObject.resetMultiViewCulling(viewFrustums, viewCount);
 
-            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+                glUseProgram(sceneObject.mShaderPrograms.at("view_batch").program);
+
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("view_batch").program, "clusterCount");
+                glUniform1ui(loc, sceneObject.mClusterCount);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("view_batch").program, "viewCount");
+                glUniform1ui(loc, viewCount);
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mIbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMultiViewIndirectDrawBuffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mClustersSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mMultiViewWriteIbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, sceneObject.mMaterialsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, sceneObject.mMultiViewFrustumsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, sceneObject.mTransformsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, sceneObject.mTransformScalesSsbo);
+
+                glDispatchCompute(std::ceil(std::cbrt(sceneObject.mClusterCount)),
+                    std::ceil(std::cbrt(sceneObject.mClusterCount)), std::ceil(std::cbrt(sceneObject.mClusterCount) / 64.0f));
+
+                glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+
+                glViewport(0, 0, cascadedShadowMap.mResolution, cascadedShadowMap.mResolution);
+                glEnable(GL_DEPTH_CLAMP);
+                glDepthFunc(GL_LESS);
+                glClearDepth(1.0f);
+
+                glBindFramebuffer(GL_FRAMEBUFFER, cascadedShadowMap.mFbo);
+
+                glBindVertexArray(sceneObject.mMultiViewVao);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mMultiViewWriteIbo);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mMultiViewIndirectDrawBuffer);
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMaterialsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mVbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mTransformsSsbo);
+
+                glUseProgram(sceneObject.mShaderPrograms.at("shadow").program);
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("shadow").program, "transform");
+
+                for (int i{ 0 }; i < cascadedShadowMap.mCascadeCount; ++i)
+                {
+                    glNamedFramebufferTextureLayer(cascadedShadowMap.mFbo, GL_DEPTH_ATTACHMENT, cascadedShadowMap.mTexture, 0, i);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+
+                    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(cascadedShadowMap.mCascades[i].viewProj));
+                    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                        reinterpret_cast<const void*>(i * sizeof(SceneObject::IndirectDraw)));
+                }
+
+                glDisable(GL_DEPTH_CLAMP);
+                glDepthFunc(GL_GREATER);
+                glClearDepth(0.0f);
+                glViewport(0, 0, renderWidth, renderHeight);
+            }
+
+            glBeginQuery(GL_TIME_ELAPSED, transparentQueries[0]);
+
+            if (transparencyMode == sortedClusterBlending)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mBlendSortSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mBlendClusterDrawBuffer);
+
+                // The count is only known on the GPU, so every pass is sized for the capacity and skips what's past the count
+                constexpr GLuint blendSortBlockSize{ 2048 };
+                const GLuint capacity{ sceneObject.mBlendSortCapacity };
+                const GLuint blockCount{ std::max(capacity / blendSortBlockSize, 1u) };
+
+                auto useBlendSortProgram{ [&](const char* name) {
+                    const GLuint program{ sceneObject.mShaderPrograms.at(name).program };
+                    glUseProgram(program);
+                    glUniform1ui(glGetUniformLocation(program, "capacity"), capacity);
+                    return program;
+                } };
+
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                useBlendSortProgram("blend_sort");
+                glDispatchCompute(blockCount, 1, 1);
+
+                // Stages past the block size: a global step for every distance down to the block size, then the rest in
+                // shared memory
+                for (GLuint k{ blendSortBlockSize * 2 }; k <= capacity; k <<= 1)
+                {
+                    const GLuint globalProgram{ useBlendSortProgram("blend_sort_global_merge") };
+                    glUniform1ui(glGetUniformLocation(globalProgram, "k"), k);
+                    for (GLuint j{ k / 2 }; j >= blendSortBlockSize; j >>= 1)
+                    {
+                        glUniform1ui(glGetUniformLocation(globalProgram, "j"), j);
+                        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                        glDispatchCompute(capacity / 2 / 256, 1, 1);
+                    }
+
+                    const GLuint localProgram{ useBlendSortProgram("blend_sort_local_merge") };
+                    glUniform1ui(glGetUniformLocation(localProgram, "k"), k);
+                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                    glDispatchCompute(blockCount, 1, 1);
+                }
+
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                useBlendSortProgram("blend_sort_draws");
+                glDispatchCompute((capacity + 255) / 256, 1, 1);
+                glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+            }
 
             glDepthMask(GL_FALSE);
-            glEnable(GL_BLEND);
-            glBlendFunci(0, GL_ONE, GL_ONE);
-            glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
             glBlendEquation(GL_FUNC_ADD);
 
             float color0[]{ 0.0f, 0.0f, 0.0f, 0.0f };
@@ -558,34 +1452,182 @@ int main()
             glClearNamedFramebufferfv(transparentFBO, GL_COLOR, 0, color0);
             glClearNamedFramebufferfv(transparentFBO, GL_COLOR, 1, color1);
 
-            glUseProgram(sceneObject.mShaderPrograms.at("transparent").program);
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("transparent").program, "transform") };
+            const char* transparentProgramName{ "transparent" };
+            if (transparencyMode == weightedBlendedOit)
+            {
+                glEnable(GL_BLEND);
+                glBlendFunci(0, GL_ONE, GL_ONE);
+                glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+            }
+            else if (transparencyMode == fragmentListOit)
+            {
+                transparentProgramName = "transparent_fragment_lists";
+
+                // Only the lists are written. Depth testing against the opaque depth still applies
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                fragmentLists->reset();
+
+                glBindImageTexture(0, fragmentLists->mHeadTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, fragmentLists->mNodesSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, fragmentLists->mNodeCountSsbo);
+            }
+            else
+            {
+                transparentProgramName = "transparent_sorted";
+
+                glEnable(GL_BLEND);
+                glBlendFunci(0, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glColorMaski(1, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            }
+
+            const GLuint transparentProgram{ sceneObject.mShaderPrograms.at(transparentProgramName).program };
+            glUseProgram(transparentProgram);
+            loc = { glGetUniformLocation(transparentProgram, "transform") };
             glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(tp));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("transparent").program, "view") };
+            loc = { glGetUniformLocation(transparentProgram, "view") };
             glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
-            loc = { glGetUniformLocation(sceneObject.mShaderPrograms.at("transparent").program, "camPos") };
+            loc = { glGetUniformLocation(transparentProgram, "camPos") };
             glUniform3fv(loc, 1, glm::value_ptr(camera.mPos));
+            loc = { glGetUniformLocation(transparentProgram, "nodeCapacity") };
+            glUniform1ui(loc, fragmentLists->mNodeCapacity);
 
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sceneObject.mClustersSsbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sceneObject.mMaterialsSsbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sceneObject.mVbo);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, sceneObject.mTransformsSsbo);
 
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mWriteBlendIbo);
-            glBindVertexArray(sceneObject.mBlendVao);
-            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mIndirectBlendDrawBuffer);
+            if (transparencyMode == sortedClusterBlending)
+            {
+                // Commands are already in back to front order. The draw count is the sort list's count
+                glBindVertexArray(sceneObject.mClusterDrawVao);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mBlendClusterDrawBuffer);
+                glBindBuffer(GL_PARAMETER_BUFFER, sceneObject.mBlendSortSsbo);
+
+                glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_BYTE, nullptr, 0,
+                    std::max(sceneObject.mBlendClusterCount, 1), 0);
+            }
+            else
+            {
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sceneObject.mWriteBlendIbo);
+                glBindVertexArray(sceneObject.mBlendVao);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, sceneObject.mIndirectBlendDrawBuffer);
+
+                glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+            }
+
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+            glEndQuery(GL_TIME_ELAPSED);
 
             glDepthFunc(GL_ALWAYS);
             glDisable(GL_BLEND);
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneColorFBO);
+
+            // Light binning. The timer query & overflow count are read a frame late so they never stall
+            {
+                if (lightCullQueryPending)
+                {
+                    GLuint64 elapsedTime{};
+                    glGetQueryObjectui64v(lightCullQuery, GL_QUERY_RESULT, &elapsedTime);
+                    stats.gpuLightCullTime = elapsedTime / 1e6f;
+
+                    GLuint overflowingFroxels{};
+                    glGetNamedBufferSubData(lightClusters.mLightCullStatsSsbo, 0, sizeof(GLuint), &overflowingFroxels);
+                    stats.gpuOverflowingFroxels = static_cast<int>(overflowingFroxels);
+                }
+                glClearNamedBufferData(lightClusters.mLightCullStatsSsbo, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+                glBeginQuery(GL_TIME_ELAPSED, lightCullQuery);
+
+                glUseProgram(sceneObject.mShaderPrograms.at("light_cull").program);
+
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("light_cull").program, "view");
+                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
+                loc = glGetUniformLocation(sceneObject.mShaderPrograms.at("light_cull").program, "lightCount");
+                glUniform1ui(loc, static_cast<GLuint>(lightClusters.mGrid.mLights.size()));
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightClusters.mLightsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lightClusters.mFroxelBoundsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lightClusters.mFroxelLightCountsSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lightClusters.mFroxelLightIndicesSsbo);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, lightClusters.mLightCullStatsSsbo);
+
+                glDispatchCompute((LightGrid::froxelCount + 63) / 64, 1, 1);
+
+                glEndQuery(GL_TIME_ELAPSED);
+                lightCullQueryPending = true;
+
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+                if (cpuReferenceLightBinning)
+                {
+                    std::vector<GLuint> froxelLightCounts{};
+                    std::vector<GLuint> froxelLightIndices{};
+
+                    auto binStart{ std::chrono::high_resolution_clock::now() };
+                    const std::size_t overflowingFroxels{ lightClusters.mGrid.binLights(jobSystem, view, froxelLightCounts,
+                        froxelLightIndices) };
+                    auto binEnd{ std::chrono::high_resolution_clock::now() };
+                    stats.cpuLightBinTime = std::chrono::duration_cast<std::chrono::microseconds>(binEnd - binStart).count() / 1000.0f;
+
+                    std::vector<GLuint> gpuFroxelLightCounts(LightGrid::froxelCount);
+                    std::vector<GLuint> gpuFroxelLightIndices(froxelLightIndices.size());
+                    glGetNamedBufferSubData(lightClusters.mFroxelLightCountsSsbo, 0,
+                        gpuFroxelLightCounts.size() * sizeof(GLuint), gpuFroxelLightCounts.data());
+                    glGetNamedBufferSubData(lightClusters.mFroxelLightIndicesSsbo, 0,
+                        gpuFroxelLightIndices.size() * sizeof(GLuint), gpuFroxelLightIndices.data());
+
+                    stats.lightBinMismatches = 0;
+                    std::size_t totalLights{ 0 };
+                    for (int i{ 0 }; i < LightGrid::froxelCount; ++i)
+                    {
+                        totalLights += froxelLightCounts[i];
+
+                        auto first{ froxelLightIndices.cbegin() + static_cast<std::ptrdiff_t>(i) * LightGrid::maxLightsPerFroxel };
+                        auto gpuFirst{ gpuFroxelLightIndices.cbegin() + static_cast<std::ptrdiff_t>(i) * LightGrid::maxLightsPerFroxel };
+                        if (froxelLightCounts[i] != gpuFroxelLightCounts[i] || !std::equal(first, first + froxelLightCounts[i], gpuFirst))
+                        {
+                            ++stats.lightBinMismatches;
+                        }
+                    }
+                    stats.averageFroxelLights = static_cast<float>(totalLights) / LightGrid::froxelCount;
+                    stats.cpuOverflowingFroxels = static_cast<int>(overflowingFroxels);
+                }
+            }
 
             glUseProgram(sceneObject.mShaderPrograms.at("lighting").program);
 
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightClusters.mLightsSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lightClusters.mFroxelLightCountsSsbo);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lightClusters.mFroxelLightIndicesSsbo);
+
             glBindTextureUnit(0, opaqueTexture);
             glBindTextureUnit(1, normalTexture);
+            glBindTextureUnit(3, depthTexture);
+            glBindTextureUnit(4, cascadedShadowMap.mTexture);
+
+            {
+                glm::mat4 cascadeViewProjs[CascadedShadowMap::maxCascades]{};
+                float cascadeSplits[CascadedShadowMap::maxCascades]{};
+                for (int i{ 0 }; i < cascadedShadowMap.mCascadeCount; ++i)
+                {
+                    cascadeViewProjs[i] = cascadedShadowMap.mCascades[i].viewProj;
+                    cascadeSplits[i] = cascadedShadowMap.mCascades[i].splitDepth;
+                }
+
+                const GLuint program{ sceneObject.mShaderPrograms.at("lighting").program };
+                glm::mat4 inverseViewProj{ glm::inverse(tp) };
+                glUniformMatrix4fv(glGetUniformLocation(program, "inverseViewProj"), 1, GL_FALSE, glm::value_ptr(inverseViewProj));
+                glUniform1f(glGetUniformLocation(program, "zNear"), camera.mZNear);
+                glUniformMatrix4fv(glGetUniformLocation(program, "cascadeViewProjs"), CascadedShadowMap::maxCascades, GL_FALSE,
+                    glm::value_ptr(cascadeViewProjs[0]));
+                glUniform1fv(glGetUniformLocation(program, "cascadeSplits"), CascadedShadowMap::maxCascades, cascadeSplits);
+                glUniform1i(glGetUniformLocation(program, "cascadeCount"), cascadedShadowMap.mCascadeCount);
+
+                glUniform1f(glGetUniformLocation(program, "sliceScale"), lightClusters.mGrid.getSliceScale());
+                glUniform1f(glGetUniformLocation(program, "sliceBias"), lightClusters.mGrid.getSliceBias());
+            }
 
             // temp
             glBindTextureUnit(2, hiZTexture);
@@ -599,14 +1641,90 @@ int main()
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-            glUseProgram(sceneObject.mShaderPrograms.at("comp").program);
+            glBeginQuery(GL_TIME_ELAPSED, transparentQueries[1]);
+
+            if (transparencyMode == fragmentListOit)
+            {
+                glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+                glUseProgram(sceneObject.mShaderPrograms.at("oit_resolve").program);
+
+                glBindImageTexture(0, fragmentLists->mHeadTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, fragmentLists->mNodesSsbo);
+            }
+            else
+            {
+                glUseProgram(sceneObject.mShaderPrograms.at(transparencyMode == sortedClusterBlending ? "comp_sorted" : "comp").program);
 
-            glBindTextureUnit(0, accumTexture);
-            glBindTextureUnit(1, revealTexture);
+                glBindTextureUnit(0, accumTexture);
+                glBindTextureUnit(1, revealTexture);
+            }
 
             glBindVertexArray(screenQuadVAO);
 
             glDrawArrays(GL_TRIANGLES, 0, 6);
+
+            glEndQuery(GL_TIME_ELAPSED);
+            transparentQueriesPending = true;
+
+            glDisable(GL_BLEND);
+            glViewport(0, 0, screenWidth, screenHeight);
+
+            if (temporalUpscaling)
+            {
+                const GLuint program{ sceneObject.mShaderPrograms.at("temporal_upscale").program };
+                glUseProgram(program);
+
+                glm::mat4 inverseViewProj{ glm::inverse(proj * view) };
+                glUniform2fv(glGetUniformLocation(program, "jitter"), 1, glm::value_ptr(jitter));
+                glUniformMatrix4fv(glGetUniformLocation(program, "inverseViewProj"), 1, GL_FALSE, glm::value_ptr(inverseViewProj));
+                glUniformMatrix4fv(glGetUniformLocation(program, "previousViewProj"), 1, GL_FALSE,
+                    glm::value_ptr(temporalUpscaler.mPreviousViewProj));
+                glUniform1i(glGetUniformLocation(program, "historyValid"), temporalUpscaler.mHistoryValid);
+                glUniform1f(glGetUniformLocation(program, "currentFrameWeight"), temporalUpscaler.mCurrentFrameWeight);
+
+                glBindTextureUnit(0, sceneColorTexture);
+                glBindTextureUnit(1, depthTexture);
+                glBindTextureUnit(2, temporalUpscaler.getHistoryTexture());
+
+                glBindFramebuffer(GL_FRAMEBUFFER, temporalUpscaler.getHistoryTargetFbo());
+                glBindVertexArray(screenQuadVAO);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+
+                glBlitNamedFramebuffer(temporalUpscaler.getHistoryTargetFbo(), 0, 0, 0, screenWidth, screenHeight,
+                    0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+                temporalUpscaler.advance(proj * view);
+            }
+            else
+            {
+                glBlitNamedFramebuffer(sceneColorFBO, 0, 0, 0, renderWidth, renderHeight,
+                    0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+                temporalUpscaler.invalidate();
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // Runs both hi-z tests against every pixel of this frame's final depth. Stalls, so only on request
+            if (captureHiZDepth)
+            {
+                std::vector<float> depth(static_cast<std::size_t>(renderWidth) * renderHeight);
+                glGetTextureImage(depthTexture, 0, GL_DEPTH_COMPONENT, GL_FLOAT, static_cast<GLsizei>(depth.size() * sizeof(float)),
+                    depth.data());
+                hiZOcclusion.setDepth(std::move(depth), renderWidth, renderHeight);
+
+                const Camera::Frustum viewFrustum{ camera.getViewFrustum(proj) };
+                stats.hiZResults = hiZOcclusion.measure(jobSystem, sceneObject.mFrustumCuller, viewFrustum, view, proj, camera.mZNear,
+                    HiZOcclusion::Method::conservative);
+                stats.centeredHiZResults = hiZOcclusion.measure(jobSystem, sceneObject.mFrustumCuller, viewFrustum, view, proj, camera.mZNear,
+                    HiZOcclusion::Method::centered);
+
+                captureHiZDepth = false;
+            }
+
+            glQueryCounter(frameTimeQueries[1], GL_TIMESTAMP);
+            frameTimeQueriesPending = true;
         }
 
         ImGui::Render();
@@ -619,22 +1737,21 @@ int main()
         stats.frameTime = elapsed.count() / 1000.0f;
     }
 
+    glDeleteQueries(1, &lightCullQuery);
+    glDeleteQueries(2, opaqueQueries);
+    glDeleteQueries(2, cullQueries);
+    glDeleteQueries(2, transparentQueries);
+    glDeleteQueries(2, frameTimeQueries);
+
+    glDeleteSamplers(1, &hiZMinSampler);
+
     glDeleteFramebuffers(1, &opaqueFBO);
+    glDeleteFramebuffers(1, &visibilityFBO);
     glDeleteFramebuffers(1, &transparentFBO);
-    
-    glDeleteTextures(1, &opaqueTexture);
-    glDeleteTextures(1, &accumTexture);
-    glDeleteTextures(1, &revealTexture);
-    glDeleteTextures(1, &depthTexture);
-
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplSDL2_Shutdown();
-    ImGui::DestroyContext();
-
-    SDL_GL_DeleteContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_QuitSubSystem(SDL_INIT_VIDEO);
-    SDL_Quit();
+    glDeleteFramebuffers(1, &sceneColorFBO);
+
+    glDeleteVertexArrays(1, &screenQuadVAO);
+    glDeleteBuffers(1, &screenQuadVBO);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "image_decoder.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "ktx2_image.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+#include <algorithm> // for min
+#include <cstddef> // for size_t
+#include <cstring> // for memcpy
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <system_error> // for error_code
+#include <vector>
+
+
+
+namespace
+{
+	// Enough for the size in any PNG, most JPEGs and the KTX2 header & level index
+	constexpr std::size_t headerReadSize{ 64 * 1024 };
+
+	std::vector<unsigned char> readFile(const std::filesystem::path& path,
+		std::size_t maxSize = std::numeric_limits<std::size_t>::max())
+	{
+		std::ifstream file{ path, std::ios::binary | std::ios::ate };
+		if (!file)
+		{
+			return {};
+		}
+
+		std::vector<unsigned char> bytes(std::min(static_cast<std::size_t>(file.tellg()), maxSize));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+		return bytes;
+	}
+}
+
+
+
+std::optional<ImageDecoder::Header> ImageDecoder::readHeader(const Source& source)
+{
+	std::vector<unsigned char> file{};
+	const unsigned char* bytes{ source.bytes };
+	std::size_t size{ source.size };
+	std::size_t fileSize{ size };
+	if (!bytes)
+	{
+		std::error_code error{};
+		fileSize = static_cast<std::size_t>(std::filesystem::file_size(source.path, error));
+		file = readFile(source.path, headerReadSize);
+		bytes = file.data();
+		size = file.size();
+	}
+
+	Header header{};
+
+	if (Ktx2Image::hasIdentifier(bytes, size))
+	{
+		header.ktx2 = Ktx2Image::parse(bytes, size, fileSize);
+		if (!header.ktx2)
+		{
+			return std::nullopt;
+		}
+
+		header.width = header.ktx2->mWidth;
+		header.height = header.ktx2->mHeight;
+		header.byteSize = header.ktx2->getUploadSize();
+		return header;
+	}
+
+	// JPEGs can have metadata before the size, so the whole file might be needed
+	int channels{};
+	bool hasHeader{ stbi_info_from_memory(bytes, static_cast<int>(size), &header.width, &header.height, &channels) != 0 };
+	if (!hasHeader && size < fileSize)
+	{
+		file = readFile(source.path);
+		hasHeader = stbi_info_from_memory(file.data(), static_cast<int>(file.size()), &header.width, &header.height, &channels) != 0;
+	}
+
+	if (!hasHeader)
+	{
+		return std::nullopt;
+	}
+
+	header.channels = channels == 2 ? 4 : channels;
+	header.byteSize = static_cast<std::size_t>(header.width) * header.height * header.channels;
+
+	return header;
+}
+
+bool ImageDecoder::decode(const Source& source, const Header& header, unsigned char* destination)
+{
+	if (!destination)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> file{};
+	const unsigned char* bytes{ source.bytes };
+	std::size_t size{ source.size };
+	if (!bytes)
+	{
+		file = readFile(source.path);
+		bytes = file.data();
+		size = file.size();
+	}
+
+	if (header.ktx2)
+	{
+		return header.ktx2->writeLevels(bytes, size, destination);
+	}
+
+	int width{};
+	int height{};
+	int channels{};
+	unsigned char* pixels{ stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &channels, header.channels) };
+	if (!pixels || width != header.width || height != header.height)
+	{
+		stbi_image_free(pixels);
+		return false;
+	}
+
+	std::memcpy(destination, pixels, header.byteSize);
+	stbi_image_free(pixels);
+
+	return true;
+}
+
+ImageDecoder::Stats ImageDecoder::decodeAll(JobSystem& jobSystem, const std::vector<Source>& sources, std::vector<bool>* failed)
+{
+	struct DecodedImage
+	{
+		bool ktx2{ false };
+		bool failed{ false };
+		std::size_t byteSize{};
+	};
+
+	std::vector<DecodedImage> images(sources.size());
+
+	jobSystem.parallelFor(sources.size(), 1, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			std::optional<Header> header{ readHeader(sources[i]) };
+			if (!header)
+			{
+				images[i].failed = true;
+				continue;
+			}
+
+			std::vector<unsigned char> pixels(header->byteSize);
+			images[i].ktx2 = header->ktx2.has_value();
+			images[i].failed = !decode(sources[i], *header, pixels.data());
+			images[i].byteSize = header->byteSize;
+		}
+		});
+
+	Stats stats{};
+	stats.imageCount = static_cast<int>(sources.size());
+	for (const auto& image : images)
+	{
+		stats.failedImages += image.failed;
+		stats.ktx2Images += image.ktx2 && !image.failed;
+		stats.decodedBytes += image.failed ? 0 : image.byteSize;
+	}
+
+	if (failed)
+	{
+		failed->resize(sources.size());
+		for (std::size_t i{ 0 }; i < sources.size(); ++i)
+		{
+			(*failed)[i] = images[i].failed;
+		}
+	}
+
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+#include "ktx2_image.hpp"
+
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// The CPU half of loading a model's images, without GL: PNG, JPEG & the rest are decoded with stb_image, KTX2 levels
+// are copied or transcoded as stored. ImageStreamer runs these on its jobs and uploads the results
+class ImageDecoder final
+{
+public:
+
+	// Either bytes in memory or a file, which is only read while its image is in flight
+	struct Source
+	{
+		const unsigned char* bytes{};
+		std::size_t size{};
+
+		std::filesystem::path path{};
+	};
+
+	struct Header
+	{
+		int width{};
+		int height{};
+		int channels{}; // As stored: 1, 3 or 4. Grey + alpha is rare, and has no compressed format of its own
+
+		std::optional<Ktx2Image> ktx2{};
+
+		// What decode() writes
+		std::size_t byteSize{};
+	};
+
+	struct Stats
+	{
+		int imageCount{};
+		int failedImages{};
+		int ktx2Images{};
+
+		std::size_t decodedBytes{};
+	};
+
+	// Only reads the start of a file, unless it's a JPEG with metadata before the size. Empty if the image can't be
+	// decoded
+	static std::optional<Header> readHeader(const Source& source);
+
+	// Writes header.byteSize bytes to destination: pixels of header.channels bytes, or every KTX2 level packed from
+	// level 0. Can run on any thread
+	static bool decode(const Source& source, const Header& header, unsigned char* destination);
+
+	// Decodes every source on jobSystem into memory that's dropped right away, for measuring decodes without a GL
+	// context. One image per job, so only about a thread's worth of pixels is resident at once
+	static Stats decodeAll(JobSystem& jobSystem, const std::vector<Source>& sources, std::vector<bool>* failed = nullptr);
+};
\ No newline at end of file
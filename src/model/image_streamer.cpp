@@ -0,0 +1,257 @@
+#include "image_streamer.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "image_decoder.hpp"
+
+#include "glad/glad.h"
+
+#include <algorithm> // for any_of, find_if & max
+#include <bit> // for bit_width
+#include <chrono>
+#include <cstddef> // for size_t
+#include <cstdlib> // for malloc & free
+#include <iostream>
+#include <memory> // for unique_ptr
+#include <optional>
+#include <vector>
+
+
+
+ImageStreamer::ImageStreamer(std::size_t stagingSize)
+	: mStagingSize{ stagingSize }
+{
+	constexpr GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+
+	glCreateBuffers(1, &mStagingBuffer);
+	glNamedBufferStorage(mStagingBuffer, mStagingSize, nullptr, flags);
+	mStagingData = static_cast<unsigned char*>(glMapNamedBufferRange(mStagingBuffer, 0, mStagingSize, flags));
+}
+
+ImageStreamer::~ImageStreamer()
+{
+	for (const auto& region : mRegionsInUse)
+	{
+		waitForRegion(region);
+	}
+
+	// Deleting the buffer unmaps it
+	glDeleteBuffers(1, &mStagingBuffer);
+}
+
+std::vector<GLuint> ImageStreamer::load(JobSystem& jobSystem, const std::vector<Source>& sources, std::vector<bool>* failed)
+{
+	struct PendingImage
+	{
+		std::optional<ImageDecoder::Header> header{};
+
+		// Not staged: the decode goes to pixels instead
+		std::optional<std::size_t> stagingOffset{};
+		std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, std::free };
+
+		bool failed{ false };
+		JobSystem::Counter decoded{ 0 };
+	};
+
+	std::vector<PendingImage> images(sources.size());
+
+	// Headers are cheap to read and give every image's decoded size up front
+	jobSystem.parallelFor(sources.size(), 0, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			images[i].header = ImageDecoder::readHeader(sources[i]);
+			images[i].failed = !images[i].header;
+		}
+		});
+
+	GLint unpackAlignment{};
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	std::vector<GLuint> textures(sources.size());
+	std::size_t inFlightBytes{ 0 };
+	std::size_t nextDecode{ 0 };
+	for (std::size_t i{ 0 }; i < sources.size(); ++i)
+	{
+		// Images too big for the ring only start once they're next, so at most one of them is ever in flight
+		while (nextDecode < sources.size())
+		{
+			PendingImage& image{ images[nextDecode] };
+			if (!image.failed)
+			{
+				const std::size_t byteSize{ image.header->byteSize };
+				if (byteSize <= mStagingSize)
+				{
+					image.stagingOffset = allocateStaging(byteSize);
+					if (!image.stagingOffset)
+					{
+						break;
+					}
+				}
+				else if (nextDecode != i)
+				{
+					break;
+				}
+
+				inFlightBytes += byteSize;
+
+				jobSystem.run([&image, &source = sources[nextDecode], stagingData = mStagingData] {
+					if (!image.stagingOffset)
+					{
+						image.pixels = { static_cast<unsigned char*>(std::malloc(image.header->byteSize)), std::free };
+					}
+					unsigned char* destination{ image.stagingOffset ? stagingData + *image.stagingOffset : image.pixels.get() };
+					image.failed = !ImageDecoder::decode(source, *image.header, destination);
+					}, &image.decoded);
+			}
+
+			++nextDecode;
+		}
+		mStats.peakInFlightBytes = std::max(mStats.peakInFlightBytes, inFlightBytes);
+
+		PendingImage& image{ images[i] };
+
+		auto waitStart{ std::chrono::high_resolution_clock::now() };
+		jobSystem.wait(image.decoded);
+		auto uploadStart{ std::chrono::high_resolution_clock::now() };
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &textures[i]);
+
+		// Uploads read from the ring when the image was staged, otherwise from client memory
+		if (image.stagingOffset)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+		}
+		auto source{ [&](std::size_t offset) -> const void* {
+			return image.stagingOffset ? reinterpret_cast<const void*>(*image.stagingOffset + offset) : image.pixels.get() + offset;
+			} };
+
+		if (image.failed)
+		{
+			std::cerr << "Warning: failed to load image " << i << ".\n";
+			++mStats.failedImages;
+
+			const unsigned char white[4]{ 255, 255, 255, 255 };
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glTextureStorage2D(textures[i], 1, GL_RGBA8, 1, 1);
+			glTextureSubImage2D(textures[i], 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		}
+		else if (image.header->ktx2)
+		{
+			const auto& ktx2{ *image.header->ktx2 };
+
+			glTextureStorage2D(textures[i], static_cast<GLsizei>(ktx2.mLevels.size()), ktx2.mInternalFormat, ktx2.mWidth, ktx2.mHeight);
+			for (std::size_t level{ 0 }; level < ktx2.mLevels.size(); ++level)
+			{
+				const auto& levelInfo{ ktx2.mLevels[level] };
+				glCompressedTextureSubImage2D(textures[i], static_cast<GLint>(level), 0, 0, levelInfo.width, levelInfo.height,
+					ktx2.mInternalFormat, static_cast<GLsizei>(levelInfo.uploadSize), source(levelInfo.uploadOffset));
+			}
+
+			if (ktx2.mInternalFormat == GL_COMPRESSED_RED_RGTC1)
+			{
+				const GLint swizzle[4]{ GL_RED, GL_RED, GL_RED, GL_ONE };
+				glTextureParameteriv(textures[i], GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			}
+
+			++mStats.ktx2Images;
+			mStats.decodedBytes += image.header->byteSize;
+		}
+		else
+		{
+			const int width{ image.header->width };
+			const int height{ image.header->height };
+			const int channels{ image.header->channels };
+			const GLenum format{ static_cast<GLenum>(channels == 1 ? GL_RED : channels == 3 ? GL_RGB : GL_RGBA) };
+			const GLenum internalFormat{ static_cast<GLenum>(
+				channels == 4 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT) };
+			const int levels{ static_cast<int>(std::bit_width(static_cast<unsigned>(std::max(width, height)))) };
+
+			glTextureStorage2D(textures[i], levels, internalFormat, width, height);
+
+			if (channels == 1)
+			{
+				const GLint swizzle[4]{ GL_RED, GL_RED, GL_RED, GL_ONE };
+				glTextureParameteriv(textures[i], GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			}
+
+			glTextureSubImage2D(textures[i], 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, source(0));
+			glGenerateTextureMipmap(textures[i]);
+
+			mStats.decodedBytes += image.header->byteSize;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!image.stagingOffset && !image.failed)
+		{
+			++mStats.unstagedImages;
+		}
+		image.pixels.reset();
+
+		// Regions are allocated in image order, so this image's is the oldest one not uploaded from
+		if (image.stagingOffset)
+		{
+			auto region{ std::find_if(mRegionsInUse.begin(), mRegionsInUse.end(), [](const Region& r) { return r.fence == 0; }) };
+			region->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		inFlightBytes -= image.header ? image.header->byteSize : 0;
+
+		auto uploadEnd{ std::chrono::high_resolution_clock::now() };
+		mStats.decodeWaitTime += std::chrono::duration_cast<std::chrono::microseconds>(uploadStart - waitStart).count() / 1000.0f;
+		mStats.uploadTime += std::chrono::duration_cast<std::chrono::microseconds>(uploadEnd - uploadStart).count() / 1000.0f;
+	}
+	mStats.imageCount += static_cast<int>(sources.size());
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+	if (failed)
+	{
+		failed->resize(sources.size());
+		for (std::size_t i{ 0 }; i < sources.size(); ++i)
+		{
+			(*failed)[i] = images[i].failed;
+		}
+	}
+
+	return textures;
+}
+
+std::optional<std::size_t> ImageStreamer::allocateStaging(std::size_t size)
+{
+	// Whatever is left at the end of the ring is skipped rather than splitting an image
+	std::size_t begin{ mStagingHead + size <= mStagingSize ? mStagingHead : 0 };
+	std::size_t end{ begin + size };
+
+	auto overlaps{ [&](const Region& region) { return region.begin < end && begin < region.end; } };
+
+	// Regions are freed oldest first, which is also the order they come up in the ring
+	while (std::any_of(mRegionsInUse.begin(), mRegionsInUse.end(), overlaps))
+	{
+		if (mRegionsInUse.front().fence == 0)
+		{
+			return std::nullopt;
+		}
+
+		waitForRegion(mRegionsInUse.front());
+		mRegionsInUse.pop_front();
+	}
+
+	mRegionsInUse.push_back({ begin, end });
+	mStagingHead = end;
+
+	return begin;
+}
+
+void ImageStreamer::waitForRegion(const Region& region)
+{
+	if (region.fence == 0)
+	{
+		return;
+	}
+
+	if (glClientWaitSync(region.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+	{
+		++mStats.stagingStalls;
+		glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, ~GLuint64{ 0 });
+	}
+	glDeleteSync(region.fence);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+#include "image_decoder.hpp"
+
+#include "glad/glad.h"
+
+#include <cstddef> // for std::size_t
+#include <deque>
+#include <optional>
+#include <vector>
+
+// Decodes encoded images (PNG, JPEG, ...) with ImageDecoder on the job system straight into a persistently mapped
+// staging ring, which the GL thread uploads from in order. A decode only starts once its pixels have room in the ring,
+// so the decoded bytes alive at once are bounded by mStagingSize no matter how many images there are.
+// Pixels keep the image's own channel count instead of being expanded to RGBA: grey images are swizzled on sampling.
+// KTX2 images skip decoding and compression: their BC levels are copied, or transcoded, and uploaded as stored
+class ImageStreamer final
+{
+public:
+
+	using Source = ImageDecoder::Source;
+
+	// Added up over every load()
+	struct Stats
+	{
+		int imageCount{};
+		int failedImages{};
+		int ktx2Images{};
+
+		std::size_t decodedBytes{};
+		std::size_t peakInFlightBytes{};
+
+		// Times the ring had to wait for the GPU to read a region, and images too big for it, which are decoded on
+		// their own into client memory
+		int stagingStalls{};
+		int unstagedImages{};
+
+		float decodeWaitTime{}; // ms the GL thread spent waiting for (and helping with) the next decode
+		float uploadTime{}; // ms, including the driver's compression & mip generation
+	};
+
+	explicit ImageStreamer(std::size_t stagingSize = std::size_t{ 128 } << 20);
+
+	ImageStreamer(const ImageStreamer&) = delete;
+	ImageStreamer& operator=(const ImageStreamer&) = delete;
+
+	// Waits for the GPU to finish reading the ring
+	~ImageStreamer();
+
+	// Creates a mipmapped, compressed texture per source. Sources that fail to load get a 1x1 white texture, and
+	// are flagged in failed if it's given. Must be called on the GL thread
+	std::vector<GLuint> load(JobSystem& jobSystem, const std::vector<Source>& sources, std::vector<bool>* failed = nullptr);
+
+	Stats mStats{};
+
+	const std::size_t mStagingSize{};
+
+private:
+
+	// fence is 0 until the region has been uploaded from
+	struct Region
+	{
+		std::size_t begin{};
+		std::size_t end{};
+		GLsync fence{};
+	};
+
+	// Frees uploaded regions in the way, waiting for the GPU if needed. Empty if a region still waiting to be
+	// uploaded is in the way
+	std::optional<std::size_t> allocateStaging(std::size_t size);
+
+	void waitForRegion(const Region& region);
+
+	GLuint mStagingBuffer{};
+	unsigned char* mStagingData{};
+
+	std::size_t mStagingHead{ 0 };
+	std::deque<Region> mRegionsInUse{};
+};
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "ktx2_image.hpp"
+
+#include "glad/glad.h"
+
+#include <algorithm> // for equal & max
+#include <bit> // for bit_width
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstring> // for memcpy
+#include <iostream>
+#include <iterator> // for begin & end
+#include <optional>
+
+
+
+namespace
+{
+	constexpr unsigned char identifier[12]{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	constexpr std::size_t headerSize{ 80 };
+	constexpr std::size_t levelIndexEntrySize{ 24 };
+
+	constexpr std::uint32_t noSupercompression{ 0 };
+
+	template <typename T>
+	T read(const unsigned char* bytes)
+	{
+		// KTX2 is little endian, like every platform we run on
+		T value{};
+		std::memcpy(&value, bytes, sizeof(T));
+		return value;
+	}
+
+	struct BcFormat
+	{
+		GLenum internalFormat{};
+		bool hasAlpha{};
+	};
+
+	// VK_FORMAT_BC1_RGB_UNORM_BLOCK (131) through VK_FORMAT_BC7_SRGB_BLOCK (146), each UNORM/SRGB or UNORM/SNORM pair
+	// next to each other
+	std::optional<BcFormat> getBcFormat(std::uint32_t vkFormat)
+	{
+		switch (vkFormat)
+		{
+		case 131: case 132: return BcFormat{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT, false };
+		case 133: case 134: return BcFormat{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, true };
+		case 135: case 136: return BcFormat{ GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, true };
+		case 137: case 138: return BcFormat{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, true };
+		case 139: return BcFormat{ GL_COMPRESSED_RED_RGTC1, false };
+		case 140: return BcFormat{ GL_COMPRESSED_SIGNED_RED_RGTC1, false };
+		case 141: return BcFormat{ GL_COMPRESSED_RG_RGTC2, false };
+		case 142: return BcFormat{ GL_COMPRESSED_SIGNED_RG_RGTC2, false };
+		case 143: return BcFormat{ GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, false };
+		case 144: return BcFormat{ GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, false };
+		case 145: case 146: return BcFormat{ GL_COMPRESSED_RGBA_BPTC_UNORM, true };
+		default: return std::nullopt;
+		}
+	}
+
+	std::size_t getBlockSize(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+		case GL_COMPRESSED_SIGNED_RED_RGTC1:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+}
+
+
+
+bool Ktx2Image::hasIdentifier(const unsigned char* bytes, std::size_t size)
+{
+	return size >= sizeof(identifier) && std::equal(std::begin(identifier), std::end(identifier), bytes);
+}
+
+std::optional<Ktx2Image> Ktx2Image::parse(const unsigned char* bytes, std::size_t size, std::size_t fileSize)
+{
+	if (!hasIdentifier(bytes, size) || size < headerSize)
+	{
+		return std::nullopt;
+	}
+
+	const std::uint32_t vkFormat{ read<std::uint32_t>(bytes + 12) };
+	const std::uint32_t width{ read<std::uint32_t>(bytes + 20) };
+	const std::uint32_t height{ read<std::uint32_t>(bytes + 24) };
+	const std::uint32_t depth{ read<std::uint32_t>(bytes + 28) };
+	const std::uint32_t layerCount{ read<std::uint32_t>(bytes + 32) };
+	const std::uint32_t faceCount{ read<std::uint32_t>(bytes + 36) };
+	const std::uint32_t levelCount{ std::max(read<std::uint32_t>(bytes + 40), 1u) };
+	const std::uint32_t supercompression{ read<std::uint32_t>(bytes + 44) };
+
+	const std::uint32_t dfdOffset{ read<std::uint32_t>(bytes + 48) };
+	const std::uint32_t dfdSize{ read<std::uint32_t>(bytes + 52) };
+
+	if (width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1
+		|| levelCount > static_cast<std::uint32_t>(std::bit_width(std::max(width, height))))
+	{
+		std::cerr << "Warning: KTX2 image isn't a single 2D texture.\n";
+		return std::nullopt;
+	}
+
+	if (headerSize + levelCount * levelIndexEntrySize > size || static_cast<std::size_t>(dfdOffset) + dfdSize > size)
+	{
+		return std::nullopt;
+	}
+
+	Ktx2Image image{};
+	image.mWidth = static_cast<int>(width);
+	image.mHeight = static_cast<int>(height);
+
+	const auto bcFormat{ getBcFormat(vkFormat) };
+	if (!bcFormat)
+	{
+		// Basis Universal leaves the format undefined. Transcoding it is out of scope
+		std::cerr << "Warning: unsupported KTX2 format " << vkFormat << (vkFormat == 0 ? " (Basis Universal)" : "") << ".\n";
+		return std::nullopt;
+	}
+
+	if (supercompression != noSupercompression)
+	{
+		std::cerr << "Warning: supercompressed KTX2 payloads aren't supported.\n";
+		return std::nullopt;
+	}
+
+	image.mInternalFormat = bcFormat->internalFormat;
+	image.mHasAlpha = bcFormat->hasAlpha;
+
+	const std::size_t blockSize{ getBlockSize(image.mInternalFormat) };
+
+	std::size_t uploadOffset{ 0 };
+	for (std::uint32_t i{ 0 }; i < levelCount; ++i)
+	{
+		const unsigned char* entry{ bytes + headerSize + i * levelIndexEntrySize };
+
+		Level level{};
+		level.width = std::max(image.mWidth >> i, 1);
+		level.height = std::max(image.mHeight >> i, 1);
+		level.fileOffset = static_cast<std::size_t>(read<std::uint64_t>(entry));
+		level.fileSize = static_cast<std::size_t>(read<std::uint64_t>(entry + 8));
+		level.uploadOffset = uploadOffset;
+		level.uploadSize = static_cast<std::size_t>((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize;
+
+		if (level.fileOffset > fileSize || level.fileSize > fileSize - level.fileOffset || level.fileSize != level.uploadSize)
+		{
+			std::cerr << "Warning: KTX2 level " << i << " is out of bounds or the wrong size.\n";
+			return std::nullopt;
+		}
+
+		uploadOffset += level.uploadSize;
+		image.mLevels.push_back(level);
+	}
+
+	return image;
+}
+
+std::size_t Ktx2Image::getUploadSize() const
+{
+	return mLevels.empty() ? 0 : mLevels.back().uploadOffset + mLevels.back().uploadSize;
+}
+
+bool Ktx2Image::writeLevels(const unsigned char* bytes, std::size_t size, unsigned char* destination) const
+{
+	for (const auto& level : mLevels)
+	{
+		if (level.fileOffset > size || level.fileSize > size - level.fileOffset)
+		{
+			return false;
+		}
+		std::memcpy(destination + level.uploadOffset, bytes + level.fileOffset, level.uploadSize);
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef> // for std::size_t
+#include <optional>
+#include <vector>
+
+// The parts of a KTX2 container needed to upload a 2D texture with its mip chain as stored. Only raw BC payloads
+// are supported, and they are uploaded as they are. Basis Universal (ETC1S or UASTC) images fail to parse, and the
+// texture falls back to its plain image. KHR_texture_basisu textures without one are drawn white.
+// todo: transcode ETC1S & UASTC to BC7/BC1 with the basisu transcoder, vendored into third_party. Tracked as its own
+// follow-up to the KTX2 work, which so far only covers raw BC
+class Ktx2Image final
+{
+public:
+
+	struct Level
+	{
+		int width{};
+		int height{};
+
+		// Where the level is in the file
+		std::size_t fileOffset{};
+		std::size_t fileSize{};
+
+		// Where it goes in the buffer written by writeLevels()
+		std::size_t uploadOffset{};
+		std::size_t uploadSize{};
+	};
+
+	static bool hasIdentifier(const unsigned char* bytes, std::size_t size);
+
+	// bytes only needs to hold the start of the file, up to the end of the data format descriptor. Empty if the
+	// container is broken or isn't a single 2D image in a format we can upload
+	static std::optional<Ktx2Image> parse(const unsigned char* bytes, std::size_t size, std::size_t fileSize);
+
+	// All levels, packed from level 0
+	std::size_t getUploadSize() const;
+
+	// Copies every level of the whole file to destination. Can run on any thread
+	bool writeLevels(const unsigned char* bytes, std::size_t size, unsigned char* destination) const;
+
+	int mWidth{};
+	int mHeight{};
+
+	// sRGB formats are uploaded as UNORM, the same as decoded images, since shading doesn't linearize either
+	GLenum mInternalFormat{};
+	bool mHasAlpha{ false };
+
+	std::vector<Level> mLevels{};
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "load_arena.hpp"
+
+#include <algorithm> // for max
+#include <cstddef> // for size_t
+#include <memory> // for make_unique() & unique_ptr
+#include <memory_resource>
+#include <mutex>
+#include <new> // for bad_alloc
+
+
+
+namespace
+{
+	// Overflow blocks never get smaller than this, so a run of small allocations past the capacity stays cheap
+	constexpr std::size_t minimumOverflowBlockSize{ 64 * 1024 };
+}
+
+
+
+LoadArena::LoadArena(std::size_t capacity)
+	: mBuffer{ capacity > 0 ? std::make_unique_for_overwrite<std::byte[]>(capacity) : nullptr }
+	, mCapacity{ capacity }
+{
+}
+
+void LoadArena::reset()
+{
+	if (!mOverflowBlocks.empty())
+	{
+		mCapacity = mUsed + mOverflowBytes;
+		mBuffer = std::make_unique_for_overwrite<std::byte[]>(mCapacity);
+
+		mOverflowBlocks.clear();
+		mOverflowBlockSize = 0;
+		mOverflowBlockUsed = 0;
+		mOverflowBytes = 0;
+	}
+
+	mUsed = 0;
+}
+
+std::size_t LoadArena::getUsedBytes() const
+{
+	return mUsed + mOverflowBytes;
+}
+
+std::size_t LoadArena::getCapacity() const
+{
+	return mCapacity;
+}
+
+void* LoadArena::do_allocate(std::size_t bytes, std::size_t requestedAlignment)
+{
+	if (requestedAlignment > alignment)
+	{
+		throw std::bad_alloc{};
+	}
+
+	bytes = (std::max<std::size_t>(bytes, 1) + alignment - 1) / alignment * alignment;
+
+	// Blocks come from new[], so they start aligned to max_align_t and every size is a multiple of it
+	if (mOverflowBlocks.empty() && bytes <= mCapacity - mUsed)
+	{
+		void* pointer{ mBuffer.get() + mUsed };
+		mUsed += bytes;
+
+		return pointer;
+	}
+
+	if (mOverflowBlocks.empty() || bytes > mOverflowBlockSize - mOverflowBlockUsed)
+	{
+		mOverflowBlockSize = std::max({ bytes, mOverflowBlockSize * 2, mCapacity, minimumOverflowBlockSize });
+		mOverflowBlockUsed = 0;
+		mOverflowBlocks.push_back(std::make_unique_for_overwrite<std::byte[]>(mOverflowBlockSize));
+	}
+
+	void* pointer{ mOverflowBlocks.back().get() + mOverflowBlockUsed };
+	mOverflowBlockUsed += bytes;
+	mOverflowBytes += bytes;
+
+	return pointer;
+}
+
+void LoadArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+	// Everything goes at once in reset()
+}
+
+bool LoadArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+
+
+LoadArena& LoadArenaPool::acquire()
+{
+	std::lock_guard lock{ mMutex };
+
+	if (mFreeArenas.empty())
+	{
+		return *mArenas.emplace_back(std::make_unique<LoadArena>());
+	}
+
+	LoadArena* arena{ mFreeArenas.back() };
+	mFreeArenas.pop_back();
+
+	return *arena;
+}
+
+void LoadArenaPool::release(LoadArena& arena)
+{
+	arena.reset();
+
+	std::lock_guard lock{ mMutex };
+	mFreeArenas.push_back(&arena);
+}
\ No newline at end of file
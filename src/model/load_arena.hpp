@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <memory> // for unique_ptr & uninitialized_default_construct_n()
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for the temporaries of a load. Nothing is freed one by one: reset() drops every allocation at once and
+// keeps the memory, so one arena serves primitive after primitive without going back to the heap. Whatever doesn't fit
+// goes into overflow blocks, which the next reset() folds into a single buffer of the size that was needed.
+// Works as a std::pmr::memory_resource, so pmr containers can live in it. Not thread safe, see LoadArenaPool
+class LoadArena final : public std::pmr::memory_resource
+{
+public:
+
+	// Every allocation is aligned to this and rounded up to a multiple of it
+	static constexpr std::size_t alignment{ alignof(std::max_align_t) };
+
+	// Size an array of count Ts takes in an arena, for adding up a capacity up front
+	template <typename T>
+	static constexpr std::size_t getArraySize(std::size_t count)
+	{
+		return (count * sizeof(T) + alignment - 1) / alignment * alignment;
+	}
+
+	// Reserving the sum of getArraySize() of everything that will be allocated makes the arena a single allocation
+	explicit LoadArena(std::size_t capacity = 0);
+
+	LoadArena(const LoadArena&) = delete;
+	LoadArena& operator=(const LoadArena&) = delete;
+
+	// Default constructed, so scalars are left uninitialized
+	template <typename T>
+	std::span<T> allocateArray(std::size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena memory is dropped without running destructors");
+		static_assert(alignof(T) <= alignment);
+
+		T* data{ static_cast<T*>(allocate(getArraySize<T>(count), alignof(T))) };
+		std::uninitialized_default_construct_n(data, count);
+
+		return { data, count };
+	}
+
+	void reset();
+
+	// Bytes allocated since the last reset()
+	std::size_t getUsedBytes() const;
+	std::size_t getCapacity() const;
+
+private:
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	std::unique_ptr<std::byte[]> mBuffer{};
+	std::size_t mCapacity{ 0 };
+	std::size_t mUsed{ 0 };
+
+	std::vector<std::unique_ptr<std::byte[]>> mOverflowBlocks{};
+	std::size_t mOverflowBlockSize{ 0 };
+	std::size_t mOverflowBlockUsed{ 0 };
+	std::size_t mOverflowBytes{ 0 };
+};
+
+// Scratch arenas for jobs running at once. A job takes one for as long as it runs, so there are never more arenas than
+// jobs that ran at the same time, and each one is reused by the jobs after it
+class LoadArenaPool final
+{
+public:
+
+	LoadArena& acquire();
+	void release(LoadArena& arena);
+
+private:
+
+	std::mutex mMutex{};
+	std::vector<std::unique_ptr<LoadArena>> mArenas{};
+	std::vector<LoadArena*> mFreeArenas{};
+};
\ No newline at end of file
@@ -0,0 +1,1228 @@
+#include "mesh_codec.hpp"
+
+#include "../jobs/job_system.hpp"
+
+#include "fastgltf/core.hpp"
+#include "fastgltf/types.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE
+#include <immintrin.h>
+#endif
+
+#include <algorithm> // for fill, max & min
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstring> // for memcpy & memset
+#include <limits>
+#include <utility> // for move()
+#include <variant>
+#include <vector>
+
+
+
+namespace
+{
+	constexpr unsigned char vertexHeader{ 0xA0 };
+	constexpr unsigned char indexHeader{ 0xE1 };
+	constexpr unsigned char sequenceHeader{ 0xD1 };
+
+	constexpr std::size_t vertexBlockSizeBytes{ 8192 };
+	constexpr std::size_t vertexBlockMaxSize{ 256 };
+	constexpr std::size_t byteGroupSize{ 16 };
+	constexpr std::size_t byteGroupDecodeLimit{ 24 }; // Header bits + 16 sentinel bytes of a 4 bit group, rounded up
+	constexpr std::size_t tailMaxSize{ 32 };
+
+	// The index codec's codeaux byte for common vertex FIFO references, also written at the end of the stream
+	constexpr unsigned char codeAuxTable[16]{ 0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00 };
+
+	// Vertices per block, so a block's bytes fit in vertexBlockSizeBytes. Always a whole number of byte groups
+	std::size_t getVertexBlockSize(std::size_t vertexSize)
+	{
+		std::size_t result{ vertexBlockSizeBytes / vertexSize };
+		result &= ~(byteGroupSize - 1);
+		return std::min(result, vertexBlockMaxSize);
+	}
+
+	unsigned char zigzag8(unsigned char v)
+	{
+		return static_cast<unsigned char>((static_cast<signed char>(v) >> 7) ^ (v << 1));
+	}
+
+#if !defined(MESH_CODEC_SSE)
+	unsigned char unzigzag8(unsigned char v)
+	{
+		return static_cast<unsigned char>(-(v & 1) ^ (v >> 1));
+	}
+#endif
+
+	// Encoded size of 16 deltas with 0, 2, 4 or 8 bits each. Deltas that don't fit are stored after the packed bits
+	std::size_t measureBytesGroup(const unsigned char* group, int bitsLog2)
+	{
+		if (bitsLog2 == 0)
+		{
+			return std::all_of(group, group + byteGroupSize, [](unsigned char v) { return v == 0; })
+				? 0 : std::numeric_limits<std::size_t>::max();
+		}
+		if (bitsLog2 == 3)
+		{
+			return byteGroupSize;
+		}
+
+		const int bits{ 1 << bitsLog2 };
+		const unsigned sentinel{ (1u << bits) - 1 };
+
+		std::size_t size{ byteGroupSize * bits / 8 };
+		for (std::size_t i{ 0 }; i < byteGroupSize; ++i)
+		{
+			size += group[i] >= sentinel;
+		}
+
+		return size;
+	}
+
+	void encodeBytesGroup(std::vector<unsigned char>& out, const unsigned char* group, int bitsLog2)
+	{
+		if (bitsLog2 == 0)
+		{
+			return;
+		}
+		if (bitsLog2 == 3)
+		{
+			out.insert(out.end(), group, group + byteGroupSize);
+			return;
+		}
+
+		const int bits{ 1 << bitsLog2 };
+		const unsigned sentinel{ (1u << bits) - 1 };
+		const int perByte{ 8 / bits };
+
+		// Packed most significant bits first
+		for (std::size_t i{ 0 }; i < byteGroupSize; i += perByte)
+		{
+			unsigned byte{ 0 };
+			for (int n{ 0 }; n < perByte; ++n)
+			{
+				byte = (byte << bits) | std::min<unsigned>(group[i + n], sentinel);
+			}
+			out.push_back(static_cast<unsigned char>(byte));
+		}
+
+		for (std::size_t i{ 0 }; i < byteGroupSize; ++i)
+		{
+			if (group[i] >= sentinel)
+			{
+				out.push_back(group[i]);
+			}
+		}
+	}
+
+	void encodeBytes(std::vector<unsigned char>& out, const unsigned char* buffer, std::size_t bufferSize)
+	{
+		// 2 bits of header per group, 4 groups to a byte
+		const std::size_t groupCount{ bufferSize / byteGroupSize };
+		const std::size_t headerOffset{ out.size() };
+		out.resize(out.size() + (groupCount + 3) / 4, 0);
+
+		for (std::size_t g{ 0 }; g < groupCount; ++g)
+		{
+			const unsigned char* group{ buffer + g * byteGroupSize };
+
+			int bestBitsLog2{ 3 };
+			std::size_t bestSize{ measureBytesGroup(group, 3) };
+			for (int bitsLog2{ 0 }; bitsLog2 < 3; ++bitsLog2)
+			{
+				std::size_t size{ measureBytesGroup(group, bitsLog2) };
+				if (size < bestSize)
+				{
+					bestBitsLog2 = bitsLog2;
+					bestSize = size;
+				}
+			}
+
+			out[headerOffset + g / 4] |= static_cast<unsigned char>(bestBitsLog2 << ((g % 4) * 2));
+			encodeBytesGroup(out, group, bestBitsLog2);
+		}
+	}
+
+	const unsigned char* decodeBytesGroup(const unsigned char* data, unsigned char* buffer, int bitsLog2)
+	{
+		switch (bitsLog2)
+		{
+		case 0:
+			std::memset(buffer, 0, byteGroupSize);
+			return data;
+		case 3:
+			std::memcpy(buffer, data, byteGroupSize);
+			return data + byteGroupSize;
+		default:
+		{
+#if defined(MESH_CODEC_SSE)
+			// Unpacks all 16 values with shifts & interleaves, then patches in the explicit bytes, which are rare
+			const __m128i lowNibbles{ _mm_set1_epi8(0x0F) };
+			const __m128i lowPairs{ _mm_set1_epi8(0x03) };
+
+			__m128i values{};
+			std::size_t packedSize{};
+			int sentinel{};
+			if (bitsLog2 == 1)
+			{
+				int word{};
+				std::memcpy(&word, data, sizeof(word));
+				__m128i packed{ _mm_cvtsi32_si128(word) };
+				__m128i nibbles{ _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), lowNibbles), _mm_and_si128(packed, lowNibbles)) };
+				values = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(nibbles, 2), lowPairs), _mm_and_si128(nibbles, lowPairs));
+				packedSize = 4;
+				sentinel = 0x03;
+			}
+			else
+			{
+				__m128i packed{ _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)) };
+				values = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), lowNibbles), _mm_and_si128(packed, lowNibbles));
+				packedSize = 8;
+				sentinel = 0x0F;
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), values);
+
+			const unsigned char* explicitBytes{ data + packedSize };
+			int mask{ _mm_movemask_epi8(_mm_cmpeq_epi8(values, _mm_set1_epi8(static_cast<char>(sentinel)))) };
+			for (int i{ 0 }; mask != 0; ++i, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					buffer[i] = *explicitBytes++;
+				}
+			}
+
+			return explicitBytes;
+#else
+			const int bits{ 1 << bitsLog2 };
+			const unsigned sentinel{ (1u << bits) - 1 };
+			const int perByte{ 8 / bits };
+
+			const unsigned char* explicitBytes{ data + byteGroupSize * bits / 8 };
+			for (std::size_t i{ 0 }; i < byteGroupSize; i += perByte)
+			{
+				unsigned byte{ *data++ };
+				for (int n{ 0 }; n < perByte; ++n)
+				{
+					unsigned value{ (byte >> (8 - bits)) & sentinel };
+					byte <<= bits;
+
+					buffer[i + n] = static_cast<unsigned char>(value == sentinel ? *explicitBytes : value);
+					explicitBytes += value == sentinel;
+				}
+			}
+
+			return explicitBytes;
+#endif
+		}
+		}
+	}
+
+	const unsigned char* decodeBytes(const unsigned char* data, const unsigned char* dataEnd, unsigned char* buffer,
+		std::size_t bufferSize)
+	{
+		const std::size_t groupCount{ bufferSize / byteGroupSize };
+		const std::size_t headerSize{ (groupCount + 3) / 4 };
+		if (static_cast<std::size_t>(dataEnd - data) < headerSize)
+		{
+			return nullptr;
+		}
+
+		const unsigned char* header{ data };
+		data += headerSize;
+
+		for (std::size_t g{ 0 }; g < groupCount; ++g)
+		{
+			// The tail guarantees this much is readable for any valid stream
+			if (static_cast<std::size_t>(dataEnd - data) < byteGroupDecodeLimit)
+			{
+				return nullptr;
+			}
+
+			const int bitsLog2{ (header[g / 4] >> ((g % 4) * 2)) & 3 };
+			data = decodeBytesGroup(data, buffer + g * byteGroupSize, bitsLog2);
+		}
+
+		return data;
+	}
+
+	// Undoes the zigzag deltas of one byte of every vertex in the block, and interleaves them back into vertices.
+	// The deltas are a prefix sum, so SSE adds them up 16 at a time in 4 shifted steps
+	void unpackDeltas(const unsigned char* deltas, std::size_t vertexCount, std::size_t vertexSize, std::size_t byteIndex,
+		unsigned char& last, unsigned char* vertices)
+	{
+#if defined(MESH_CODEC_SSE)
+		const __m128i one{ _mm_set1_epi8(1) };
+		const __m128i lowBits{ _mm_set1_epi8(0x7F) };
+
+		for (std::size_t i{ 0 }; i < vertexCount; i += byteGroupSize)
+		{
+			__m128i v{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + i)) };
+
+			// (v >> 1) ^ -(v & 1), with the byte shift done as a 16 bit one and masked
+			__m128i half{ _mm_and_si128(_mm_srli_epi16(v, 1), lowBits) };
+			__m128i sign{ _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, one)) };
+			__m128i sum{ _mm_xor_si128(half, sign) };
+
+			sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 1));
+			sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 2));
+			sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+			sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+			sum = _mm_add_epi8(sum, _mm_set1_epi8(static_cast<char>(last)));
+
+			alignas(16) unsigned char values[byteGroupSize];
+			_mm_store_si128(reinterpret_cast<__m128i*>(values), sum);
+
+			const std::size_t count{ std::min(byteGroupSize, vertexCount - i) };
+			for (std::size_t n{ 0 }; n < count; ++n)
+			{
+				vertices[(i + n) * vertexSize + byteIndex] = values[n];
+			}
+			last = values[count - 1];
+		}
+#else
+		for (std::size_t i{ 0 }; i < vertexCount; ++i)
+		{
+			last = static_cast<unsigned char>(unzigzag8(deltas[i]) + last);
+			vertices[i * vertexSize + byteIndex] = last;
+		}
+#endif
+	}
+
+	const unsigned char* decodeVertexBlock(const unsigned char* data, const unsigned char* dataEnd, unsigned char* vertices,
+		std::size_t vertexCount, std::size_t vertexSize, unsigned char lastVertex[256])
+	{
+		unsigned char deltas[vertexBlockMaxSize]{};
+		const std::size_t alignedCount{ (vertexCount + byteGroupSize - 1) & ~(byteGroupSize - 1) };
+
+		for (std::size_t k{ 0 }; k < vertexSize; ++k)
+		{
+			data = decodeBytes(data, dataEnd, deltas, alignedCount);
+			if (!data)
+			{
+				return nullptr;
+			}
+
+			unpackDeltas(deltas, vertexCount, vertexSize, k, lastVertex[k], vertices);
+		}
+
+		return data;
+	}
+
+	using EdgeFifo = unsigned int[16][2];
+	using VertexFifo = unsigned int[16];
+
+	void pushEdgeFifo(EdgeFifo fifo, unsigned int a, unsigned int b, std::size_t& offset)
+	{
+		fifo[offset][0] = a;
+		fifo[offset][1] = b;
+		offset = (offset + 1) & 15;
+	}
+
+	void pushVertexFifo(VertexFifo fifo, unsigned int v, std::size_t& offset, int condition = 1)
+	{
+		fifo[offset] = v;
+		offset = (offset + condition) & 15;
+	}
+
+	// Position of the edge counting back from the newest, times 4, plus the rotation that makes a-b the found edge
+	int getEdgeFifo(const EdgeFifo fifo, unsigned int a, unsigned int b, unsigned int c, std::size_t offset)
+	{
+		for (int i{ 0 }; i < 16; ++i)
+		{
+			const std::size_t index{ (offset - 1 - i) & 15 };
+			const unsigned int e0{ fifo[index][0] };
+			const unsigned int e1{ fifo[index][1] };
+
+			if (e0 == a && e1 == b)
+			{
+				return (i << 2) | 0;
+			}
+			if (e0 == b && e1 == c)
+			{
+				return (i << 2) | 1;
+			}
+			if (e0 == c && e1 == a)
+			{
+				return (i << 2) | 2;
+			}
+		}
+
+		return -1;
+	}
+
+	int getVertexFifo(const VertexFifo fifo, unsigned int v, std::size_t offset)
+	{
+		for (int i{ 0 }; i < 16; ++i)
+		{
+			if (fifo[(offset - 1 - i) & 15] == v)
+			{
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	constexpr int triangleIndexOrder[3][3]{ { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 } };
+
+	void encodeVByte(std::vector<unsigned char>& out, unsigned int v)
+	{
+		do
+		{
+			out.push_back(static_cast<unsigned char>((v & 127) | (v > 127 ? 128 : 0)));
+			v >>= 7;
+		} while (v);
+	}
+
+	unsigned int decodeVByte(const unsigned char*& data)
+	{
+		unsigned char lead{ *data++ };
+		if (lead < 128)
+		{
+			return lead;
+		}
+
+		unsigned int result{ lead & 127u };
+		unsigned int shift{ 7 };
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			unsigned char group{ *data++ };
+			result |= static_cast<unsigned int>(group & 127) << shift;
+			shift += 7;
+
+			if (group < 128)
+			{
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	// Free indices are zigzag deltas from the last free index
+	void encodeIndex(std::vector<unsigned char>& out, unsigned int index, unsigned int last)
+	{
+		unsigned int d{ index - last };
+		encodeVByte(out, (d << 1) ^ static_cast<unsigned int>(static_cast<int>(d) >> 31));
+	}
+
+	unsigned int decodeIndex(const unsigned char*& data, unsigned int last)
+	{
+		unsigned int v{ decodeVByte(data) };
+		return last + ((v >> 1) ^ (0u - (v & 1)));
+	}
+
+	void writeIndex(void* destination, std::size_t i, std::size_t indexSize, unsigned int index)
+	{
+		if (indexSize == 2)
+		{
+			static_cast<std::uint16_t*>(destination)[i] = static_cast<std::uint16_t>(index);
+		}
+		else
+		{
+			static_cast<std::uint32_t*>(destination)[i] = index;
+		}
+	}
+
+	void writeTriangle(void* destination, std::size_t i, std::size_t indexSize, unsigned int a, unsigned int b, unsigned int c)
+	{
+		writeIndex(destination, i + 0, indexSize, a);
+		writeIndex(destination, i + 1, indexSize, b);
+		writeIndex(destination, i + 2, indexSize, c);
+	}
+
+	// The index codec keeps the winding but may rotate a triangle's vertices
+	bool isSameTriangle(const std::uint8_t* a, const std::uint8_t* b)
+	{
+		for (const int* order : triangleIndexOrder)
+		{
+			if (a[0] == b[order[0]] && a[1] == b[order[1]] && a[2] == b[order[2]])
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <typename T>
+	void decodeOctahedral(T* data, std::size_t count, std::size_t stride)
+	{
+		constexpr float max{ static_cast<float>(std::numeric_limits<T>::max()) };
+
+		for (std::size_t i{ 0 }; i < count; ++i)
+		{
+			T* v{ reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(data) + i * stride) };
+
+			// z holds the scale x & y were quantized with
+			float one{ static_cast<float>(v[2]) };
+			float x{ v[0] / one };
+			float y{ v[1] / one };
+			float z{ 1.0f - std::abs(x) - std::abs(y) };
+
+			// Unfolds the lower hemisphere
+			float t{ std::min(z, 0.0f) };
+			x -= x >= 0.0f ? t : -t;
+			y -= y >= 0.0f ? t : -t;
+
+			float scale{ max / std::sqrt(x * x + y * y + z * z) };
+			v[0] = static_cast<T>(std::lround(x * scale));
+			v[1] = static_cast<T>(std::lround(y * scale));
+			v[2] = static_cast<T>(std::lround(z * scale));
+		}
+	}
+
+	void decodeQuaternion(std::int16_t* data, std::size_t count, std::size_t stride)
+	{
+		const float scale{ 1.0f / std::sqrt(2.0f) };
+
+		for (std::size_t i{ 0 }; i < count; ++i)
+		{
+			std::int16_t* q{ reinterpret_cast<std::int16_t*>(reinterpret_cast<unsigned char*>(data) + i * stride) };
+
+			// The last component holds the quantization scale and which component was dropped
+			const int sf{ q[3] | 3 };
+			const float ss{ scale / static_cast<float>(sf) };
+
+			float x{ q[0] * ss };
+			float y{ q[1] * ss };
+			float z{ q[2] * ss };
+			float ww{ 1.0f - x * x - y * y - z * z };
+			float w{ std::sqrt(std::max(ww, 0.0f)) };
+
+			const int qc{ q[3] & 3 };
+			q[(qc + 1) & 3] = static_cast<std::int16_t>(std::lround(x * 32767.0f));
+			q[(qc + 2) & 3] = static_cast<std::int16_t>(std::lround(y * 32767.0f));
+			q[(qc + 3) & 3] = static_cast<std::int16_t>(std::lround(z * 32767.0f));
+			q[(qc + 0) & 3] = static_cast<std::int16_t>(std::lround(w * 32767.0f));
+		}
+	}
+
+	// Each 32 bit value is a signed 8 bit exponent over a signed 24 bit mantissa
+	void decodeExponential(unsigned char* data, std::size_t count, std::size_t stride)
+	{
+		for (std::size_t i{ 0 }; i < count * stride / 4; ++i)
+		{
+			std::int32_t v{};
+			std::memcpy(&v, data + i * 4, 4);
+
+			const int exponent{ v >> 24 };
+			const int mantissa{ static_cast<std::int32_t>(static_cast<std::uint32_t>(v) << 8) >> 8 };
+			const float f{ std::ldexp(static_cast<float>(mantissa), exponent) };
+
+			std::memcpy(data + i * 4, &f, 4);
+		}
+	}
+}
+
+
+
+std::vector<unsigned char> MeshCodec::encodeVertexBuffer(const void* vertices, std::size_t vertexCount, std::size_t vertexSize)
+{
+	assert(vertexSize > 0 && vertexSize <= 256 && vertexSize % 4 == 0);
+
+	const unsigned char* vertexData{ static_cast<const unsigned char*>(vertices) };
+
+	std::vector<unsigned char> out{};
+	out.push_back(vertexHeader);
+
+	unsigned char lastVertex[256]{};
+	if (vertexCount > 0)
+	{
+		std::memcpy(lastVertex, vertexData, vertexSize);
+	}
+
+	const std::size_t blockSize{ getVertexBlockSize(vertexSize) };
+	unsigned char deltas[vertexBlockMaxSize]{};
+	for (std::size_t first{ 0 }; first < vertexCount; first += blockSize)
+	{
+		const std::size_t count{ std::min(blockSize, vertexCount - first) };
+		const std::size_t alignedCount{ (count + byteGroupSize - 1) & ~(byteGroupSize - 1) };
+
+		for (std::size_t k{ 0 }; k < vertexSize; ++k)
+		{
+			unsigned char last{ lastVertex[k] };
+			for (std::size_t i{ 0 }; i < count; ++i)
+			{
+				const unsigned char v{ vertexData[(first + i) * vertexSize + k] };
+				deltas[i] = zigzag8(static_cast<unsigned char>(v - last));
+				last = v;
+			}
+			std::fill(deltas + count, deltas + alignedCount, static_cast<unsigned char>(0));
+
+			encodeBytes(out, deltas, alignedCount);
+		}
+
+		std::memcpy(lastVertex, vertexData + (first + count - 1) * vertexSize, vertexSize);
+	}
+
+	// The first vertex goes at the very end, and the padding before it lets the decoder read whole groups unchecked
+	const std::size_t tailSize{ std::max(vertexSize, tailMaxSize) };
+	out.resize(out.size() + tailSize - vertexSize, 0);
+	if (vertexCount > 0)
+	{
+		out.insert(out.end(), vertexData, vertexData + vertexSize);
+	}
+	else
+	{
+		out.resize(out.size() + vertexSize, 0);
+	}
+
+	return out;
+}
+
+bool MeshCodec::decodeVertexBuffer(void* destination, std::size_t vertexCount, std::size_t vertexSize,
+	const unsigned char* buffer, std::size_t bufferSize)
+{
+	if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0 || bufferSize < 1 + vertexSize)
+	{
+		return false;
+	}
+
+	const unsigned char* data{ buffer };
+	const unsigned char* dataEnd{ buffer + bufferSize };
+
+	if ((*data & 0xF0) != (vertexHeader & 0xF0) || (*data & 0x0F) > 0)
+	{
+		return false;
+	}
+	++data;
+
+	unsigned char lastVertex[256]{};
+	std::memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+	unsigned char* vertices{ static_cast<unsigned char*>(destination) };
+	const std::size_t blockSize{ getVertexBlockSize(vertexSize) };
+	for (std::size_t first{ 0 }; first < vertexCount; first += blockSize)
+	{
+		const std::size_t count{ std::min(blockSize, vertexCount - first) };
+
+		data = decodeVertexBlock(data, dataEnd, vertices + first * vertexSize, count, vertexSize, lastVertex);
+		if (!data)
+		{
+			return false;
+		}
+	}
+
+	return static_cast<std::size_t>(dataEnd - data) == std::max(vertexSize, tailMaxSize);
+}
+
+std::vector<unsigned char> MeshCodec::encodeIndexBuffer(const std::uint32_t* indices, std::size_t indexCount)
+{
+	assert(indexCount % 3 == 0);
+
+	// One code byte per triangle up front, then the free indices & codeaux bytes they point to
+	std::vector<unsigned char> codes(indexCount / 3);
+	std::vector<unsigned char> data{};
+
+	EdgeFifo edgeFifo{};
+	VertexFifo vertexFifo{};
+	std::memset(edgeFifo, -1, sizeof(edgeFifo));
+	std::memset(vertexFifo, -1, sizeof(vertexFifo));
+	std::size_t edgeFifoOffset{ 0 };
+	std::size_t vertexFifoOffset{ 0 };
+
+	unsigned int next{ 0 };
+	unsigned int last{ 0 };
+
+	// Version 1 spends 13 & 14 on last - 1 & last + 1, which strips are full of
+	constexpr int fecMax{ 13 };
+
+	for (std::size_t i{ 0 }; i < indexCount; i += 3)
+	{
+		unsigned char& code{ codes[i / 3] };
+
+		const int fer{ getEdgeFifo(edgeFifo, indices[i + 0], indices[i + 1], indices[i + 2], edgeFifoOffset) };
+		if (fer >= 0 && (fer >> 2) < 15)
+		{
+			// Rotated so a-b is the edge that was found
+			const int* order{ triangleIndexOrder[fer & 3] };
+			const unsigned int a{ indices[i + order[0]] };
+			const unsigned int b{ indices[i + order[1]] };
+			const unsigned int c{ indices[i + order[2]] };
+
+			const int fe{ fer >> 2 };
+			const int fc{ getVertexFifo(vertexFifo, c, vertexFifoOffset) };
+
+			int fec{ (fc >= 1 && fc < fecMax) ? fc : (c == next) ? (++next, 0) : 15 };
+			if (fec == 15 && c + 1 == last)
+			{
+				fec = 13;
+				last = c;
+			}
+			if (fec == 15 && c == last + 1)
+			{
+				fec = 14;
+				last = c;
+			}
+
+			code = static_cast<unsigned char>((fe << 4) | fec);
+
+			if (fec == 15)
+			{
+				encodeIndex(data, c, last);
+				last = c;
+			}
+
+			// a & b are likely in the vertex FIFO already, and the a-b edge in the edge FIFO
+			if (fec == 0 || fec >= fecMax)
+			{
+				pushVertexFifo(vertexFifo, c, vertexFifoOffset);
+			}
+			pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+		}
+		else
+		{
+			// Rotated so next, if it's there, comes first
+			const int rotation{ indices[i + 1] == next ? 1 : indices[i + 2] == next ? 2 : 0 };
+			const int* order{ triangleIndexOrder[rotation] };
+			const unsigned int a{ indices[i + order[0]] };
+			const unsigned int b{ indices[i + order[1]] };
+			const unsigned int c{ indices[i + order[2]] };
+
+			// 0, 1, 2 after anything else restarts next, e.g. between meshlets with local indices
+			bool reset{ false };
+			if (a == 0 && b == 1 && c == 2 && next > 0)
+			{
+				reset = true;
+				next = 0;
+
+				// Keeps stale vertices from being referenced. The decoder's FIFO isn't reset, but those entries are
+				// never looked up
+				std::memset(vertexFifo, -1, sizeof(vertexFifo));
+			}
+
+			const int fb{ getVertexFifo(vertexFifo, b, vertexFifoOffset) };
+			const int fc{ getVertexFifo(vertexFifo, c, vertexFifoOffset) };
+
+			const int fea{ (a == next) ? (++next, 0) : 15 };
+			const int feb{ (fb >= 0 && fb < 14) ? fb + 1 : (b == next) ? (++next, 0) : 15 };
+			const int fec{ (fc >= 0 && fc < 14) ? fc + 1 : (c == next) ? (++next, 0) : 15 };
+
+			const unsigned char codeAux{ static_cast<unsigned char>((feb << 4) | fec) };
+			const auto tableEntry{ std::find(std::begin(codeAuxTable), std::end(codeAuxTable), codeAux) };
+
+			if (fea == 0 && tableEntry != std::end(codeAuxTable) && !reset)
+			{
+				code = static_cast<unsigned char>(0xF0 | (tableEntry - std::begin(codeAuxTable)));
+			}
+			else
+			{
+				code = static_cast<unsigned char>(0xFE + (fea == 15));
+				data.push_back(codeAux);
+			}
+
+			if (fea == 15)
+			{
+				encodeIndex(data, a, last);
+				last = a;
+			}
+			if (feb == 15)
+			{
+				encodeIndex(data, b, last);
+				last = b;
+			}
+			if (fec == 15)
+			{
+				encodeIndex(data, c, last);
+				last = c;
+			}
+
+			if (fea == 0 || fea == 15)
+			{
+				pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+			}
+			if (feb == 0 || feb == 15)
+			{
+				pushVertexFifo(vertexFifo, b, vertexFifoOffset);
+			}
+			if (fec == 0 || fec == 15)
+			{
+				pushVertexFifo(vertexFifo, c, vertexFifoOffset);
+			}
+
+			pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+		}
+	}
+
+	// The table doubles as padding, so the decoder can read a whole triangle's worth of data without checks
+	std::vector<unsigned char> out{};
+	out.reserve(1 + codes.size() + data.size() + 16);
+	out.push_back(indexHeader);
+	out.insert(out.end(), codes.begin(), codes.end());
+	out.insert(out.end(), data.begin(), data.end());
+	out.insert(out.end(), std::begin(codeAuxTable), std::end(codeAuxTable));
+
+	return out;
+}
+
+bool MeshCodec::decodeIndexBuffer(void* destination, std::size_t indexCount, std::size_t indexSize,
+	const unsigned char* buffer, std::size_t bufferSize)
+{
+	if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4) || bufferSize < 1 + indexCount / 3 + 16)
+	{
+		return false;
+	}
+
+	if ((buffer[0] & 0xF0) != (indexHeader & 0xF0) || (buffer[0] & 0x0F) > 1)
+	{
+		return false;
+	}
+	const int fecMax{ (buffer[0] & 0x0F) >= 1 ? 13 : 15 };
+
+	EdgeFifo edgeFifo{};
+	VertexFifo vertexFifo{};
+	std::memset(edgeFifo, -1, sizeof(edgeFifo));
+	std::memset(vertexFifo, -1, sizeof(vertexFifo));
+	std::size_t edgeFifoOffset{ 0 };
+	std::size_t vertexFifoOffset{ 0 };
+
+	unsigned int next{ 0 };
+	unsigned int last{ 0 };
+
+	const unsigned char* code{ buffer + 1 };
+	const unsigned char* data{ code + indexCount / 3 };
+	const unsigned char* dataSafeEnd{ buffer + bufferSize - 16 };
+	const unsigned char* codeAuxTable{ dataSafeEnd };
+
+	for (std::size_t i{ 0 }; i < indexCount; i += 3)
+	{
+		// A triangle reads at most 16 bytes: a codeaux byte and 3 free indices of up to 5 bytes
+		if (data > dataSafeEnd)
+		{
+			return false;
+		}
+
+		const unsigned char codeTri{ *code++ };
+		if (codeTri < 0xF0)
+		{
+			const int fe{ codeTri >> 4 };
+			const unsigned int a{ edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0] };
+			const unsigned int b{ edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1] };
+
+			const int fec{ codeTri & 15 };
+			if (fec < fecMax)
+			{
+				const unsigned int c{ fec == 0 ? next : vertexFifo[(vertexFifoOffset - 1 - fec) & 15] };
+				next += fec == 0;
+
+				writeTriangle(destination, i, indexSize, a, b, c);
+
+				pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec == 0);
+				pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+				pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+			}
+			else
+			{
+				// 13 & 14 are last - 1 & last + 1
+				const unsigned int c{ fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(data, last) };
+				last = c;
+
+				writeTriangle(destination, i, indexSize, a, b, c);
+
+				pushVertexFifo(vertexFifo, c, vertexFifoOffset);
+				pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+				pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+			}
+		}
+		else if (codeTri < 0xFE)
+		{
+			// next is bumped for each vertex in turn, the same as the encoder
+			const unsigned char codeAux{ codeAuxTable[codeTri & 15] };
+			const int feb{ codeAux >> 4 };
+			const int fec{ codeAux & 15 };
+
+			const unsigned int a{ next++ };
+			const unsigned int b{ feb == 0 ? next : vertexFifo[(vertexFifoOffset - feb) & 15] };
+			next += feb == 0;
+			const unsigned int c{ fec == 0 ? next : vertexFifo[(vertexFifoOffset - fec) & 15] };
+			next += fec == 0;
+
+			writeTriangle(destination, i, indexSize, a, b, c);
+
+			pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+			pushVertexFifo(vertexFifo, b, vertexFifoOffset, feb == 0);
+			pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec == 0);
+			pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+		}
+		else
+		{
+			const unsigned char codeAux{ *data++ };
+			const int fea{ codeTri == 0xFE ? 0 : 15 };
+			const int feb{ codeAux >> 4 };
+			const int fec{ codeAux & 15 };
+
+			// A codeaux of 0 outside the table is a restart
+			if (codeAux == 0)
+			{
+				next = 0;
+			}
+
+			unsigned int a{ fea == 0 ? next++ : 0 };
+			unsigned int b{ feb == 0 ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15] };
+			unsigned int c{ fec == 0 ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15] };
+
+			if (fea == 15)
+			{
+				last = a = decodeIndex(data, last);
+			}
+			if (feb == 15)
+			{
+				last = b = decodeIndex(data, last);
+			}
+			if (fec == 15)
+			{
+				last = c = decodeIndex(data, last);
+			}
+
+			writeTriangle(destination, i, indexSize, a, b, c);
+
+			pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+			pushVertexFifo(vertexFifo, b, vertexFifoOffset, (feb == 0) | (feb == 15));
+			pushVertexFifo(vertexFifo, c, vertexFifoOffset, (fec == 0) | (fec == 15));
+			pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+			pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+		}
+	}
+
+	// Everything up to the table must have been read
+	return data == dataSafeEnd;
+}
+
+std::vector<unsigned char> MeshCodec::encodeIndexSequence(const std::uint32_t* indices, std::size_t indexCount)
+{
+	std::vector<unsigned char> out{};
+	out.push_back(sequenceHeader);
+
+	// Two baselines, so interleaved runs (e.g. the two ends of line strips) both stay small deltas
+	unsigned int last[2]{};
+	for (std::size_t i{ 0 }; i < indexCount; ++i)
+	{
+		const unsigned int index{ indices[i] };
+
+		auto distance{ [&](unsigned int baseline) {
+			const unsigned int d{ index - baseline };
+			return static_cast<int>(d) < 0 ? 0u - d : d;
+			} };
+		const int current{ distance(last[1]) < distance(last[0]) ? 1 : 0 };
+
+		const unsigned int d{ index - last[current] };
+		const unsigned int v{ (d << 1) ^ static_cast<unsigned int>(static_cast<int>(d) >> 31) };
+		encodeVByte(out, (v << 1) | static_cast<unsigned int>(current));
+
+		last[current] = index;
+	}
+
+	// Lets the decoder read a whole varint without checks
+	out.resize(out.size() + 4, 0);
+
+	return out;
+}
+
+bool MeshCodec::decodeIndexSequence(void* destination, std::size_t indexCount, std::size_t indexSize,
+	const unsigned char* buffer, std::size_t bufferSize)
+{
+	if ((indexSize != 2 && indexSize != 4) || bufferSize < 1 + indexCount + 4)
+	{
+		return false;
+	}
+
+	if ((buffer[0] & 0xF0) != (sequenceHeader & 0xF0) || (buffer[0] & 0x0F) > 1)
+	{
+		return false;
+	}
+
+	const unsigned char* data{ buffer + 1 };
+	const unsigned char* dataSafeEnd{ buffer + bufferSize - 4 };
+
+	unsigned int last[2]{};
+	for (std::size_t i{ 0 }; i < indexCount; ++i)
+	{
+		if (data >= dataSafeEnd)
+		{
+			return false;
+		}
+
+		unsigned int v{ decodeVByte(data) };
+		const unsigned int current{ v & 1 };
+		v >>= 1;
+
+		const unsigned int index{ last[current] + ((v >> 1) ^ (0u - (v & 1))) };
+		last[current] = index;
+
+		writeIndex(destination, i, indexSize, index);
+	}
+
+	return data == dataSafeEnd;
+}
+
+void MeshCodec::decodeFilter(Filter filter, void* elements, std::size_t count, std::size_t stride)
+{
+	switch (filter)
+	{
+	case Filter::octahedral:
+		if (stride == 4)
+		{
+			decodeOctahedral(static_cast<std::int8_t*>(elements), count, stride);
+		}
+		else
+		{
+			decodeOctahedral(static_cast<std::int16_t*>(elements), count, stride);
+		}
+		break;
+	case Filter::quaternion:
+		decodeQuaternion(static_cast<std::int16_t*>(elements), count, stride);
+		break;
+	case Filter::exponential:
+		decodeExponential(static_cast<unsigned char*>(elements), count, stride);
+		break;
+	case Filter::none:
+		break;
+	}
+}
+
+bool MeshCodec::decodeCompressedBufferViews(JobSystem& jobSystem, fastgltf::Asset& asset)
+{
+	std::vector<std::size_t> compressedViews{};
+	for (std::size_t i{ 0 }; i < asset.bufferViews.size(); ++i)
+	{
+		if (asset.bufferViews[i].meshoptCompression)
+		{
+			compressedViews.push_back(i);
+		}
+	}
+
+	// Allocated up front, StaticVector has no empty state to resize from
+	std::vector<fastgltf::StaticVector<std::uint8_t>> decoded{};
+	decoded.reserve(compressedViews.size());
+	for (std::size_t view : compressedViews)
+	{
+		const auto& compression{ *asset.bufferViews[view].meshoptCompression };
+		decoded.emplace_back(compression.count * compression.byteStride);
+	}
+
+	std::atomic<bool> succeeded{ true };
+
+	jobSystem.parallelFor(compressedViews.size(), 1, [&](std::size_t first, std::size_t last) {
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			const auto& compression{ *asset.bufferViews[compressedViews[i]].meshoptCompression };
+
+			const auto* source{ std::get_if<fastgltf::sources::Array>(&asset.buffers[compression.bufferIndex].data) };
+			if (!source || compression.byteOffset + compression.byteLength > source->bytes.size())
+			{
+				succeeded = false;
+				continue;
+			}
+			const unsigned char* bytes{ reinterpret_cast<const unsigned char*>(source->bytes.data()) + compression.byteOffset };
+
+			void* destination{ decoded[i].data() };
+
+			bool result{ false };
+			switch (compression.mode)
+			{
+			case fastgltf::MeshoptCompressionMode::Attributes:
+				result = decodeVertexBuffer(destination, compression.count, compression.byteStride, bytes, compression.byteLength);
+				break;
+			case fastgltf::MeshoptCompressionMode::Triangles:
+				result = decodeIndexBuffer(destination, compression.count, compression.byteStride, bytes, compression.byteLength);
+				break;
+			case fastgltf::MeshoptCompressionMode::Indices:
+				result = decodeIndexSequence(destination, compression.count, compression.byteStride, bytes, compression.byteLength);
+				break;
+			}
+
+			if (result && compression.filter != fastgltf::MeshoptCompressionFilter::None)
+			{
+				const Filter filter{ compression.filter == fastgltf::MeshoptCompressionFilter::Octahedral ? Filter::octahedral
+					: compression.filter == fastgltf::MeshoptCompressionFilter::Quaternion ? Filter::quaternion : Filter::exponential };
+				decodeFilter(filter, destination, compression.count, compression.byteStride);
+			}
+
+			if (!result)
+			{
+				succeeded = false;
+			}
+		}
+		});
+
+	// The views' own buffers are usually empty fallbacks, so each decoded view gets a new buffer
+	for (std::size_t i{ 0 }; i < compressedViews.size(); ++i)
+	{
+		auto& view{ asset.bufferViews[compressedViews[i]] };
+
+		const std::size_t size{ decoded[i].size() };
+		asset.buffers.push_back({ .byteLength{ size }, .data{ fastgltf::sources::Array{ std::move(decoded[i]) } }, .name{} });
+
+		view.bufferIndex = asset.buffers.size() - 1;
+		view.byteOffset = 0;
+		view.byteLength = size;
+		view.meshoptCompression.reset();
+	}
+
+	return succeeded;
+}
+
+float MeshCodec::BenchmarkResults::getCompressionRatio() const
+{
+	const std::size_t encoded{ encodedVertexBytes + encodedIndexBytes };
+	return encoded > 0 ? static_cast<float>(vertexBytes + indexBytes) / encoded : 0.0f;
+}
+
+float MeshCodec::BenchmarkResults::getDecodeGigabytesPerSecond() const
+{
+	return decodeTime > 0.0f ? static_cast<float>(vertexBytes + indexBytes) / (decodeTime * 1e6f) : 0.0f;
+}
+
+MeshCodec::BenchmarkResults MeshCodec::benchmark(JobSystem& jobSystem, const void* vertices, std::size_t vertexSize,
+	const std::uint8_t* indices, const std::vector<MeshletRange>& meshlets, std::size_t groupVertexCount)
+{
+	struct Group
+	{
+		std::size_t firstMeshlet{};
+		std::size_t meshletCount{};
+		std::size_t firstVertex{};
+		std::size_t vertexCount{};
+		std::size_t indexCount{};
+
+		std::vector<unsigned char> encodedVertices{};
+		std::vector<unsigned char> encodedIndices{};
+	};
+
+	// Meshlets are in vertex order, so a group is a contiguous range of vertices
+	std::vector<Group> groups{};
+	for (std::size_t m{ 0 }; m < meshlets.size(); ++m)
+	{
+		if (groups.empty() || groups.back().vertexCount >= groupVertexCount)
+		{
+			groups.push_back({ .firstMeshlet{ m }, .firstVertex{ meshlets[m].firstVertex } });
+		}
+
+		Group& group{ groups.back() };
+		++group.meshletCount;
+		group.vertexCount = meshlets[m].firstVertex + meshlets[m].vertexCount - group.firstVertex;
+		group.indexCount += meshlets[m].indexCount;
+	}
+
+	BenchmarkResults results{};
+	results.groupCount = static_cast<int>(groups.size());
+	results.threadCount = jobSystem.getThreadCount();
+
+	const unsigned char* vertexBytes{ static_cast<const unsigned char*>(vertices) };
+
+	auto encodeStart{ std::chrono::high_resolution_clock::now() };
+	jobSystem.parallelFor(groups.size(), 1, [&](std::size_t first, std::size_t last) {
+		for (std::size_t g{ first }; g < last; ++g)
+		{
+			Group& group{ groups[g] };
+			group.encodedVertices = encodeVertexBuffer(vertexBytes + group.firstVertex * vertexSize, group.vertexCount, vertexSize);
+
+			std::vector<std::uint32_t> groupIndices{};
+			groupIndices.reserve(group.indexCount);
+			for (std::size_t m{ group.firstMeshlet }; m < group.firstMeshlet + group.meshletCount; ++m)
+			{
+				const std::uint32_t base{ static_cast<std::uint32_t>(meshlets[m].firstVertex - group.firstVertex) };
+				for (std::size_t i{ 0 }; i < meshlets[m].indexCount; ++i)
+				{
+					groupIndices.push_back(base + indices[meshlets[m].firstIndex + i]);
+				}
+			}
+			group.encodedIndices = encodeIndexBuffer(groupIndices.data(), groupIndices.size());
+		}
+		});
+	auto encodeEnd{ std::chrono::high_resolution_clock::now() };
+	results.encodeTime = std::chrono::duration_cast<std::chrono::microseconds>(encodeEnd - encodeStart).count() / 1000.0f;
+
+	std::size_t indexOffset{ 0 };
+	std::vector<std::size_t> groupIndexOffsets(groups.size());
+	for (std::size_t g{ 0 }; g < groups.size(); ++g)
+	{
+		results.vertexBytes += groups[g].vertexCount * vertexSize;
+		results.indexBytes += groups[g].indexCount;
+		results.encodedVertexBytes += groups[g].encodedVertices.size();
+		results.encodedIndexBytes += groups[g].encodedIndices.size();
+
+		groupIndexOffsets[g] = indexOffset;
+		indexOffset += groups[g].indexCount;
+	}
+
+	// Decoding includes narrowing the indices back to meshlet local bytes, which a loader would have to do too
+	std::vector<unsigned char> decodedVertices(results.vertexBytes);
+	std::vector<std::uint8_t> decodedIndices(results.indexBytes);
+	std::vector<std::size_t> groupVertexOffsets(groups.size());
+	for (std::size_t g{ 1 }; g < groups.size(); ++g)
+	{
+		groupVertexOffsets[g] = groupVertexOffsets[g - 1] + groups[g - 1].vertexCount * vertexSize;
+	}
+
+	constexpr int runs{ 5 };
+	std::atomic<bool> decoded{ true };
+	for (int run{ 0 }; run < runs; ++run)
+	{
+		auto decodeStart{ std::chrono::high_resolution_clock::now() };
+		jobSystem.parallelFor(groups.size(), 1, [&](std::size_t first, std::size_t last) {
+			std::vector<std::uint32_t> groupIndices{};
+			for (std::size_t g{ first }; g < last; ++g)
+			{
+				const Group& group{ groups[g] };
+
+				groupIndices.resize(group.indexCount);
+				if (!decodeVertexBuffer(decodedVertices.data() + groupVertexOffsets[g], group.vertexCount, vertexSize,
+					group.encodedVertices.data(), group.encodedVertices.size())
+					|| !decodeIndexBuffer(groupIndices.data(), group.indexCount, sizeof(std::uint32_t),
+						group.encodedIndices.data(), group.encodedIndices.size()))
+				{
+					decoded = false;
+					continue;
+				}
+
+				std::size_t i{ 0 };
+				for (std::size_t m{ group.firstMeshlet }; m < group.firstMeshlet + group.meshletCount; ++m)
+				{
+					const std::uint32_t base{ static_cast<std::uint32_t>(meshlets[m].firstVertex - group.firstVertex) };
+					for (std::size_t n{ 0 }; n < meshlets[m].indexCount; ++n, ++i)
+					{
+						decodedIndices[groupIndexOffsets[g] + i] = static_cast<std::uint8_t>(groupIndices[i] - base);
+					}
+				}
+			}
+			});
+		auto decodeEnd{ std::chrono::high_resolution_clock::now() };
+
+		const float decodeTime{ std::chrono::duration_cast<std::chrono::microseconds>(decodeEnd - decodeStart).count() / 1000.0f };
+		results.decodeTime = run == 0 ? decodeTime : std::min(results.decodeTime, decodeTime);
+	}
+
+	results.matches = decoded;
+	for (std::size_t g{ 0 }; g < groups.size() && results.matches; ++g)
+	{
+		const Group& group{ groups[g] };
+		results.matches = std::memcmp(decodedVertices.data() + groupVertexOffsets[g], vertexBytes + group.firstVertex * vertexSize,
+			group.vertexCount * vertexSize) == 0;
+
+		std::size_t i{ 0 };
+		for (std::size_t m{ group.firstMeshlet }; m < group.firstMeshlet + group.meshletCount && results.matches; ++m)
+		{
+			for (std::size_t n{ 0 }; n < meshlets[m].indexCount && results.matches; n += 3, i += 3)
+			{
+				results.matches = isSameTriangle(indices + meshlets[m].firstIndex + n, decodedIndices.data() + groupIndexOffsets[g] + i);
+			}
+		}
+	}
+
+	return results;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+
+#include "fastgltf/core.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <vector>
+
+// meshoptimizer's vertex & index codecs, bitstream compatible with meshopt_encodeVertexBuffer/meshopt_encodeIndexBuffer
+// and the EXT_meshopt_compression glTF extension. The vendored meshoptimizer only has the clusterizer, so they live
+// here. Vertex streams are stored byte by byte as zigzag deltas from the previous vertex, in 16 byte groups of 0, 2,
+// 4 or 8 bits per delta. Triangles are stored as references into small FIFOs of recent edges & vertices.
+// A stream decodes serially, so large data is encoded as independent groups that decode in parallel
+class MeshCodec final
+{
+public:
+
+	enum class Filter { none, octahedral, quaternion, exponential };
+
+	// Consecutive meshlets' vertices & indices, for encoding meshlet groups
+	struct MeshletRange
+	{
+		std::size_t firstVertex{};
+		std::size_t vertexCount{};
+		std::size_t firstIndex{};
+		std::size_t indexCount{}; // Not counting the padding between meshlets
+	};
+
+	struct BenchmarkResults
+	{
+		int groupCount{};
+
+		std::size_t vertexBytes{};
+		std::size_t indexBytes{};
+		std::size_t encodedVertexBytes{};
+		std::size_t encodedIndexBytes{};
+
+		float encodeTime{}; // ms
+		float decodeTime{}; // ms, best of a few runs
+		int threadCount{};
+
+		bool matches{ false }; // Decoded data is the source, up to the rotation of triangles
+
+		float getCompressionRatio() const;
+		float getDecodeGigabytesPerSecond() const;
+	};
+
+	// vertexSize is a multiple of 4, at most 256
+	static std::vector<unsigned char> encodeVertexBuffer(const void* vertices, std::size_t vertexCount, std::size_t vertexSize);
+	static bool decodeVertexBuffer(void* destination, std::size_t vertexCount, std::size_t vertexSize,
+		const unsigned char* buffer, std::size_t bufferSize);
+
+	// Triangle lists. indexSize is 2 or 4
+	static std::vector<unsigned char> encodeIndexBuffer(const std::uint32_t* indices, std::size_t indexCount);
+	static bool decodeIndexBuffer(void* destination, std::size_t indexCount, std::size_t indexSize,
+		const unsigned char* buffer, std::size_t bufferSize);
+
+	// Any index list, e.g. for points or lines
+	static std::vector<unsigned char> encodeIndexSequence(const std::uint32_t* indices, std::size_t indexCount);
+	static bool decodeIndexSequence(void* destination, std::size_t indexCount, std::size_t indexSize,
+		const unsigned char* buffer, std::size_t bufferSize);
+
+	// In place, on count elements of stride bytes. Only what EXT_meshopt_compression allows
+	static void decodeFilter(Filter filter, void* elements, std::size_t count, std::size_t stride);
+
+	// Decodes every EXT_meshopt_compression buffer view in parallel into a buffer of its own, and points the view at
+	// it, so accessors read it like any other. False if any view failed
+	static bool decodeCompressedBufferViews(JobSystem& jobSystem, fastgltf::Asset& asset);
+
+	// Encodes vertices & byte indices as groups of about groupVertexCount vertices, then decodes them on jobSystem and
+	// compares. Indices are widened to group local triangle lists, the way a cooked scene file would store them
+	static BenchmarkResults benchmark(JobSystem& jobSystem, const void* vertices, std::size_t vertexSize,
+		const std::uint8_t* indices, const std::vector<MeshletRange>& meshlets, std::size_t groupVertexCount = 8192);
+};
\ No newline at end of file
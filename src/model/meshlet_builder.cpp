@@ -0,0 +1,806 @@
+#include "meshlet_builder.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "mesh_codec.hpp"
+
+#include "fastgltf/core.hpp"
+#include "fastgltf/tools.hpp"
+#include "fastgltf/types.hpp"
+
+#include "fastgltf/glm_element_traits.hpp"
+#include "glm/glm.hpp"
+
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <algorithm> // for clamp, copy, max, min & sort
+#include <cassert>
+#include <chrono>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstring> // for memcpy
+#include <filesystem>
+#include <iomanip> // for setw & setprecision
+#include <iostream>
+#include <memory_resource>
+#include <numeric> // for iota
+#include <ostream>
+#include <random>
+#include <span>
+#include <string>
+#include <utility> // for move()
+#include <vector>
+
+
+
+namespace
+{
+	constexpr unsigned int vertexCacheSize{ 16 };
+
+	// meshoptimizer allocates through one global pair of functions. While a build() runs, the ones below send the
+	// clusterizer's temporaries to its scratch resource. Each allocation is prefixed with its size, which pmr needs back
+	thread_local std::pmr::memory_resource* tScratch{ nullptr };
+
+	constexpr std::size_t scratchHeaderSize{ alignof(std::max_align_t) };
+
+	void* allocateMeshoptScratch(std::size_t size)
+	{
+		if (tScratch == nullptr)
+		{
+			return ::operator new(size);
+		}
+
+		auto* block{ static_cast<unsigned char*>(tScratch->allocate(size + scratchHeaderSize, alignof(std::max_align_t))) };
+		std::memcpy(block, &size, sizeof(size));
+
+		return block + scratchHeaderSize;
+	}
+
+	void deallocateMeshoptScratch(void* pointer)
+	{
+		if (tScratch == nullptr)
+		{
+			::operator delete(pointer);
+			return;
+		}
+
+		auto* block{ static_cast<unsigned char*>(pointer) - scratchHeaderSize };
+		std::size_t size{};
+		std::memcpy(&size, block, sizeof(size));
+
+		tScratch->deallocate(block, size + scratchHeaderSize, alignof(std::max_align_t));
+	}
+
+	// Points meshoptimizer at the thread's scratch for as long as it lives
+	class MeshoptScratchScope final
+	{
+	public:
+
+		explicit MeshoptScratchScope(std::pmr::memory_resource* scratch)
+			: mPrevious{ tScratch }
+		{
+			static const bool installed{ [] {
+				meshopt_Allocator::Storage::allocate = allocateMeshoptScratch;
+				meshopt_Allocator::Storage::deallocate = deallocateMeshoptScratch;
+				return true;
+				}() };
+			(void)installed;
+
+			tScratch = scratch;
+		}
+
+		MeshoptScratchScope(const MeshoptScratchScope&) = delete;
+		MeshoptScratchScope& operator=(const MeshoptScratchScope&) = delete;
+
+		~MeshoptScratchScope()
+		{
+			tScratch = mPrevious;
+		}
+
+	private:
+
+		std::pmr::memory_resource* mPrevious{};
+	};
+
+	MeshletBuilder::Settings clampSettings(MeshletBuilder::Settings settings)
+	{
+		settings.maxVertices = std::clamp<std::size_t>(settings.maxVertices, 3, MeshletBuilder::maxMeshletVertices);
+		settings.maxTriangles = std::clamp<std::size_t>(settings.maxTriangles / 4 * 4, 4, MeshletBuilder::maxMeshletTriangles);
+		settings.coneWeight = std::clamp(settings.coneWeight, 0.0f, 1.0f);
+
+		return settings;
+	}
+
+	glm::vec3 getPosition(const void* vertices, std::size_t vertexSize, std::size_t vertex)
+	{
+		glm::vec3 position{};
+		std::memcpy(&position, static_cast<const unsigned char*>(vertices) + vertex * vertexSize, sizeof(glm::vec3));
+
+		return position;
+	}
+
+	// Tipsify. Fast Triangle Reordering for Vertex Locality and Reduced Overdraw. Pedro Sander, Diego Nehab, Joshua Barczak. 2007
+	// Rewrites indices in place
+	void optimizeVertexCache(std::span<std::uint32_t> indices, std::size_t vertexCount, std::pmr::memory_resource* scratch)
+	{
+		const std::size_t triangleCount{ indices.size() / 3 };
+
+		// Triangles using each vertex, as offsets into one flat array
+		std::pmr::vector<std::uint32_t> liveTriangles(vertexCount, 0, scratch);
+		for (auto index : indices)
+		{
+			++liveTriangles[index];
+		}
+
+		std::pmr::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0, scratch);
+		std::uint32_t maxLiveTriangles{ 0 };
+		for (std::size_t i{ 0 }; i < vertexCount; ++i)
+		{
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+			maxLiveTriangles = std::max(maxLiveTriangles, liveTriangles[i]);
+		}
+
+		std::pmr::vector<std::uint32_t> adjacency(indices.size(), scratch);
+		std::pmr::vector<std::uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1, scratch);
+		for (std::size_t i{ 0 }; i < indices.size(); ++i)
+		{
+			adjacency[adjacencyFill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+
+		std::pmr::vector<std::uint32_t> cacheTimes(vertexCount, 0, scratch);
+		std::pmr::vector<bool> isEmitted(triangleCount, false, scratch);
+
+		// Every emitted index is pushed once at most, and a fan emits 3 per triangle of its vertex, so neither grows
+		std::pmr::vector<std::uint32_t> deadEnds{ scratch };
+		deadEnds.reserve(indices.size());
+		std::pmr::vector<std::uint32_t> candidates{ scratch };
+		candidates.reserve(static_cast<std::size_t>(maxLiveTriangles) * 3);
+
+		std::pmr::vector<std::uint32_t> output{ scratch };
+		output.reserve(indices.size());
+
+		std::uint32_t time{ vertexCacheSize + 1 };
+		std::size_t cursor{ 0 };
+
+		auto skipDeadEnd{ [&]() -> std::int64_t {
+			while (!deadEnds.empty())
+			{
+				std::uint32_t vertex{ deadEnds.back() };
+				deadEnds.pop_back();
+
+				if (liveTriangles[vertex] > 0)
+				{
+					return vertex;
+				}
+			}
+
+			for (; cursor < vertexCount; ++cursor)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					return static_cast<std::int64_t>(cursor);
+				}
+			}
+
+			return -1;
+			} };
+
+		std::int64_t fanningVertex{ skipDeadEnd() };
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+
+			for (std::uint32_t i{ adjacencyOffsets[fanningVertex] }; i < adjacencyOffsets[fanningVertex + 1]; ++i)
+			{
+				std::uint32_t triangle{ adjacency[i] };
+				if (isEmitted[triangle])
+				{
+					continue;
+				}
+
+				for (int n{ 0 }; n < 3; ++n)
+				{
+					std::uint32_t vertex{ indices[triangle * 3 + n] };
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+
+					if (time - cacheTimes[vertex] > vertexCacheSize)
+					{
+						cacheTimes[vertex] = time;
+						++time;
+					}
+				}
+
+				isEmitted[triangle] = true;
+			}
+
+			// Prefer the candidate that stays in the cache the longest while its remaining triangles get emitted
+			std::int64_t nextVertex{ -1 };
+			std::int64_t bestPriority{ -1 };
+			for (auto vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+				{
+					continue;
+				}
+
+				std::int64_t priority{ 0 };
+				if (time - cacheTimes[vertex] + 2 * liveTriangles[vertex] <= vertexCacheSize)
+				{
+					priority = time - cacheTimes[vertex];
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+
+			fanningVertex = nextVertex >= 0 ? nextVertex : skipDeadEnd();
+		}
+
+		std::copy(output.cbegin(), output.cend(), indices.begin());
+	}
+
+	// Vertices in order of first use. Unused vertices are dropped
+	std::size_t optimizeVertexFetch(std::span<std::uint32_t> indices, void* vertices, std::size_t vertexCount, std::size_t vertexSize,
+		std::pmr::memory_resource* scratch)
+	{
+		constexpr std::uint32_t unmapped{ ~0u };
+		std::pmr::vector<std::uint32_t> remap(vertexCount, unmapped, scratch);
+
+		std::uint32_t nextVertex{ 0 };
+		for (auto& index : indices)
+		{
+			if (remap[index] == unmapped)
+			{
+				remap[index] = nextVertex++;
+			}
+
+			index = remap[index];
+		}
+
+		std::pmr::vector<unsigned char> original(static_cast<unsigned char*>(vertices), static_cast<unsigned char*>(vertices) + vertexCount * vertexSize,
+			scratch);
+		for (std::size_t i{ 0 }; i < vertexCount; ++i)
+		{
+			if (remap[i] != unmapped)
+			{
+				std::memcpy(static_cast<unsigned char*>(vertices) + remap[i] * vertexSize, &original[i * vertexSize], vertexSize);
+			}
+		}
+
+		return nextVertex;
+	}
+
+	// Spreads the low 10 bits out to every third bit
+	std::uint32_t part1By2(std::uint32_t x)
+	{
+		x &= 0x000003ff;
+		x = (x ^ (x << 16)) & 0xff0000ff;
+		x = (x ^ (x << 8)) & 0x0300f00f;
+		x = (x ^ (x << 4)) & 0x030c30c3;
+		x = (x ^ (x << 2)) & 0x09249249;
+
+		return x;
+	}
+
+	// Rewrites meshlets in place. The packed sizes of vertices & triangles don't change
+	void sortMeshletsSpatially(const MeshletBuilder::MeshletSpans& meshlets, std::pmr::memory_resource* scratch)
+	{
+		glm::vec3 min{ 1e30f };
+		glm::vec3 max{ -1e30f };
+		for (const auto& bounds : meshlets.bounds)
+		{
+			glm::vec3 center{ bounds.center[0], bounds.center[1], bounds.center[2] };
+			min = glm::min(min, center);
+			max = glm::max(max, center);
+		}
+
+		const glm::vec3 scale{ 1023.0f / glm::max(max - min, glm::vec3{ 1e-20f }) };
+
+		std::pmr::vector<std::uint32_t> codes(meshlets.meshlets.size(), scratch);
+		for (std::size_t i{ 0 }; i < codes.size(); ++i)
+		{
+			const auto& bounds{ meshlets.bounds[i] };
+			glm::uvec3 cell{ glm::clamp((glm::vec3{ bounds.center[0], bounds.center[1], bounds.center[2] } - min) * scale,
+				0.0f, 1023.0f) };
+
+			codes[i] = part1By2(cell.x) | (part1By2(cell.y) << 1) | (part1By2(cell.z) << 2);
+		}
+
+		std::pmr::vector<std::size_t> order(codes.size(), scratch);
+		std::iota(order.begin(), order.end(), 0);
+		// Ties keep their order, as stable_sort would without its temporary buffer
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return codes[a] < codes[b] || (codes[a] == codes[b] && a < b); });
+
+		// Lay the vertex & triangle data out again in the new order, so memory order matches draw order
+		const std::pmr::vector<meshopt_Meshlet> unsorted(meshlets.meshlets.begin(), meshlets.meshlets.end(), scratch);
+		const std::pmr::vector<unsigned int> unsortedVertices(meshlets.vertices.begin(), meshlets.vertices.end(), scratch);
+		const std::pmr::vector<unsigned char> unsortedTriangles(meshlets.triangles.begin(), meshlets.triangles.end(), scratch);
+		const std::pmr::vector<meshopt_Bounds> unsortedBounds(meshlets.bounds.begin(), meshlets.bounds.end(), scratch);
+
+		std::size_t vertexOffset{ 0 };
+		std::size_t triangleOffset{ 0 };
+		for (std::size_t i{ 0 }; i < order.size(); ++i)
+		{
+			meshopt_Meshlet meshlet{ unsorted[order[i]] };
+
+			auto vertices{ unsortedVertices.cbegin() + meshlet.vertex_offset };
+			auto triangles{ unsortedTriangles.cbegin() + meshlet.triangle_offset };
+			const std::size_t triangleByteCount{ (meshlet.triangle_count * 3 + 3) & ~3u };
+
+			meshlet.vertex_offset = static_cast<unsigned int>(vertexOffset);
+			meshlet.triangle_offset = static_cast<unsigned int>(triangleOffset);
+
+			std::copy(vertices, vertices + meshlet.vertex_count, meshlets.vertices.begin() + vertexOffset);
+			std::copy(triangles, triangles + triangleByteCount, meshlets.triangles.begin() + triangleOffset);
+			vertexOffset += meshlet.vertex_count;
+			triangleOffset += triangleByteCount;
+
+			meshlets.meshlets[i] = meshlet;
+			meshlets.bounds[i] = unsortedBounds[order[i]];
+		}
+	}
+
+	glm::vec3 randomUnitVector(std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+		glm::vec3 direction{};
+		do
+		{
+			direction = { unit(generator), unit(generator), unit(generator) };
+		} while (glm::dot(direction, direction) > 1.0f || glm::dot(direction, direction) < 1e-6f);
+
+		return glm::normalize(direction);
+	}
+}
+
+
+
+MeshletBuilder::Meshlets MeshletBuilder::build(std::vector<std::uint32_t>& indices, void* vertices, std::size_t& vertexCount,
+	std::size_t vertexSize, Settings settings)
+{
+	const StorageSize size{ getStorageSize(indices.size(), settings) };
+
+	Meshlets meshlets{};
+	meshlets.meshlets.resize(size.meshletCount);
+	meshlets.vertices.resize(size.vertexCount);
+	meshlets.triangles.resize(size.triangleByteCount);
+	meshlets.bounds.resize(size.meshletCount);
+
+	const MeshletSpans built{ build(indices, vertices, vertexCount, vertexSize, settings,
+		{ .meshlets{ meshlets.meshlets }, .vertices{ meshlets.vertices }, .triangles{ meshlets.triangles }, .bounds{ meshlets.bounds } },
+		std::pmr::get_default_resource()) };
+
+	meshlets.meshlets.resize(built.meshlets.size());
+	meshlets.vertices.resize(built.vertices.size());
+	meshlets.triangles.resize(built.triangles.size());
+	meshlets.bounds.resize(built.bounds.size());
+
+	return meshlets;
+}
+
+MeshletBuilder::MeshletSpans MeshletBuilder::build(std::span<std::uint32_t> indices, void* vertices, std::size_t& vertexCount,
+	std::size_t vertexSize, Settings settings, const MeshletSpans& storage, std::pmr::memory_resource* scratch)
+{
+	const Settings requested{ settings };
+	settings = clampSettings(settings);
+
+	if (settings.maxVertices != requested.maxVertices || settings.maxTriangles != requested.maxTriangles)
+	{
+		std::cerr << "Warning: meshlet limits of " << requested.maxVertices << " vertices & " << requested.maxTriangles
+			<< " triangles aren't supported. Using " << settings.maxVertices << " & " << settings.maxTriangles << ".\n";
+	}
+
+	if (indices.empty() || vertexCount == 0)
+	{
+		return {};
+	}
+
+	// Sized in the assert so release builds don't compute it
+	assert([&] {
+		const StorageSize size{ getStorageSize(indices.size(), settings) };
+		return storage.meshlets.size() >= size.meshletCount && storage.bounds.size() >= size.meshletCount
+			&& storage.vertices.size() >= size.vertexCount && storage.triangles.size() >= size.triangleByteCount;
+		}());
+
+	MeshoptScratchScope scratchScope{ scratch };
+
+	if (settings.optimizeVertexCache)
+	{
+		optimizeVertexCache(indices, vertexCount, scratch);
+	}
+
+	if (settings.optimizeVertexFetch)
+	{
+		vertexCount = optimizeVertexFetch(indices, vertices, vertexCount, vertexSize, scratch);
+	}
+
+	const float* positions{ static_cast<const float*>(vertices) };
+
+	std::size_t meshletCount{ meshopt_buildMeshlets(storage.meshlets.data(), storage.vertices.data(), storage.triangles.data(),
+		indices.data(), indices.size(), positions, vertexCount, vertexSize, settings.maxVertices, settings.maxTriangles, settings.coneWeight) };
+
+	if (meshletCount == 0)
+	{
+		return {};
+	}
+
+	const meshopt_Meshlet& last{ storage.meshlets[meshletCount - 1] };
+	const MeshletSpans meshlets
+	{
+		.meshlets{ storage.meshlets.first(meshletCount) },
+		.vertices{ storage.vertices.first(last.vertex_offset + last.vertex_count) },
+		.triangles{ storage.triangles.first(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3u)) },
+		.bounds{ storage.bounds.first(meshletCount) },
+	};
+
+	for (std::size_t i{ 0 }; i < meshletCount; ++i)
+	{
+		const auto& meshlet{ meshlets.meshlets[i] };
+
+		if (settings.optimizeMeshlets)
+		{
+			meshopt_optimizeMeshlet(&meshlets.vertices[meshlet.vertex_offset], &meshlets.triangles[meshlet.triangle_offset],
+				meshlet.triangle_count, meshlet.vertex_count);
+		}
+
+		meshlets.bounds[i] = meshopt_computeMeshletBounds(&meshlets.vertices[meshlet.vertex_offset],
+			&meshlets.triangles[meshlet.triangle_offset], meshlet.triangle_count, positions, vertexCount, vertexSize);
+	}
+
+	if (settings.spatialSort)
+	{
+		sortMeshletsSpatially(meshlets, scratch);
+	}
+
+	return meshlets;
+}
+
+MeshletBuilder::StorageSize MeshletBuilder::getStorageSize(std::size_t indexCount, Settings settings)
+{
+	settings = clampSettings(settings);
+
+	const std::size_t meshletCount{ meshopt_buildMeshletsBound(indexCount, settings.maxVertices, settings.maxTriangles) };
+
+	return { .meshletCount{ meshletCount }, .vertexCount{ meshletCount * settings.maxVertices },
+		.triangleByteCount{ meshletCount * settings.maxTriangles * 3 } };
+}
+
+MeshletBuilder::Stats MeshletBuilder::measure(const Meshlets& meshlets, const void* vertices, std::size_t vertexSize)
+{
+	Stats stats{};
+	stats.meshletCount = meshlets.meshlets.size();
+	stats.vertexCount = meshlets.vertices.size();
+
+	if (meshlets.meshlets.empty())
+	{
+		return stats;
+	}
+
+	// The index stream as drawn, into the meshlet vertex copies
+	std::vector<std::uint32_t> drawnIndices{};
+	for (const auto& meshlet : meshlets.meshlets)
+	{
+		for (unsigned int i{ 0 }; i < meshlet.triangle_count * 3; ++i)
+		{
+			drawnIndices.push_back(meshlet.vertex_offset + meshlets.triangles[meshlet.triangle_offset + i]);
+		}
+	}
+	stats.triangleCount = drawnIndices.size() / 3;
+
+	{
+		std::vector<std::uint32_t> insertTimes(stats.vertexCount, 0);
+		std::uint32_t time{ vertexCacheSize + 1 };
+		std::size_t misses{ 0 };
+
+		for (auto index : drawnIndices)
+		{
+			// FIFO: hits don't refresh an entry
+			if (time - insertTimes[index] > vertexCacheSize)
+			{
+				insertTimes[index] = time++;
+				++misses;
+			}
+		}
+
+		stats.acmr = static_cast<float>(misses) / stats.triangleCount;
+	}
+
+	{
+		constexpr std::size_t lineSize{ 64 };
+		constexpr std::size_t lineCount{ 256 };
+		std::vector<std::size_t> tags(lineCount, ~std::size_t{ 0 });
+		std::size_t bytesFetched{ 0 };
+
+		for (auto index : drawnIndices)
+		{
+			std::size_t firstLine{ index * vertexSize / lineSize };
+			std::size_t lastLine{ ((index + 1) * vertexSize - 1) / lineSize };
+
+			for (std::size_t line{ firstLine }; line <= lastLine; ++line)
+			{
+				if (tags[line % lineCount] != line)
+				{
+					tags[line % lineCount] = line;
+					bytesFetched += lineSize;
+				}
+			}
+		}
+
+		stats.overfetch = static_cast<float>(bytesFetched) / (stats.vertexCount * vertexSize);
+	}
+
+	auto getDrawnPosition{ [&](std::uint32_t drawnIndex) {
+		return getPosition(vertices, vertexSize, meshlets.vertices[drawnIndex]);
+		} };
+
+	glm::vec3 center{ 0.0f };
+	for (auto vertex : meshlets.vertices)
+	{
+		center += getPosition(vertices, vertexSize, vertex) / static_cast<float>(meshlets.vertices.size());
+	}
+
+	float radius{ 0.0f };
+	for (auto vertex : meshlets.vertices)
+	{
+		radius = std::max(radius, glm::length(getPosition(vertices, vertexSize, vertex) - center));
+	}
+
+	constexpr int sampleCount{ 64 };
+	std::mt19937 generator{ 1 };
+	std::uniform_real_distribution<float> offsets{ -0.5f, 0.5f };
+
+	std::size_t neededTriangles{ 0 };
+	std::size_t keptTriangles{ 0 };
+	std::size_t coneCulledMeshlets{ 0 };
+
+	for (int sample{ 0 }; sample < sampleCount; ++sample)
+	{
+		// Keeps everything on the positive side of the plane
+		glm::vec3 normal{ randomUnitVector(generator) };
+		float distance{ glm::dot(normal, center) + offsets(generator) * radius };
+
+		std::size_t triangle{ 0 };
+		for (std::size_t i{ 0 }; i < meshlets.meshlets.size(); ++i)
+		{
+			const auto& meshlet{ meshlets.meshlets[i] };
+			const auto& bounds{ meshlets.bounds[i] };
+
+			glm::vec3 meshletCenter{ bounds.center[0], bounds.center[1], bounds.center[2] };
+			if (glm::dot(normal, meshletCenter) - distance > -bounds.radius)
+			{
+				keptTriangles += meshlet.triangle_count;
+			}
+
+			for (unsigned int n{ 0 }; n < meshlet.triangle_count; ++n, ++triangle)
+			{
+				for (int k{ 0 }; k < 3; ++k)
+				{
+					if (glm::dot(normal, getDrawnPosition(drawnIndices[triangle * 3 + k])) > distance)
+					{
+						++neededTriangles;
+						break;
+					}
+				}
+			}
+		}
+
+		glm::vec3 viewDirection{ randomUnitVector(generator) };
+		for (const auto& bounds : meshlets.bounds)
+		{
+			glm::vec3 coneAxis{ bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] };
+			if (glm::dot(viewDirection, coneAxis) >= bounds.cone_cutoff)
+			{
+				++coneCulledMeshlets;
+			}
+		}
+	}
+
+	stats.sphereCullEfficiency = keptTriangles > 0 ? static_cast<float>(neededTriangles) / keptTriangles : 1.0f;
+	stats.coneCullRate = static_cast<float>(coneCulledMeshlets) / (sampleCount * meshlets.meshlets.size());
+
+	return stats;
+}
+
+void MeshletBuilder::writeReport(std::ostream& out, const std::filesystem::path& path, const std::vector<Settings>& settings)
+{
+	fastgltf::Parser parser{ fastgltf::Extensions::EXT_meshopt_compression };
+
+	auto data{ fastgltf::GltfDataBuffer::FromPath(path) };
+	if (auto error{ data.error() }; error != fastgltf::Error::None)
+	{
+		std::cerr << "Failed to load GLTF file. Error code: "
+			<< static_cast<int>(error) << '\n';
+		return;
+	}
+
+	auto asset{ parser.loadGltf(data.get(), path.parent_path(), fastgltf::Options::LoadExternalBuffers) };
+	if (auto error{ asset.error() }; error != fastgltf::Error::None)
+	{
+		std::cerr << "Failed to load GLTF file. Error code: "
+			<< static_cast<int>(error) << '\n';
+		return;
+	}
+
+	JobSystem jobSystem{};
+	if (!MeshCodec::decodeCompressedBufferViews(jobSystem, asset.get()))
+	{
+		std::cerr << "Failed to decode EXT_meshopt_compression buffer views\n";
+		return;
+	}
+
+	// Same size as ModelAsset::Vertex, so vertex fetch is measured with the renderer's stride
+	struct ReportVertex
+	{
+		glm::vec3 pos{};
+		float padding[5]{};
+	};
+	static_assert(sizeof(ReportVertex) == 32);
+
+	struct PrimitiveData
+	{
+		std::vector<ReportVertex> vertices{};
+		std::vector<std::uint32_t> indices{};
+	};
+
+	std::vector<PrimitiveData> primitives{};
+	std::size_t sourceVertexCount{ 0 };
+	for (const auto& mesh : asset->meshes)
+	{
+		for (const auto& primitive : mesh.primitives)
+		{
+			auto position{ primitive.findAttribute("POSITION") };
+			if (!primitive.indicesAccessor.has_value() || position == primitive.attributes.end())
+			{
+				continue;
+			}
+
+			PrimitiveData& newPrimitive{ primitives.emplace_back() };
+
+			const auto& indexAccessor{ asset->accessors[primitive.indicesAccessor.value()] };
+			newPrimitive.indices.resize(indexAccessor.count);
+			fastgltf::iterateAccessorWithIndex<std::uint32_t>(asset.get(), indexAccessor, [&](std::uint32_t val, std::size_t k) {
+				newPrimitive.indices[k] = val;
+				});
+
+			const auto& positionAccessor{ asset->accessors[position->second] };
+			newPrimitive.vertices.resize(positionAccessor.count);
+			fastgltf::iterateAccessorWithIndex<glm::vec3>(asset.get(), positionAccessor, [&](glm::vec3 v, std::size_t k) {
+				newPrimitive.vertices[k].pos = v;
+				});
+
+			sourceVertexCount += newPrimitive.vertices.size();
+		}
+	}
+
+	out << "Meshlet report for " << path.string() << ": " << primitives.size() << " primitives, " << sourceVertexCount << " vertices\n";
+	out << "Vertex duplication is drawn vertices / source vertices. Sphere efficiency and cone culling are averaged over random\n"
+		"planes & view directions. ACMR uses a " << vertexCacheSize << " entry FIFO, overfetch a 16 KB direct mapped cache.\n\n";
+
+	out << std::left << std::setw(44) << "settings" << std::right
+		<< std::setw(10) << "meshlets" << std::setw(10) << "avg tris" << std::setw(11) << "avg verts"
+		<< std::setw(10) << "vtx dup" << std::setw(8) << "ACMR" << std::setw(11) << "overfetch"
+		<< std::setw(12) << "sphere eff" << std::setw(11) << "cone cull" << std::setw(12) << "build ms" << '\n';
+
+	for (const auto& setting : settings)
+	{
+		Stats total{};
+		double acmrSum{ 0.0 };
+		double overfetchSum{ 0.0 };
+		double sphereSum{ 0.0 };
+		double coneSum{ 0.0 };
+		double buildTime{ 0.0 };
+
+		for (const auto& primitive : primitives)
+		{
+			std::vector<ReportVertex> vertices{ primitive.vertices };
+			std::vector<std::uint32_t> indices{ primitive.indices };
+			std::size_t vertexCount{ vertices.size() };
+
+			auto buildStart{ std::chrono::high_resolution_clock::now() };
+			Meshlets meshlets{ build(indices, vertices.data(), vertexCount, sizeof(ReportVertex), setting) };
+			auto buildEnd{ std::chrono::high_resolution_clock::now() };
+			buildTime += std::chrono::duration_cast<std::chrono::microseconds>(buildEnd - buildStart).count() / 1000.0;
+
+			Stats stats{ measure(meshlets, vertices.data(), sizeof(ReportVertex)) };
+
+			total.meshletCount += stats.meshletCount;
+			total.triangleCount += stats.triangleCount;
+			total.vertexCount += stats.vertexCount;
+
+			acmrSum += static_cast<double>(stats.acmr) * stats.triangleCount;
+			overfetchSum += static_cast<double>(stats.overfetch) * stats.vertexCount;
+			sphereSum += static_cast<double>(stats.sphereCullEfficiency) * stats.triangleCount;
+			coneSum += static_cast<double>(stats.coneCullRate) * stats.meshletCount;
+		}
+
+		auto average{ [](double sum, std::size_t weight) { return weight > 0 ? sum / weight : 0.0; } };
+
+		out << std::left << std::setw(44) << describe(setting) << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << total.meshletCount
+			<< std::setw(10) << average(static_cast<double>(total.triangleCount), total.meshletCount)
+			<< std::setw(11) << average(static_cast<double>(total.vertexCount), total.meshletCount)
+			<< std::setw(10) << average(static_cast<double>(total.vertexCount), sourceVertexCount)
+			<< std::setw(8) << average(acmrSum, total.triangleCount)
+			<< std::setw(11) << average(overfetchSum, total.vertexCount)
+			<< std::setw(12) << average(sphereSum, total.triangleCount)
+			<< std::setw(11) << average(coneSum, total.meshletCount)
+			<< std::setw(12) << buildTime << '\n';
+	}
+}
+
+std::vector<MeshletBuilder::Settings> MeshletBuilder::getReportSettings()
+{
+	const Settings raw{ .optimizeVertexCache{ false }, .optimizeVertexFetch{ false }, .optimizeMeshlets{ false }, .spatialSort{ false } };
+
+	Settings cacheOnly{ raw };
+	cacheOnly.optimizeVertexCache = true;
+
+	Settings fetchOnly{ raw };
+	fetchOnly.optimizeVertexFetch = true;
+
+	Settings meshletOnly{ raw };
+	meshletOnly.optimizeMeshlets = true;
+
+	Settings spatialOnly{ raw };
+	spatialOnly.spatialSort = true;
+
+	const Settings all{};
+
+	std::vector<Settings> settings{ raw, cacheOnly, fetchOnly, meshletOnly, spatialOnly, all };
+
+	for (float coneWeight : { 0.25f, 0.5f })
+	{
+		Settings cone{ all };
+		cone.coneWeight = coneWeight;
+		settings.push_back(cone);
+	}
+
+	constexpr std::size_t limits[][2]{ { 32, 64 }, { 96, 128 }, { 128, 128 } };
+	for (const auto& limit : limits)
+	{
+		Settings limited{ all };
+		limited.maxVertices = limit[0];
+		limited.maxTriangles = limit[1];
+		settings.push_back(limited);
+	}
+
+	return settings;
+}
+
+std::string MeshletBuilder::describe(const Settings& settings)
+{
+	std::string description{ std::to_string(settings.maxVertices) + "v " + std::to_string(settings.maxTriangles) + "t" };
+
+	if (settings.coneWeight > 0.0f)
+	{
+		description += " cone " + std::to_string(settings.coneWeight).substr(0, 4);
+	}
+	if (settings.optimizeVertexCache)
+	{
+		description += " +cache";
+	}
+	if (settings.optimizeVertexFetch)
+	{
+		description += " +fetch";
+	}
+	if (settings.optimizeMeshlets)
+	{
+		description += " +meshlet";
+	}
+	if (settings.spatialSort)
+	{
+		description += " +morton";
+	}
+	if (!settings.optimizeVertexCache && !settings.optimizeVertexFetch && !settings.optimizeMeshlets && !settings.spatialSort)
+	{
+		description += " raw";
+	}
+
+	return description;
+}
\ No newline at end of file
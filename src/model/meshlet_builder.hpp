@@ -0,0 +1,115 @@
+#pragma once
+
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <filesystem>
+#include <memory_resource>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Splits a primitive into meshlets, the unit that gets culled and drawn. Vertices are opaque to the builder apart from
+// a float3 position in their first 12 bytes, which is the layout meshoptimizer expects too.
+class MeshletBuilder final
+{
+public:
+
+	struct Settings
+	{
+		// Both limits are bounded by the 7 bits the (clusterId << 7) | index encoding has for local vertex indices,
+		// and the 7 bits per cluster visibility buffer ids have for triangles. meshoptimizer also needs maxTriangles % 4 == 0
+		std::size_t maxVertices{ 64 };
+		std::size_t maxTriangles{ 124 };
+
+		// 0 only optimizes for tight bounding spheres. Towards 1 the normal cones get narrower, for backface culling
+		float coneWeight{ 0.0f };
+
+		// Reorders triangles for the post-transform cache, then vertices in order of first use, before building meshlets
+		bool optimizeVertexCache{ true };
+		bool optimizeVertexFetch{ true };
+
+		// Reorders vertices and triangles inside each meshlet for rasterizer locality
+		bool optimizeMeshlets{ true };
+
+		// Sorts a primitive's meshlets along a Morton curve through their centers, so neighbours in memory are neighbours in space
+		bool spatialSort{ true };
+	};
+
+	static constexpr std::size_t maxMeshletVertices{ 128 };
+	static constexpr std::size_t maxMeshletTriangles{ 128 };
+
+	struct Meshlets
+	{
+		std::vector<meshopt_Meshlet> meshlets{};
+
+		// Indices into the primitive's vertices
+		std::vector<unsigned int> vertices{};
+
+		// Indices into the meshlet's vertices. Every meshlet starts on a multiple of 4
+		std::vector<unsigned char> triangles{};
+
+		std::vector<meshopt_Bounds> bounds{};
+	};
+
+	// The same, in storage the caller owns
+	struct MeshletSpans
+	{
+		std::span<meshopt_Meshlet> meshlets{};
+		std::span<unsigned int> vertices{};
+		std::span<unsigned char> triangles{};
+		std::span<meshopt_Bounds> bounds{};
+	};
+
+	// Most build() can write for indexCount indices. bounds needs as many as meshlets
+	struct StorageSize
+	{
+		std::size_t meshletCount{ 0 };
+		std::size_t vertexCount{ 0 };
+		std::size_t triangleByteCount{ 0 };
+	};
+
+	// Measured on the layout the renderer draws: each meshlet's vertices copied out in order, indexed by its local triangles
+	struct Stats
+	{
+		std::size_t meshletCount{ 0 };
+		std::size_t triangleCount{ 0 };
+		std::size_t vertexCount{ 0 };
+
+		// Post-transform cache misses per triangle, with a 16 entry FIFO
+		float acmr{ 0.0f };
+
+		// Bytes fetched through a small direct mapped cache / vertex buffer size
+		float overfetch{ 0.0f };
+
+		// Over random planes through the primitive: triangles touching the kept side / triangles of meshlets whose sphere
+		// touches it. 1 means sphere culling never keeps a triangle it didn't need
+		float sphereCullEfficiency{ 0.0f };
+
+		// Fraction of meshlets whose normal cone rejects them, averaged over random orthographic view directions
+		float coneCullRate{ 0.0f };
+	};
+
+	// indices and vertices are rewritten in place when the settings reorder them. vertexCount shrinks if vertices are unused
+	static Meshlets build(std::vector<std::uint32_t>& indices, void* vertices, std::size_t& vertexCount, std::size_t vertexSize,
+		Settings settings);
+
+	// Writes into storage sized with getStorageSize() and returns the packed start of it that was used. Every temporary
+	// comes from scratch, so with an arena building makes no heap allocations of its own
+	static MeshletSpans build(std::span<std::uint32_t> indices, void* vertices, std::size_t& vertexCount, std::size_t vertexSize,
+		Settings settings, const MeshletSpans& storage, std::pmr::memory_resource* scratch);
+
+	static StorageSize getStorageSize(std::size_t indexCount, Settings settings);
+
+	static Stats measure(const Meshlets& meshlets, const void* vertices, std::size_t vertexSize);
+
+	// Offline comparison of settings. Builds every primitive of the glTF file with each one and prints a table of the totals
+	static void writeReport(std::ostream& out, const std::filesystem::path& path, const std::vector<Settings>& settings);
+
+	// Raw index order, each optimization on its own, everything together, and a few different limits & cone weights
+	static std::vector<Settings> getReportSettings();
+
+	static std::string describe(const Settings& settings);
+};
\ No newline at end of file
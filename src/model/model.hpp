@@ -1,111 +1,34 @@
 #pragma once
 
-#include "glad/glad.h"
-#include "glm/glm.hpp"
+#include "../jobs/job_system.hpp"
+#include "../profiling/load_profiler.hpp"
+#include "image_streamer.hpp"
+#include "meshlet_builder.hpp"
+#include "model_asset.hpp"
 
-#include "fastgltf/core.hpp"
+#include "glad/glad.h"
 
-#include <cstddef> // for std::size_t
-#include <cstdint>
 #include <filesystem>
 #include <vector>
 
+// The GL side of a model: uploads a ModelAsset's images, creates its samplers and makes bindless handles for its
+// textures, which go into the asset's materials. Everything CPU-side is in mAsset.
 // ModelObject is not guaranteed to contain any data
 class ModelObject final
 {
 public:
 
-	struct Vertex
-	{
-		glm::vec3 pos{};
-		float u{};
-		glm::vec3 normal{ 0.0f, 0.0f, 1.0f };
-		float v{};
-	};
-
-	struct Texture
-	{
-		int sampler{};
-		int image{};
-
-		GLuint64 bindlessHandle{};
-	};
-
-	struct Material
-	{
-		glm::vec4 colorFactor{};
-
-		GLuint64 colorTexture{};
-		GLuint64 metallicRoughnessTexture{};
-		GLuint64 normalTexture{};
-
-		GLfloat metallicFactor{};
-		GLfloat roughnessFactor{};
-
-		GLint hasColorTexture{ false };
-		GLint hasMetallicRoughnessTexture{ false };
-		GLint hasNormalTexture{ false };
-
-		GLint alphaMask{};
-		GLfloat alphaCutoff{};
-		GLint alphaBlend{};
-
-		GLint64 padding{};
-	};
-
-	struct Meshlet
-	{
-		glm::vec4 boundingSphere{};
-
-		GLint triangleCount{};
-		GLuint firstIndex{};
-		GLint sceneVertexOffset{};
-	};
-
-	// Clusters are instances of meshlets.
-	struct Cluster
-	{
-		glm::vec4 boundingSphere{};
-
-		GLuint transformIndex{};
-		GLint materialIndex{ -1 };
-
-		GLuint indexCount{};
-		GLuint firstIndex{};
-		GLint vertexOffset{};
-
-		GLuint viewId{};
-
-		GLint padding1{};
-		GLint padding2{};
-	};
-
-	struct Primitive
-	{
-		int sceneMaterialIndex{ -1 };
-		int localMaterialIndex{ -1 };
-
-		std::vector<Meshlet> meshlets{};
-	};
-
-	struct Mesh
-	{
-		std::vector<Primitive> primitives{};
-	};
-
-	struct Node
-	{
-		std::vector<int> children{};
-		int mesh{ -1 };
-
-		glm::mat4 localTransform{};
-	};
-
 	// No operations should expect/require the ModelObject to contain data
 	ModelObject() = default;
 
-	ModelObject(const std::filesystem::path& path, int sceneVertexOffset, int sceneIndexOffset, 
-		int sceneMaterialOffset, int sceneTransformOffset, const std::filesystem::path& directory = "assets");
+	// Builds the ModelAsset on jobSystem, then uploads it. Everything touching GL stays on the calling thread.
+	// Images are streamed, so only a bounded amount of decoded pixels is ever resident
+	ModelObject(JobSystem& jobSystem, const std::filesystem::path& path, int sceneVertexOffset, int sceneIndexOffset,
+		int sceneMaterialOffset, int sceneTransformOffset, const std::filesystem::path& directory = "assets",
+		const MeshletBuilder::Settings& meshletSettings = {}, LoadProfiler* profiler = nullptr);
+
+	// Must be called on the GL thread. The asset's glTF buffers are released once its images are uploaded
+	ModelObject(JobSystem& jobSystem, ModelAsset&& asset, LoadProfiler* profiler = nullptr);
 
 	ModelObject(const ModelObject&) = delete;
 	ModelObject& operator=(const ModelObject&) = delete;
@@ -115,38 +38,21 @@ public:
 
 	~ModelObject();
 
-	void buildPrimitiveUniforms(int sceneMaterialOffset, int sceneTransformOffset);
-	void buildPrimitiveUniformsFromNodeAndChildren(const Node& node, const glm::mat4& parentTransform, 
-		int sceneMaterialOffset, int sceneTransformOffset);
-
-	std::vector<Node> mNodes{};
-	std::vector<int> mRootNodes{};
-
-	std::vector<Mesh> mMeshes{};
-	int mPrimitiveCount{};
-
-	std::vector<Cluster> mClusters{};
+	ModelAsset mAsset{};
 
 	std::vector<GLuint> mSamplers{};
 	GLuint mDefaultSampler{};
 	std::vector<GLuint> mImages{};
-	std::vector<Texture> mTextures{};
-	
-	std::vector<glm::mat4> mGlobalTransforms{};
-	std::vector<Material> mMaterials{};
-
-	std::vector<Vertex> mVertices{};
-	std::vector<std::uint32_t> mIndices{};
-	int mBlendIndexCount{};
+	// One per ModelAsset::Texture
+	std::vector<GLuint64> mTextureHandles{};
+	ImageStreamer::Stats mImageStreamStats{};
 
 private:
-	
-	void loadNodes(const fastgltf::Expected<fastgltf::Asset>& asset);
-	void loadMeshes(fastgltf::Expected<fastgltf::Asset>& asset, GLint sceneVertexOffset, GLuint sceneIndexOffset, int sceneMaterialOffset);
-	void loadSamplers(const fastgltf::Expected<fastgltf::Asset>& asset);
-	void loadImages(const fastgltf::Expected<fastgltf::Asset>& asset);
-	void loadTextures(const fastgltf::Expected<fastgltf::Asset>& asset);
-	void loadMaterials(const fastgltf::Expected<fastgltf::Asset>& asset);
+
+	void createSamplers();
+	// Returns which images failed to load
+	std::vector<bool> uploadImages(JobSystem& jobSystem);
+	void createTextureHandles(const std::vector<bool>& failedImages);
 
 	void moveFrom(ModelObject&& o);
 	void cleanup();
@@ -0,0 +1,648 @@
+#include "model_asset.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "../profiling/load_profiler.hpp"
+#include "image_decoder.hpp"
+#include "load_arena.hpp"
+#include "mesh_codec.hpp"
+#include "meshlet_builder.hpp"
+#include "transform_kernel.hpp"
+
+#include "fastgltf/core.hpp"
+#include "fastgltf/types.hpp"
+#include "fastgltf/tools.hpp"
+
+#include "fastgltf/glm_element_traits.hpp"
+#include "glm/glm.hpp"
+
+#include "glad/glad.h"
+
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <algorithm> // for copy
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <utility> // for move()
+#include <variant>
+#include <vector>
+
+
+
+glm::mat4 calculateTrsMatrix(const fastgltf::TRS& trs)
+{
+	return TransformKernel::composeTrs(glm::vec3{ trs.translation.x(), trs.translation.y(), trs.translation.z() },
+		glm::vec4{ trs.rotation.x(), trs.rotation.y(), trs.rotation.z(), trs.rotation.w() },
+		glm::vec3{ trs.scale.x(), trs.scale.y(), trs.scale.z() });
+}
+
+glm::mat4 toGlmMat4(const fastgltf::math::fmat4x4& m)
+{
+	glm::mat4 newMat4{};
+	for (int i{ 0 }; i < 4; ++i)
+	{
+		for (int n{ 0 }; n < 4; ++n)
+		{
+			newMat4[i][n] = m[i][n];
+		}
+	}
+
+	return newMat4;
+}
+
+
+
+ModelAsset::ModelAsset(JobSystem& jobSystem, const std::filesystem::path& path, int sceneVertexOffset,
+	int sceneIndexOffset, int sceneMaterialOffset, int sceneTransformOffset, const std::filesystem::path& directory,
+	const MeshletBuilder::Settings& meshletSettings, LoadProfiler* profiler)
+{
+	fastgltf::Parser parser{ fastgltf::Extensions::KHR_texture_basisu | fastgltf::Extensions::EXT_meshopt_compression };
+
+	std::optional<LoadProfiler::Scope> stage{ std::in_place, profiler, "FromPath" };
+	auto data{ fastgltf::GltfDataBuffer::FromPath(path) };
+	if (auto error{ data.error() }; error != fastgltf::Error::None)
+	{
+		std::cerr << "Failed to load GLTF file. Error code: "
+			<< static_cast<int>(error) << '\n';
+	}
+
+	// External images are left as URIs and read by the image decoder while they're in flight
+	stage.emplace(profiler, "loadGltf");
+	auto asset{ parser.loadGltf(data.get(), directory, fastgltf::Options::LoadExternalBuffers) };
+	if (auto error{ asset.error() }; error != fastgltf::Error::None)
+	{
+		std::cerr << "Failed to load GLTF file. Error code: "
+			<< static_cast<int>(error) << '\n';
+	}
+
+	stage.emplace(profiler, "validate");
+	if (auto error{ fastgltf::validate(asset.get()) }; error != fastgltf::Error::None)
+	{
+		std::cerr << "Failed to validate GLTF file. Error code: "
+			<< static_cast<int>(error) << '\n';
+	}
+
+	// Before anything reads an accessor, so compressed views look like plain ones from here on
+	stage.emplace(profiler, "decodeCompressedBufferViews");
+	if (!MeshCodec::decodeCompressedBufferViews(jobSystem, asset.get()))
+	{
+		std::cerr << "Failed to decode EXT_meshopt_compression buffer views\n";
+	}
+
+	if (asset->scenes.size() > 1)
+	{
+		std::cerr << "Warning: GLTF file contains multiple scenes. All but the first will be ignored.\n";
+	}
+
+	stage.emplace(profiler, "loadNodes");
+	mNodes = buildNodeTable(asset.get());
+
+	stage.emplace(profiler, "loadMeshes");
+	loadMeshes(jobSystem, asset, sceneVertexOffset, sceneIndexOffset, sceneMaterialOffset, meshletSettings);
+
+	stage.emplace(profiler, "loadSamplers");
+	loadSamplers(asset);
+
+	stage.emplace(profiler, "loadImages");
+	loadImages(asset, directory);
+
+	stage.emplace(profiler, "loadTextures");
+	loadTextures(asset);
+
+	stage.emplace(profiler, "loadMaterials");
+	loadMaterials(asset);
+
+	stage.emplace(profiler, "buildPrimitiveUniforms");
+	buildPrimitiveUniforms(jobSystem, sceneTransformOffset);
+
+	stage.reset();
+
+	mGltf.emplace(std::move(asset.get()));
+}
+
+void ModelAsset::releaseSources()
+{
+	mImageSources.clear();
+	mGltf.reset();
+}
+
+
+
+void ModelAsset::buildPrimitiveUniforms(JobSystem& jobSystem, int sceneTransformOffset)
+{
+	// Where each node's transforms & clusters go, so the nodes can be written in any order
+	mNodeUniforms.resize(mNodes.size());
+	std::size_t transformCount{ 0 };
+	std::size_t clusterCount{ 0 };
+	for (std::size_t i{ 0 }; i < mNodes.size(); ++i)
+	{
+		mNodeUniforms[i] = { .firstTransform{ transformCount }, .firstCluster{ clusterCount } };
+
+		if (mNodes.meshes[i] != -1)
+		{
+			for (const auto& primitive : getPrimitives(mMeshes[mNodes.meshes[i]]))
+			{
+				++transformCount;
+				clusterCount += primitive.meshletCount;
+			}
+		}
+	}
+
+	mNodeTransforms.resize(mNodes.size());
+	TransformKernel::evaluate(jobSystem, mNodes.localTransforms, mNodes.parents, mNodes.levelOffsets, mNodeTransforms);
+
+	mGlobalTransforms.resize(transformCount);
+	mTransformScales.resize(transformCount);
+	mClusters.assign(clusterCount, {});
+
+	jobSystem.parallelFor(mNodes.size(), TransformKernel::grainSize, [&](std::size_t firstNode, std::size_t lastNode) {
+		for (std::size_t i{ firstNode }; i < lastNode; ++i)
+		{
+			if (mNodes.meshes[i] == -1)
+			{
+				continue;
+			}
+
+			const float scale{ TransformKernel::getMaxScale(mNodeTransforms[i]) };
+			std::size_t transformIndex{ mNodeUniforms[i].firstTransform };
+			std::size_t clusterIndex{ mNodeUniforms[i].firstCluster };
+
+			for (const auto& primitive : getPrimitives(mMeshes[mNodes.meshes[i]]))
+			{
+				mGlobalTransforms[transformIndex] = mNodeTransforms[i];
+				mTransformScales[transformIndex] = scale;
+
+				for (const auto& cluster : getMeshlets(primitive))
+				{
+					Cluster& newCluster{ mClusters[clusterIndex++] };
+
+					newCluster.boundingSphere = cluster.boundingSphere;
+
+					newCluster.transformIndex = transformIndex + sceneTransformOffset;
+					newCluster.materialIndex = primitive.sceneMaterialIndex;
+
+					newCluster.indexCount = cluster.triangleCount * 3;
+					newCluster.firstIndex = cluster.firstIndex;
+					newCluster.vertexOffset = cluster.sceneVertexOffset;
+				}
+
+				++transformIndex;
+			}
+		}
+		});
+}
+
+std::span<const ModelAsset::Primitive> ModelAsset::getPrimitives(const Mesh& mesh) const
+{
+	return std::span{ mPrimitives }.subspan(mesh.firstPrimitive, mesh.primitiveCount);
+}
+
+std::span<const ModelAsset::Meshlet> ModelAsset::getMeshlets(const Primitive& primitive) const
+{
+	return std::span{ mMeshlets }.subspan(primitive.firstMeshlet, primitive.meshletCount);
+}
+
+ModelAsset::NodeTable ModelAsset::buildNodeTable(const fastgltf::Asset& asset)
+{
+	NodeTable table{};
+	if (asset.scenes.empty())
+	{
+		return table;
+	}
+
+	// Everything is read from the glTF nodes in file order first, into compact arrays with every child list in one
+	// index array. Walking breadth-first straight over the glTF nodes jumps around them, which costs more than the
+	// walk itself once files reach a few hundred thousand nodes
+	const std::size_t sourceCount{ asset.nodes.size() };
+	std::vector<glm::mat4> sourceTransforms(sourceCount);
+	std::vector<int> sourceMeshes(sourceCount);
+	std::vector<int> sourceFirstChildren(sourceCount + 1);
+
+	std::size_t childCount{ 0 };
+	for (const auto& node : asset.nodes)
+	{
+		childCount += node.children.size();
+	}
+	std::vector<int> sourceChildren{};
+	sourceChildren.reserve(childCount);
+
+	for (std::size_t i{ 0 }; i < sourceCount; ++i)
+	{
+		const auto& node{ asset.nodes[i] };
+
+		sourceTransforms[i] = std::holds_alternative<fastgltf::TRS>(node.transform)
+			? calculateTrsMatrix(std::get<fastgltf::TRS>(node.transform))
+			: toGlmMat4(std::get<fastgltf::math::fmat4x4>(node.transform));
+		sourceMeshes[i] = node.meshIndex ? static_cast<int>(*node.meshIndex) : -1;
+
+		sourceFirstChildren[i] = static_cast<int>(sourceChildren.size());
+		sourceChildren.insert(sourceChildren.end(), node.children.begin(), node.children.end());
+	}
+	sourceFirstChildren[sourceCount] = static_cast<int>(sourceChildren.size());
+
+	table.parents.reserve(sourceCount);
+	table.firstChildren.reserve(sourceCount);
+	table.childCounts.reserve(sourceCount);
+	table.sourceIndices.reserve(sourceCount);
+
+	// The table is its own queue: appending a node's children while walking it front to back is a breadth-first walk.
+	// glTF only allows a node one parent, but a broken file could reach one twice or loop
+	std::vector<bool> isQueued(sourceCount, false);
+	auto enqueue{ [&](std::size_t sourceIndex, int parent) {
+		if (sourceIndex >= sourceCount || isQueued[sourceIndex])
+		{
+			return false;
+		}
+		isQueued[sourceIndex] = true;
+
+		table.parents.push_back(parent);
+		table.firstChildren.push_back(0);
+		table.childCounts.push_back(0);
+		table.sourceIndices.push_back(static_cast<int>(sourceIndex));
+
+		return true;
+		} };
+
+	for (auto root : asset.scenes[0].nodeIndices)
+	{
+		enqueue(root, -1);
+	}
+
+	int levelEnd{ static_cast<int>(table.size()) };
+	for (int i{ 0 }; i < static_cast<int>(table.size()); ++i)
+	{
+		if (i == levelEnd)
+		{
+			table.levelOffsets.push_back(levelEnd);
+			levelEnd = static_cast<int>(table.size());
+		}
+
+		const int source{ table.sourceIndices[i] };
+		table.firstChildren[i] = static_cast<int>(table.size());
+		for (int child{ sourceFirstChildren[source] }; child < sourceFirstChildren[source + 1]; ++child)
+		{
+			if (enqueue(sourceChildren[child], i))
+			{
+				++table.childCounts[i];
+			}
+		}
+	}
+
+	if (table.size() > 0)
+	{
+		table.levelOffsets.push_back(static_cast<int>(table.size()));
+	}
+
+	table.localTransforms.resize(table.size());
+	table.meshes.resize(table.size());
+	for (std::size_t i{ 0 }; i < table.size(); ++i)
+	{
+		table.localTransforms[i] = sourceTransforms[table.sourceIndices[i]];
+		table.meshes[i] = sourceMeshes[table.sourceIndices[i]];
+	}
+
+	return table;
+}
+
+
+
+void ModelAsset::loadMeshes(JobSystem& jobSystem, fastgltf::Expected<fastgltf::Asset>& asset, GLint sceneVertexOffset,
+	GLuint sceneIndexOffset, int sceneMaterialOffset, const MeshletBuilder::Settings& meshletSettings)
+{
+	// Sized in two passes, so loading takes a handful of large allocations instead of several per primitive. The
+	// accessor counts give every primitive its slice of one arena for its source vertices, indices & meshlets. Once
+	// meshlets are built their exact sizes give every primitive its place in mVertices, mIndices & mMeshlets, which are
+	// then filled in parallel. The primitive's vertices/indices can't go straight into those because meshlet building
+	// reorders them and typically changes their size
+	struct PrimitiveData
+	{
+		const fastgltf::Primitive* primitive{};
+
+		std::span<Vertex> vertices{};
+		std::span<std::uint32_t> indices{};
+		MeshletBuilder::MeshletSpans meshlets{};
+
+		std::size_t firstVertex{};
+		std::size_t firstIndex{};
+		std::size_t firstMeshlet{};
+	};
+
+	std::size_t primitiveCount{ 0 };
+	for (const auto& mesh : asset->meshes)
+	{
+		primitiveCount += mesh.primitives.size();
+	}
+
+	// First pass: upper bounds straight from the accessors
+	struct PrimitiveSize
+	{
+		std::size_t vertexCount{};
+		std::size_t indexCount{};
+		MeshletBuilder::StorageSize meshlets{};
+	};
+
+	mMeshes.resize(asset->meshes.size());
+	mPrimitives.resize(primitiveCount);
+	std::vector<PrimitiveData> primitiveDatas(primitiveCount);
+	std::vector<PrimitiveSize> primitiveSizes(primitiveCount);
+
+	std::size_t arenaSize{ 0 };
+	std::size_t nextPrimitive{ 0 };
+	for (std::size_t i{ 0 }; i < asset->meshes.size(); ++i)
+	{
+		mMeshes[i] = { .firstPrimitive{ static_cast<int>(nextPrimitive) },
+			.primitiveCount{ static_cast<int>(asset->meshes[i].primitives.size()) } };
+
+		for (const auto& primitive : asset->meshes[i].primitives)
+		{
+			PrimitiveSize& size{ primitiveSizes[nextPrimitive] };
+			size.vertexCount = asset->accessors[primitive.findAttribute("POSITION")->second].count;
+			size.indexCount = asset->accessors[primitive.indicesAccessor.value()].count;
+			size.meshlets = MeshletBuilder::getStorageSize(size.indexCount, meshletSettings);
+
+			arenaSize += LoadArena::getArraySize<Vertex>(size.vertexCount) + LoadArena::getArraySize<std::uint32_t>(size.indexCount)
+				+ LoadArena::getArraySize<meshopt_Meshlet>(size.meshlets.meshletCount)
+				+ LoadArena::getArraySize<unsigned int>(size.meshlets.vertexCount)
+				+ LoadArena::getArraySize<unsigned char>(size.meshlets.triangleByteCount)
+				+ LoadArena::getArraySize<meshopt_Bounds>(size.meshlets.meshletCount);
+
+			primitiveDatas[nextPrimitive].primitive = &primitive;
+			++nextPrimitive;
+		}
+	}
+
+	LoadArena arena{ arenaSize };
+	for (std::size_t i{ 0 }; i < primitiveCount; ++i)
+	{
+		const PrimitiveSize& size{ primitiveSizes[i] };
+
+		primitiveDatas[i].vertices = arena.allocateArray<Vertex>(size.vertexCount);
+		primitiveDatas[i].indices = arena.allocateArray<std::uint32_t>(size.indexCount);
+		primitiveDatas[i].meshlets = {
+			.meshlets{ arena.allocateArray<meshopt_Meshlet>(size.meshlets.meshletCount) },
+			.vertices{ arena.allocateArray<unsigned int>(size.meshlets.vertexCount) },
+			.triangles{ arena.allocateArray<unsigned char>(size.meshlets.triangleByteCount) },
+			.bounds{ arena.allocateArray<meshopt_Bounds>(size.meshlets.meshletCount) },
+		};
+	}
+
+	// Meshlet building's temporaries, reused from primitive to primitive
+	LoadArenaPool scratchArenas{};
+
+	jobSystem.parallelFor(primitiveDatas.size(), 1, [&](std::size_t first, std::size_t last) {
+		LoadArena& scratch{ scratchArenas.acquire() };
+
+		for (std::size_t p{ first }; p < last; ++p)
+		{
+			const auto& primitive{ *primitiveDatas[p].primitive };
+			std::span<Vertex> primitiveVertices{ primitiveDatas[p].vertices };
+			std::span<std::uint32_t> primitiveIndices{ primitiveDatas[p].indices };
+
+			{
+				auto accessor{ asset->accessors[primitive.indicesAccessor.value()] };
+
+				fastgltf::iterateAccessorWithIndex<std::uint32_t>(asset.get(), accessor, [&](std::uint32_t val, std::size_t k) {
+					primitiveIndices[k] = val;
+					});
+			}
+
+			{
+				auto accessor{ asset->accessors[primitive.findAttribute("POSITION")->second] };
+
+				fastgltf::iterateAccessorWithIndex<glm::vec3>(asset.get(), accessor, [&](glm::vec3 v, std::size_t k) {
+					primitiveVertices[k].pos = v;
+					});
+			}
+
+			{
+				auto normals{ primitive.findAttribute("NORMAL") };
+
+				if (normals != primitive.attributes.end())
+				{
+					auto accessor{ asset->accessors[normals->second] };
+
+					fastgltf::iterateAccessorWithIndex<glm::vec3>(asset.get(), accessor, [&](glm::vec3 v, std::size_t k) {
+						primitiveVertices[k].normal = v;
+						});
+
+				}
+				else
+				{
+					std::cerr << "Warning: normals not found for mesh.\n";
+				}
+			}
+
+			{
+				auto uvs{ primitive.findAttribute("TEXCOORD_0") };
+
+				if (uvs != primitive.attributes.end())
+				{
+					auto accessor{ asset->accessors[uvs->second] };
+
+					fastgltf::iterateAccessorWithIndex<glm::vec2>(asset.get(), accessor, [&](glm::vec2 v, std::size_t k) {
+						primitiveVertices[k].u = v.x;
+						primitiveVertices[k].v = v.y;
+						});
+				}
+			}
+
+			// Reorders primitiveIndices & primitiveVertices in place when the settings ask for it
+			std::size_t primitiveVertexCount{ primitiveVertices.size() };
+			primitiveDatas[p].meshlets = MeshletBuilder::build(primitiveIndices, primitiveVertices.data(), primitiveVertexCount,
+				sizeof(Vertex), meshletSettings, primitiveDatas[p].meshlets, &scratch);
+
+			scratch.reset();
+		}
+
+		scratchArenas.release(scratch);
+		});
+
+	// Second pass: the built sizes place every primitive in the output arrays, in load order
+	std::size_t vertexCount{ mVertices.size() };
+	std::size_t indexCount{ mIndices.size() };
+	std::size_t meshletCount{ mMeshlets.size() };
+	for (std::size_t i{ 0 }; i < primitiveCount; ++i)
+	{
+		PrimitiveData& primitiveData{ primitiveDatas[i] };
+		const auto& meshlets{ primitiveData.meshlets };
+
+		primitiveData.firstVertex = vertexCount;
+		primitiveData.firstIndex = indexCount;
+		primitiveData.firstMeshlet = meshletCount;
+
+		vertexCount += meshlets.vertices.size();
+		indexCount += meshlets.triangles.size();
+		meshletCount += meshlets.meshlets.size();
+
+		Primitive& newPrimitive{ mPrimitives[i] };
+		newPrimitive.firstMeshlet = static_cast<int>(primitiveData.firstMeshlet);
+		newPrimitive.meshletCount = static_cast<int>(meshlets.meshlets.size());
+
+		newPrimitive.localMaterialIndex = primitiveData.primitive->materialIndex.value_or(-1);
+		newPrimitive.sceneMaterialIndex = newPrimitive.localMaterialIndex == -1 ? -1 
+			: newPrimitive.localMaterialIndex + sceneMaterialOffset;
+	}
+
+	mVertices.resize(vertexCount);
+	mIndices.resize(indexCount);
+	mMeshlets.resize(meshletCount);
+	mMeshletRanges.resize(meshletCount);
+
+	jobSystem.parallelFor(primitiveDatas.size(), 1, [&](std::size_t first, std::size_t last) {
+		for (std::size_t p{ first }; p < last; ++p)
+		{
+			const PrimitiveData& primitiveData{ primitiveDatas[p] };
+			const auto& meshlets{ primitiveData.meshlets };
+
+			GLint localVertexOffset{ static_cast<GLint>(primitiveData.firstVertex) };
+			GLuint localIndexOffset{ static_cast<GLuint>(primitiveData.firstIndex) };
+
+			// Every meshlet's triangles are padded to a multiple of 4, so clusters start on a uint boundary in mIbo
+			std::copy(meshlets.triangles.begin(), meshlets.triangles.end(), mIndices.begin() + primitiveData.firstIndex);
+
+			for (std::size_t i{ 0 }; i < meshlets.vertices.size(); ++i)
+			{
+				mVertices[primitiveData.firstVertex + i] = primitiveData.vertices[meshlets.vertices[i]];
+			}
+
+			for (std::size_t i{ 0 }; i < meshlets.meshlets.size(); ++i)
+			{
+				const meshopt_Meshlet& meshlet{ meshlets.meshlets[i] };
+				Meshlet& newMeshlet{ mMeshlets[primitiveData.firstMeshlet + i] };
+
+				newMeshlet.triangleCount = meshlet.triangle_count;
+				newMeshlet.firstIndex = localIndexOffset + meshlet.triangle_offset
+					+ sceneIndexOffset;
+				newMeshlet.sceneVertexOffset = static_cast<GLint>(meshlet.vertex_offset) + sceneVertexOffset
+					+ localVertexOffset;
+
+				mMeshletRanges[primitiveData.firstMeshlet + i] = { .firstVertex{ localVertexOffset + meshlet.vertex_offset },
+					.vertexCount{ meshlet.vertex_count }, .firstIndex{ localIndexOffset + meshlet.triangle_offset },
+					.indexCount{ meshlet.triangle_count * 3 } };
+
+				const meshopt_Bounds& meshletBounds{ meshlets.bounds[i] };
+				newMeshlet.boundingSphere = { meshletBounds.center[0], meshletBounds.center[1], meshletBounds.center[2], meshletBounds.radius };
+			}
+		}
+		});
+
+	mPrimitiveCount += static_cast<int>(primitiveCount);
+}
+
+void ModelAsset::loadSamplers(const fastgltf::Expected<fastgltf::Asset>& asset)
+{
+	auto toGlWrap{ [](fastgltf::Wrap wrap) -> GLenum {
+		switch (wrap)
+		{
+		case fastgltf::Wrap::Repeat: return GL_REPEAT;
+		case fastgltf::Wrap::MirroredRepeat: return GL_MIRRORED_REPEAT;
+		case fastgltf::Wrap::ClampToEdge: return GL_CLAMP_TO_EDGE;
+		default: return GL_REPEAT;
+		}
+		} };
+
+	mSamplers.resize(asset->samplers.size());
+	for (std::size_t i{ 0 }; i < asset->samplers.size(); ++i)
+	{
+		mSamplers[i] = { .wrapS{ toGlWrap(asset->samplers[i].wrapS) }, .wrapT{ toGlWrap(asset->samplers[i].wrapT) } };
+	}
+}
+
+void ModelAsset::loadImages(const fastgltf::Expected<fastgltf::Asset>& asset, const std::filesystem::path& directory)
+{
+	mImageSources.resize(asset->images.size());
+	for (std::size_t i{ 0 }; i < asset->images.size(); ++i)
+	{
+		const auto& image{ asset->images[i] };
+
+		if (std::holds_alternative<fastgltf::sources::BufferView>(image.data))
+		{
+			const auto& bufferView{ asset->bufferViews[
+				std::get<fastgltf::sources::BufferView>(image.data).bufferViewIndex] };
+			const auto& buffer{ asset->buffers[bufferView.bufferIndex] };
+
+			if (std::holds_alternative<fastgltf::sources::Array>(buffer.data))
+			{
+				const auto& array{ std::get<fastgltf::sources::Array>(buffer.data) };
+				mImageSources[i] = { reinterpret_cast<const unsigned char*>(array.bytes.data()) + bufferView.byteOffset,
+					bufferView.byteLength };
+			}
+			else
+			{
+				std::cerr << "Warning: unrecognized image bufferView data source.";
+			}
+		}
+		else if (std::holds_alternative<fastgltf::sources::Array>(image.data))
+		{
+			const auto& array{ std::get<fastgltf::sources::Array>(image.data) };
+			mImageSources[i] = { reinterpret_cast<const unsigned char*>(array.bytes.data()), array.bytes.size() };
+		}
+		else if (std::holds_alternative<fastgltf::sources::URI>(image.data)
+			&& std::get<fastgltf::sources::URI>(image.data).uri.isLocalPath())
+		{
+			mImageSources[i].path = directory / std::get<fastgltf::sources::URI>(image.data).uri.fspath();
+		}
+		else
+		{
+			std::cerr << "Warning: unrecognized image data source.";
+		}
+	}
+}
+
+void ModelAsset::loadTextures(const fastgltf::Expected<fastgltf::Asset>& asset)
+{
+	mTextures.resize(asset->textures.size());
+	for (std::size_t i{ 0 }; i < asset->textures.size(); ++i)
+	{
+		const auto& basisuImage{ asset->textures[i].basisuImageIndex };
+		const auto& image{ asset->textures[i].imageIndex };
+
+		mTextures[i].image = static_cast<int>(basisuImage ? *basisuImage : image.value());
+		mTextures[i].fallbackImage = basisuImage && image ? static_cast<int>(*image) : -1;
+		mTextures[i].sampler = asset->textures[i].samplerIndex ? static_cast<int>(*asset->textures[i].samplerIndex) : -1;
+	}
+}
+
+void ModelAsset::loadMaterials(const fastgltf::Expected<fastgltf::Asset>& asset)
+{
+	mMaterials.resize(asset->materials.size());
+	mMaterialTextures.resize(asset->materials.size());
+
+	for (std::size_t i{ 0 }; i < asset->materials.size(); ++i)
+	{
+		glm::vec4 colorFactor
+		{
+		asset->materials[i].pbrData.baseColorFactor.x(),
+		asset->materials[i].pbrData.baseColorFactor.y(),
+		asset->materials[i].pbrData.baseColorFactor.z(),
+		asset->materials[i].pbrData.baseColorFactor.w(),
+		};
+
+		MaterialTextures& textures{ mMaterialTextures[i] };
+		if (asset->materials[i].pbrData.baseColorTexture)
+		{
+			textures.color = static_cast<int>(asset->materials[i].pbrData.baseColorTexture.value().textureIndex);
+		}
+		if (asset->materials[i].normalTexture)
+		{
+			textures.normal = static_cast<int>(asset->materials[i].normalTexture.value().textureIndex);
+		}
+
+		// The texture handles are filled in by ModelObject once the textures exist
+		Material material
+		{
+			.colorFactor{ colorFactor },
+			.metallicFactor{ asset->materials[i].pbrData.metallicFactor },
+			.roughnessFactor{ asset->materials[i].pbrData.roughnessFactor },
+			.hasColorTexture{ textures.color != -1 },
+			.hasNormalTexture{ textures.normal != -1 },
+			.alphaMask{ asset->materials[i].alphaMode == fastgltf::AlphaMode::Mask },
+			.alphaCutoff{ asset->materials[i].alphaCutoff },
+			.alphaBlend{ asset->materials[i].alphaMode == fastgltf::AlphaMode::Blend },
+		};
+		mMaterials[i] = material;
+	}
+}
\ No newline at end of file
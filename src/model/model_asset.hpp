@@ -0,0 +1,226 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+#include "../profiling/load_profiler.hpp"
+#include "image_decoder.hpp"
+#include "mesh_codec.hpp"
+#include "meshlet_builder.hpp"
+
+// Only for the GL types & enums of the structs uploaded as is. Nothing here calls GL
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include "fastgltf/core.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Everything loading a glTF file produces before GL is involved: vertices, meshlets, clusters, transforms, materials,
+// and where the images & samplers come from. Builds without a GL context, so loading can be run, tested & measured
+// on machines without a GPU. ModelObject uploads it
+class ModelAsset final
+{
+public:
+
+	struct Vertex
+	{
+		glm::vec3 pos{};
+		float u{};
+		glm::vec3 normal{ 0.0f, 0.0f, 1.0f };
+		float v{};
+	};
+
+	struct Sampler
+	{
+		GLenum wrapS{ GL_REPEAT };
+		GLenum wrapT{ GL_REPEAT };
+	};
+
+	struct Texture
+	{
+		int sampler{ -1 }; // -1 uses the default sampler
+
+		// KHR_texture_basisu textures may leave out the plain image, which is otherwise a fallback for when the KTX2
+		// image can't be used. -1 when there's no fallback
+		int image{};
+		int fallbackImage{ -1 };
+	};
+
+	struct Material
+	{
+		glm::vec4 colorFactor{};
+
+		GLuint64 colorTexture{};
+		GLuint64 metallicRoughnessTexture{};
+		GLuint64 normalTexture{};
+
+		GLfloat metallicFactor{};
+		GLfloat roughnessFactor{};
+
+		GLint hasColorTexture{ false };
+		GLint hasMetallicRoughnessTexture{ false };
+		GLint hasNormalTexture{ false };
+
+		GLint alphaMask{};
+		GLfloat alphaCutoff{};
+		GLint alphaBlend{};
+
+		GLint64 padding{};
+	};
+
+	// Indices into mTextures, -1 for none. Material holds the bindless handles, which only exist once uploaded
+	struct MaterialTextures
+	{
+		int color{ -1 };
+		int normal{ -1 };
+	};
+
+	struct Meshlet
+	{
+		glm::vec4 boundingSphere{};
+
+		GLint triangleCount{};
+		GLuint firstIndex{};
+		GLint sceneVertexOffset{};
+	};
+
+	// Clusters are instances of meshlets.
+	struct Cluster
+	{
+		glm::vec4 boundingSphere{};
+
+		GLuint transformIndex{};
+		GLint materialIndex{ -1 };
+
+		GLuint indexCount{};
+		GLuint firstIndex{};
+		GLint vertexOffset{};
+
+		// Bit i set means the cluster can be drawn in view i of view_batch.comp
+		GLuint viewMask{ ~0u };
+
+		GLint padding1{};
+		GLint padding2{};
+	};
+
+	struct Primitive
+	{
+		int sceneMaterialIndex{ -1 };
+		int localMaterialIndex{ -1 };
+
+		// Range of mMeshlets
+		int firstMeshlet{};
+		int meshletCount{};
+	};
+
+	// Range of mPrimitives
+	struct Mesh
+	{
+		int firstPrimitive{};
+		int primitiveCount{};
+	};
+
+	// The first scene's nodes in breadth-first order, one array per field. That order puts every node after its parent
+	// and the children of a node next to each other, so children are a range of the table itself and a single pass
+	// in table order reaches every parent before its children. Nodes the scene doesn't reach are left out
+	struct NodeTable
+	{
+		std::vector<glm::mat4> localTransforms{};
+		std::vector<int> parents{}; // -1 for roots
+		std::vector<int> meshes{}; // -1 for none
+
+		std::vector<int> firstChildren{};
+		std::vector<int> childCounts{};
+
+		// Nodes [levelOffsets[i], levelOffsets[i + 1]) are i levels below a root. The last offset is the node count
+		std::vector<int> levelOffsets{ 0 };
+
+		// Index of each node in the glTF file
+		std::vector<int> sourceIndices{};
+
+		std::size_t size() const { return parents.size(); }
+	};
+
+	ModelAsset() = default;
+
+	// Meshlets are built on jobSystem. Images aren't decoded: mImageSources says where each one is, and the glTF
+	// buffers they may point into are kept until releaseSources()
+	ModelAsset(JobSystem& jobSystem, const std::filesystem::path& path, int sceneVertexOffset, int sceneIndexOffset,
+		int sceneMaterialOffset, int sceneTransformOffset, const std::filesystem::path& directory = "assets",
+		const MeshletBuilder::Settings& meshletSettings = {}, LoadProfiler* profiler = nullptr);
+
+	ModelAsset(const ModelAsset&) = delete;
+	ModelAsset& operator=(const ModelAsset&) = delete;
+
+	ModelAsset(ModelAsset&& o) = default;
+	ModelAsset& operator=(ModelAsset&& o) = default;
+
+	// Frees the glTF buffers once the images have been decoded
+	void releaseSources();
+
+	// A transform & its max scale per primitive of every mesh node, and a cluster per meshlet, in node table order.
+	// Replaces mGlobalTransforms, mTransformScales & mClusters, so calling it again rebuilds the same uniforms.
+	// Transforms are evaluated a level of the node table at a time, in parallel on jobSystem
+	void buildPrimitiveUniforms(JobSystem& jobSystem, int sceneTransformOffset);
+
+	std::span<const Primitive> getPrimitives(const Mesh& mesh) const;
+	std::span<const Meshlet> getMeshlets(const Primitive& primitive) const;
+
+	static NodeTable buildNodeTable(const fastgltf::Asset& asset);
+
+	// Meshes & primitives point into flat arrays instead of owning their own, so loading them takes one allocation
+	// per array rather than one per element
+	NodeTable mNodes{};
+
+	std::vector<Mesh> mMeshes{};
+	std::vector<Primitive> mPrimitives{};
+	std::vector<Meshlet> mMeshlets{};
+	int mPrimitiveCount{};
+
+	std::vector<Cluster> mClusters{};
+
+	std::vector<Sampler> mSamplers{};
+	std::vector<ImageDecoder::Source> mImageSources{};
+	std::vector<Texture> mTextures{};
+
+	std::vector<glm::mat4> mGlobalTransforms{};
+	// Largest axis scale of each of mGlobalTransforms, which cluster bounding spheres are scaled by when culling
+	std::vector<float> mTransformScales{};
+	std::vector<Material> mMaterials{};
+	std::vector<MaterialTextures> mMaterialTextures{};
+
+	std::vector<Vertex> mVertices{};
+	// Meshlet local indices. They fit in a byte and are uploaded as is, 4 per uint
+	std::vector<std::uint8_t> mIndices{};
+
+	// Each meshlet's span of mVertices & mIndices, in load order, for MeshCodec::benchmark
+	std::vector<MeshCodec::MeshletRange> mMeshletRanges{};
+
+private:
+
+	void loadMeshes(JobSystem& jobSystem, fastgltf::Expected<fastgltf::Asset>& asset, GLint sceneVertexOffset,
+		GLuint sceneIndexOffset, int sceneMaterialOffset, const MeshletBuilder::Settings& meshletSettings);
+	void loadSamplers(const fastgltf::Expected<fastgltf::Asset>& asset);
+	void loadImages(const fastgltf::Expected<fastgltf::Asset>& asset, const std::filesystem::path& directory);
+	void loadTextures(const fastgltf::Expected<fastgltf::Asset>& asset);
+	void loadMaterials(const fastgltf::Expected<fastgltf::Asset>& asset);
+
+	// Owns the buffers mImageSources point into
+	std::optional<fastgltf::Asset> mGltf{};
+
+	// Ranges of mGlobalTransforms & mClusters
+	struct NodeUniforms
+	{
+		std::size_t firstTransform{};
+		std::size_t firstCluster{};
+	};
+
+	// Every node's global transform & uniforms, in mNodes order. Kept between calls to buildPrimitiveUniforms so
+	// rebuilding doesn't allocate
+	std::vector<glm::mat4> mNodeTransforms{};
+	std::vector<NodeUniforms> mNodeUniforms{};
+};
\ No newline at end of file
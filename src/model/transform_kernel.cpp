@@ -0,0 +1,121 @@
+#include "transform_kernel.hpp"
+
+#include "../jobs/job_system.hpp"
+
+#include "glm/glm.hpp"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+#include <algorithm> // for max
+#include <cmath>
+#include <cstddef> // for size_t
+#include <span>
+
+
+
+glm::mat4 TransformKernel::composeTrs(const glm::vec3& translation, const glm::vec4& rotation, const glm::vec3& scale)
+{
+	const float x2{ rotation.x + rotation.x };
+	const float y2{ rotation.y + rotation.y };
+	const float z2{ rotation.z + rotation.z };
+
+	const float xx{ rotation.x * x2 };
+	const float yy{ rotation.y * y2 };
+	const float zz{ rotation.z * z2 };
+	const float xy{ rotation.x * y2 };
+	const float xz{ rotation.x * z2 };
+	const float yz{ rotation.y * z2 };
+	const float wx{ rotation.w * x2 };
+	const float wy{ rotation.w * y2 };
+	const float wz{ rotation.w * z2 };
+
+	return {
+		glm::vec4{ 1.0f - (yy + zz), xy + wz, xz - wy, 0.0f } * scale.x,
+		glm::vec4{ xy - wz, 1.0f - (xx + zz), yz + wx, 0.0f } * scale.y,
+		glm::vec4{ xz + wy, yz - wx, 1.0f - (xx + yy), 0.0f } * scale.z,
+		glm::vec4{ translation, 1.0f },
+	};
+}
+
+glm::mat4 TransformKernel::multiply(const glm::mat4& a, const glm::mat4& b)
+{
+	glm::mat4 result{};
+
+#if defined(__AVX__)
+	// Two columns of the result at a time. Each 128 bit lane holds a column of b, and every column of a is in both lanes
+	const __m256 a0{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[0])) };
+	const __m256 a1{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[1])) };
+	const __m256 a2{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[2])) };
+	const __m256 a3{ _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[3])) };
+
+	for (int i{ 0 }; i < 4; i += 2)
+	{
+		const __m256 column{ _mm256_loadu_ps(&b[i][0]) };
+
+		__m256 sum{ _mm256_mul_ps(a0, _mm256_permute_ps(column, 0x00)) };
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_permute_ps(column, 0x55)));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_permute_ps(column, 0xAA)));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_permute_ps(column, 0xFF)));
+
+		_mm256_storeu_ps(&result[i][0], sum);
+	}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const __m128 a0{ _mm_loadu_ps(&a[0][0]) };
+	const __m128 a1{ _mm_loadu_ps(&a[1][0]) };
+	const __m128 a2{ _mm_loadu_ps(&a[2][0]) };
+	const __m128 a3{ _mm_loadu_ps(&a[3][0]) };
+
+	for (int i{ 0 }; i < 4; ++i)
+	{
+		const __m128 column{ _mm_loadu_ps(&b[i][0]) };
+
+		__m128 sum{ _mm_mul_ps(a0, _mm_shuffle_ps(column, column, 0x00)) };
+		sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_shuffle_ps(column, column, 0x55)));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_shuffle_ps(column, column, 0xAA)));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_shuffle_ps(column, column, 0xFF)));
+
+		_mm_storeu_ps(&result[i][0], sum);
+	}
+#else
+	result = a * b;
+#endif
+
+	return result;
+}
+
+float TransformKernel::getMaxScale(const glm::mat4& transform)
+{
+	return std::sqrt(std::max(glm::dot(glm::vec3{ transform[0] }, glm::vec3{ transform[0] }),
+		std::max(glm::dot(glm::vec3{ transform[1] }, glm::vec3{ transform[1] }), glm::dot(glm::vec3{ transform[2] }, glm::vec3{ transform[2] }))));
+}
+
+void TransformKernel::evaluate(JobSystem& jobSystem, std::span<const glm::mat4> localTransforms, std::span<const int> parents,
+	std::span<const int> levelOffsets, std::span<glm::mat4> globalTransforms)
+{
+	for (std::size_t level{ 0 }; level + 1 < levelOffsets.size(); ++level)
+	{
+		const std::size_t first{ static_cast<std::size_t>(levelOffsets[level]) };
+		const std::size_t last{ static_cast<std::size_t>(levelOffsets[level + 1]) };
+
+		if (last - first <= grainSize || jobSystem.getThreadCount() == 1)
+		{
+			evaluateRange(localTransforms, parents, globalTransforms, first, last);
+			continue;
+		}
+
+		jobSystem.parallelFor(last - first, grainSize, [&](std::size_t firstNode, std::size_t lastNode) {
+			evaluateRange(localTransforms, parents, globalTransforms, first + firstNode, first + lastNode);
+			});
+	}
+}
+
+void TransformKernel::evaluateRange(std::span<const glm::mat4> localTransforms, std::span<const int> parents,
+	std::span<glm::mat4> globalTransforms, std::size_t first, std::size_t last)
+{
+	for (std::size_t i{ first }; i < last; ++i)
+	{
+		globalTransforms[i] = parents[i] == -1 ? localTransforms[i] : multiply(globalTransforms[parents[i]], localTransforms[i]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../jobs/job_system.hpp"
+
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <span>
+
+// Batched node transform evaluation for the breadth-first node table. Every level of the table only reads the one
+// above it, so the levels run one after another and the nodes within a level are split across the job system.
+// Matrix products use SSE, or AVX when the build enables it, and add in the same order as glm, so the results are
+// identical to glm's down to the bit.
+class TransformKernel final
+{
+public:
+
+	// Levels smaller than this run on the calling thread, and larger ones are split into ranges of this size.
+	// A range costs a few hundred ns to queue, a node around 10
+	static constexpr std::size_t grainSize{ 4096 };
+
+	// translation * rotation * scale built as one matrix, instead of multiplying three. rotation is a unit quaternion
+	// in glTF order: x, y, z, w
+	static glm::mat4 composeTrs(const glm::vec3& translation, const glm::vec4& rotation, const glm::vec3& scale);
+
+	static glm::mat4 multiply(const glm::mat4& a, const glm::mat4& b);
+
+	// Largest axis scale, which bounding sphere radii are multiplied by, for the uniforms and FrustumCuller alike.
+	// Takes the square root once, of the largest squared length
+	static float getMaxScale(const glm::mat4& transform);
+
+	// globalTransforms[i] = globalTransforms[parents[i]] * localTransforms[i] for every node, in parallel over the
+	// nodes of each level. Nodes [levelOffsets[i], levelOffsets[i + 1]) are i levels below a root, and parents are
+	// -1 for roots
+	static void evaluate(JobSystem& jobSystem, std::span<const glm::mat4> localTransforms, std::span<const int> parents,
+		std::span<const int> levelOffsets, std::span<glm::mat4> globalTransforms);
+
+	// evaluate() over nodes [first, last) on the calling thread. Their parents must already be done
+	static void evaluateRange(std::span<const glm::mat4> localTransforms, std::span<const int> parents,
+		std::span<glm::mat4> globalTransforms, std::size_t first, std::size_t last);
+};
\ No newline at end of file
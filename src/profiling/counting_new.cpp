@@ -0,0 +1,125 @@
+// Replaces the global operator new & delete so memory_usage.hpp's heap counters see every allocation. Only linked into
+// asset_benchmark & asset_tests: the renderer keeps the standard allocator
+#include "memory_usage.hpp"
+
+#if defined(_WIN32)
+#include <malloc.h> // for _msize, _aligned_malloc, _aligned_msize & _aligned_free
+#elif defined(__linux__)
+#include <malloc.h> // for malloc_usable_size
+#endif
+
+#include <cstddef> // for size_t
+#include <cstdlib> // for malloc, aligned_alloc & free
+#include <new>
+
+
+
+namespace
+{
+	// The size malloc actually handed out, so frees can be subtracted without storing a header
+	std::size_t getBlockSize(void* block)
+	{
+#if defined(_WIN32)
+		return _msize(block);
+#elif defined(__linux__)
+		return malloc_usable_size(block);
+#else
+		return 0;
+#endif
+	}
+
+	std::size_t getAlignedBlockSize(void* block, std::size_t alignment)
+	{
+#if defined(_WIN32)
+		return _aligned_msize(block, alignment, 0);
+#elif defined(__linux__)
+		static_cast<void>(alignment);
+		return malloc_usable_size(block);
+#else
+		static_cast<void>(alignment);
+		return 0;
+#endif
+	}
+
+	void* allocateAligned(std::size_t size, std::size_t alignment)
+	{
+#if defined(_WIN32)
+		return _aligned_malloc(size, alignment);
+#else
+		// aligned_alloc wants a multiple of the alignment
+		return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	}
+
+	void freeAligned(void* block)
+	{
+#if defined(_WIN32)
+		_aligned_free(block);
+#else
+		std::free(block);
+#endif
+	}
+
+	template <typename Allocate>
+	void* allocateOrThrow(Allocate&& allocate)
+	{
+		void* block{ allocate() };
+		while (!block)
+		{
+			std::new_handler handler{ std::get_new_handler() };
+			if (!handler)
+			{
+				throw std::bad_alloc{};
+			}
+			handler();
+			block = allocate();
+		}
+		return block;
+	}
+}
+
+
+
+// The array & nothrow forms call these by default, so replacing the plain & aligned ones covers all allocations
+void* operator new(std::size_t size)
+{
+	void* block{ allocateOrThrow([&] { return std::malloc(size == 0 ? 1 : size); }) };
+	recordHeapAllocation(size, getBlockSize(block));
+	return block;
+}
+
+void operator delete(void* block) noexcept
+{
+	if (block)
+	{
+		recordHeapFree(getBlockSize(block));
+		std::free(block);
+	}
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+	operator delete(block);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	std::size_t align{ static_cast<std::size_t>(alignment) };
+	void* block{ allocateOrThrow([&] { return allocateAligned(size == 0 ? 1 : size, align); }) };
+	recordHeapAllocation(size, getAlignedBlockSize(block, align));
+	return block;
+}
+
+void operator delete(void* block, std::align_val_t alignment) noexcept
+{
+	if (block)
+	{
+		recordHeapFree(getAlignedBlockSize(block, static_cast<std::size_t>(alignment)));
+		freeAligned(block);
+	}
+}
+
+void operator delete(void* block, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(block, alignment);
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "culling_benchmark.hpp"
+
+#include "../camera/camera.hpp"
+#include "../culling/cluster_bvh.hpp"
+#include "../culling/frustum_culler.hpp"
+#include "../jobs/job_system.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for max, min & sort
+#include <chrono>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib> // for strtoull
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	constexpr float buildingSpacing{ 20.0f };
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+std::vector<glm::vec4> CullingBenchmark::generateCity(std::size_t clusterCount, std::uint32_t seed)
+{
+	std::mt19937 generator{ seed };
+	std::uniform_real_distribution<float> jitter{ -3.0f, 3.0f };
+	std::uniform_real_distribution<float> radius{ 1.5f, 3.0f };
+
+	const std::size_t buildingCount{ (clusterCount + clustersPerBuilding - 1) / clustersPerBuilding };
+	const std::size_t gridSize{ static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(buildingCount)))) };
+
+	std::vector<glm::vec4> spheres{};
+	spheres.reserve(clusterCount);
+	for (std::size_t building{ 0 }; spheres.size() < clusterCount; ++building)
+	{
+		const glm::vec2 base{ static_cast<float>(building % gridSize) * buildingSpacing + jitter(generator),
+			static_cast<float>(building / gridSize) * buildingSpacing + jitter(generator) };
+
+		for (std::size_t floor{ 0 }; floor < clustersPerBuilding && spheres.size() < clusterCount; ++floor)
+		{
+			spheres.push_back({ base.x + jitter(generator) * 0.5f, static_cast<float>(floor) * 4.0f + 2.0f,
+				base.y + jitter(generator) * 0.5f, radius(generator) });
+		}
+	}
+
+	return spheres;
+}
+
+std::vector<CullingBenchmark::View> CullingBenchmark::getDefaultViews(const std::vector<glm::vec4>& city)
+{
+	glm::vec3 min{ 0.0f };
+	glm::vec3 max{ 0.0f };
+	if (!city.empty())
+	{
+		min = max = glm::vec3{ city.front() };
+	}
+	for (const auto& sphere : city)
+	{
+		min = glm::min(min, glm::vec3{ sphere });
+		max = glm::max(max, glm::vec3{ sphere });
+	}
+	const glm::vec3 center{ (min + max) * 0.5f };
+
+	// Roads run halfway between the rows of buildings
+	const float road{ min.z + std::floor((center.z - min.z) / buildingSpacing) * buildingSpacing + buildingSpacing * 0.5f };
+
+	return {
+		{ .name{ "street" }, .position{ center.x, 1.7f, road }, .target{ max.x, 1.7f, road } },
+		{ .name{ "above" }, .position{ center.x, 200.0f, center.z + 1.0f }, .target{ center.x, 0.0f, center.z } },
+		{ .name{ "corner" }, .position{ min.x - 20.0f, 100.0f, min.z - 20.0f }, .target{ glm::mix(min, max, 0.25f) } },
+	};
+}
+
+bool CullingBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	const std::vector<glm::vec4> city{ generateCity(settings.clusterCount) };
+
+	ClusterBvh bvh{};
+	std::vector<double> buildTimes{};
+	for (int i{ 0 }; i < std::max(settings.iterations / 3, 1); ++i)
+	{
+		buildTimes.push_back(measureTime([&] { bvh.build(city); }));
+	}
+
+	JobSystem jobSystem{ settings.threadCount > 0 ? settings.threadCount
+		: static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+
+	FrustumCuller frustumCuller{};
+	frustumCuller.setClusters(city, std::vector<GLuint>(city.size(), 0));
+	frustumCuller.updateWorldSpheres(jobSystem, { glm::mat4{ 1.0f } });
+	const bool hasAvx2{ FrustumCuller::getBestPath() == FrustumCuller::Path::avx2 };
+
+	out << "CPU cluster culling of " << city.size() << " clusters: BVH traversal vs testing every cluster, then "
+		"FrustumCuller's paths on " << jobSystem.getThreadCount() << " threads. Median of " << settings.iterations << " runs\n";
+	out << "BVH build " << std::fixed << std::setprecision(3) << median(buildTimes) << " ms, " << bvh.mNodes.size()
+		<< " nodes, " << bvh.mLevelNodeCounts.size() << " levels\n\n";
+
+	out << std::left << std::setw(10) << "view" << std::right
+		<< std::setw(12) << "visible" << std::setw(12) << "bvh ms" << std::setw(12) << "flat ms" << std::setw(10) << "speedup"
+		<< std::setw(14) << "soa scalar ms" << std::setw(10) << "sse ms" << std::setw(10) << "avx2 ms" << '\n';
+
+	const glm::mat4 proj{ glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.25f, 10000.0f) };
+
+	std::vector<GLuint> bvhVisible{};
+	std::vector<GLuint> flatVisible{};
+	bvhVisible.reserve(city.size());
+	flatVisible.reserve(city.size());
+
+	std::vector<std::uint32_t> scalarBits{};
+	std::vector<std::uint32_t> sseBits{};
+	std::vector<std::uint32_t> avx2Bits{};
+
+	bool allMatch{ true };
+	for (const auto& view : getDefaultViews(city))
+	{
+		const Camera::Frustum frustum{ Camera::getFrustum(proj * glm::lookAt(view.position, view.target, glm::vec3{ 0.0f, 1.0f, 0.0f })) };
+
+		std::vector<double> bvhTimes{};
+		std::vector<double> flatTimes{};
+		std::vector<double> soaScalarTimes{};
+		std::vector<double> sseTimes{};
+		std::vector<double> avx2Times{};
+
+		// The first run of each is a warmup
+		for (int i{ 0 }; i <= std::max(settings.iterations, 1); ++i)
+		{
+			bvhVisible.clear();
+			flatVisible.clear();
+
+			const double bvhTime{ measureTime([&] { bvh.cull(frustum, bvhVisible); }) };
+			const double flatTime{ measureTime([&] { ClusterBvh::cullFlat(frustum, city, flatVisible); }) };
+
+			const double soaScalarTime{ measureTime([&] { frustumCuller.cullScalar(frustum, scalarBits); }) };
+			const double sseTime{ measureTime([&] { frustumCuller.cull(jobSystem, frustum, sseBits, FrustumCuller::Path::sse); }) };
+			const double avx2Time{ hasAvx2
+				? measureTime([&] { frustumCuller.cull(jobSystem, frustum, avx2Bits, FrustumCuller::Path::avx2); }) : 0.0 };
+
+			if (i > 0)
+			{
+				bvhTimes.push_back(bvhTime);
+				flatTimes.push_back(flatTime);
+				soaScalarTimes.push_back(soaScalarTime);
+				sseTimes.push_back(sseTime);
+				avx2Times.push_back(avx2Time);
+			}
+		}
+
+		// The BVH visits clusters in leaf order
+		std::sort(bvhVisible.begin(), bvhVisible.end());
+
+		std::vector<GLuint> soaVisible{};
+		soaVisible.reserve(flatVisible.size());
+		for (std::size_t cluster{ 0 }; cluster < city.size(); ++cluster)
+		{
+			if (scalarBits[cluster / 32] & (std::uint32_t{ 1 } << (cluster % 32)))
+			{
+				soaVisible.push_back(static_cast<GLuint>(cluster));
+			}
+		}
+
+		Results results{ .view{ view.name }, .visibleCount{ flatVisible.size() }, .bvhTime{ median(bvhTimes) },
+			.flatTime{ median(flatTimes) }, .soaScalarTime{ median(soaScalarTimes) }, .sseTime{ median(sseTimes) },
+			.avx2Time{ median(avx2Times) },
+			.matches{ bvhVisible == flatVisible && soaVisible == flatVisible && sseBits == scalarBits && (!hasAvx2 || avx2Bits == scalarBits) } };
+
+		out << std::left << std::setw(10) << results.view << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(12) << results.visibleCount
+			<< std::setw(12) << results.bvhTime
+			<< std::setw(12) << results.flatTime
+			<< std::setw(10) << (results.bvhTime > 0.0 ? results.flatTime / results.bvhTime : 0.0)
+			<< std::setw(14) << results.soaScalarTime
+			<< std::setw(10) << results.sseTime
+			<< std::setw(10) << results.avx2Time
+			<< (results.matches ? "" : "   MISMATCH") << '\n';
+
+		allMatch = allMatch && results.matches;
+	}
+
+	return allMatch;
+}
+
+CullingBenchmark::Settings CullingBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--clusters")
+		{
+			settings.clusterCount = std::max<std::size_t>(size, 1);
+		}
+		else if (option == "--threads")
+		{
+			settings.threadCount = static_cast<int>(size);
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times the CPU cluster culling paths on a synthetic city of around a million cluster spheres, from a few camera
+// views: ClusterBvh::cull against testing every cluster with ClusterBvh::cullFlat, and FrustumCuller's scalar, SSE &
+// AVX2 paths over its structure-of-arrays bounds. The GPU traversal in bvh_cull.comp needs a GL context and is timed
+// in the Stats window instead. Every path must find the same visible clusters.
+class CullingBenchmark final
+{
+public:
+
+	// generateCity writes each building's clusters next to each other, bottom floor first
+	static constexpr std::size_t clustersPerBuilding{ 16 };
+
+	struct Settings
+	{
+		int iterations{ 9 };
+		std::size_t clusterCount{ 1'000'000 };
+
+		// For FrustumCuller::cull. 0 uses every hardware thread
+		int threadCount{ 0 };
+	};
+
+	struct View
+	{
+		std::string name{};
+
+		glm::vec3 position{};
+		glm::vec3 target{};
+	};
+
+	struct Results
+	{
+		std::string view{};
+
+		std::size_t visibleCount{};
+
+		// Median ms
+		double bvhTime{};
+		double flatTime{};
+
+		// FrustumCuller::cullScalar, and cull() with each path. 0 for paths the CPU doesn't have
+		double soaScalarTime{};
+		double sseTime{};
+		double avx2Time{};
+
+		bool matches{ false };
+	};
+
+	// Buildings on a square grid, each a stack of clusters, with a few spread over the ground between them
+	static std::vector<glm::vec4> generateCity(std::size_t clusterCount, std::uint32_t seed = 1);
+
+	// Street level down a road from the center, low above the center, and from a corner looking in
+	static std::vector<View> getDefaultViews(const std::vector<glm::vec4>& city);
+
+	// Prints the BVH build time and a table of every view. Returns false if the paths disagree on any of them
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations, --clusters & --threads, each followed by a value
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+};
\ No newline at end of file
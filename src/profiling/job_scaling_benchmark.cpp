@@ -0,0 +1,223 @@
+#include "job_scaling_benchmark.hpp"
+
+#include "culling_benchmark.hpp"
+#include "occlusion_benchmark.hpp"
+#include "../camera/camera.hpp"
+#include "../culling/frustum_culler.hpp"
+#include "../culling/occlusion_buffer.hpp"
+#include "../jobs/job_system.hpp"
+#include "../lighting/light_grid.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for equal, max & sort
+#include <chrono>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib> // for strtoull
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	constexpr std::size_t emptyJobCount{ 100'000 };
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+
+	// The renderer's reverse-Z projection, which the occlusion buffer's depth test expects
+	glm::mat4 infiniteReversePerspective(float fovY, float aspect, float zNear)
+	{
+		float f{ 1.0f / std::tan(fovY / 2.0f) };
+		return glm::mat4{
+			f / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, f, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, -1.0f,
+			0.0f, 0.0f, zNear, 0.0f };
+	}
+}
+
+
+
+bool JobScalingBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	const int maxThreadCount{ settings.maxThreadCount > 0 ? settings.maxThreadCount
+		: static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+
+	const std::vector<glm::vec4> city{ CullingBenchmark::generateCity(settings.clusterCount) };
+	const CullingBenchmark::View street{ CullingBenchmark::getDefaultViews(city).front() };
+
+	const float fovY{ glm::radians(75.0f) };
+	constexpr float aspectRatio{ 16.0f / 9.0f };
+	constexpr float zNear{ 0.25f };
+	const glm::mat4 view{ glm::lookAt(street.position, street.target, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+	const glm::mat4 proj{ infiniteReversePerspective(fovY, aspectRatio, zNear) };
+	const Camera::Frustum frustum{ Camera::getFrustum(glm::perspective(fovY, aspectRatio, zNear, 10000.0f) * view) };
+
+	FrustumCuller frustumCuller{};
+	frustumCuller.setClusters(city, std::vector<GLuint>(city.size(), 0));
+
+	OcclusionBuffer occlusionBuffer{ 256, 144 };
+	occlusionBuffer.setOccluders(OcclusionBenchmark::generateOccluders(city, street.position, 256));
+	occlusionBuffer.rasterize(proj * view);
+
+	LightGrid lightGrid{};
+	lightGrid.setProjection(proj, zNear);
+	lightGrid.mLights = LightGrid::generateRandomLights(settings.lightCount, { street.position + glm::vec3{ 100.0f, 0.0f, 0.0f }, 100.0f });
+
+	out << "Frame CPU work on 1 to " << maxThreadCount << " threads: culling " << city.size() << " clusters, binning "
+		<< lightGrid.mLights.size() << " lights & " << emptyJobCount << " empty jobs. Median of " << settings.iterations << " runs\n\n";
+	out << std::right << std::setw(8) << "threads" << std::setw(10) << "cull ms" << std::setw(10) << "speedup"
+		<< std::setw(10) << "light ms" << std::setw(10) << "speedup" << std::setw(12) << "us per job" << '\n';
+
+	std::vector<std::uint32_t> referenceBits{};
+	std::vector<GLuint> referenceCounts{};
+	std::vector<GLuint> referenceIndices{};
+	Results first{};
+
+	bool allMatch{ true };
+	for (int threadCount{ 1 }; threadCount <= maxThreadCount; ++threadCount)
+	{
+		JobSystem jobSystem{ threadCount };
+		frustumCuller.updateWorldSpheres(jobSystem, { glm::mat4{ 1.0f } });
+
+		std::vector<std::uint32_t> bits{};
+		std::vector<GLuint> counts{};
+		std::vector<GLuint> indices{};
+
+		std::vector<double> cullTimes{};
+		std::vector<double> lightTimes{};
+		std::vector<double> jobTimes{};
+
+		// The first run of each is a warmup
+		for (int i{ 0 }; i <= std::max(settings.iterations, 1); ++i)
+		{
+			const double cullTime{ measureTime([&] {
+				occlusionBuffer.cull(jobSystem, frustumCuller, frustum, view, proj, zNear, bits); }) };
+			const double lightTime{ measureTime([&] { lightGrid.binLights(jobSystem, view, counts, indices); }) };
+			const double jobTime{ measureTime([&] {
+				jobSystem.parallelFor(emptyJobCount, 1, [](std::size_t, std::size_t) {}); }) };
+
+			if (i > 0)
+			{
+				cullTimes.push_back(cullTime);
+				lightTimes.push_back(lightTime);
+				jobTimes.push_back(jobTime);
+			}
+		}
+
+		if (threadCount == 1)
+		{
+			referenceBits = bits;
+			referenceCounts = counts;
+			referenceIndices = indices;
+		}
+
+		// Slots past a froxel's count are left as they were, so only the lists are compared
+		bool matches{ bits == referenceBits && counts == referenceCounts };
+		for (std::size_t froxel{ 0 }; matches && froxel < LightGrid::froxelCount; ++froxel)
+		{
+			const std::size_t offset{ froxel * LightGrid::maxLightsPerFroxel };
+			matches = std::equal(indices.begin() + offset, indices.begin() + offset + counts[froxel], referenceIndices.begin() + offset);
+		}
+
+		Results results{ .threadCount{ threadCount }, .cullTime{ median(cullTimes) }, .lightTime{ median(lightTimes) },
+			.jobOverhead{ median(jobTimes) * 1000.0 / emptyJobCount }, .matches{ matches } };
+		if (threadCount == 1)
+		{
+			first = results;
+		}
+
+		out << std::setw(8) << results.threadCount << std::fixed << std::setprecision(3)
+			<< std::setw(10) << results.cullTime
+			<< std::setw(10) << (results.cullTime > 0.0 ? first.cullTime / results.cullTime : 0.0)
+			<< std::setw(10) << results.lightTime
+			<< std::setw(10) << (results.lightTime > 0.0 ? first.lightTime / results.lightTime : 0.0)
+			<< std::setw(12) << results.jobOverhead
+			<< (results.matches ? "" : "   MISMATCH") << '\n';
+
+		allMatch = allMatch && results.matches;
+	}
+
+	return allMatch;
+}
+
+JobScalingBenchmark::Settings JobScalingBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--threads")
+		{
+			settings.maxThreadCount = static_cast<int>(size);
+		}
+		else if (option == "--clusters")
+		{
+			settings.clusterCount = std::max<std::size_t>(size, 1);
+		}
+		else if (option == "--lights")
+		{
+			settings.lightCount = size;
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
\ No newline at end of file
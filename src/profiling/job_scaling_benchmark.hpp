@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <vector>
+
+// Times the CPU side of a frame on JobSystems of 1 to N threads, like the renderer's "measure job scaling" button but
+// headless: frustum & occlusion culling CullingBenchmark's city from the street, and binning random lights. Also
+// measures the overhead of a job on its own with a parallelFor of empty ranges. Every thread count must produce the
+// same visibility & froxel lists as 1 thread.
+class JobScalingBenchmark final
+{
+public:
+
+	struct Settings
+	{
+		int iterations{ 9 };
+
+		// Up to every hardware thread when 0
+		int maxThreadCount{ 0 };
+
+		std::size_t clusterCount{ 1'000'000 };
+		std::size_t lightCount{ 1000 };
+	};
+
+	struct Results
+	{
+		int threadCount{};
+
+		// Median ms
+		double cullTime{};
+		double lightTime{};
+
+		// Median microseconds per empty job
+		double jobOverhead{};
+
+		bool matches{ false };
+	};
+
+	// Prints a table of every thread count. Returns false if any of them disagrees with 1 thread
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations, --threads, --clusters & --lights, each followed by a value. --threads is the most threads tried
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+};
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "light_benchmark.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "../lighting/light_grid.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for count, equal, max & sort
+#include <chrono>
+#include <cstddef> // for ptrdiff_t & size_t
+#include <cstdlib> // for strtoull
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	constexpr std::size_t lightCounts[]{ 10, 100, 1000, 10000 };
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+std::size_t LightBenchmark::binLightsReference(const LightGrid& grid, const glm::mat4& view, std::vector<GLuint>& froxelLightCounts,
+	std::vector<GLuint>& froxelLightIndices)
+{
+	froxelLightCounts.assign(LightGrid::froxelCount, 0);
+	froxelLightIndices.assign(static_cast<std::size_t>(LightGrid::froxelCount) * LightGrid::maxLightsPerFroxel, 0);
+	std::vector<bool> overflows(LightGrid::froxelCount, false);
+
+	for (std::size_t i{ 0 }; i < grid.mLights.size(); ++i)
+	{
+		const glm::vec3 center{ view * glm::vec4{ grid.mLights[i].position, 1.0f } };
+		const float radius{ grid.mLights[i].radius };
+
+		for (std::size_t froxel{ 0 }; froxel < LightGrid::froxelCount; ++froxel)
+		{
+			const glm::vec3 offset{ glm::clamp(center, glm::vec3{ grid.mFroxelBounds[froxel].min },
+				glm::vec3{ grid.mFroxelBounds[froxel].max }) - center };
+
+			if (glm::dot(offset, offset) > radius * radius)
+			{
+				continue;
+			}
+
+			GLuint& count{ froxelLightCounts[froxel] };
+			if (count < LightGrid::maxLightsPerFroxel)
+			{
+				froxelLightIndices[froxel * LightGrid::maxLightsPerFroxel + count] = static_cast<GLuint>(i);
+				++count;
+			}
+			else
+			{
+				overflows[froxel] = true;
+			}
+		}
+	}
+
+	return static_cast<std::size_t>(std::count(overflows.begin(), overflows.end(), true));
+}
+
+bool LightBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	JobSystem jobSystem{ settings.threadCount > 0 ? settings.threadCount
+		: static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+
+	LightGrid grid{};
+	grid.setProjection(glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.25f, 10000.0f), 0.25f);
+
+	// Looking down -z from the origin, with the lights filling the first 200 units of the lit range
+	const glm::mat4 view{ 1.0f };
+	const glm::vec4 boundingSphere{ 0.0f, 0.0f, -100.0f, 100.0f };
+
+	out << "Light binning into " << LightGrid::froxelCount << " froxels on " << jobSystem.getThreadCount()
+		<< " threads. Median of " << settings.iterations << " runs\n\n";
+	out << std::right << std::setw(8) << "lights" << std::setw(12) << "bin ms" << std::setw(14) << "lights/froxel"
+		<< std::setw(14) << "overflowing" << '\n';
+
+	std::vector<GLuint> counts{};
+	std::vector<GLuint> indices{};
+	std::vector<GLuint> referenceCounts{};
+	std::vector<GLuint> referenceIndices{};
+
+	bool allMatch{ true };
+	for (std::size_t lightCount : lightCounts)
+	{
+		grid.mLights = LightGrid::generateRandomLights(lightCount, boundingSphere);
+
+		std::vector<double> binTimes{};
+		std::size_t overflowingFroxelCount{ 0 };
+
+		// The first run is a warmup
+		for (int i{ 0 }; i <= std::max(settings.iterations, 1); ++i)
+		{
+			const double binTime{ measureTime([&] { overflowingFroxelCount = grid.binLights(jobSystem, view, counts, indices); }) };
+			if (i > 0)
+			{
+				binTimes.push_back(binTime);
+			}
+		}
+
+		const std::size_t referenceOverflowingFroxelCount{ binLightsReference(grid, view, referenceCounts, referenceIndices) };
+
+		// Slots past a froxel's count are never read
+		bool matches{ counts == referenceCounts && overflowingFroxelCount == referenceOverflowingFroxelCount };
+		std::size_t totalLights{ 0 };
+		for (std::size_t froxel{ 0 }; froxel < LightGrid::froxelCount; ++froxel)
+		{
+			const auto first{ indices.cbegin() + static_cast<std::ptrdiff_t>(froxel) * LightGrid::maxLightsPerFroxel };
+			const auto referenceFirst{ referenceIndices.cbegin() + static_cast<std::ptrdiff_t>(froxel) * LightGrid::maxLightsPerFroxel };
+			matches = matches && std::equal(first, first + counts[froxel], referenceFirst);
+
+			totalLights += counts[froxel];
+		}
+
+		Results results{ .lightCount{ lightCount }, .binTime{ median(binTimes) },
+			.averageFroxelLights{ static_cast<double>(totalLights) / LightGrid::froxelCount },
+			.overflowingFroxelCount{ overflowingFroxelCount }, .matches{ matches } };
+
+		out << std::setw(8) << results.lightCount << std::fixed << std::setprecision(3)
+			<< std::setw(12) << results.binTime
+			<< std::setw(14) << std::setprecision(1) << results.averageFroxelLights << std::setprecision(3)
+			<< std::setw(14) << results.overflowingFroxelCount
+			<< (results.matches ? "" : "   MISMATCH") << '\n';
+
+		allMatch = allMatch && results.matches;
+	}
+
+	return allMatch;
+}
+
+LightBenchmark::Settings LightBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--threads")
+		{
+			settings.threadCount = static_cast<int>(size);
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
\ No newline at end of file
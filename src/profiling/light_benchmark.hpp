@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../lighting/light_grid.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <vector>
+
+// Times LightGrid::binLights from 10 to 10k random lights in front of the camera. light_cull.comp needs a GL context
+// and is compared against the CPU binning in the renderer's Stats window instead. Every run is checked against a
+// light-major reference that follows the same rules.
+class LightBenchmark final
+{
+public:
+
+	struct Settings
+	{
+		int iterations{ 9 };
+
+		// 0 uses every hardware thread
+		int threadCount{ 0 };
+	};
+
+	struct Results
+	{
+		std::size_t lightCount{};
+
+		// Median ms
+		double binTime{};
+
+		double averageFroxelLights{};
+		// Froxels touched by more than LightGrid::maxLightsPerFroxel lights, which dropped the rest
+		std::size_t overflowingFroxelCount{};
+
+		bool matches{ false };
+	};
+
+	// Walks the lights in the outer loop instead of the froxels, appending each light to every froxel it touches
+	// until that froxel is full. Gives the same lists & overflow count as LightGrid::binLights
+	static std::size_t binLightsReference(const LightGrid& grid, const glm::mat4& view, std::vector<GLuint>& froxelLightCounts,
+		std::vector<GLuint>& froxelLightIndices);
+
+	// Prints a table of every light count. Returns false if binLights disagrees with the reference on any of them
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations & --threads, each followed by a value
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+};
\ No newline at end of file
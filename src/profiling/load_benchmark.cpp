@@ -0,0 +1,385 @@
+#include "load_benchmark.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "../model/image_decoder.hpp"
+#include "../model/model_asset.hpp"
+#include "load_profiler.hpp"
+#include "memory_usage.hpp"
+
+#include "simdjson.h"
+
+#include <algorithm> // for find_if, max & sort
+#include <chrono>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib> // for strtod & strtoull
+#include <filesystem>
+#include <fstream>
+#include <iomanip> // for setprecision
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	// Stages faster than this are all noise, so they never count as regressions
+	constexpr double minimumRegressionTime{ 0.1 }; // ms
+
+	template <typename T>
+	T median(std::vector<T> values)
+	{
+		if (values.empty())
+		{
+			return T{};
+		}
+
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	void writeString(std::ostream& out, std::string_view string)
+	{
+		out << '"';
+		for (char c : string)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				out << ' ';
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+	}
+
+	// A default value for missing or mistyped fields, so older result files still load
+	template <typename T>
+	T getValue(simdjson::dom::element element, const char* key)
+	{
+		T value{};
+		if (element[key].get(value))
+		{
+			return T{};
+		}
+		return value;
+	}
+
+	double getChange(double value, double baseline)
+	{
+		return baseline > 0.0 ? value / baseline - 1.0 : 0.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+LoadBenchmark::Results LoadBenchmark::measure(const std::filesystem::path& path, const Settings& settings)
+{
+	JobSystem jobSystem{ settings.threadCount > 0 ? settings.threadCount
+		: static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+	const std::filesystem::path absolutePath{ std::filesystem::absolute(path) };
+
+	std::vector<LoadProfiler> profilers(settings.iterations);
+	std::vector<double> totalWallTimes{};
+	std::vector<std::size_t> totalAllocationCounts{};
+	std::vector<std::size_t> totalAllocatedBytes{};
+
+	for (int i{ -settings.warmupIterations }; i < settings.iterations; ++i)
+	{
+		LoadProfiler* profiler{ i >= 0 ? &profilers[i] : nullptr };
+
+		std::size_t allocationCount{ getAllocationCount() };
+		std::size_t allocatedBytes{ getAllocatedBytes() };
+		auto start{ std::chrono::high_resolution_clock::now() };
+
+		{
+			ModelAsset asset{ jobSystem, absolutePath, 0, 0, 0, 0, absolutePath.parent_path(), {}, profiler };
+
+			// What ModelObject's image streaming does on its jobs, minus the upload
+			LoadProfiler::Scope stage{ profiler, "decodeImages" };
+			ImageDecoder::decodeAll(jobSystem, asset.mImageSources);
+		}
+
+		auto end{ std::chrono::high_resolution_clock::now() };
+		if (profiler)
+		{
+			totalWallTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1'000'000.0);
+			totalAllocationCounts.push_back(getAllocationCount() - allocationCount);
+			totalAllocatedBytes.push_back(getAllocatedBytes() - allocatedBytes);
+		}
+	}
+
+	Results results{
+		.label{ settings.label },
+		.path{ absolutePath.generic_string() },
+		.iterations{ settings.iterations },
+		.threadCount{ jobSystem.getThreadCount() },
+		.totalWallTime{ median(totalWallTimes) },
+		.totalAllocationCount{ median(totalAllocationCounts) },
+		.totalAllocatedBytes{ median(totalAllocatedBytes) },
+		.peakResidentBytes{ getPeakResidentBytes() } };
+
+	// Every load runs the same stages in the same order, so the first one names them
+	if (profilers.empty())
+	{
+		return results;
+	}
+
+	for (const auto& firstStage : profilers.front().mStages)
+	{
+		StageResults stage{ .name{ firstStage.name }, .minWallTime{ firstStage.wallTime } };
+
+		std::vector<double> wallTimes{};
+		std::vector<std::size_t> allocationCounts{};
+		std::vector<std::size_t> allocatedBytes{};
+		for (const auto& profiler : profilers)
+		{
+			auto match{ std::find_if(profiler.mStages.begin(), profiler.mStages.end(),
+				[&](const LoadProfiler::Stage& s) { return s.name == firstStage.name; }) };
+			if (match == profiler.mStages.end())
+			{
+				continue;
+			}
+
+			wallTimes.push_back(match->wallTime);
+			allocationCounts.push_back(match->allocationCount);
+			allocatedBytes.push_back(match->allocatedBytes);
+
+			stage.minWallTime = std::min(stage.minWallTime, match->wallTime);
+			stage.peakHeapBytes = std::max(stage.peakHeapBytes, match->peakHeapBytes);
+			stage.peakResidentBytes = std::max(stage.peakResidentBytes, match->peakResidentBytes);
+		}
+
+		stage.medianWallTime = median(wallTimes);
+		stage.allocationCount = median(allocationCounts);
+		stage.allocatedBytes = median(allocatedBytes);
+
+		results.stages.push_back(stage);
+	}
+
+	return results;
+}
+
+void LoadBenchmark::writeJson(std::ostream& out, const Results& results)
+{
+	out << std::fixed << std::setprecision(3);
+
+	out << "{\n";
+	out << "  \"label\": ";
+	writeString(out, results.label);
+	out << ",\n  \"path\": ";
+	writeString(out, results.path);
+	out << ",\n  \"iterations\": " << results.iterations;
+	out << ",\n  \"threadCount\": " << results.threadCount;
+	out << ",\n  \"totalWallTimeMs\": " << results.totalWallTime;
+	out << ",\n  \"totalAllocationCount\": " << results.totalAllocationCount;
+	out << ",\n  \"totalAllocatedBytes\": " << results.totalAllocatedBytes;
+	out << ",\n  \"peakResidentBytes\": " << results.peakResidentBytes;
+	out << ",\n  \"stages\": [";
+
+	for (std::size_t i{ 0 }; i < results.stages.size(); ++i)
+	{
+		const auto& stage{ results.stages[i] };
+
+		out << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+		writeString(out, stage.name);
+		out << ", \"medianWallTimeMs\": " << stage.medianWallTime
+			<< ", \"minWallTimeMs\": " << stage.minWallTime
+			<< ", \"allocationCount\": " << stage.allocationCount
+			<< ", \"allocatedBytes\": " << stage.allocatedBytes
+			<< ", \"peakHeapBytes\": " << stage.peakHeapBytes
+			<< ", \"peakResidentBytes\": " << stage.peakResidentBytes << " }";
+	}
+
+	out << "\n  ]\n}\n";
+
+	out << std::defaultfloat << std::setprecision(6);
+}
+
+std::optional<LoadBenchmark::Results> LoadBenchmark::readJson(const std::filesystem::path& path)
+{
+	simdjson::dom::parser parser{};
+	simdjson::dom::element root{};
+	simdjson::dom::array stages{};
+	if (parser.load(path.string()).get(root) || root["stages"].get(stages))
+	{
+		return std::nullopt;
+	}
+
+	Results results{
+		.label{ std::string{ getValue<std::string_view>(root, "label") } },
+		.path{ std::string{ getValue<std::string_view>(root, "path") } },
+		.iterations{ static_cast<int>(getValue<std::int64_t>(root, "iterations")) },
+		.threadCount{ static_cast<int>(getValue<std::int64_t>(root, "threadCount")) },
+		.totalWallTime{ getValue<double>(root, "totalWallTimeMs") },
+		.totalAllocationCount{ static_cast<std::size_t>(getValue<std::uint64_t>(root, "totalAllocationCount")) },
+		.totalAllocatedBytes{ static_cast<std::size_t>(getValue<std::uint64_t>(root, "totalAllocatedBytes")) },
+		.peakResidentBytes{ static_cast<std::size_t>(getValue<std::uint64_t>(root, "peakResidentBytes")) } };
+
+	for (simdjson::dom::element stage : stages)
+	{
+		results.stages.push_back({
+			.name{ std::string{ getValue<std::string_view>(stage, "name") } },
+			.medianWallTime{ getValue<double>(stage, "medianWallTimeMs") },
+			.minWallTime{ getValue<double>(stage, "minWallTimeMs") },
+			.allocationCount{ static_cast<std::size_t>(getValue<std::uint64_t>(stage, "allocationCount")) },
+			.allocatedBytes{ static_cast<std::size_t>(getValue<std::uint64_t>(stage, "allocatedBytes")) },
+			.peakHeapBytes{ static_cast<std::size_t>(getValue<std::uint64_t>(stage, "peakHeapBytes")) },
+			.peakResidentBytes{ static_cast<std::size_t>(getValue<std::uint64_t>(stage, "peakResidentBytes")) } });
+	}
+
+	return results;
+}
+
+bool LoadBenchmark::compare(std::ostream& out, const Results& results, const Results& baseline, float threshold)
+{
+	bool passed{ true };
+
+	out << "Against " << (baseline.label.empty() ? std::string{ "baseline" } : baseline.label) << ":\n";
+	out << std::fixed << std::setprecision(2);
+
+	for (const auto& stage : results.stages)
+	{
+		auto match{ std::find_if(baseline.stages.begin(), baseline.stages.end(),
+			[&](const StageResults& s) { return s.name == stage.name; }) };
+
+		out << "  " << std::left << std::setw(28) << stage.name << std::right;
+		if (match == baseline.stages.end())
+		{
+			out << std::setw(10) << stage.medianWallTime << " ms (new stage)\n";
+			continue;
+		}
+
+		double timeChange{ getChange(stage.medianWallTime, match->medianWallTime) };
+		double allocationChange{ getChange(static_cast<double>(stage.allocationCount), static_cast<double>(match->allocationCount)) };
+
+		bool slower{ timeChange > threshold && stage.medianWallTime - match->medianWallTime > minimumRegressionTime };
+		bool moreAllocations{ allocationChange > threshold };
+
+		out << std::setw(10) << match->medianWallTime << " -> " << std::setw(10) << stage.medianWallTime << " ms ("
+			<< std::showpos << timeChange * 100.0 << "%)   " << std::noshowpos
+			<< std::setw(9) << match->allocationCount << " -> " << std::setw(9) << stage.allocationCount << " allocations ("
+			<< std::showpos << allocationChange * 100.0 << "%)" << std::noshowpos;
+
+		if (slower || moreAllocations)
+		{
+			out << "   REGRESSION";
+			passed = false;
+		}
+		out << '\n';
+	}
+
+	out << "  " << std::left << std::setw(28) << "total" << std::right << std::setw(10) << baseline.totalWallTime << " -> "
+		<< std::setw(10) << results.totalWallTime << " ms ("
+		<< std::showpos << getChange(results.totalWallTime, baseline.totalWallTime) * 100.0 << "%)\n" << std::noshowpos;
+
+	out << std::defaultfloat << std::setprecision(6);
+
+	return passed;
+}
+
+bool LoadBenchmark::run(std::ostream& out, const std::filesystem::path& path, const Settings& settings)
+{
+	Results results{ measure(path, settings) };
+
+	if (settings.output.empty())
+	{
+		writeJson(out, results);
+	}
+	else
+	{
+		std::ofstream file{ settings.output };
+		writeJson(file, results);
+		out << "Wrote " << settings.output.generic_string() << '\n';
+	}
+
+	if (settings.baseline.empty())
+	{
+		return true;
+	}
+
+	std::optional<Results> baseline{ readJson(settings.baseline) };
+	if (!baseline)
+	{
+		out << "Failed to read baseline " << settings.baseline.generic_string() << '\n';
+		return false;
+	}
+
+	return compare(out, results, *baseline, settings.regressionThreshold);
+}
+
+LoadBenchmark::Settings LoadBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (option == "--iterations" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--warmup" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.warmupIterations = static_cast<int>(size);
+		}
+		else if (option == "--threads" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.threadCount = static_cast<int>(size);
+		}
+		else if (option == "--label")
+		{
+			settings.label = value;
+		}
+		else if (option == "--out")
+		{
+			settings.output = value;
+		}
+		else if (option == "--baseline")
+		{
+			settings.baseline = value;
+		}
+		else if (option == "--threshold")
+		{
+			settings.regressionThreshold = static_cast<float>(std::strtod(value, nullptr));
+		}
+		else if (option != "--iterations" && option != "--warmup" && option != "--threads")
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "load_profiler.hpp"
+
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Builds a ModelAsset from a glTF/GLB file a number of times, decoding its images too, and reports every stage as
+// JSON. Nothing touches GL, so it runs anywhere the file does. Saving a run per commit and comparing the next one against
+// it flags the stages that got slower or allocate more.
+class LoadBenchmark final
+{
+public:
+
+	struct Settings
+	{
+		int iterations{ 5 };
+		// Untimed loads first, so the file is in the OS cache for every timed one
+		int warmupIterations{ 1 };
+		int threadCount{ 0 }; // 0 uses every hardware thread
+
+		// Written into the results as is. Meant for the commit the run was made at
+		std::string label{};
+
+		// JSON is written here instead of to out when set
+		std::filesystem::path output{};
+
+		std::filesystem::path baseline{};
+		// Fraction a stage's median time or allocation count may grow by before it's a regression
+		float regressionThreshold{ 0.1f };
+	};
+
+	struct StageResults
+	{
+		std::string name{};
+
+		// ms over the timed iterations
+		double medianWallTime{};
+		double minWallTime{};
+
+		// Medians, as job scheduling makes them vary a little between loads
+		std::size_t allocationCount{};
+		std::size_t allocatedBytes{};
+
+		// Highest over every iteration
+		std::size_t peakHeapBytes{};
+		std::size_t peakResidentBytes{};
+	};
+
+	struct Results
+	{
+		std::string label{};
+		std::string path{};
+
+		int iterations{};
+		int threadCount{};
+
+		// Medians of whole loads, including what happens between stages
+		double totalWallTime{};
+		std::size_t totalAllocationCount{};
+		std::size_t totalAllocatedBytes{};
+		std::size_t peakResidentBytes{};
+
+		std::vector<StageResults> stages{};
+	};
+
+	static Results measure(const std::filesystem::path& path, const Settings& settings);
+
+	static void writeJson(std::ostream& out, const Results& results);
+	// Only reads what writeJson writes. Empty if the file is missing or isn't valid JSON
+	static std::optional<Results> readJson(const std::filesystem::path& path);
+
+	// Prints every stage next to the baseline's. Returns false if any of them regressed past threshold
+	static bool compare(std::ostream& out, const Results& results, const Results& baseline, float threshold);
+
+	// measure(), then writeJson() and compare() as the settings ask. Returns false on a regression or a missing baseline
+	static bool run(std::ostream& out, const std::filesystem::path& path, const Settings& settings);
+
+	// --iterations, --warmup, --threads, --label, --out, --baseline and --threshold, each followed by a value.
+	// Unknown options are reported to out and skipped
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+};
\ No newline at end of file
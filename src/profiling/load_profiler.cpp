@@ -0,0 +1,62 @@
+#include "load_profiler.hpp"
+
+#include "memory_usage.hpp"
+
+#include <algorithm> // for find_if & max
+#include <chrono>
+#include <cstddef> // for size_t
+#include <string>
+#include <string_view>
+
+
+
+LoadProfiler::Scope::Scope(LoadProfiler* profiler, std::string_view name)
+	: mProfiler{ profiler }
+	, mName{ name }
+{
+	if (!mProfiler)
+	{
+		return;
+	}
+
+	resetPeakHeapBytes();
+	mAllocationCount = getAllocationCount();
+	mAllocatedBytes = getAllocatedBytes();
+	mStart = std::chrono::high_resolution_clock::now();
+}
+
+LoadProfiler::Scope::~Scope()
+{
+	if (!mProfiler)
+	{
+		return;
+	}
+
+	auto end{ std::chrono::high_resolution_clock::now() };
+
+	mProfiler->addStage({
+		.name{ std::string{ mName } },
+		.wallTime{ std::chrono::duration_cast<std::chrono::nanoseconds>(end - mStart).count() / 1'000'000.0 },
+		.allocationCount{ getAllocationCount() - mAllocationCount },
+		.allocatedBytes{ getAllocatedBytes() - mAllocatedBytes },
+		.peakHeapBytes{ getPeakHeapBytes() },
+		.peakResidentBytes{ getPeakResidentBytes() } });
+}
+
+
+
+void LoadProfiler::addStage(const Stage& stage)
+{
+	auto existing{ std::find_if(mStages.begin(), mStages.end(), [&](const Stage& s) { return s.name == stage.name; }) };
+	if (existing == mStages.end())
+	{
+		mStages.push_back(stage);
+		return;
+	}
+
+	existing->wallTime += stage.wallTime;
+	existing->allocationCount += stage.allocationCount;
+	existing->allocatedBytes += stage.allocatedBytes;
+	existing->peakHeapBytes = std::max(existing->peakHeapBytes, stage.peakHeapBytes);
+	existing->peakResidentBytes = std::max(existing->peakResidentBytes, stage.peakResidentBytes);
+}
\ No newline at end of file
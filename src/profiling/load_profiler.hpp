@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef> // for std::size_t
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits a model load into named stages and records each one's wall time, operator new traffic and memory.
+// Stages with the same name add up, so one profiler can be handed to several loads
+class LoadProfiler final
+{
+public:
+
+	struct Stage
+	{
+		std::string name{};
+
+		double wallTime{}; // ms
+		std::size_t allocationCount{};
+		std::size_t allocatedBytes{};
+
+		// Highest live operator new bytes while the stage ran, and the process' resident high-water mark after it
+		std::size_t peakHeapBytes{};
+		std::size_t peakResidentBytes{};
+	};
+
+	// Records a stage from construction to destruction. Does nothing without a profiler. Scopes mustn't nest, as each
+	// one resets the heap peak
+	class Scope final
+	{
+	public:
+
+		Scope(LoadProfiler* profiler, std::string_view name);
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope();
+
+	private:
+
+		LoadProfiler* mProfiler{};
+		std::string_view mName{};
+
+		std::chrono::high_resolution_clock::time_point mStart{};
+		std::size_t mAllocationCount{};
+		std::size_t mAllocatedBytes{};
+	};
+
+	// In the order each stage first ran
+	std::vector<Stage> mStages{};
+
+private:
+
+	void addStage(const Stage& stage);
+};
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "memory_usage.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h> // for sysconf
+
+#include <fstream>
+#endif
+
+#include <atomic>
+#include <cstddef> // for size_t
+
+
+
+namespace
+{
+	// Relaxed: the counts are only read between load stages, never used to order anything
+	std::atomic<std::size_t> allocationCount{ 0 };
+	std::atomic<std::size_t> allocatedBytes{ 0 };
+	std::atomic<std::size_t> liveHeapBytes{ 0 };
+	std::atomic<std::size_t> peakHeapBytes{ 0 };
+}
+
+
+
+std::size_t getCurrentResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.WorkingSetSize;
+	}
+	return 0;
+#elif defined(__linux__)
+	// Second field of statm is the resident page count
+	std::ifstream statm{ "/proc/self/statm" };
+	std::size_t totalPages{ 0 };
+	std::size_t residentPages{ 0 };
+	if (statm >> totalPages >> residentPages)
+	{
+		return residentPages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	}
+	return 0;
+#else
+	return 0;
+#endif
+}
+
+std::size_t getPeakResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#elif defined(__linux__)
+	// ru_maxrss is in KiB on Linux
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+	}
+	return 0;
+#else
+	return 0;
+#endif
+}
+
+std::size_t getAllocationCount()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+std::size_t getAllocatedBytes()
+{
+	return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+std::size_t getLiveHeapBytes()
+{
+	return liveHeapBytes.load(std::memory_order_relaxed);
+}
+
+std::size_t getPeakHeapBytes()
+{
+	return peakHeapBytes.load(std::memory_order_relaxed);
+}
+
+void resetPeakHeapBytes()
+{
+	peakHeapBytes.store(liveHeapBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void recordHeapAllocation(std::size_t size, std::size_t blockSize)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	std::size_t live{ liveHeapBytes.fetch_add(blockSize, std::memory_order_relaxed) + blockSize };
+	std::size_t peak{ peakHeapBytes.load(std::memory_order_relaxed) };
+	while (live > peak && !peakHeapBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+void recordHeapFree(std::size_t blockSize)
+{
+	liveHeapBytes.fetch_sub(blockSize, std::memory_order_relaxed);
+}
\ No newline at end of file
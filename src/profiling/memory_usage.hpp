@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+
+// Resident memory of the whole process as the OS reports it, in bytes. 0 where it isn't available
+std::size_t getCurrentResidentBytes();
+std::size_t getPeakResidentBytes();
+
+// Heap traffic through the global operator new & delete, plain and aligned. Only counted in executables that link
+// counting_new.cpp, which replaces them: asset_benchmark & asset_tests. Everywhere else, including the renderer, these
+// stay 0. Plain malloc (stb_image's decodes) isn't counted
+std::size_t getAllocationCount();
+std::size_t getAllocatedBytes(); // Added up over every allocation, freed or not
+
+std::size_t getLiveHeapBytes();
+// Highest getLiveHeapBytes() since the last resetPeakHeapBytes(), which sets it to the current live bytes
+std::size_t getPeakHeapBytes();
+void resetPeakHeapBytes();
+
+// Called by counting_new.cpp. blockSize is what the allocator actually handed out, so frees can be subtracted
+// without storing a header
+void recordHeapAllocation(std::size_t size, std::size_t blockSize);
+void recordHeapFree(std::size_t blockSize);
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "occlusion_benchmark.hpp"
+
+#include "culling_benchmark.hpp"
+#include "../camera/camera.hpp"
+#include "../culling/frustum_culler.hpp"
+#include "../culling/occlusion_buffer.hpp"
+#include "../jobs/job_system.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for max, min, partial_sort & sort
+#include <chrono>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib> // for strtoull
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility> // for pair
+#include <vector>
+
+
+
+namespace
+{
+	// The resolutions of the renderer's "occlusion buffer resolution" combo, and one above them
+	constexpr int resolutions[][2]{ { 64, 36 }, { 128, 72 }, { 256, 144 }, { 512, 288 }, { 1024, 576 } };
+
+	// A box a little inside the clusters of a building, so it only hides what the building would
+	constexpr float occluderHalfWidth{ 2.5f };
+
+	constexpr float fovY{ glm::radians(75.0f) };
+	constexpr float aspectRatio{ 16.0f / 9.0f };
+	constexpr float zNear{ 0.25f };
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+
+	// The renderer's reverse-Z projection, which the occlusion buffer's depth test expects
+	glm::mat4 infiniteReversePerspective(float fovY, float aspect, float zNear)
+	{
+		float f{ 1.0f / std::tan(fovY / 2.0f) };
+		return glm::mat4{
+			f / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, f, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, -1.0f,
+			0.0f, 0.0f, zNear, 0.0f };
+	}
+
+	std::size_t countBits(const std::vector<std::uint32_t>& bitmask)
+	{
+		std::size_t count{ 0 };
+		for (auto word : bitmask)
+		{
+			for (; word != 0; word &= word - 1)
+			{
+				++count;
+			}
+		}
+
+		return count;
+	}
+}
+
+
+
+std::vector<glm::vec3> OcclusionBenchmark::generateOccluders(const std::vector<glm::vec4>& city, const glm::vec3& cameraPosition,
+	std::size_t occluderCount)
+{
+	constexpr std::size_t clustersPerBuilding{ CullingBenchmark::clustersPerBuilding };
+
+	// Footprint center & height of every building
+	std::vector<std::pair<float, glm::vec3>> buildings{};
+	buildings.reserve(city.size() / clustersPerBuilding + 1);
+	for (std::size_t first{ 0 }; first < city.size(); first += clustersPerBuilding)
+	{
+		const std::size_t last{ std::min(first + clustersPerBuilding, city.size()) };
+
+		glm::vec3 center{ 0.0f };
+		for (std::size_t i{ first }; i < last; ++i)
+		{
+			center.x += city[i].x;
+			center.z += city[i].z;
+			center.y = std::max(center.y, city[i].y);
+		}
+		center.x /= static_cast<float>(last - first);
+		center.z /= static_cast<float>(last - first);
+
+		const glm::vec2 offset{ center.x - cameraPosition.x, center.z - cameraPosition.z };
+		buildings.push_back({ glm::dot(offset, offset), center });
+	}
+
+	occluderCount = std::min(occluderCount, buildings.size());
+	std::partial_sort(buildings.begin(), buildings.begin() + occluderCount, buildings.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::vector<glm::vec3> triangles{};
+	triangles.reserve(occluderCount * 30);
+	for (std::size_t i{ 0 }; i < occluderCount; ++i)
+	{
+		const glm::vec3& center{ buildings[i].second };
+		const glm::vec3 min{ center.x - occluderHalfWidth, 0.0f, center.z - occluderHalfWidth };
+		const glm::vec3 max{ center.x + occluderHalfWidth, center.y, center.z + occluderHalfWidth };
+
+		const glm::vec3 corners[8]
+		{
+			{ min.x, min.y, min.z }, { max.x, min.y, min.z }, { max.x, min.y, max.z }, { min.x, min.y, max.z },
+			{ min.x, max.y, min.z }, { max.x, max.y, min.z }, { max.x, max.y, max.z }, { min.x, max.y, max.z },
+		};
+
+		// Four walls & the roof, two triangles each
+		constexpr int quads[5][4]{ { 0, 1, 5, 4 }, { 1, 2, 6, 5 }, { 2, 3, 7, 6 }, { 3, 0, 4, 7 }, { 4, 5, 6, 7 } };
+		for (const auto& quad : quads)
+		{
+			for (int corner : { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] })
+			{
+				triangles.push_back(corners[corner]);
+			}
+		}
+	}
+
+	return triangles;
+}
+
+bool OcclusionBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	const std::vector<glm::vec4> city{ CullingBenchmark::generateCity(settings.clusterCount) };
+
+	JobSystem jobSystem{ settings.threadCount > 0 ? settings.threadCount
+		: static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+
+	FrustumCuller frustumCuller{};
+	frustumCuller.setClusters(city, std::vector<GLuint>(city.size(), 0));
+	frustumCuller.updateWorldSpheres(jobSystem, { glm::mat4{ 1.0f } });
+
+	out << "Occlusion buffer culling of " << city.size() << " clusters behind the " << settings.occluderCount
+		<< " nearest buildings on " << jobSystem.getThreadCount() << " threads. Median of " << settings.iterations << " runs\n\n";
+	out << std::left << std::setw(10) << "view" << std::setw(10) << "size" << std::right
+		<< std::setw(12) << "in frustum" << std::setw(12) << "visible" << std::setw(10) << "hidden"
+		<< std::setw(12) << "raster ms" << std::setw(10) << "cull ms" << '\n';
+
+	const glm::mat4 frustumProj{ glm::perspective(fovY, aspectRatio, zNear, 10000.0f) };
+	const glm::mat4 proj{ infiniteReversePerspective(fovY, aspectRatio, zNear) };
+
+	std::vector<std::uint32_t> frustumBits{};
+	std::vector<std::uint32_t> visibleBits{};
+
+	bool allSubsets{ true };
+	for (const auto& view : CullingBenchmark::getDefaultViews(city))
+	{
+		const glm::mat4 viewMatrix{ glm::lookAt(view.position, view.target, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+		const Camera::Frustum frustum{ Camera::getFrustum(frustumProj * viewMatrix) };
+
+		frustumCuller.cull(jobSystem, frustum, frustumBits);
+		const std::size_t frustumVisibleCount{ countBits(frustumBits) };
+
+		OcclusionBuffer occlusionBuffer{};
+		occlusionBuffer.setOccluders(generateOccluders(city, view.position, settings.occluderCount));
+
+		for (const auto& resolution : resolutions)
+		{
+			occlusionBuffer.resize(resolution[0], resolution[1]);
+
+			std::vector<double> rasterizeTimes{};
+			std::vector<double> cullTimes{};
+
+			// The first run of each is a warmup
+			for (int i{ 0 }; i <= std::max(settings.iterations, 1); ++i)
+			{
+				const double rasterizeTime{ measureTime([&] { occlusionBuffer.rasterize(proj * viewMatrix); }) };
+				const double cullTime{ measureTime([&] {
+					occlusionBuffer.cull(jobSystem, frustumCuller, frustum, viewMatrix, proj, zNear, visibleBits); }) };
+
+				if (i > 0)
+				{
+					rasterizeTimes.push_back(rasterizeTime);
+					cullTimes.push_back(cullTime);
+				}
+			}
+
+			bool isSubset{ visibleBits.size() == frustumBits.size() };
+			for (std::size_t i{ 0 }; isSubset && i < visibleBits.size(); ++i)
+			{
+				isSubset = (visibleBits[i] & ~frustumBits[i]) == 0;
+			}
+
+			Results results{ .view{ view.name }, .width{ resolution[0] }, .height{ resolution[1] },
+				.frustumVisibleCount{ frustumVisibleCount }, .visibleCount{ countBits(visibleBits) },
+				.rasterizeTime{ median(rasterizeTimes) }, .cullTime{ median(cullTimes) }, .isSubset{ isSubset } };
+
+			const double hidden{ results.frustumVisibleCount > 0
+				? 100.0 * (1.0 - static_cast<double>(results.visibleCount) / results.frustumVisibleCount) : 0.0 };
+
+			out << std::left << std::setw(10) << results.view
+				<< std::setw(10) << (std::to_string(results.width) + "x" + std::to_string(results.height)) << std::right
+				<< std::fixed << std::setprecision(3)
+				<< std::setw(12) << results.frustumVisibleCount
+				<< std::setw(12) << results.visibleCount
+				<< std::setw(9) << std::setprecision(1) << hidden << '%' << std::setprecision(3)
+				<< std::setw(12) << results.rasterizeTime
+				<< std::setw(10) << results.cullTime
+				<< (results.isSubset ? "" : "   MISMATCH") << '\n';
+
+			allSubsets = allSubsets && results.isSubset;
+		}
+	}
+
+	return allSubsets;
+}
+
+OcclusionBenchmark::Settings OcclusionBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--clusters")
+		{
+			settings.clusterCount = std::max<std::size_t>(size, 1);
+		}
+		else if (option == "--occluders")
+		{
+			settings.occluderCount = size;
+		}
+		else if (option == "--threads")
+		{
+			settings.threadCount = static_cast<int>(size);
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
\ No newline at end of file
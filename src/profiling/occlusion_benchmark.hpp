@@ -0,0 +1,54 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times OcclusionBuffer at every resolution the renderer offers on CullingBenchmark's synthetic city, with the
+// buildings nearest the camera as box occluders. Occlusion culling must only ever remove clusters that frustum
+// culling kept.
+class OcclusionBenchmark final
+{
+public:
+
+	struct Settings
+	{
+		int iterations{ 9 };
+		std::size_t clusterCount{ 1'000'000 };
+
+		// Buildings nearest the camera that are rasterized as boxes
+		std::size_t occluderCount{ 256 };
+
+		// For OcclusionBuffer::cull. 0 uses every hardware thread
+		int threadCount{ 0 };
+	};
+
+	struct Results
+	{
+		std::string view{};
+		int width{};
+		int height{};
+
+		std::size_t frustumVisibleCount{};
+		std::size_t visibleCount{};
+
+		// Median ms
+		double rasterizeTime{};
+		double cullTime{};
+
+		bool isSubset{ false };
+	};
+
+	// A box without its bottom face around each of the occluderCount buildings nearest cameraPosition, as a triangle list
+	static std::vector<glm::vec3> generateOccluders(const std::vector<glm::vec4>& city, const glm::vec3& cameraPosition,
+		std::size_t occluderCount);
+
+	// Prints a table of every view & resolution. Returns false if occlusion culling kept a cluster frustum culling removed
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations, --clusters, --occluders & --threads, each followed by a value
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+};
\ No newline at end of file
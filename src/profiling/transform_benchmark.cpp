@@ -0,0 +1,361 @@
+#include "transform_benchmark.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "../model/transform_kernel.hpp"
+
+#include "fastgltf/types.hpp"
+
+#include "glm/glm.hpp"
+
+#include <algorithm> // for max & sort
+#include <chrono>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdlib> // for strtoull
+#include <cstring> // for memcmp
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	struct Trs
+	{
+		glm::vec3 translation{};
+		glm::vec4 rotation{ 0.0f, 0.0f, 0.0f, 1.0f };
+		glm::vec3 scale{ 1.0f };
+	};
+
+	// A node table as ModelAsset::buildNodeTable lays it out, with the children of every level in order
+	struct Table
+	{
+		std::vector<Trs> trs{};
+		std::vector<int> parents{};
+		std::vector<int> levelOffsets{ 0 };
+	};
+
+	// Small turns, offsets & scales keep deep chains from blowing up
+	Table generateTable(const TransformBenchmark::Hierarchy& hierarchy)
+	{
+		std::mt19937 generator{ 1 };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+		Table table{};
+
+		std::size_t levelSize{ hierarchy.rootCount };
+		for (int level{ 0 }; level < hierarchy.depth && levelSize > 0; ++level)
+		{
+			const int levelStart{ table.levelOffsets.back() };
+			const int parentStart{ level == 0 ? 0 : table.levelOffsets[level - 1] };
+
+			for (std::size_t i{ 0 }; i < levelSize; ++i)
+			{
+				const glm::vec3 axis{ glm::normalize(glm::vec3{ unit(generator), 1.0f, unit(generator) }) };
+				const float halfAngle{ unit(generator) * 0.05f };
+
+				table.trs.push_back({ .translation{ unit(generator), unit(generator), unit(generator) },
+					.rotation{ axis * std::sin(halfAngle), std::cos(halfAngle) },
+					.scale{ glm::vec3{ 1.0f + unit(generator) * 0.02f } } });
+				table.parents.push_back(level == 0 ? -1 : parentStart + static_cast<int>(i / hierarchy.fanout));
+			}
+
+			table.levelOffsets.push_back(levelStart + static_cast<int>(levelSize));
+			levelSize *= hierarchy.fanout;
+		}
+
+		return table;
+	}
+
+	// How ModelAsset built TRS matrices before TransformKernel::composeTrs
+	glm::mat4 composeMatrices(const Trs& trs)
+	{
+		fastgltf::TRS source{};
+		source.translation = fastgltf::math::fvec3{ trs.translation.x, trs.translation.y, trs.translation.z };
+		source.rotation = fastgltf::math::fquat{ trs.rotation.x, trs.rotation.y, trs.rotation.z, trs.rotation.w };
+		source.scale = fastgltf::math::fvec3{ trs.scale.x, trs.scale.y, trs.scale.z };
+
+		auto t{ fastgltf::math::translate(fastgltf::math::fmat4x4{ 1.0f }, source.translation) };
+		auto r{ fastgltf::math::rotate(fastgltf::math::fmat4x4{ 1.0f }, source.rotation) };
+		auto s{ fastgltf::math::scale(fastgltf::math::fmat4x4{ 1.0f }, source.scale) };
+		const auto m{ t * r * s };
+
+		glm::mat4 matrix{};
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			for (int n{ 0 }; n < 4; ++n)
+			{
+				matrix[i][n] = m[i][n];
+			}
+		}
+
+		return matrix;
+	}
+
+	// Largest of the three axis lengths. TransformKernel::getMaxScale takes one square root instead, and must agree
+	float getReferenceMaxScale(const glm::mat4& transform)
+	{
+		return std::max(glm::length(glm::vec3{ transform[0] }),
+			std::max(glm::length(glm::vec3{ transform[1] }), glm::length(glm::vec3{ transform[2] })));
+	}
+
+	float getRelativeError(const glm::mat4& a, const glm::mat4& b)
+	{
+		float difference{ 0.0f };
+		float magnitude{ 0.0f };
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			for (int n{ 0 }; n < 4; ++n)
+			{
+				difference = std::max(difference, std::abs(a[i][n] - b[i][n]));
+				magnitude = std::max(magnitude, std::abs(a[i][n]));
+			}
+		}
+
+		return magnitude > 0.0f ? difference / magnitude : difference;
+	}
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+TransformBenchmark::Results TransformBenchmark::measure(const Hierarchy& hierarchy, int iterations, int threadCount)
+{
+	const Table table{ generateTable(hierarchy) };
+	const std::size_t nodeCount{ table.parents.size() };
+
+	JobSystem jobSystem{ threadCount > 0 ? threadCount : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) };
+
+	Results results{ .hierarchy{ hierarchy }, .nodeCount{ nodeCount }, .threadCount{ jobSystem.getThreadCount() } };
+
+	// Written once before timing, so no run is timed faulting in fresh pages
+	std::vector<glm::mat4> matrixLocals(nodeCount);
+	std::vector<glm::mat4> localTransforms(nodeCount);
+	std::vector<glm::mat4> scalarGlobals(nodeCount);
+	std::vector<glm::mat4> simdGlobals(nodeCount);
+	std::vector<glm::mat4> parallelGlobals(nodeCount);
+	std::vector<float> scales(nodeCount);
+
+	std::vector<double> matrixComposeTimes{};
+	std::vector<double> directComposeTimes{};
+	std::vector<double> scalarTimes{};
+	std::vector<double> simdTimes{};
+	std::vector<double> parallelTimes{};
+	std::vector<double> scaleTimes{};
+
+	// The first run of each is a warmup
+	for (int i{ 0 }; i <= std::max(iterations, 1); ++i)
+	{
+		const double matrixComposeTime{ measureTime([&] {
+			for (std::size_t node{ 0 }; node < nodeCount; ++node)
+			{
+				matrixLocals[node] = composeMatrices(table.trs[node]);
+			}
+			}) };
+
+		const double directComposeTime{ measureTime([&] {
+			for (std::size_t node{ 0 }; node < nodeCount; ++node)
+			{
+				const Trs& trs{ table.trs[node] };
+				localTransforms[node] = TransformKernel::composeTrs(trs.translation, trs.rotation, trs.scale);
+			}
+			}) };
+
+		const double scalarTime{ measureTime([&] {
+			for (std::size_t node{ 0 }; node < nodeCount; ++node)
+			{
+				const int parent{ table.parents[node] };
+				scalarGlobals[node] = parent == -1 ? localTransforms[node] : scalarGlobals[parent] * localTransforms[node];
+			}
+			}) };
+
+		const double simdTime{ measureTime([&] {
+			TransformKernel::evaluateRange(localTransforms, table.parents, simdGlobals, 0, nodeCount);
+			}) };
+
+		const double parallelTime{ measureTime([&] {
+			TransformKernel::evaluate(jobSystem, localTransforms, table.parents, table.levelOffsets, parallelGlobals);
+			}) };
+
+		const double scaleTime{ measureTime([&] {
+			for (std::size_t node{ 0 }; node < nodeCount; ++node)
+			{
+				scales[node] = TransformKernel::getMaxScale(parallelGlobals[node]);
+			}
+			}) };
+
+		if (i > 0)
+		{
+			matrixComposeTimes.push_back(matrixComposeTime);
+			directComposeTimes.push_back(directComposeTime);
+			scalarTimes.push_back(scalarTime);
+			simdTimes.push_back(simdTime);
+			parallelTimes.push_back(parallelTime);
+			scaleTimes.push_back(scaleTime);
+		}
+	}
+
+	results.matrixComposeTime = median(matrixComposeTimes);
+	results.directComposeTime = median(directComposeTimes);
+	results.scalarTime = median(scalarTimes);
+	results.simdTime = median(simdTimes);
+	results.parallelTime = median(parallelTimes);
+	results.scaleTime = median(scaleTimes);
+
+	bool scalesMatch{ true };
+	for (std::size_t node{ 0 }; node < nodeCount; ++node)
+	{
+		results.composeError = std::max(results.composeError, getRelativeError(matrixLocals[node], localTransforms[node]));
+		scalesMatch = scalesMatch && scales[node] == getReferenceMaxScale(parallelGlobals[node]);
+	}
+
+	results.matches = scalesMatch
+		&& std::memcmp(scalarGlobals.data(), simdGlobals.data(), nodeCount * sizeof(glm::mat4)) == 0
+		&& std::memcmp(scalarGlobals.data(), parallelGlobals.data(), nodeCount * sizeof(glm::mat4)) == 0;
+
+	return results;
+}
+
+std::vector<TransformBenchmark::Hierarchy> TransformBenchmark::getDefaultHierarchies()
+{
+	return {
+		{ .rootCount{ 1 }, .fanout{ 2 }, .depth{ 20 } },
+		{ .rootCount{ 1024 }, .fanout{ 1 }, .depth{ 1024 } },
+		{ .rootCount{ 1024 }, .fanout{ 1024 }, .depth{ 2 } },
+		{ .rootCount{ 16 }, .fanout{ 16 }, .depth{ 5 } },
+	};
+}
+
+bool TransformBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	const std::vector<Hierarchy> hierarchies{ settings.hierarchies.empty() ? getDefaultHierarchies() : settings.hierarchies };
+
+	out << "Node transforms: TRS as three matrices multiplied vs built directly, then global transforms with glm, the SIMD "
+		"multiply, and the SIMD multiply in parallel per level. Median of " << settings.iterations << " runs\n\n";
+
+	out << std::left << std::setw(32) << "hierarchy" << std::right
+		<< std::setw(10) << "nodes" << std::setw(14) << "3 matrix ms" << std::setw(12) << "direct ms"
+		<< std::setw(10) << "glm ms" << std::setw(10) << "simd ms" << std::setw(14) << "parallel ms"
+		<< std::setw(9) << "threads" << std::setw(12) << "scales ms" << std::setw(14) << "TRS error" << '\n';
+
+	bool allMatch{ true };
+	for (const auto& hierarchy : hierarchies)
+	{
+		const Results results{ measure(hierarchy, settings.iterations, settings.threadCount) };
+
+		out << std::left << std::setw(32) << describe(hierarchy) << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << results.nodeCount
+			<< std::setw(14) << results.matrixComposeTime
+			<< std::setw(12) << results.directComposeTime
+			<< std::setw(10) << results.scalarTime
+			<< std::setw(10) << results.simdTime
+			<< std::setw(14) << results.parallelTime
+			<< std::setw(9) << results.threadCount
+			<< std::setw(12) << results.scaleTime
+			<< std::setw(14) << std::scientific << std::setprecision(2) << results.composeError << std::fixed
+			<< (results.matches ? "" : "   MISMATCH") << '\n';
+
+		allMatch = allMatch && results.matches;
+	}
+
+	return allMatch;
+}
+
+TransformBenchmark::Settings TransformBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+	Hierarchy hierarchy{};
+	bool hasHierarchy{ false };
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--threads")
+		{
+			settings.threadCount = static_cast<int>(size);
+		}
+		else if (option == "--roots")
+		{
+			hierarchy.rootCount = std::max<std::size_t>(size, 1);
+			hasHierarchy = true;
+		}
+		else if (option == "--fanout")
+		{
+			hierarchy.fanout = std::max<std::size_t>(size, 1);
+			hasHierarchy = true;
+		}
+		else if (option == "--depth")
+		{
+			hierarchy.depth = std::max(static_cast<int>(size), 1);
+			hasHierarchy = true;
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	if (hasHierarchy)
+	{
+		settings.hierarchies.push_back(hierarchy);
+	}
+
+	return settings;
+}
+
+std::string TransformBenchmark::describe(const Hierarchy& hierarchy)
+{
+	return std::to_string(hierarchy.rootCount) + " roots, fanout " + std::to_string(hierarchy.fanout) + ", depth "
+		+ std::to_string(hierarchy.depth);
+}
\ No newline at end of file
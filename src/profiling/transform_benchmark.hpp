@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times TransformKernel on synthetic node tables of around a million nodes with TRS local transforms: building the
+// local matrices directly against multiplying translation, rotation & scale matrices, and evaluating the global
+// transforms with glm one node at a time, with the SIMD multiply, and with the SIMD multiply over the levels in
+// parallel. Every way of evaluating must produce the same transforms.
+class TransformBenchmark final
+{
+public:
+
+	struct Hierarchy
+	{
+		std::size_t rootCount{ 1 };
+
+		// Children of every node above the deepest level. 1 makes chains
+		std::size_t fanout{ 2 };
+		int depth{ 20 };
+	};
+
+	struct Settings
+	{
+		int iterations{ 9 };
+
+		// 0 uses every hardware thread
+		int threadCount{ 0 };
+
+		// Empty runs getDefaultHierarchies()
+		std::vector<Hierarchy> hierarchies{};
+	};
+
+	struct Results
+	{
+		Hierarchy hierarchy{};
+
+		std::size_t nodeCount{};
+		int threadCount{};
+
+		// Median ms
+		double matrixComposeTime{};
+		double directComposeTime{};
+		double scalarTime{};
+		double simdTime{};
+		double parallelTime{};
+		double scaleTime{};
+
+		// Largest difference between the two ways of composing, relative to the matrix's largest element
+		float composeError{};
+
+		bool matches{ false };
+	};
+
+	static Results measure(const Hierarchy& hierarchy, int iterations, int threadCount);
+
+	// A binary tree, long chains, a wide & shallow scene and something in between, each around a million nodes
+	static std::vector<Hierarchy> getDefaultHierarchies();
+
+	// Prints a table of measure() over every hierarchy. Returns false if the evaluations disagree on any of them
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations & --threads, and --roots, --fanout & --depth for a single hierarchy, each followed by a value
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+
+	static std::string describe(const Hierarchy& hierarchy);
+};
\ No newline at end of file
@@ -0,0 +1,402 @@
+#include "traversal_benchmark.hpp"
+
+#include "../jobs/job_system.hpp"
+#include "../model/model_asset.hpp"
+
+#include "fastgltf/types.hpp"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for equal, max, reverse & sort
+#include <chrono>
+#include <cstddef> // for size_t
+#include <cstdlib> // for strtoull
+#include <cstring> // for memcmp
+#include <iomanip> // for setw & setprecision
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+
+
+namespace
+{
+	// The layout & walk ModelAsset used before the node table, kept as the reference to measure against
+	struct LegacyNode
+	{
+		std::vector<int> children{};
+		int mesh{ -1 };
+
+		glm::mat4 localTransform{};
+	};
+
+	struct LegacyPrimitive
+	{
+		int sceneMaterialIndex{ -1 };
+
+		std::vector<ModelAsset::Meshlet> meshlets{};
+	};
+
+	struct LegacyMesh
+	{
+		std::vector<LegacyPrimitive> primitives{};
+	};
+
+	struct LegacyAsset
+	{
+		std::vector<LegacyNode> nodes{};
+		std::vector<int> rootNodes{};
+		std::vector<LegacyMesh> meshes{};
+
+		std::vector<glm::mat4> globalTransforms{};
+		std::vector<ModelAsset::Cluster> clusters{};
+	};
+
+	// What loadNodes did before the node table: a child vector per node, in file order
+	void loadLegacyNodes(LegacyAsset& asset, const fastgltf::Asset& gltf)
+	{
+		asset.nodes.clear();
+		asset.nodes.resize(gltf.nodes.size());
+		for (std::size_t i{ 0 }; i < gltf.nodes.size(); ++i)
+		{
+			const auto& matrix{ std::get<fastgltf::math::fmat4x4>(gltf.nodes[i].transform) };
+			for (int n{ 0 }; n < 4; ++n)
+			{
+				for (int k{ 0 }; k < 4; ++k)
+				{
+					asset.nodes[i].localTransform[n][k] = matrix[n][k];
+				}
+			}
+
+			asset.nodes[i].children.assign(gltf.nodes[i].children.begin(), gltf.nodes[i].children.end());
+			asset.nodes[i].mesh = gltf.nodes[i].meshIndex ? static_cast<int>(*gltf.nodes[i].meshIndex) : -1;
+		}
+
+		asset.rootNodes.assign(gltf.scenes[0].nodeIndices.begin(), gltf.scenes[0].nodeIndices.end());
+	}
+
+	void buildLegacyUniforms(LegacyAsset& asset, const LegacyNode& node, const glm::mat4& parentTransform)
+	{
+		if (node.mesh != -1)
+		{
+			for (const auto& primitive : asset.meshes[node.mesh].primitives)
+			{
+				glm::mat4 globalTransform{ parentTransform * node.localTransform };
+				asset.globalTransforms.push_back(globalTransform);
+
+				for (const auto& meshlet : primitive.meshlets)
+				{
+					ModelAsset::Cluster newCluster{};
+
+					newCluster.boundingSphere = meshlet.boundingSphere;
+
+					newCluster.transformIndex = static_cast<GLuint>(asset.globalTransforms.size() - 1);
+					newCluster.materialIndex = primitive.sceneMaterialIndex;
+
+					newCluster.indexCount = meshlet.triangleCount * 3;
+					newCluster.firstIndex = meshlet.firstIndex;
+					newCluster.vertexOffset = meshlet.sceneVertexOffset;
+
+					asset.clusters.push_back(newCluster);
+				}
+			}
+		}
+
+		for (auto childIndex : node.children)
+		{
+			buildLegacyUniforms(asset, asset.nodes[childIndex], parentTransform * node.localTransform);
+		}
+	}
+
+	// Nodes numbered depth-first, as exporters write them. Small turns & offsets keep deep chains from blowing up
+	fastgltf::Asset generateHierarchy(const TraversalBenchmark::Hierarchy& hierarchy)
+	{
+		std::mt19937 generator{ 1 };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+		fastgltf::Asset asset{};
+		asset.scenes.emplace_back();
+
+		struct Pending
+		{
+			int depth{};
+			std::size_t parent{};
+		};
+		constexpr std::size_t noParent{ ~std::size_t{ 0 } };
+
+		std::vector<Pending> stack(hierarchy.rootCount, { .depth{ 0 }, .parent{ noParent } });
+		while (!stack.empty())
+		{
+			const Pending pending{ stack.back() };
+			stack.pop_back();
+
+			const glm::mat4 local{ glm::rotate(glm::translate(glm::mat4{ 1.0f }, glm::vec3{ unit(generator), unit(generator), unit(generator) }),
+				unit(generator) * 0.1f, glm::normalize(glm::vec3{ unit(generator), 1.0f, unit(generator) })) };
+
+			fastgltf::math::fmat4x4 matrix{};
+			for (int i{ 0 }; i < 4; ++i)
+			{
+				for (int n{ 0 }; n < 4; ++n)
+				{
+					matrix[i][n] = local[i][n];
+				}
+			}
+
+			fastgltf::Node node{};
+			node.transform = matrix;
+			node.meshIndex = 0;
+
+			const std::size_t index{ asset.nodes.size() };
+			asset.nodes.push_back(std::move(node));
+
+			if (pending.parent == noParent)
+			{
+				asset.scenes[0].nodeIndices.push_back(index);
+			}
+			else
+			{
+				asset.nodes[pending.parent].children.push_back(index);
+			}
+
+			// Pushed last to first, so the first child is numbered next
+			if (pending.depth + 1 < hierarchy.depth)
+			{
+				stack.insert(stack.end(), hierarchy.fanout, { .depth{ pending.depth + 1 }, .parent{ index } });
+			}
+		}
+
+		return asset;
+	}
+
+	std::vector<ModelAsset::Meshlet> generateMeshlets(int count)
+	{
+		std::vector<ModelAsset::Meshlet> meshlets(std::max(count, 0));
+		for (std::size_t i{ 0 }; i < meshlets.size(); ++i)
+		{
+			meshlets[i] = { .boundingSphere{ static_cast<float>(i), 0.0f, 0.0f, 1.0f }, .triangleCount{ 64 },
+				.firstIndex{ static_cast<GLuint>(i * 64 * 3) }, .sceneVertexOffset{ static_cast<GLint>(i * 64) } };
+		}
+
+		return meshlets;
+	}
+
+	double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values.empty() ? 0.0 : values[values.size() / 2];
+	}
+
+	template <typename Function>
+	double measureTime(Function&& function)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		function();
+		auto end{ std::chrono::high_resolution_clock::now() };
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+	}
+
+	// Both walks visit nodes in different orders, so the transforms are compared as sets
+	bool sameTransforms(std::vector<glm::mat4> a, std::vector<glm::mat4> b)
+	{
+		auto less{ [](const glm::mat4& x, const glm::mat4& y) { return std::memcmp(&x, &y, sizeof(glm::mat4)) < 0; } };
+		std::sort(a.begin(), a.end(), less);
+		std::sort(b.begin(), b.end(), less);
+
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const glm::mat4& x, const glm::mat4& y) { return std::memcmp(&x, &y, sizeof(glm::mat4)) == 0; });
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+TraversalBenchmark::Results TraversalBenchmark::measure(const Hierarchy& hierarchy, int iterations)
+{
+	const fastgltf::Asset gltf{ generateHierarchy(hierarchy) };
+	const std::vector<ModelAsset::Meshlet> meshlets{ generateMeshlets(hierarchy.meshletsPerPrimitive) };
+
+	LegacyAsset legacy{};
+	legacy.meshes.push_back({ .primitives{ { .sceneMaterialIndex{ 0 }, .meshlets{ meshlets } } } });
+	legacy.globalTransforms.reserve(gltf.nodes.size());
+	legacy.clusters.reserve(gltf.nodes.size() * meshlets.size());
+
+	// One thread, like the recursive walk
+	JobSystem jobSystem{ 1 };
+
+	ModelAsset asset{};
+	asset.mMeshes.push_back({ .firstPrimitive{ 0 }, .primitiveCount{ 1 } });
+	asset.mPrimitives.push_back({ .sceneMaterialIndex{ 0 }, .localMaterialIndex{ 0 }, .firstMeshlet{ 0 },
+		.meshletCount{ static_cast<int>(meshlets.size()) } });
+	asset.mMeshlets = meshlets;
+
+	Results results{ .hierarchy{ hierarchy }, .nodeCount{ gltf.nodes.size() } };
+
+	std::vector<double> recursiveTimes{};
+	std::vector<double> iterativeTimes{};
+	std::vector<double> nestedBuildTimes{};
+	std::vector<double> tableBuildTimes{};
+
+	// The first run of each is a warmup. Nodes are loaded again every run, as they would be, but the output arrays
+	// keep their capacity, so neither walk is timed growing them
+	for (int i{ 0 }; i <= std::max(iterations, 1); ++i)
+	{
+		const double nestedBuildTime{ measureTime([&] { loadLegacyNodes(legacy, gltf); }) };
+		const double tableBuildTime{ measureTime([&] { asset.mNodes = ModelAsset::buildNodeTable(gltf); }) };
+
+		legacy.globalTransforms.clear();
+		legacy.clusters.clear();
+		const double recursiveTime{ measureTime([&] {
+			for (auto rootNodeIndex : legacy.rootNodes)
+			{
+				buildLegacyUniforms(legacy, legacy.nodes[rootNodeIndex], glm::mat4{ 1.0f });
+			}
+			}) };
+
+		const double iterativeTime{ measureTime([&] { asset.buildPrimitiveUniforms(jobSystem, 0); }) };
+
+		if (i > 0)
+		{
+			nestedBuildTimes.push_back(nestedBuildTime);
+			tableBuildTimes.push_back(tableBuildTime);
+			recursiveTimes.push_back(recursiveTime);
+			iterativeTimes.push_back(iterativeTime);
+		}
+	}
+
+	results.clusterCount = asset.mClusters.size();
+	results.recursiveTime = median(recursiveTimes);
+	results.iterativeTime = median(iterativeTimes);
+	results.nestedBuildTime = median(nestedBuildTimes);
+	results.tableBuildTime = median(tableBuildTimes);
+	results.matches = asset.mNodes.size() == legacy.nodes.size() && asset.mClusters.size() == legacy.clusters.size()
+		&& sameTransforms(asset.mGlobalTransforms, legacy.globalTransforms);
+
+	return results;
+}
+
+std::vector<TraversalBenchmark::Hierarchy> TraversalBenchmark::getDefaultHierarchies()
+{
+	return {
+		{ .rootCount{ 1 }, .fanout{ 2 }, .depth{ 18 } },
+		{ .rootCount{ 256 }, .fanout{ 1 }, .depth{ 1000 } },
+		{ .rootCount{ 64 }, .fanout{ 64 }, .depth{ 3 } },
+		{ .rootCount{ 8 }, .fanout{ 8 }, .depth{ 6 } },
+	};
+}
+
+bool TraversalBenchmark::run(std::ostream& out, const Settings& settings)
+{
+	const std::vector<Hierarchy> hierarchies{ settings.hierarchies.empty() ? getDefaultHierarchies() : settings.hierarchies };
+
+	out << "Node traversal, recursive over per-node child vectors vs the breadth-first node table, on one thread. Median of "
+		<< settings.iterations << " runs\n\n";
+
+	out << std::left << std::setw(44) << "hierarchy" << std::right
+		<< std::setw(10) << "nodes" << std::setw(10) << "clusters" << std::setw(14) << "recursive ms"
+		<< std::setw(14) << "iterative ms" << std::setw(10) << "speedup" << std::setw(17) << "nested load ms"
+		<< std::setw(16) << "table load ms" << '\n';
+
+	bool allMatch{ true };
+	for (const auto& hierarchy : hierarchies)
+	{
+		const Results results{ measure(hierarchy, settings.iterations) };
+
+		out << std::left << std::setw(44) << describe(hierarchy) << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << results.nodeCount
+			<< std::setw(10) << results.clusterCount
+			<< std::setw(14) << results.recursiveTime
+			<< std::setw(14) << results.iterativeTime
+			<< std::setw(10) << (results.iterativeTime > 0.0 ? results.recursiveTime / results.iterativeTime : 0.0)
+			<< std::setw(17) << results.nestedBuildTime
+			<< std::setw(16) << results.tableBuildTime
+			<< (results.matches ? "" : "   MISMATCH") << '\n';
+
+		allMatch = allMatch && results.matches;
+	}
+
+	return allMatch;
+}
+
+TraversalBenchmark::Settings TraversalBenchmark::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+	Hierarchy hierarchy{};
+	bool hasHierarchy{ false };
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (!parseSize(out, argv[i - 1], value, size))
+		{
+			continue;
+		}
+
+		if (option == "--iterations")
+		{
+			settings.iterations = std::max(static_cast<int>(size), 1);
+		}
+		else if (option == "--roots")
+		{
+			hierarchy.rootCount = std::max<std::size_t>(size, 1);
+			hasHierarchy = true;
+		}
+		else if (option == "--fanout")
+		{
+			hierarchy.fanout = std::max<std::size_t>(size, 1);
+			hasHierarchy = true;
+		}
+		else if (option == "--depth")
+		{
+			hierarchy.depth = std::max(static_cast<int>(size), 1);
+			hasHierarchy = true;
+		}
+		else if (option == "--meshlets")
+		{
+			hierarchy.meshletsPerPrimitive = static_cast<int>(size);
+			hasHierarchy = true;
+		}
+		else
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	if (hasHierarchy)
+	{
+		settings.hierarchies.push_back(hierarchy);
+	}
+
+	return settings;
+}
+
+std::string TraversalBenchmark::describe(const Hierarchy& hierarchy)
+{
+	return std::to_string(hierarchy.rootCount) + " roots, fanout " + std::to_string(hierarchy.fanout) + ", depth "
+		+ std::to_string(hierarchy.depth) + ", " + std::to_string(hierarchy.meshletsPerPrimitive) + " meshlets";
+}
\ No newline at end of file
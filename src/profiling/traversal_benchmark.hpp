@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times ModelAsset::buildPrimitiveUniforms, which walks the breadth-first node table a level at a time, against the recursive walk over
+// per-node child vectors it replaced. The hierarchies are synthetic and far deeper & larger than shipped assets, with
+// nodes numbered depth-first the way exporters write them. Both walks must produce the same transforms.
+class TraversalBenchmark final
+{
+public:
+
+	struct Hierarchy
+	{
+		std::size_t rootCount{ 1 };
+
+		// Children of every node above the deepest level. 1 makes chains
+		std::size_t fanout{ 2 };
+		int depth{ 18 };
+
+		// Every node draws the same mesh of one primitive
+		int meshletsPerPrimitive{ 1 };
+	};
+
+	struct Settings
+	{
+		int iterations{ 9 };
+
+		// Empty runs getDefaultHierarchies()
+		std::vector<Hierarchy> hierarchies{};
+	};
+
+	struct Results
+	{
+		Hierarchy hierarchy{};
+
+		std::size_t nodeCount{};
+		std::size_t clusterCount{};
+
+		// Median ms
+		double recursiveTime{};
+		double iterativeTime{};
+
+		// Loading the nodes each walk needs, once per load: the vectors per node, and ModelAsset::buildNodeTable
+		double nestedBuildTime{};
+		double tableBuildTime{};
+
+		bool matches{ false };
+	};
+
+	static Results measure(const Hierarchy& hierarchy, int iterations);
+
+	// A binary tree, long chains, a wide & shallow scene and something in between, each around 250k nodes
+	static std::vector<Hierarchy> getDefaultHierarchies();
+
+	// Prints a table of measure() over every hierarchy. Returns false if the walks disagree on any of them
+	static bool run(std::ostream& out, const Settings& settings);
+
+	// --iterations, and --roots, --fanout, --depth & --meshlets for a single hierarchy, each followed by a value
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+
+	static std::string describe(const Hierarchy& hierarchy);
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "render_target_pool.hpp"
+
+#include "glad/glad.h"
+
+#include <algorithm> // for any_of & max
+#include <cstddef> // for size_t
+#include <utility> // for move()
+#include <vector>
+
+RenderTargetPool::~RenderTargetPool()
+{
+	clear();
+}
+
+GLuint RenderTargetPool::acquire(const Desc& desc, int firstPass, int lastPass)
+{
+	++mRequestCount;
+	mRequestedBytes += getByteSize(desc);
+
+	for (auto& target : mTargets)
+	{
+		if (target.desc != desc)
+		{
+			continue;
+		}
+
+		bool overlaps{ std::any_of(target.lifetimes.cbegin(), target.lifetimes.cend(), [&](const auto& lifetime) {
+			return firstPass <= lifetime.second && lifetime.first <= lastPass;
+			}) };
+		if (!overlaps)
+		{
+			target.lifetimes.emplace_back(firstPass, lastPass);
+			return target.texture;
+		}
+	}
+
+	Target target{ .desc{ desc }, .lifetimes{ { firstPass, lastPass } } };
+	glCreateTextures(GL_TEXTURE_2D, 1, &target.texture);
+	glTextureStorage2D(target.texture, desc.levels, desc.internalFormat, desc.width, desc.height);
+	// Mip chains like hi-z are read per level through texelFetch, which needs a mipmapped min filter
+	GLenum minFilter{ desc.filter };
+	if (desc.levels > 1)
+	{
+		minFilter = desc.filter == GL_LINEAR ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+	}
+	glTextureParameteri(target.texture, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTextureParameteri(target.texture, GL_TEXTURE_MAG_FILTER, desc.filter);
+	glTextureParameteri(target.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(target.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	mAllocatedBytes += getByteSize(desc);
+	mPeakBytes = std::max(mPeakBytes, mAllocatedBytes);
+	++mTextureCount;
+
+	mTargets.push_back(std::move(target));
+	return mTargets.back().texture;
+}
+
+void RenderTargetPool::clear()
+{
+	for (const auto& target : mTargets)
+	{
+		glDeleteTextures(1, &target.texture);
+	}
+	mTargets.clear();
+
+	mAllocatedBytes = 0;
+	mRequestedBytes = 0;
+	mRequestCount = 0;
+	mTextureCount = 0;
+}
+
+std::size_t RenderTargetPool::getByteSize(const Desc& desc)
+{
+	std::size_t texelSize{ 4 };
+	switch (desc.internalFormat)
+	{
+	case GL_R8: texelSize = 1; break;
+	case GL_RG16F: texelSize = 4; break;
+	case GL_RGBA16F: texelSize = 8; break;
+	case GL_RGBA32F: texelSize = 16; break;
+	default: texelSize = 4; break; // GL_R32F, GL_R32UI, GL_RGBA8, GL_DEPTH_COMPONENT32F
+	}
+
+	std::size_t size{ 0 };
+	for (int level{ 0 }; level < desc.levels; ++level)
+	{
+		std::size_t width{ static_cast<std::size_t>(std::max(desc.width >> level, 1)) };
+		std::size_t height{ static_cast<std::size_t>(std::max(desc.height >> level, 1)) };
+		size += width * height * texelSize;
+	}
+
+	return size;
+}
\ No newline at end of file
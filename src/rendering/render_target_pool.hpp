@@ -0,0 +1,62 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef> // for std::size_t
+#include <utility> // for pair
+#include <vector>
+
+// Owns the per pixel render targets. Targets are requested with the range of passes they live through, numbered in
+// frame order, and targets with the same description whose ranges don't overlap share one texture. Everything is
+// dropped and requested again when the resolution changes
+class RenderTargetPool final
+{
+public:
+
+	struct Desc
+	{
+		GLenum internalFormat{ GL_RGBA8 };
+		int width{ 0 };
+		int height{ 0 };
+		int levels{ 1 };
+
+		// Set on both min & mag. Wrapping is always clamp to edge
+		GLenum filter{ GL_NEAREST };
+
+		bool operator==(const Desc&) const = default;
+	};
+
+	RenderTargetPool() = default;
+
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+	~RenderTargetPool();
+
+	// A texture nobody else uses from firstPass through lastPass, both included
+	GLuint acquire(const Desc& desc, int firstPass, int lastPass);
+
+	// Deletes every texture. The peak is kept
+	void clear();
+
+	// Includes the mip chain. Only knows the formats the renderer uses
+	static std::size_t getByteSize(const Desc& desc);
+
+	std::size_t mAllocatedBytes{ 0 };
+	std::size_t mRequestedBytes{ 0 }; // What the same targets would take without aliasing
+	std::size_t mPeakBytes{ 0 };
+
+	int mRequestCount{ 0 };
+	int mTextureCount{ 0 };
+
+private:
+
+	struct Target
+	{
+		Desc desc{};
+		GLuint texture{};
+		std::vector<std::pair<int, int>> lifetimes{};
+	};
+
+	std::vector<Target> mTargets{};
+};
\ No newline at end of file
@@ -1,20 +1,31 @@
 #include "scene.hpp"
 
 #include "../camera/camera.hpp"
+#include "../jobs/job_system.hpp"
 #include "../model/model.hpp"
+#include "../model/model_asset.hpp"
+#include "../profiling/memory_usage.hpp"
 
 #include "glad/glad.h"
 #include "glm/glm.hpp"
 
+#include <algorithm> // for clamp, copy, max & min
+#include <bit> // for bit_ceil
 #include <cstdint>
 #include <fstream>
+#include <iomanip> // for setw
 #include <iostream>
+#include <iterator> // for begin & end
+#include <ranges> // for views::values
 #include <string>
+#include <utility> // for move() & pair
+#include <vector>
 
 SceneObject::~SceneObject()
 {
 	glDeleteBuffers(1, &mMaterialsSsbo);
 	glDeleteBuffers(1, &mTransformsSsbo);
+	glDeleteBuffers(1, &mTransformScalesSsbo);
 	glDeleteBuffers(1, &mClustersSsbo);
 
 	glDeleteBuffers(1, &mVbo);
@@ -22,12 +33,31 @@ SceneObject::~SceneObject()
 
 	glDeleteVertexArrays(1, &mVao);
 	glDeleteVertexArrays(1, &mBlendVao);
+	glDeleteVertexArrays(1, &mMultiViewVao);
+	glDeleteVertexArrays(1, &mClusterDrawVao);
 
 	glDeleteBuffers(1, &mWriteIbo);
 	glDeleteBuffers(1, &mIndirectDrawBuffer);
 
+	glDeleteBuffers(1, &mClusterDrawBuffer);
+	glDeleteBuffers(1, &mClusterDrawCountBuffer);
+
 	glDeleteBuffers(1, &mWriteBlendIbo);
 	glDeleteBuffers(1, &mIndirectBlendDrawBuffer);
+	glDeleteBuffers(1, &mBlendSortSsbo);
+	glDeleteBuffers(1, &mBlendClusterDrawBuffer);
+
+	glDeleteBuffers(1, &mMultiViewWriteIbo);
+	glDeleteBuffers(1, &mMultiViewIndirectDrawBuffer);
+	glDeleteBuffers(1, &mMultiViewFrustumsSsbo);
+
+	glDeleteBuffers(1, &mVisibilityBitmaskSsbo);
+	glDeleteBuffers(1, &mLastVisibilityBitmaskSsbo);
+
+	glDeleteBuffers(1, &mBvhNodesSsbo);
+	glDeleteBuffers(1, &mBvhClusterIndicesSsbo);
+	glDeleteBuffers(1, &mBvhQueueSsbo);
+	glDeleteBuffers(1, &mCandidateClustersSsbo);
 
 	for (auto& [name, shaderProgram] : mShaderPrograms)
 	{
@@ -35,37 +65,38 @@ SceneObject::~SceneObject()
 	}
 }
 
-void SceneObject::loadModels(const std::vector<ModelObjectLoadInfo>& loadInfo)
+void SceneObject::loadModels(JobSystem& jobSystem, const std::vector<ModelObjectLoadInfo>& loadInfo)
 {
 	for (const auto& info : loadInfo)
 	{
-		mModels[info.name] = ModelObject{ info.path, mVertexCount, mIndexCount, mMaterialCount, mTransformCount, info.directory };
-
-		mMaterialCount += mModels[info.name].mMaterials.size();
-		mTransformCount += mModels[info.name].mGlobalTransforms.size();
-		mClusterCount += mModels[info.name].mClusters.size();
-		mVertexCount += mModels[info.name].mVertices.size();
-		mIndexCount += mModels[info.name].mIndices.size();
-		mBlendIndexCount += mModels[info.name].mBlendIndexCount;
+		mModels[info.name] = ModelObject{ jobSystem, info.path, mVertexCount, mIndexCount, mMaterialCount, mTransformCount, info.directory,
+			info.meshletSettings };
+
+		mMaterialCount += mModels[info.name].mAsset.mMaterials.size();
+		mTransformCount += mModels[info.name].mAsset.mGlobalTransforms.size();
+		mClusterCount += mModels[info.name].mAsset.mClusters.size();
+		mVertexCount += mModels[info.name].mAsset.mVertices.size();
+		mIndexCount += mModels[info.name].mAsset.mIndices.size();
 	}
 }
 
-void SceneObject::initGlMemory()
+void SceneObject::initGlMemory(JobSystem& jobSystem, int multiViewCount)
 {
 	glCreateBuffers(1, &mMaterialsSsbo);
-	glNamedBufferStorage(mMaterialsSsbo, mMaterialCount * sizeof(ModelObject::Material), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glNamedBufferStorage(mMaterialsSsbo, mMaterialCount * sizeof(ModelAsset::Material), nullptr, GL_DYNAMIC_STORAGE_BIT);
 
 	glCreateBuffers(1, &mTransformsSsbo);
 	glNamedBufferData(mTransformsSsbo, sizeof(glm::mat4) * mTransformCount, nullptr, GL_STATIC_DRAW);
 
 	glCreateBuffers(1, &mClustersSsbo);
-	glNamedBufferStorage(mClustersSsbo, sizeof(ModelObject::Cluster) * mClusterCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glNamedBufferStorage(mClustersSsbo, sizeof(ModelAsset::Cluster) * mClusterCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
 
 	glCreateBuffers(1, &mVbo);
-	glNamedBufferStorage(mVbo, sizeof(ModelObject::Vertex) * mVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glNamedBufferStorage(mVbo, sizeof(ModelAsset::Vertex) * mVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
 
 	glCreateBuffers(1, &mIbo);
-	glNamedBufferStorage(mIbo, mIndexCount * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	// One byte per index. Rounded up to a whole uint since the culling shaders read it as uint[]
+	glNamedBufferStorage(mIbo, (mIndexCount + 3) / 4 * 4, nullptr, GL_DYNAMIC_STORAGE_BIT);
 
 	glCreateBuffers(1, &mViewFrustumSsbo);
 	glNamedBufferStorage(mViewFrustumSsbo, sizeof(Camera::Frustum), nullptr, GL_MAP_WRITE_BIT);
@@ -73,11 +104,28 @@ void SceneObject::initGlMemory()
 	GLsizei visibilityBitmaskSize{ static_cast<GLsizei>(std::ceil(mClusterCount / 8.0f)) };
 	visibilityBitmaskSize = ((visibilityBitmaskSize + 32 - 1) / 32) * 32; // Rounded up to a multiple of 32 because OpenGL GLSL only supports 32 bit types
 
+	mVisibilityBitmaskSize = visibilityBitmaskSize;
+
 	glCreateBuffers(1, &mVisibilityBitmaskSsbo);
-	glNamedBufferStorage(mVisibilityBitmaskSsbo, visibilityBitmaskSize, nullptr, GL_NONE);
+	glNamedBufferStorage(mVisibilityBitmaskSsbo, visibilityBitmaskSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
 	GLubyte visibilityClearData{ 0 };
 	glClearNamedBufferData(mVisibilityBitmaskSsbo, GL_R8UI, GL_RED, GL_UNSIGNED_BYTE, &visibilityClearData);
 
+	glCreateBuffers(1, &mLastVisibilityBitmaskSsbo);
+	glNamedBufferStorage(mLastVisibilityBitmaskSsbo, visibilityBitmaskSize, nullptr, GL_NONE);
+	glClearNamedBufferData(mLastVisibilityBitmaskSsbo, GL_R8UI, GL_RED, GL_UNSIGNED_BYTE, &visibilityClearData);
+
+	std::vector<glm::vec4> clusterSpheres{};
+	clusterSpheres.reserve(mClusterCount);
+	std::vector<GLuint> clusterTransformIndices{};
+	clusterTransformIndices.reserve(mClusterCount);
+	std::vector<glm::mat4> transforms{};
+	transforms.reserve(mTransformCount);
+	std::vector<float> transformScales{};
+	transformScales.reserve(mTransformCount);
+	std::vector<ModelAsset::Material> materials{};
+	materials.reserve(mMaterialCount);
+
 	int materialOffset { 0 };
 	int transformOffset{ 0 };
 	int clusterOffset  { 0 };
@@ -86,47 +134,291 @@ void SceneObject::initGlMemory()
 
 	for (const auto& [name, model] : mModels)
 	{
-		glNamedBufferSubData(mMaterialsSsbo, materialOffset * sizeof(ModelObject::Material),
-			model.mMaterials.size() * sizeof(ModelObject::Material), model.mMaterials.data());
+		glNamedBufferSubData(mMaterialsSsbo, materialOffset * sizeof(ModelAsset::Material),
+			model.mAsset.mMaterials.size() * sizeof(ModelAsset::Material), model.mAsset.mMaterials.data());
 
 		glNamedBufferSubData(mTransformsSsbo, transformOffset * sizeof(glm::mat4),
-			model.mGlobalTransforms.size() * sizeof(glm::mat4), model.mGlobalTransforms.data());
-
-		glNamedBufferSubData(mClustersSsbo, clusterOffset * sizeof(ModelObject::Cluster),
-			model.mClusters.size() * sizeof(ModelObject::Cluster), model.mClusters.data());
-
-		glNamedBufferSubData(mVbo, vertexOffset * sizeof(ModelObject::Vertex),
-			model.mVertices.size() * sizeof(ModelObject::Vertex), model.mVertices.data());
+			model.mAsset.mGlobalTransforms.size() * sizeof(glm::mat4), model.mAsset.mGlobalTransforms.data());
+
+		glNamedBufferSubData(mClustersSsbo, clusterOffset * sizeof(ModelAsset::Cluster),
+			model.mAsset.mClusters.size() * sizeof(ModelAsset::Cluster), model.mAsset.mClusters.data());
+
+		glNamedBufferSubData(mVbo, vertexOffset * sizeof(ModelAsset::Vertex),
+			model.mAsset.mVertices.size() * sizeof(ModelAsset::Vertex), model.mAsset.mVertices.data());
+
+		glNamedBufferSubData(mIbo, indexOffset * sizeof(std::uint8_t),
+			model.mAsset.mIndices.size() * sizeof(std::uint8_t), model.mAsset.mIndices.data());
+
+		for (const auto& cluster : model.mAsset.mClusters)
+		{
+			clusterSpheres.push_back(cluster.boundingSphere);
+			clusterTransformIndices.push_back(cluster.transformIndex);
+		}
+		transforms.insert(transforms.end(), model.mAsset.mGlobalTransforms.cbegin(), model.mAsset.mGlobalTransforms.cend());
+		transformScales.insert(transformScales.end(), model.mAsset.mTransformScales.cbegin(), model.mAsset.mTransformScales.cend());
+		materials.insert(materials.end(), model.mAsset.mMaterials.cbegin(), model.mAsset.mMaterials.cend());
+
+		materialOffset += model.mAsset.mMaterials.size();
+		transformOffset += model.mAsset.mGlobalTransforms.size();
+		clusterOffset += model.mAsset.mClusters.size();
+		vertexOffset += model.mAsset.mVertices.size();
+		indexOffset += model.mAsset.mIndices.size();
+	}
 
-		glNamedBufferSubData(mIbo, indexOffset * sizeof(std::uint32_t),
-			model.mIndices.size() * sizeof(std::uint32_t), model.mIndices.data());
+	// The buffer can't be empty
+	transformScales.resize(std::max<std::size_t>(transformScales.size(), 1), 1.0f);
 
-		materialOffset += model.mMaterials.size();
-		transformOffset += model.mGlobalTransforms.size();
-		clusterOffset += model.mClusters.size();
-		vertexOffset += model.mVertices.size();
-		indexOffset += model.mIndices.size();
-	}
+	glCreateBuffers(1, &mTransformScalesSsbo);
+	glNamedBufferStorage(mTransformScalesSsbo, transformScales.size() * sizeof(float), transformScales.data(), GL_DYNAMIC_STORAGE_BIT);
 
 	glCreateVertexArrays(1, &mVao);
 	glCreateVertexArrays(1, &mBlendVao);
 
+	// Meshes can be instanced, so the streams are sized by cluster rather than by mIndices
+	mOpaqueIndexCount = 0;
+	mMaskedIndexCount = 0;
+	mBlendIndexCount = 0;
+	mOpaqueClusterCount = 0;
+	mMaskedClusterCount = 0;
+	mBlendClusterCount = 0;
+	for (const auto& model : mModels | std::views::values)
+	{
+		for (const auto& cluster : model.mAsset.mClusters)
+		{
+			if (cluster.materialIndex >= 0 && materials[cluster.materialIndex].alphaBlend)
+			{
+				mBlendIndexCount += cluster.indexCount;
+				++mBlendClusterCount;
+				continue;
+			}
+
+			if (cluster.materialIndex >= 0 && materials[cluster.materialIndex].alphaMask)
+			{
+				mMaskedIndexCount += cluster.indexCount;
+				++mMaskedClusterCount;
+			}
+			else
+			{
+				mOpaqueIndexCount += cluster.indexCount;
+				++mOpaqueClusterCount;
+			}
+		}
+	}
+
 	glCreateBuffers(1, &mWriteIbo);
-	glNamedBufferStorage(mWriteIbo, mIndexCount * sizeof(GLuint), nullptr, GL_NONE);
+	glNamedBufferStorage(mWriteIbo, std::max(mOpaqueIndexCount + mMaskedIndexCount, 1) * sizeof(GLuint), nullptr, GL_NONE);
 
 	IndirectDraw indirectDraw{};
 	glCreateBuffers(1, &mIndirectDrawBuffer);
-	glNamedBufferStorage(mIndirectDrawBuffer, sizeof(IndirectDraw), &indirectDraw, GL_MAP_WRITE_BIT);
+	glNamedBufferStorage(mIndirectDrawBuffer, drawCommandCount * sizeof(IndirectDraw), nullptr, GL_DYNAMIC_STORAGE_BIT);
 
 	glVertexArrayElementBuffer(mVao, mWriteIbo);
 
+	mClusterDrawCapacities[opaqueFirstPassDraw] = mOpaqueClusterCount;
+	mClusterDrawCapacities[opaqueSecondPassDraw] = mOpaqueClusterCount;
+	mClusterDrawCapacities[maskedFirstPassDraw] = mMaskedClusterCount;
+	mClusterDrawCapacities[maskedSecondPassDraw] = mMaskedClusterCount;
+
+	GLuint clusterDrawTotal{ 0 };
+	for (int i{ 0 }; i < drawCommandCount; ++i)
+	{
+		mClusterDrawFirsts[i] = clusterDrawTotal;
+		clusterDrawTotal += mClusterDrawCapacities[i];
+	}
+
+	glCreateBuffers(1, &mClusterDrawBuffer);
+	glNamedBufferStorage(mClusterDrawBuffer, std::max<GLuint>(clusterDrawTotal, 1) * sizeof(IndirectDraw), nullptr, GL_NONE);
+
+	glCreateBuffers(1, &mClusterDrawCountBuffer);
+	glNamedBufferStorage(mClusterDrawCountBuffer, sizeof(ClusterDrawCounts), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateVertexArrays(1, &mClusterDrawVao);
+	glVertexArrayElementBuffer(mClusterDrawVao, mIbo);
+
 	glCreateBuffers(1, &mWriteBlendIbo);
-	glNamedBufferStorage(mWriteBlendIbo, mBlendIndexCount * sizeof(GLuint), nullptr, GL_NONE);
+	glNamedBufferStorage(mWriteBlendIbo, std::max(mBlendIndexCount, 1) * sizeof(GLuint), nullptr, GL_NONE);
 
 	glCreateBuffers(1, &mIndirectBlendDrawBuffer);
-	glNamedBufferStorage(mIndirectBlendDrawBuffer, sizeof(IndirectDraw), &indirectDraw, GL_MAP_WRITE_BIT);
+	glNamedBufferStorage(mIndirectBlendDrawBuffer, sizeof(IndirectDraw), &indirectDraw, GL_DYNAMIC_STORAGE_BIT);
+
+	mBlendSortCapacity = std::bit_ceil(static_cast<GLuint>(std::max(mBlendClusterCount, 1)));
+
+	glCreateBuffers(1, &mBlendSortSsbo);
+	glNamedBufferStorage(mBlendSortSsbo, blendSortHeaderSize + mBlendSortCapacity * 2 * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateBuffers(1, &mBlendClusterDrawBuffer);
+	glNamedBufferStorage(mBlendClusterDrawBuffer, mBlendSortCapacity * sizeof(IndirectDraw), nullptr, GL_NONE);
+
+	resetDrawCommands();
 
 	glVertexArrayElementBuffer(mBlendVao, mWriteBlendIbo);
+
+	// Secondary views only draw opaque & alpha tested clusters
+	mMultiViewIndexCapacity = static_cast<GLuint>(std::max(mOpaqueIndexCount + mMaskedIndexCount, 1));
+	mMultiViewCount = std::clamp(multiViewCount, 1, maxMultiViews);
+
+	glCreateVertexArrays(1, &mMultiViewVao);
+
+	glCreateBuffers(1, &mMultiViewWriteIbo);
+	glNamedBufferStorage(mMultiViewWriteIbo, static_cast<GLsizeiptr>(mMultiViewIndexCapacity) * mMultiViewCount * sizeof(GLuint), nullptr, GL_NONE);
+
+	glCreateBuffers(1, &mMultiViewIndirectDrawBuffer);
+	glNamedBufferStorage(mMultiViewIndirectDrawBuffer, mMultiViewCount * sizeof(IndirectDraw), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateBuffers(1, &mMultiViewFrustumsSsbo);
+	glNamedBufferStorage(mMultiViewFrustumsSsbo, mMultiViewCount * sizeof(Camera::Frustum), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glVertexArrayElementBuffer(mMultiViewVao, mMultiViewWriteIbo);
+
+	mFrustumCuller.setClusters(clusterSpheres, clusterTransformIndices);
+	mFrustumCuller.updateWorldSpheres(jobSystem, transforms);
+
+	mClusterBvh.build(mFrustumCuller.getWorldSpheres());
+
+	buildOccluders();
+
+	// ClusterBvh::build never goes deeper than the queue header's maxLevels
+	mBvhLevelCount = static_cast<GLuint>(mClusterBvh.mLevelNodeCounts.size());
+
+	glCreateBuffers(1, &mBvhNodesSsbo);
+	glNamedBufferStorage(mBvhNodesSsbo, std::max<std::size_t>(mClusterBvh.mNodes.size(), 1) * sizeof(ClusterBvh::Node),
+		mClusterBvh.mNodes.empty() ? nullptr : mClusterBvh.mNodes.data(), GL_NONE);
+
+	glCreateBuffers(1, &mBvhClusterIndicesSsbo);
+	glNamedBufferStorage(mBvhClusterIndicesSsbo, std::max<std::size_t>(mClusterBvh.mClusterIndices.size(), 1) * sizeof(GLuint),
+		mClusterBvh.mClusterIndices.empty() ? nullptr : mClusterBvh.mClusterIndices.data(), GL_NONE);
+
+	// The queue for each level only ever holds a subset of that level's nodes, so it's laid out exactly like mNodes
+	glCreateBuffers(1, &mBvhQueueSsbo);
+	glNamedBufferStorage(mBvhQueueSsbo, sizeof(BvhQueueHeader) + std::max<std::size_t>(mClusterBvh.mNodes.size(), 1) * sizeof(GLuint),
+		nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateBuffers(1, &mCandidateClustersSsbo);
+	glNamedBufferStorage(mCandidateClustersSsbo, sizeof(DispatchIndirect) + std::max(mClusterCount, 1) * sizeof(GLuint),
+		nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+void SceneObject::resetClusterCulling()
+{
+	glCopyNamedBufferSubData(mVisibilityBitmaskSsbo, mLastVisibilityBitmaskSsbo, 0, 0, mVisibilityBitmaskSize);
+
+	GLubyte visibilityClearData{ 0 };
+	glClearNamedBufferData(mVisibilityBitmaskSsbo, GL_R8UI, GL_RED, GL_UNSIGNED_BYTE, &visibilityClearData);
+
+	BvhQueueHeader header{};
+	for (GLuint i{ 0 }; i < mBvhLevelCount; ++i)
+	{
+		header.levelOffsets[i] = mClusterBvh.mLevelOffsets[i];
+	}
+	header.levels[0] = { .x{ 1 }, .count{ 1 } };
+
+	GLuint rootNode{ 0 };
+	glNamedBufferSubData(mBvhQueueSsbo, 0, sizeof(BvhQueueHeader), &header);
+	glNamedBufferSubData(mBvhQueueSsbo, sizeof(BvhQueueHeader), sizeof(GLuint), &rootNode);
+
+	DispatchIndirect candidateDispatch{};
+	glNamedBufferSubData(mCandidateClustersSsbo, 0, sizeof(DispatchIndirect), &candidateDispatch);
+}
+
+void SceneObject::resetDrawCommands()
+{
+	IndirectDraw indirectDraws[drawCommandCount]{};
+	indirectDraws[maskedFirstPassDraw].firstIndex = mOpaqueIndexCount;
+
+	// The second pass commands get their firstIndex from cluster_batch.comp, right after the first pass
+	glNamedBufferSubData(mIndirectDrawBuffer, 0, sizeof(indirectDraws), indirectDraws);
+
+	ClusterDrawCounts clusterDrawCounts{};
+	std::copy(std::begin(mClusterDrawFirsts), std::end(mClusterDrawFirsts), clusterDrawCounts.firstDraws);
+	glNamedBufferSubData(mClusterDrawCountBuffer, 0, sizeof(ClusterDrawCounts), &clusterDrawCounts);
+
+	IndirectDraw blendDraw{};
+	glNamedBufferSubData(mIndirectBlendDrawBuffer, 0, sizeof(IndirectDraw), &blendDraw);
+
+	GLuint blendClusterCount{ 0 };
+	glNamedBufferSubData(mBlendSortSsbo, 0, sizeof(GLuint), &blendClusterCount);
+}
+
+void SceneObject::seedVisibility(const std::vector<std::uint32_t>& visibilityBitmask)
+{
+	GLsizeiptr size{ std::min<GLsizeiptr>(visibilityBitmask.size() * sizeof(std::uint32_t), mVisibilityBitmaskSize) };
+	glNamedBufferSubData(mVisibilityBitmaskSsbo, 0, size, visibilityBitmask.data());
+}
+
+void SceneObject::resetMultiViewCulling(const Camera::Frustum* frustums, int viewCount)
+{
+	viewCount = std::min(viewCount, mMultiViewCount);
+
+	IndirectDraw indirectDraws[maxMultiViews]{};
+	for (int i{ 0 }; i < mMultiViewCount; ++i)
+	{
+		indirectDraws[i].firstIndex = i * mMultiViewIndexCapacity;
+	}
+
+	glNamedBufferSubData(mMultiViewIndirectDrawBuffer, 0, mMultiViewCount * sizeof(IndirectDraw), indirectDraws);
+	glNamedBufferSubData(mMultiViewFrustumsSsbo, 0, viewCount * sizeof(Camera::Frustum), frustums);
+}
+
+void SceneObject::writeMemoryReport(std::ostream& out) const
+{
+	const std::pair<const char*, GLuint> buffers[]
+	{
+		{ "transforms", mTransformsSsbo },
+		{ "transform scales", mTransformScalesSsbo },
+		{ "materials", mMaterialsSsbo },
+		{ "clusters", mClustersSsbo },
+		{ "vertices", mVbo },
+		{ "meshlet indices", mIbo },
+		{ "written indices", mWriteIbo },
+		{ "written blend indices", mWriteBlendIbo },
+		{ "cluster draws", mClusterDrawBuffer },
+		{ "blend sort", mBlendSortSsbo },
+		{ "blend cluster draws", mBlendClusterDrawBuffer },
+		{ "multi view indices", mMultiViewWriteIbo },
+		{ "visibility bitmasks", mVisibilityBitmaskSsbo },
+		{ "last visibility bitmasks", mLastVisibilityBitmaskSsbo },
+		{ "BVH nodes", mBvhNodesSsbo },
+		{ "BVH cluster indices", mBvhClusterIndicesSsbo },
+		{ "BVH queue", mBvhQueueSsbo },
+		{ "candidate clusters", mCandidateClustersSsbo },
+	};
+
+	auto toMiB{ [](GLint64 size) { return static_cast<double>(size) / (1024.0 * 1024.0); } };
+
+	out << std::fixed << std::setprecision(2);
+
+	GLint64 total{ 0 };
+	for (const auto& [name, buffer] : buffers)
+	{
+		GLint64 size{ 0 };
+		if (buffer != 0)
+		{
+			glGetNamedBufferParameteri64v(buffer, GL_BUFFER_SIZE, &size);
+		}
+		total += size;
+
+		out << std::setw(26) << std::left << name << std::setw(10) << std::right << toMiB(size) << " MiB\n";
+	}
+	out << std::setw(26) << std::left << "total" << std::setw(10) << std::right << toMiB(total) << " MiB\n";
+
+	// Meshlet indices used to be widened to 32 bits
+	GLint64 unpackedIndexSize{ static_cast<GLint64>(mIndexCount) * static_cast<GLint64>(sizeof(std::uint32_t)) };
+	GLint64 indexSize{ 0 };
+	glGetNamedBufferParameteri64v(mIbo, GL_BUFFER_SIZE, &indexSize);
+	out << mIndexCount << " meshlet indices take " << toMiB(indexSize) << " MiB packed as bytes, saving "
+		<< toMiB(unpackedIndexSize - indexSize) << " MiB over 32 bit indices\n";
+
+	for (const auto& [name, model] : mModels)
+	{
+		const auto& stats{ model.mImageStreamStats };
+		out << name << ": " << stats.imageCount << " images (" << stats.ktx2Images << " KTX2, " << stats.failedImages << " failed), "
+			<< toMiB(stats.decodedBytes) << " MiB decoded, at most " << toMiB(stats.peakInFlightBytes) << " MiB in flight, "
+			<< stats.stagingStalls << " staging stalls, " << stats.unstagedImages << " too big to stage, "
+			<< stats.decodeWaitTime << " ms waiting on decodes, " << stats.uploadTime << " ms uploading\n";
+	}
+	out << "peak resident memory " << toMiB(getPeakResidentBytes()) << " MiB\n";
+
+	out << std::defaultfloat;
 }
 
 void SceneObject::linkShaderPrograms()
@@ -143,19 +435,19 @@ void SceneObject::linkShaderProgram(ShaderProgram& shaderProgram)
 
 	if (!shaderProgram.vsPath.empty())
 	{
-		auto vertexShader{ compileShader(shaderProgram.vsPath, GL_VERTEX_SHADER) };
+		auto vertexShader{ compileShader(shaderProgram.vsPath, GL_VERTEX_SHADER, shaderProgram.defines) };
 		glAttachShader(shaderProgram.program, vertexShader);
 		glDeleteShader(vertexShader);
 	}
 	if (!shaderProgram.fsPath.empty())
 	{
-		auto fragmentShader{ compileShader(shaderProgram.fsPath, GL_FRAGMENT_SHADER) };
+		auto fragmentShader{ compileShader(shaderProgram.fsPath, GL_FRAGMENT_SHADER, shaderProgram.defines) };
 		glAttachShader(shaderProgram.program, fragmentShader);
 		glDeleteShader(fragmentShader);
 	}
 	if (!shaderProgram.computePath.empty())
 	{
-		auto computeShader{ compileShader(shaderProgram.computePath, GL_COMPUTE_SHADER) };
+		auto computeShader{ compileShader(shaderProgram.computePath, GL_COMPUTE_SHADER, shaderProgram.defines) };
 		glAttachShader(shaderProgram.program, computeShader);
 		glDeleteShader(computeShader);
 	}
@@ -171,7 +463,78 @@ void SceneObject::linkShaderProgram(ShaderProgram& shaderProgram)
 	}
 }
 
-GLuint SceneObject::compileShader(const std::string& filename, GLenum type)
+void SceneObject::buildOccluders()
+{
+	struct OccluderCandidate
+	{
+		float radius{};
+
+		const ModelAsset* model{};
+		const ModelAsset::Cluster* cluster{};
+
+		int transformOffset{};
+		int vertexOffset{};
+		int indexOffset{};
+	};
+
+	std::vector<OccluderCandidate> candidates{};
+
+	int materialOffset { 0 };
+	int transformOffset{ 0 };
+	int clusterOffset  { 0 };
+	int vertexOffset   { 0 };
+	int indexOffset    { 0 };
+
+	for (const auto& [name, model] : mModels)
+	{
+		for (std::size_t i{ 0 }; i < model.mAsset.mClusters.size(); ++i)
+		{
+			const auto& cluster{ model.mAsset.mClusters[i] };
+
+			// Only fully opaque geometry can hide anything
+			if (cluster.materialIndex != -1)
+			{
+				const auto& material{ model.mAsset.mMaterials[cluster.materialIndex - materialOffset] };
+				if (material.alphaBlend || material.alphaMask)
+				{
+					continue;
+				}
+			}
+
+			candidates.push_back({ mFrustumCuller.mWorldRadius[clusterOffset + i], &model.mAsset, &cluster,
+				transformOffset, vertexOffset, indexOffset });
+		}
+
+		materialOffset += model.mAsset.mMaterials.size();
+		transformOffset += model.mAsset.mGlobalTransforms.size();
+		clusterOffset += model.mAsset.mClusters.size();
+		vertexOffset += model.mAsset.mVertices.size();
+		indexOffset += model.mAsset.mIndices.size();
+	}
+
+	std::size_t occluderCount{ std::min<std::size_t>(candidates.size(), maxOccluderClusters) };
+	std::partial_sort(candidates.begin(), candidates.begin() + occluderCount, candidates.end(),
+		[](const OccluderCandidate& a, const OccluderCandidate& b) { return a.radius > b.radius; });
+
+	std::vector<glm::vec3> triangles{};
+	for (std::size_t i{ 0 }; i < occluderCount; ++i)
+	{
+		const auto& candidate{ candidates[i] };
+		const auto& transform{ candidate.model->mGlobalTransforms[candidate.cluster->transformIndex - candidate.transformOffset] };
+
+		for (GLuint n{ 0 }; n < candidate.cluster->indexCount; ++n)
+		{
+			auto index{ candidate.model->mIndices[candidate.cluster->firstIndex - candidate.indexOffset + n] };
+			const auto& vertex{ candidate.model->mVertices[candidate.cluster->vertexOffset - candidate.vertexOffset + index] };
+
+			triangles.push_back(glm::vec3{ transform * glm::vec4{ vertex.pos, 1.0f } });
+		}
+	}
+
+	mOcclusionBuffer.setOccluders(std::move(triangles));
+}
+
+GLuint SceneObject::compileShader(const std::string& filename, GLenum type, const std::vector<std::string>& defines)
 {
 	std::ifstream inputStream{ filename };
 
@@ -179,6 +542,19 @@ GLuint SceneObject::compileShader(const std::string& filename, GLenum type)
 	stringStream << inputStream.rdbuf();
 
 	std::string srcStr{ stringStream.str() };
+
+	// #version has to stay the first line
+	if (!defines.empty())
+	{
+		std::string defineLines{};
+		for (const auto& define : defines)
+		{
+			defineLines += "#define " + define + '\n';
+		}
+
+		auto versionEnd{ srcStr.find('\n') };
+		srcStr.insert(versionEnd == std::string::npos ? srcStr.size() : versionEnd + 1, defineLines);
+	}
 	const char* srcCStr{ srcStr.c_str() };
 
 	GLuint shader{ glCreateShader(type) };
@@ -1,12 +1,20 @@
 #pragma once
 
+#include "../camera/camera.hpp"
+#include "../culling/cluster_bvh.hpp"
+#include "../culling/frustum_culler.hpp"
+#include "../culling/occlusion_buffer.hpp"
+#include "../jobs/job_system.hpp"
 #include "../model/model.hpp"
 
 #include "glad/glad.h"
 
+#include <cstdint>
 #include <filesystem>
+#include <ostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class SceneObject
 {
@@ -17,6 +25,8 @@ public:
 		std::string name{};
 		std::filesystem::path path{};
 		std::filesystem::path directory{ "../../assets" };
+
+		MeshletBuilder::Settings meshletSettings{};
 	};
 
 	struct ShaderProgram
@@ -25,6 +35,9 @@ public:
 		std::string fsPath{};
 		std::string computePath{};
 
+		// Each one is added as "#define <name>" right after the #version line
+		std::vector<std::string> defines{};
+
 		GLuint program{};
 	};
 
@@ -37,6 +50,22 @@ public:
 		GLuint baseInstance{ 0 };
 	};
 
+	struct DispatchIndirect
+	{
+		GLuint x{ 0 };
+		GLuint y{ 1 };
+		GLuint z{ 1 };
+
+		GLuint count{ 0 }; // Number of queued items. Not read by glDispatchComputeIndirect
+	};
+
+	// Precedes the node queue in mBvhQueueSsbo. Each level of the BVH gets its own indirect dispatch
+	struct BvhQueueHeader
+	{
+		DispatchIndirect levels[ClusterBvh::maxLevels]{};
+		GLuint levelOffsets[ClusterBvh::maxLevels]{};
+	};
+
 	SceneObject() = default;
 
 	SceneObject(const SceneObject&) = delete;
@@ -44,17 +73,35 @@ public:
 
 	~SceneObject();
 
-	void loadModels(const std::vector<ModelObjectLoadInfo>& loadInfo);
-	void initGlMemory();
+	void loadModels(JobSystem& jobSystem, const std::vector<ModelObjectLoadInfo>& loadInfo);
+	// multiViewCount is the most secondary views that will ever be culled at once, at most maxMultiViews. Each gets a
+	// slice of mMultiViewWriteIbo as large as all opaque & masked indices, so don't ask for more than are drawn
+	void initGlMemory(JobSystem& jobSystem, int multiViewCount);
+
+	// Rotates the visibility bitmasks and resets the BVH work queues. Call once per frame before culling
+	void resetClusterCulling();
+
+	// Empties all opaque, alpha masked and blend indirect draws, including the per cluster ones. Call once per frame before occluder_batch
+	void resetDrawCommands();
+
+	// Overwrites the visibility bitmask, e.g. with OcclusionBuffer::cull() results when there's no usable GPU history
+	void seedVisibility(const std::vector<std::uint32_t>& visibilityBitmask);
+
+	// Uploads the frustums for view_batch.comp and points each view's indirect draw at its own slice of mMultiViewWriteIbo
+	void resetMultiViewCulling(const Camera::Frustum* frustums, int viewCount);
+
+	// Prints the size of every scene buffer. Call after initGlMemory()
+	void writeMemoryReport(std::ostream& out) const;
 
 	void linkShaderPrograms();
 	static void linkShaderProgram(ShaderProgram& shaderProgram);
-	static GLuint compileShader(const std::string& filename, GLenum type);
+	static GLuint compileShader(const std::string& filename, GLenum type, const std::vector<std::string>& defines = {});
 
 	std::unordered_map<std::string, ModelObject> mModels{};
 
 	// Per primitive
 	GLuint mTransformsSsbo{};
+	GLuint mTransformScalesSsbo{}; // ModelAsset::mTransformScales of each transform, so culling doesn't redo it per cluster
 
 	GLuint mMaterialsSsbo{};
 
@@ -66,25 +113,91 @@ public:
 
 	GLuint mVao{};
 	GLuint mWriteIbo{}; // Encodes cluster ID in each index for material/transform access
+
+	// Commands in mIndirectDrawBuffer, one per stream and pass. The opaque stream has no discard, so it keeps early-Z
+	static constexpr int opaqueFirstPassDraw{ 0 };
+	static constexpr int opaqueSecondPassDraw{ 1 };
+	static constexpr int maskedFirstPassDraw{ 2 };
+	static constexpr int maskedSecondPassDraw{ 3 };
+	static constexpr int drawCommandCount{ 4 };
 	GLuint mIndirectDrawBuffer{};
 
+	// Per cluster draw mode: instead of copying indices into mWriteIbo, culling writes one command per visible cluster
+	// that draws straight from mIbo with glMultiDrawElementsIndirectCount. baseInstance carries the cluster ID.
+	// A second pass can't start where the GPU side count of the first one ended, so every stream and pass gets its own
+	// region of mClusterDrawBuffer, big enough for all clusters of the stream
+	struct ClusterDrawCounts
+	{
+		GLuint counts[drawCommandCount]{}; // Read by glMultiDrawElementsIndirectCount from GL_PARAMETER_BUFFER
+		GLuint firstDraws[drawCommandCount]{};
+	};
+	GLuint mClusterDrawVao{};
+	GLuint mClusterDrawBuffer{};
+	GLuint mClusterDrawCountBuffer{};
+	GLuint mClusterDrawFirsts[drawCommandCount]{};
+	GLsizei mClusterDrawCapacities[drawCommandCount]{};
+
 	GLuint mBlendVao{};
 	GLuint mWriteBlendIbo{};
 	GLuint mIndirectBlendDrawBuffer{};
 
+	// Sorted blend mode: cluster_batch.comp appends (view distance, cluster ID) pairs after a uint count and a
+	// 12 byte pad, then blend_sort.comp writes one command per cluster into mBlendClusterDrawBuffer, farthest first.
+	// The count doubles as the draw count, and the pair list is sized to the next power of two for the bitonic sort
+	GLuint mBlendSortSsbo{};
+	GLuint mBlendClusterDrawBuffer{};
+	GLuint mBlendSortCapacity{ 0 };
+	static constexpr GLintptr blendSortHeaderSize{ 4 * sizeof(GLuint) };
+
 	GLuint mViewFrustumSsbo{};
 
+	// Secondary views (shadow cascades, probes) culled together by view_batch.comp.
+	// View i draws with indirect command i from its own slice of the write IBO. Limited by the bits in Cluster::viewMask
+	static constexpr int maxMultiViews{ 8 };
+	static_assert(maxMultiViews <= 32);
+	int mMultiViewCount{ 0 }; // Slices allocated by initGlMemory
+	GLuint mMultiViewVao{};
+	GLuint mMultiViewWriteIbo{};
+	GLuint mMultiViewIndirectDrawBuffer{};
+	GLuint mMultiViewFrustumsSsbo{};
+	GLuint mMultiViewIndexCapacity{ 0 };
+
 	GLuint mVisibilityBitmaskSsbo{};
+	GLuint mLastVisibilityBitmaskSsbo{};
+	GLsizei mVisibilityBitmaskSize{ 0 };
+
+	// CPU copies of the cluster bounds, in the same order as mClustersSsbo
+	FrustumCuller mFrustumCuller{};
+
+	// Rasterizes the largest opaque clusters in the scene
+	OcclusionBuffer mOcclusionBuffer{ 256, 144 };
+	static constexpr int maxOccluderClusters{ 256 };
+
+	ClusterBvh mClusterBvh{};
+	GLuint mBvhNodesSsbo{};
+	GLuint mBvhClusterIndicesSsbo{};
+	GLuint mBvhQueueSsbo{};
+	GLuint mCandidateClustersSsbo{}; // DispatchIndirect header followed by cluster IDs
+	GLuint mBvhLevelCount{ 0 };
 
 	GLsizei mMaterialCount{ 0 };
 	GLsizei mTransformCount{ 0 };
 	GLsizei mClusterCount{ 0 };
 	GLsizei mVertexCount{ 0 };
 	GLsizei mIndexCount{ 0 };
+	GLsizei mBlendClusterCount{ 0 };
+
+	// Sizes of the two mWriteIbo streams & mWriteBlendIbo, counted over cluster instances. The alpha masked stream
+	// starts at mOpaqueIndexCount
 	GLsizei mBlendIndexCount{ 0 };
+	GLsizei mOpaqueIndexCount{ 0 };
+	GLsizei mMaskedIndexCount{ 0 };
+	GLsizei mOpaqueClusterCount{ 0 };
+	GLsizei mMaskedClusterCount{ 0 };
 
 	std::unordered_map<std::string, ShaderProgram> mShaderPrograms{};
 
 private:
 
+	void buildOccluders();
 };
\ No newline at end of file
@@ -0,0 +1,717 @@
+#include "scene_generator.hpp"
+
+#include "fastgltf/core.hpp"
+#include "fastgltf/types.hpp"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <algorithm> // for max & min
+#include <array>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib> // for strtod & strtoul
+#include <cstring> // for memcpy
+#include <filesystem>
+#include <numbers>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility> // for move()
+#include <vector>
+
+
+
+namespace
+{
+	// Same attributes ModelAsset::Vertex is built from. TEXCOORD_0 can't sit between position & normal like u & v do
+	// there, since a glTF accessor has to be contiguous
+	struct GeneratedVertex
+	{
+		glm::vec3 pos{};
+		glm::vec3 normal{};
+		glm::vec2 uv{};
+	};
+
+	struct GeneratedMesh
+	{
+		std::vector<GeneratedVertex> vertices{};
+		std::vector<std::uint32_t> indices{};
+		glm::vec3 min{};
+		glm::vec3 max{};
+	};
+
+	// A sphere grid of the given rings, with (2 * rings) segments, so 4 * rings * (rings - 1) triangles once the
+	// degenerate ones at the poles are left out. Bumps & a per axis stretch keep meshes from all being round
+	GeneratedMesh generateMesh(std::size_t triangleCount, std::mt19937& generator)
+	{
+		const int rings{ std::max(2, static_cast<int>(std::lround((1.0 + std::sqrt(1.0 + static_cast<double>(triangleCount))) * 0.5))) };
+		const int segments{ rings * 2 };
+
+		std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+		std::uniform_int_distribution<int> frequency{ 1, 6 };
+
+		const glm::vec3 stretch{ 0.5f + unit(generator), 0.5f + unit(generator), 0.5f + unit(generator) };
+		const float amplitude{ 0.3f * unit(generator) };
+		const float phiFrequency{ static_cast<float>(frequency(generator)) }; // Whole numbers, so the seam closes
+		const float thetaFrequency{ static_cast<float>(frequency(generator)) };
+		const float phiPhase{ unit(generator) * 2.0f * std::numbers::pi_v<float> };
+		const float thetaPhase{ unit(generator) * 2.0f * std::numbers::pi_v<float> };
+
+		GeneratedMesh mesh{};
+		mesh.vertices.resize(static_cast<std::size_t>(rings + 1) * (segments + 1));
+		for (int y{ 0 }; y <= rings; ++y)
+		{
+			for (int x{ 0 }; x <= segments; ++x)
+			{
+				const float theta{ std::numbers::pi_v<float> * y / rings };
+				const float phi{ 2.0f * std::numbers::pi_v<float> * x / segments };
+
+				// sin(theta) flattens the bumps towards the poles, where every vertex of the row has to meet
+				const float radius{ 1.0f + amplitude * std::sin(theta) * std::sin(phiFrequency * phi + phiPhase)
+					* std::sin(thetaFrequency * theta + thetaPhase) };
+
+				GeneratedVertex& vertex{ mesh.vertices[y * (segments + 1) + x] };
+				vertex.pos = glm::vec3{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) } * radius * stretch;
+				vertex.uv = { static_cast<float>(x) / segments * 4.0f, static_cast<float>(y) / rings * 2.0f };
+			}
+		}
+
+		mesh.indices.reserve(static_cast<std::size_t>(4) * rings * (rings - 1) * 3);
+		for (int y{ 0 }; y < rings; ++y)
+		{
+			for (int x{ 0 }; x < segments; ++x)
+			{
+				const std::uint32_t a{ static_cast<std::uint32_t>(y * (segments + 1) + x) };
+				const std::uint32_t b{ a + static_cast<std::uint32_t>(segments + 1) };
+				const std::uint32_t c{ a + 1 };
+				const std::uint32_t d{ b + 1 };
+
+				if (y != 0)
+				{
+					mesh.indices.insert(mesh.indices.end(), { a, c, b });
+				}
+				if (y != rings - 1)
+				{
+					mesh.indices.insert(mesh.indices.end(), { c, d, b });
+				}
+			}
+		}
+
+		for (std::size_t i{ 0 }; i < mesh.indices.size(); i += 3)
+		{
+			GeneratedVertex& a{ mesh.vertices[mesh.indices[i + 0]] };
+			GeneratedVertex& b{ mesh.vertices[mesh.indices[i + 1]] };
+			GeneratedVertex& c{ mesh.vertices[mesh.indices[i + 2]] };
+
+			// Area weighted
+			const glm::vec3 normal{ glm::cross(b.pos - a.pos, c.pos - a.pos) };
+			a.normal += normal;
+			b.normal += normal;
+			c.normal += normal;
+		}
+
+		// The seam's and poles' vertices are duplicated for their uvs, so their normals are merged to hide the edge
+		for (int y{ 0 }; y <= rings; ++y)
+		{
+			GeneratedVertex* row{ mesh.vertices.data() + y * (segments + 1) };
+
+			if (y == 0 || y == rings)
+			{
+				glm::vec3 sum{ 0.0f };
+				for (int x{ 0 }; x <= segments; ++x)
+				{
+					sum += row[x].normal;
+				}
+				for (int x{ 0 }; x <= segments; ++x)
+				{
+					row[x].normal = sum;
+				}
+			}
+			else
+			{
+				row[0].normal += row[segments].normal;
+				row[segments].normal = row[0].normal;
+			}
+		}
+
+		mesh.min = glm::vec3{ 1e30f };
+		mesh.max = glm::vec3{ -1e30f };
+		for (auto& vertex : mesh.vertices)
+		{
+			vertex.normal = glm::normalize(vertex.normal);
+			mesh.min = glm::min(mesh.min, vertex.pos);
+			mesh.max = glm::max(mesh.max, vertex.pos);
+		}
+
+		return mesh;
+	}
+
+	std::uint32_t crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0)
+	{
+		static const std::array<std::uint32_t, 256> table{ [] {
+			std::array<std::uint32_t, 256> result{};
+			for (std::uint32_t i{ 0 }; i < 256; ++i)
+			{
+				std::uint32_t c{ i };
+				for (int k{ 0 }; k < 8; ++k)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				result[i] = c;
+			}
+			return result;
+			}() };
+
+		crc = ~crc;
+		for (std::size_t i{ 0 }; i < size; ++i)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	void appendBigEndian(std::vector<std::uint8_t>& out, std::uint32_t value)
+	{
+		out.insert(out.end(), { static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+			static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value) });
+	}
+
+	void appendPngChunk(std::vector<std::uint8_t>& out, const char type[4], const std::vector<std::uint8_t>& data)
+	{
+		appendBigEndian(out, static_cast<std::uint32_t>(data.size()));
+
+		const std::size_t typeOffset{ out.size() };
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		appendBigEndian(out, crc32(out.data() + typeOffset, out.size() - typeOffset));
+	}
+
+	// An RGB PNG with stored (uncompressed) deflate blocks. Decodes with any PNG reader, and costs nothing to write,
+	// which matters more here than file size
+	std::vector<std::uint8_t> encodePng(const std::vector<std::uint8_t>& rgb, int size)
+	{
+		std::vector<std::uint8_t> raw{};
+		raw.reserve(static_cast<std::size_t>(size) * (size * 3 + 1));
+		for (int y{ 0 }; y < size; ++y)
+		{
+			raw.push_back(0); // No filter
+			raw.insert(raw.end(), rgb.begin() + static_cast<std::size_t>(y) * size * 3, rgb.begin() + static_cast<std::size_t>(y + 1) * size * 3);
+		}
+
+		std::vector<std::uint8_t> zlib{ 0x78, 0x01 };
+		constexpr std::size_t maxStoredBlock{ 65535 };
+		for (std::size_t offset{ 0 }; offset < raw.size() || offset == 0; offset += maxStoredBlock)
+		{
+			const std::size_t length{ std::min(maxStoredBlock, raw.size() - offset) };
+			const bool last{ offset + length == raw.size() };
+
+			zlib.push_back(last ? 1 : 0);
+			zlib.insert(zlib.end(), { static_cast<std::uint8_t>(length), static_cast<std::uint8_t>(length >> 8),
+				static_cast<std::uint8_t>(~length), static_cast<std::uint8_t>(~length >> 8) });
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+		}
+
+		std::uint32_t adlerA{ 1 };
+		std::uint32_t adlerB{ 0 };
+		for (std::uint8_t byte : raw)
+		{
+			adlerA = (adlerA + byte) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+		std::vector<std::uint8_t> header{};
+		appendBigEndian(header, static_cast<std::uint32_t>(size));
+		appendBigEndian(header, static_cast<std::uint32_t>(size));
+		header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bit RGB, no interlace
+
+		std::vector<std::uint8_t> png{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		appendPngChunk(png, "IHDR", header);
+		appendPngChunk(png, "IDAT", zlib);
+		appendPngChunk(png, "IEND", {});
+
+		return png;
+	}
+
+	// A checkerboard in two random colors with a gradient, so every mip level has something to filter
+	std::vector<std::uint8_t> generateTexture(int size, std::mt19937& generator)
+	{
+		std::uniform_int_distribution<int> channel{ 32, 255 };
+		const glm::ivec3 colors[2]{ { channel(generator), channel(generator), channel(generator) },
+			{ channel(generator), channel(generator), channel(generator) } };
+
+		const int cell{ std::max(size / 8, 1) };
+
+		std::vector<std::uint8_t> rgb(static_cast<std::size_t>(size) * size * 3);
+		for (int y{ 0 }; y < size; ++y)
+		{
+			for (int x{ 0 }; x < size; ++x)
+			{
+				const glm::ivec3& color{ colors[((x / cell) + (y / cell)) & 1] };
+				const int shade{ 192 + 63 * x / std::max(size - 1, 1) };
+
+				std::uint8_t* texel{ rgb.data() + (static_cast<std::size_t>(y) * size + x) * 3 };
+				texel[0] = static_cast<std::uint8_t>(color.r * shade / 255);
+				texel[1] = static_cast<std::uint8_t>(color.g * shade / 255);
+				texel[2] = static_cast<std::uint8_t>(color.b * shade / 255);
+			}
+		}
+
+		return rgb;
+	}
+
+	std::size_t appendBufferView(fastgltf::Asset& asset, std::vector<std::uint8_t>& bytes, const void* data, std::size_t size,
+		fastgltf::Optional<std::size_t> byteStride, fastgltf::Optional<fastgltf::BufferTarget> target)
+	{
+		// Every view starts 4 byte aligned, which covers all the component types used here
+		bytes.resize((bytes.size() + 3) & ~std::size_t{ 3 });
+
+		fastgltf::BufferView view{};
+		view.bufferIndex = 0;
+		view.byteOffset = bytes.size();
+		view.byteLength = size;
+		view.byteStride = byteStride;
+		view.target = target;
+		asset.bufferViews.push_back(std::move(view));
+
+		bytes.resize(bytes.size() + size);
+		std::memcpy(bytes.data() + asset.bufferViews.back().byteOffset, data, size);
+
+		return asset.bufferViews.size() - 1;
+	}
+
+	std::size_t appendAccessor(fastgltf::Asset& asset, std::size_t bufferView, std::size_t byteOffset, std::size_t count,
+		fastgltf::AccessorType type, fastgltf::ComponentType componentType)
+	{
+		fastgltf::Accessor accessor{};
+		accessor.bufferViewIndex = bufferView;
+		accessor.byteOffset = byteOffset;
+		accessor.count = count;
+		accessor.type = type;
+		accessor.componentType = componentType;
+		asset.accessors.push_back(std::move(accessor));
+
+		return asset.accessors.size() - 1;
+	}
+
+	// Rigid transforms for group nodes. Scale only ever appears on the instances
+	struct RigidTransform
+	{
+		glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+		glm::vec3 translation{ 0.0f };
+	};
+
+	fastgltf::TRS toTrs(const glm::quat& rotation, const glm::vec3& translation, float scale)
+	{
+		fastgltf::TRS trs{};
+		trs.translation = fastgltf::math::fvec3{ translation.x, translation.y, translation.z };
+		trs.rotation = fastgltf::math::fquat{ rotation.x, rotation.y, rotation.z, rotation.w };
+		trs.scale = fastgltf::math::fvec3{ scale };
+		return trs;
+	}
+
+	bool parseSize(std::ostream& out, const char* option, const char* value, std::size_t& result)
+	{
+		char* end{};
+		unsigned long long parsed{ std::strtoull(value, &end, 10) };
+		if (end == value || *end != '\0')
+		{
+			out << "Invalid value '" << value << "' for " << option << '\n';
+			return false;
+		}
+
+		result = static_cast<std::size_t>(parsed);
+		return true;
+	}
+}
+
+
+
+bool SceneGenerator::write(std::ostream& out, const std::filesystem::path& path, const Settings& settings)
+{
+	std::mt19937 generator{ settings.seed };
+	std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+	fastgltf::Asset asset{};
+	asset.assetInfo = fastgltf::AssetInfo{};
+	asset.assetInfo->gltfVersion = "2.0";
+	asset.assetInfo->generator = "OpenGL-Sandbox SceneGenerator";
+	std::vector<std::uint8_t> bytes{};
+
+	std::size_t triangleCount{ 0 };
+	std::vector<std::size_t> meshTriangleCounts(settings.meshCount);
+
+	asset.meshes.reserve(settings.meshCount);
+	for (std::size_t i{ 0 }; i < settings.meshCount; ++i)
+	{
+		const GeneratedMesh mesh{ generateMesh(settings.trianglesPerMesh, generator) };
+		meshTriangleCounts[i] = mesh.indices.size() / 3;
+		triangleCount += meshTriangleCounts[i];
+
+		const std::size_t vertexView{ appendBufferView(asset, bytes, mesh.vertices.data(), mesh.vertices.size() * sizeof(GeneratedVertex),
+			sizeof(GeneratedVertex), fastgltf::BufferTarget::ArrayBuffer) };
+
+		const std::size_t positions{ appendAccessor(asset, vertexView, offsetof(GeneratedVertex, pos), mesh.vertices.size(),
+			fastgltf::AccessorType::Vec3, fastgltf::ComponentType::Float) };
+		asset.accessors[positions].min = FASTGLTF_STD_PMR_NS::vector<double>{ mesh.min.x, mesh.min.y, mesh.min.z };
+		asset.accessors[positions].max = FASTGLTF_STD_PMR_NS::vector<double>{ mesh.max.x, mesh.max.y, mesh.max.z };
+
+		const std::size_t normals{ appendAccessor(asset, vertexView, offsetof(GeneratedVertex, normal), mesh.vertices.size(),
+			fastgltf::AccessorType::Vec3, fastgltf::ComponentType::Float) };
+		const std::size_t uvs{ appendAccessor(asset, vertexView, offsetof(GeneratedVertex, uv), mesh.vertices.size(),
+			fastgltf::AccessorType::Vec2, fastgltf::ComponentType::Float) };
+
+		// 16 bit indices whenever they fit, like most exporters write
+		std::size_t indexView{};
+		fastgltf::ComponentType indexType{};
+		if (mesh.vertices.size() <= 65536)
+		{
+			std::vector<std::uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+			indexView = appendBufferView(asset, bytes, shortIndices.data(), shortIndices.size() * sizeof(std::uint16_t), {},
+				fastgltf::BufferTarget::ElementArrayBuffer);
+			indexType = fastgltf::ComponentType::UnsignedShort;
+		}
+		else
+		{
+			indexView = appendBufferView(asset, bytes, mesh.indices.data(), mesh.indices.size() * sizeof(std::uint32_t), {},
+				fastgltf::BufferTarget::ElementArrayBuffer);
+			indexType = fastgltf::ComponentType::UnsignedInt;
+		}
+		const std::size_t indices{ appendAccessor(asset, indexView, 0, mesh.indices.size(), fastgltf::AccessorType::Scalar, indexType) };
+
+		fastgltf::Primitive primitive{};
+		primitive.attributes.emplace_back("POSITION", positions);
+		primitive.attributes.emplace_back("NORMAL", normals);
+		primitive.attributes.emplace_back("TEXCOORD_0", uvs);
+		primitive.indicesAccessor = indices;
+		if (settings.materialCount > 0)
+		{
+			primitive.materialIndex = i % settings.materialCount;
+		}
+
+		fastgltf::Mesh newMesh{};
+		newMesh.primitives.push_back(std::move(primitive));
+		newMesh.name = "mesh" + std::to_string(i);
+		asset.meshes.push_back(std::move(newMesh));
+	}
+
+	if (settings.textureCount > 0 && settings.textureSize > 0)
+	{
+		fastgltf::Sampler sampler{};
+		sampler.magFilter = fastgltf::Filter::Linear;
+		sampler.minFilter = fastgltf::Filter::LinearMipMapLinear;
+		asset.samplers.push_back(std::move(sampler));
+
+		for (std::size_t i{ 0 }; i < settings.textureCount; ++i)
+		{
+			const std::vector<std::uint8_t> png{ encodePng(generateTexture(settings.textureSize, generator), settings.textureSize) };
+			const std::size_t imageView{ appendBufferView(asset, bytes, png.data(), png.size(), {}, {}) };
+
+			fastgltf::Image image{};
+			image.data = fastgltf::sources::BufferView{ .bufferViewIndex{ imageView }, .mimeType{ fastgltf::MimeType::PNG } };
+			asset.images.push_back(std::move(image));
+
+			fastgltf::Texture texture{};
+			texture.samplerIndex = 0;
+			texture.imageIndex = i;
+			asset.textures.push_back(std::move(texture));
+		}
+	}
+
+	std::size_t blendMaterialCount{ 0 };
+	for (std::size_t i{ 0 }; i < settings.materialCount; ++i)
+	{
+		fastgltf::Material material{};
+		material.pbrData.baseColorFactor = fastgltf::math::nvec4{ 0.5f + 0.5f * unit(generator), 0.5f + 0.5f * unit(generator),
+			0.5f + 0.5f * unit(generator), 1.0f };
+		material.pbrData.metallicFactor = 0.0f;
+		material.pbrData.roughnessFactor = 0.5f + 0.5f * unit(generator);
+
+		if (!asset.textures.empty())
+		{
+			fastgltf::TextureInfo textureInfo{};
+			textureInfo.textureIndex = i % asset.textures.size();
+			material.pbrData.baseColorTexture = std::move(textureInfo);
+		}
+
+		// Spread evenly through the materials, so the blended share holds for any prefix of the meshes too
+		const float fraction{ std::clamp(settings.alphaBlendFraction, 0.0f, 1.0f) };
+		if (std::floor((i + 1) * fraction) > std::floor(i * fraction))
+		{
+			material.alphaMode = fastgltf::AlphaMode::Blend;
+			material.pbrData.baseColorFactor[3] = 0.5f;
+			++blendMaterialCount;
+		}
+
+		material.name = "material" + std::to_string(i);
+		asset.materials.push_back(std::move(material));
+	}
+
+	// Group levels widen by the same fanout down to the instances, each node's children a contiguous range of the next level
+	const int groupLevels{ std::max(settings.nodeDepth, 1) - 1 };
+	const std::size_t fanout{ std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(
+		std::pow(static_cast<double>(std::max<std::size_t>(settings.instanceCount, 1)), 1.0 / (groupLevels + 1))))) };
+
+	std::vector<std::size_t> levelCounts{};
+	for (int level{ 0 }; level < groupLevels; ++level)
+	{
+		const std::size_t previous{ level == 0 ? 1 : levelCounts.back() };
+		levelCounts.push_back(std::min(previous * fanout, std::max<std::size_t>(settings.instanceCount, 1)));
+	}
+
+	std::vector<RigidTransform> groupTransforms{};
+	std::size_t levelFirst{ 0 };
+	for (int level{ 0 }; level < groupLevels; ++level)
+	{
+		const std::size_t previousFirst{ level == 0 ? 0 : levelFirst - levelCounts[level - 1] };
+
+		for (std::size_t i{ 0 }; i < levelCounts[level]; ++i)
+		{
+			// A small turn & offset, enough that every level has real work in it
+			const RigidTransform local{ glm::angleAxis(unit(generator) * 2.0f * std::numbers::pi_v<float>, glm::vec3{ 0.0f, 1.0f, 0.0f }),
+				(glm::vec3{ unit(generator), unit(generator), unit(generator) } - 0.5f) * settings.spacing };
+
+			fastgltf::Node node{};
+			node.transform = toTrs(local.rotation, local.translation, 1.0f);
+			asset.nodes.push_back(std::move(node));
+
+			RigidTransform global{ local };
+			if (level > 0)
+			{
+				const std::size_t parent{ previousFirst + i * levelCounts[level - 1] / levelCounts[level] };
+				asset.nodes[parent].children.push_back(asset.nodes.size() - 1);
+
+				global.rotation = groupTransforms[parent].rotation * local.rotation;
+				global.translation = groupTransforms[parent].translation + groupTransforms[parent].rotation * local.translation;
+			}
+			groupTransforms.push_back(global);
+		}
+
+		levelFirst += levelCounts[level];
+	}
+
+	// Instances are spread through a box that grows with their count. Their local transforms undo their group's, so the
+	// placement doesn't depend on the depth
+	const float extent{ settings.spacing * std::cbrt(static_cast<float>(std::max<std::size_t>(settings.instanceCount, 1)) * 4.0f) };
+	const std::size_t lastLevelFirst{ groupLevels > 0 ? levelFirst - levelCounts.back() : 0 };
+
+	std::size_t instancedTriangleCount{ 0 };
+	asset.nodes.reserve(asset.nodes.size() + settings.instanceCount);
+	for (std::size_t i{ 0 }; i < settings.instanceCount && settings.meshCount > 0; ++i)
+	{
+		const glm::vec3 position{ (unit(generator) - 0.5f) * extent, unit(generator) * extent * 0.25f, (unit(generator) - 0.5f) * extent };
+		const glm::quat rotation{ glm::normalize(glm::quat{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f,
+			unit(generator) - 0.5f }) };
+		const float scale{ 0.5f + unit(generator) };
+
+		fastgltf::Node node{};
+		node.meshIndex = i % settings.meshCount;
+		instancedTriangleCount += meshTriangleCounts[i % settings.meshCount];
+
+		if (groupLevels > 0)
+		{
+			const std::size_t parent{ lastLevelFirst + i * levelCounts.back() / settings.instanceCount };
+			const glm::quat inverseRotation{ glm::inverse(groupTransforms[parent].rotation) };
+
+			node.transform = toTrs(inverseRotation * rotation, inverseRotation * (position - groupTransforms[parent].translation), scale);
+			asset.nodes.push_back(std::move(node));
+			asset.nodes[parent].children.push_back(asset.nodes.size() - 1);
+		}
+		else
+		{
+			node.transform = toTrs(rotation, position, scale);
+			asset.nodes.push_back(std::move(node));
+		}
+	}
+
+	fastgltf::Scene scene{};
+	const std::size_t rootCount{ groupLevels > 0 ? levelCounts.front() : asset.nodes.size() };
+	for (std::size_t i{ 0 }; i < rootCount; ++i)
+	{
+		scene.nodeIndices.push_back(i);
+	}
+	asset.scenes.push_back(std::move(scene));
+	asset.defaultScene = 0;
+
+	const std::filesystem::path target{ std::filesystem::absolute(path) };
+
+	// Named after the file, so a .gltf's buffer is written beside it as <name>.bin
+	const std::size_t byteLength{ bytes.size() };
+	fastgltf::Buffer buffer{};
+	buffer.byteLength = byteLength;
+	// The exporter only embeds an Array in a GLB
+	fastgltf::StaticVector<std::uint8_t> bufferBytes(byteLength);
+	std::memcpy(bufferBytes.data(), bytes.data(), byteLength);
+	bytes = {};
+	buffer.data = fastgltf::sources::Array{ .bytes{ std::move(bufferBytes) }, .mimeType{ fastgltf::MimeType::GltfBuffer } };
+	buffer.name = target.stem().string().c_str();
+	asset.buffers.push_back(std::move(buffer));
+
+	fastgltf::FileExporter exporter{};
+	const fastgltf::Error error{ target.extension() == ".glb" ? exporter.writeGltfBinary(asset, target)
+		: exporter.writeGltfJson(asset, target) };
+	if (error != fastgltf::Error::None)
+	{
+		out << "Failed to write " << target.string() << ". Error code: " << static_cast<int>(error) << '\n';
+		return false;
+	}
+
+	out << target.filename().string() << ": " << settings.meshCount << " meshes, " << triangleCount << " triangles, "
+		<< settings.instanceCount << " instances (" << instancedTriangleCount << " triangles), " << asset.nodes.size() << " nodes, "
+		<< settings.materialCount << " materials (" << blendMaterialCount << " blended), " << asset.textures.size() << " textures, "
+		<< byteLength / 1048576.0 << " MiB of buffer\n";
+
+	return true;
+}
+
+SceneGenerator::Settings SceneGenerator::parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument)
+{
+	Settings settings{};
+
+	for (int i{ firstArgument }; i < argc; ++i)
+	{
+		const std::string_view option{ argv[i] };
+		if (i + 1 >= argc)
+		{
+			out << "Missing value for " << option << '\n';
+			break;
+		}
+		const char* value{ argv[++i] };
+
+		std::size_t size{};
+		if (option == "--meshes" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.meshCount = size;
+		}
+		else if (option == "--triangles" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.trianglesPerMesh = size;
+		}
+		else if (option == "--depth" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.nodeDepth = static_cast<int>(size);
+		}
+		else if (option == "--instances" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.instanceCount = size;
+		}
+		else if (option == "--materials" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.materialCount = size;
+		}
+		else if (option == "--textures" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.textureCount = size;
+		}
+		else if (option == "--texture-size" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.textureSize = static_cast<int>(size);
+		}
+		else if (option == "--seed" && parseSize(out, argv[i - 1], value, size))
+		{
+			settings.seed = static_cast<std::uint32_t>(size);
+		}
+		else if (option == "--blend-fraction")
+		{
+			settings.alphaBlendFraction = static_cast<float>(std::strtod(value, nullptr));
+		}
+		else if (option == "--spacing")
+		{
+			settings.spacing = static_cast<float>(std::strtod(value, nullptr));
+		}
+		else if (option != "--meshes" && option != "--triangles" && option != "--depth" && option != "--instances"
+			&& option != "--materials" && option != "--textures" && option != "--texture-size" && option != "--seed")
+		{
+			out << "Unknown option " << option << '\n';
+		}
+	}
+
+	return settings;
+}
+
+std::vector<SceneGenerator::Settings> SceneGenerator::getCorpusSettings()
+{
+	const Settings base{};
+
+	std::vector<Settings> settings{ base };
+
+	// Instances grow 10x per step, unique meshes & hierarchy depth more slowly, the way large worlds reuse assets
+	Settings x10{ base };
+	x10.meshCount = 500;
+	x10.instanceCount = 10'000;
+	x10.nodeDepth = 5;
+	settings.push_back(x10);
+
+	Settings x100{ base };
+	x100.meshCount = 1000;
+	x100.instanceCount = 100'000;
+	x100.nodeDepth = 6;
+	settings.push_back(x100);
+
+	Settings x1000{ base };
+	x1000.meshCount = 2000;
+	x1000.instanceCount = 1'000'000;
+	x1000.nodeDepth = 7;
+	x1000.materialCount = 128;
+	x1000.textureCount = 64;
+	settings.push_back(x1000);
+
+	Settings deep{ base };
+	deep.nodeDepth = 24;
+	settings.push_back(deep);
+
+	Settings dense{ base };
+	dense.meshCount = 50;
+	dense.trianglesPerMesh = 250'000;
+	settings.push_back(dense);
+
+	Settings materials{ base };
+	materials.materialCount = 2048;
+	materials.textureCount = 512;
+	materials.textureSize = 128;
+	settings.push_back(materials);
+
+	Settings textures{ base };
+	textures.textureCount = 16;
+	textures.textureSize = 2048;
+	settings.push_back(textures);
+
+	Settings blended{ base };
+	blended.alphaBlendFraction = 0.75f;
+	settings.push_back(blended);
+
+	return settings;
+}
+
+bool SceneGenerator::writeCorpus(std::ostream& out, const std::filesystem::path& directory)
+{
+	std::error_code error{};
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		out << "Failed to create " << directory.string() << ": " << error.message() << '\n';
+		return false;
+	}
+
+	bool succeeded{ true };
+	for (const Settings& settings : getCorpusSettings())
+	{
+		succeeded = write(out, directory / (describe(settings) + ".glb"), settings) && succeeded;
+	}
+
+	return succeeded;
+}
+
+std::string SceneGenerator::describe(const Settings& settings)
+{
+	return "m" + std::to_string(settings.meshCount) + "_t" + std::to_string(settings.trianglesPerMesh)
+		+ "_d" + std::to_string(settings.nodeDepth) + "_i" + std::to_string(settings.instanceCount)
+		+ "_mat" + std::to_string(settings.materialCount) + "_tex" + std::to_string(settings.textureCount) + "x" + std::to_string(settings.textureSize)
+		+ "_b" + std::to_string(static_cast<int>(std::lround(settings.alphaBlendFraction * 100.0f)))
+		+ "_s" + std::to_string(settings.seed);
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Writes synthetic glTF/GLB scenes in the layout ModelObject loads: interleaved POSITION/NORMAL/TEXCOORD_0 with
+// indices, one primitive per mesh, base color textures and a node hierarchy of TRS transforms. Everything comes from
+// the seed, so the same settings always produce the same file, and loading, culling & memory can be measured at
+// scales no shipped asset reaches.
+class SceneGenerator final
+{
+public:
+
+	struct Settings
+	{
+		std::size_t meshCount{ 200 };
+		std::size_t trianglesPerMesh{ 4000 }; // Rounded to what a sphere grid can hit
+
+		// Levels of nodes from a scene root down to the instances. 1 puts every instance at the root
+		int nodeDepth{ 4 };
+
+		// Mesh nodes. Meshes are shared round robin when there are more instances than meshes
+		std::size_t instanceCount{ 1000 };
+
+		std::size_t materialCount{ 32 };
+
+		// Materials share textures round robin. 0 gives untextured materials
+		std::size_t textureCount{ 16 };
+		int textureSize{ 512 };
+
+		// Share of materials with alphaMode BLEND
+		float alphaBlendFraction{ 0.1f };
+
+		// Average distance between instances. The scene grows with the instance count, so density stays the same
+		float spacing{ 4.0f };
+
+		std::uint32_t seed{ 1 };
+	};
+
+	// .glb writes a single binary file. Anything else writes .gltf JSON with the buffer beside it
+	static bool write(std::ostream& out, const std::filesystem::path& path, const Settings& settings);
+
+	// --meshes, --triangles, --depth, --instances, --materials, --textures, --texture-size, --blend-fraction, --spacing
+	// and --seed, each followed by a value. Unknown options are reported to out and skipped
+	static Settings parseArguments(std::ostream& out, int argc, char* argv[], int firstArgument);
+
+	// A baseline scene, the same at 10x, 100x & 1000x the instances with more unique meshes, and a few with one
+	// dimension pushed: deep hierarchies, dense meshes, many materials, large textures & mostly blended materials
+	static std::vector<Settings> getCorpusSettings();
+
+	// Every file of getCorpusSettings() into directory, named by describe()
+	static bool writeCorpus(std::ostream& out, const std::filesystem::path& directory);
+
+	static std::string describe(const Settings& settings);
+};
\ No newline at end of file
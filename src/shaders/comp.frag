@@ -26,7 +26,17 @@ float max3(vec3 v)
 void main()
 {
 	ivec2 coords = ivec2(gl_FragCoord.xy);
-	
+
+#ifdef SORTED_BLEND
+	// accum holds premultiplied color and coverage, already blended in order
+	vec4 blended = texelFetch(accum, coords, 0);
+	if (blended.a <= epsilon)
+	{
+		discard;
+	}
+
+	outColor = vec4(blended.rgb / blended.a, blended.a);
+#else
 	float revealage = texelFetch(reveal, coords, 0).r;
 
 	if (isApproximatelyEqual(revealage, 1.0f))
@@ -45,4 +55,5 @@ void main()
 	vec3 average_color = accumulation.rgb / max(accumulation.a, epsilon);
 
 	outColor = vec4(average_color, 1.0f - revealage);
+#endif
 }
\ No newline at end of file
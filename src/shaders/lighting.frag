@@ -1,4 +1,4 @@
-#version 420 core
+#version 430 core
 
 layout (binding = 0) uniform sampler2D inColor;
 layout (binding = 1) uniform sampler2D inNorm;
@@ -6,8 +6,125 @@ layout (binding = 1) uniform sampler2D inNorm;
 layout(binding = 2) uniform sampler2D hiZ;
 uniform int hiZLevel;
 
+layout (binding = 3) uniform sampler2D depth;
+layout (binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+uniform mat4 inverseViewProj;
+uniform float zNear;
+
+uniform mat4 cascadeViewProjs[4];
+uniform float cascadeSplits[4];
+uniform int cascadeCount;
+
+struct Light
+{
+	vec3 position;
+	float radius;
+
+	vec3 color;
+	float intensity;
+
+	vec3 direction;
+	float spotCosOuter;
+};
+layout (binding = 0, std430) readonly buffer LightBuffer
+{
+	Light lights[];
+};
+
+layout (binding = 2, std430) readonly buffer FroxelLightCounts
+{
+	uint froxelLightCounts[];
+};
+
+layout (binding = 3, std430) readonly buffer FroxelLightIndices
+{
+	uint froxelLightIndices[];
+};
+
+const uvec3 froxelGridSize = uvec3(16, 9, 24);
+const uint maxLightsPerFroxel = 128;
+
+// slice = log(viewDepth) * sliceScale + sliceBias
+uniform float sliceScale;
+uniform float sliceBias;
+
 layout (location = 0) out vec4 outColor;
 
+
+
+float getShadow(vec3 worldPos, vec3 normal, float viewDepth, float nDotL)
+{
+	int cascade = 0;
+	while (cascade < cascadeCount && viewDepth > cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+
+	if (cascade >= cascadeCount)
+	{
+		return 1.0f;
+	}
+
+	// Later cascades have bigger texels, so they need a bigger normal offset
+	vec3 offsetPos = worldPos + normal * (0.02f * float(cascade + 1));
+
+	vec4 shadowCoord = cascadeViewProjs[cascade] * vec4(offsetPos, 1.0f);
+	shadowCoord.xy = shadowCoord.xy * 0.5f + 0.5f;
+
+	float bias = max(0.001f * (1.0f - nDotL), 0.0002f);
+
+	vec2 texelSize = 1.0f / vec2(textureSize(shadowMap, 0).xy);
+
+	float shadow = 0.0f;
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			shadow += texture(shadowMap, vec4(shadowCoord.xy + vec2(x, y) * texelSize, float(cascade), shadowCoord.z - bias));
+		}
+	}
+
+	return shadow / 9.0f;
+}
+
+vec3 getLocalLights(vec3 worldPos, vec3 normal, float viewDepth, ivec2 coords)
+{
+	int slice = int(floor(log(viewDepth) * sliceScale + sliceBias));
+	if (slice < 0 || slice >= int(froxelGridSize.z))
+	{
+		return vec3(0.0f);
+	}
+
+	uvec2 tile = min(uvec2(coords) * froxelGridSize.xy / uvec2(textureSize(depth, 0)), froxelGridSize.xy - 1);
+	uint froxel = (uint(slice) * froxelGridSize.y + tile.y) * froxelGridSize.x + tile.x;
+
+	vec3 result = vec3(0.0f);
+	for (uint i = 0; i < froxelLightCounts[froxel]; i++)
+	{
+		Light light = lights[froxelLightIndices[froxel * maxLightsPerFroxel + i]];
+
+		vec3 toLight = light.position - worldPos;
+		float dist = length(toLight);
+		if (dist >= light.radius)
+		{
+			continue;
+		}
+
+		vec3 l = toLight / dist;
+
+		// Smooth window so the light reaches exactly zero at its radius
+		float falloff = clamp(1.0f - pow(dist / light.radius, 4.0f), 0.0f, 1.0f);
+		float attenuation = falloff * falloff / (dist * dist + 1.0f);
+
+		float spot = smoothstep(light.spotCosOuter, mix(light.spotCosOuter, 1.0f, 0.2f), dot(-l, light.direction));
+
+		result += light.color * light.intensity * attenuation * spot * max(dot(normal, l), 0.0f);
+	}
+
+	return result;
+}
+
 void main()
 {
 	ivec2 coords = ivec2(gl_FragCoord.xy);
@@ -21,9 +138,31 @@ void main()
 
 	const vec3 ambient = ambientStrength * ambientCol;
 
-	float diffuse = max(dot(normalize(texelFetch(inNorm, coords, 0).xyz), lightDir), 0.0f);
+	vec3 normal = normalize(texelFetch(inNorm, coords, 0).xyz);
+	float diffuse = max(dot(normal, lightDir), 0.0f);
+
+	vec3 localLight = vec3(0.0f);
+
+	// Reverse-Z, so 0 is the cleared far plane
+	float d = texelFetch(depth, coords, 0).r;
+	if (d > 0.0f)
+	{
+		vec2 ndc = (vec2(coords) + 0.5f) / vec2(textureSize(depth, 0)) * 2.0f - 1.0f;
+		vec4 worldPos = inverseViewProj * vec4(ndc, d, 1.0f);
+		worldPos /= worldPos.w;
+
+		// The infinite projection makes linear depth just zNear / d
+		float viewDepth = zNear / d;
+
+		if (diffuse > 0.0f)
+		{
+			diffuse *= getShadow(worldPos.xyz, normal, viewDepth, diffuse);
+		}
+
+		localLight = getLocalLights(worldPos.xyz, normal, viewDepth, coords);
+	}
 
-	outColor = vec4((diffuse * lightCol + ambient), 1.0f) * outColor;
+	outColor = vec4((diffuse * lightCol + ambient + localLight), 1.0f) * outColor;
 
 	if (hiZLevel != 0)
 	{
@@ -0,0 +1,109 @@
+#version 430 core
+
+// Resolves the per pixel fragment lists written by transparent.frag. The nearest maxLayers fragments are sorted and
+// blended back to front. Everything behind them is merged into a tail with an order independent weighted average
+// and blended first, so overflowing pixels lose ordering but not coverage
+
+struct Node
+{
+	uint color;
+	float depth;
+	uint next;
+};
+
+layout(binding = 4, std430) readonly buffer NodeBuffer
+{
+	Node nodes[];
+};
+
+layout(binding = 0, r32ui) uniform readonly uimage2D headImage;
+
+layout (location = 0) out vec4 outColor;
+
+
+
+const uint endOfList = 0xFFFFFFFFu;
+
+const int maxLayers = 16;
+
+// Bounds the cost of pixels covered by a huge number of layers. Fragments past it are ignored
+const int maxListLength = 512;
+
+const float epsilon = 0.00001f;
+
+
+
+void main()
+{
+	uint node = imageLoad(headImage, ivec2(gl_FragCoord.xy)).r;
+
+	if (node == endOfList)
+	{
+		discard;
+	}
+
+	// Nearest first. Depth is reverse-Z, so nearer fragments have a greater depth
+	vec4 layerColors[maxLayers];
+	float layerDepths[maxLayers];
+	int layerCount = 0;
+
+	vec3 tailColor = vec3(0.0f); // Premultiplied
+	float tailAlpha = 0.0f;
+	float tailTransmittance = 1.0f;
+
+	for (int n = 0; n < maxListLength && node != endOfList; n++)
+	{
+		vec4 color = unpackUnorm4x8(nodes[node].color);
+		float depth = nodes[node].depth;
+		node = nodes[node].next;
+
+		if (layerCount == maxLayers)
+		{
+			vec4 evicted = color;
+			if (depth > layerDepths[maxLayers - 1])
+			{
+				// The new fragment takes the farthest layer's place
+				evicted = layerColors[maxLayers - 1];
+				layerCount--;
+			}
+
+			tailColor += evicted.rgb * evicted.a;
+			tailAlpha += evicted.a;
+			tailTransmittance *= 1.0f - evicted.a;
+
+			if (layerCount == maxLayers)
+			{
+				continue;
+			}
+		}
+
+		int i = layerCount;
+		while (i > 0 && layerDepths[i - 1] < depth)
+		{
+			layerColors[i] = layerColors[i - 1];
+			layerDepths[i] = layerDepths[i - 1];
+			i--;
+		}
+		layerColors[i] = color;
+		layerDepths[i] = depth;
+		layerCount++;
+	}
+
+	vec3 color = tailAlpha > epsilon ? tailColor / tailAlpha * (1.0f - tailTransmittance) : vec3(0.0f);
+	float transmittance = tailTransmittance;
+
+	for (int i = layerCount - 1; i >= 0; i--)
+	{
+		color = layerColors[i].rgb * layerColors[i].a + color * (1.0f - layerColors[i].a);
+		transmittance *= 1.0f - layerColors[i].a;
+	}
+
+	float alpha = 1.0f - transmittance;
+	if (alpha <= epsilon)
+	{
+		discard;
+	}
+
+	// Blended over the lit scene with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA like the weighted blended composite
+	outColor = vec4(color / alpha, alpha);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+// Depth only. Color is only needed for alpha tested materials
+
+in VsOut
+{
+	vec3 norm;
+	vec2 uv;
+	vec3 camPosMinusWorldVert;
+	flat uint clusterId;
+} fsIn;
+
+struct Cluster
+{
+	vec4 boundingSphere;
+
+	uint transformIndex;
+	int materialIndex;
+
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+
+	uint viewMask;
+	int padding1;
+	int padding2;
+};
+layout(binding = 0, std430) readonly buffer ClusterBuffer
+{
+	Cluster clusters[];
+};
+
+struct Material
+{
+	vec4 colorFactor;
+
+	uvec2 baseColorTex;
+	uvec2 metallicRoughnessTex;
+	uvec2 normalTex;
+
+	float metallicFactor;
+	float roughnessFactor;
+
+	bool hasColorTex;
+	bool hasMetallicRoughnessTex;
+	bool hasNormalTex;
+
+	bool alphaMask;
+	float alphaCutoff;
+	bool alphaBlend;
+
+	uvec2 padding;
+};
+
+layout (binding = 1, std430) readonly buffer MaterialBlock
+{
+	Material materials[];
+};
+
+
+
+void main()
+{
+	int materialIndex = clusters[fsIn.clusterId].materialIndex;
+
+	if (materials[materialIndex].alphaMask)
+	{
+		float alpha = materials[materialIndex].colorFactor.a;
+		if (materials[materialIndex].hasColorTex)
+		{
+			alpha *= texture(sampler2D(materials[materialIndex].baseColorTex), fsIn.uv).a;
+		}
+
+		if (alpha < materials[materialIndex].alphaCutoff)
+		{
+			discard;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#version 430 core
+
+// Accumulates the jittered render resolution frames into the output resolution history. Motion vectors come from
+// reprojecting each pixel's depth with the previous frame's view projection. The reprojected history is clamped to
+// the current frame's neighbourhood, which rejects disocclusions without needing per object velocities
+
+layout (binding = 0) uniform sampler2D sceneColor;
+layout (binding = 1) uniform sampler2D depth;
+layout (binding = 2) uniform sampler2D history;
+
+// Render target pixels the current frame's geometry was shifted by
+uniform vec2 jitter;
+
+// Unjittered, since the jitter is already undone when sampling
+uniform mat4 inverseViewProj;
+uniform mat4 previousViewProj;
+
+uniform bool historyValid;
+uniform float currentFrameWeight;
+
+layout (location = 0) out vec4 outColor;
+
+
+
+void main()
+{
+	vec2 outputSize = vec2(textureSize(history, 0));
+	vec2 renderSize = vec2(textureSize(sceneColor, 0));
+
+	vec2 uv = gl_FragCoord.xy / outputSize;
+
+	// The scene at uv was rendered jitter pixels further along
+	vec2 renderPos = uv * renderSize + jitter;
+	vec4 current = texture(sceneColor, renderPos / renderSize);
+
+	// Neighbourhood bounds and the nearest depth around the sample, so edges reproject with the foreground
+	ivec2 centerTexel = ivec2(floor(renderPos));
+	vec3 neighbourhoodMin = vec3(1e30f);
+	vec3 neighbourhoodMax = vec3(-1e30f);
+	float nearestDepth = 0.0f;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			ivec2 texel = clamp(centerTexel + ivec2(x, y), ivec2(0), ivec2(renderSize) - 1);
+
+			vec3 color = texelFetch(sceneColor, texel, 0).rgb;
+			neighbourhoodMin = min(neighbourhoodMin, color);
+			neighbourhoodMax = max(neighbourhoodMax, color);
+
+			// Reverse-Z, so nearer is greater
+			nearestDepth = max(nearestDepth, texelFetch(depth, texel, 0).r);
+		}
+	}
+
+	if (!historyValid)
+	{
+		outColor = vec4(current.rgb, 1.0f);
+		return;
+	}
+
+	// Not divided by w, so the sky at depth 0 stays a direction and reprojects by camera rotation only
+	vec4 worldPos = inverseViewProj * vec4(uv * 2.0f - 1.0f, nearestDepth, 1.0f);
+	vec4 previousClip = previousViewProj * worldPos;
+	vec2 previousUv = previousClip.xy / previousClip.w * 0.5f + 0.5f;
+
+	if (previousClip.w <= 0.0f || any(lessThan(previousUv, vec2(0.0f))) || any(greaterThan(previousUv, vec2(1.0f))))
+	{
+		outColor = vec4(current.rgb, 1.0f);
+		return;
+	}
+
+	vec3 previous = clamp(texture(history, previousUv).rgb, neighbourhoodMin, neighbourhoodMax);
+
+	outColor = vec4(mix(previous, current.rgb, currentFrameWeight), 1.0f);
+}
\ No newline at end of file
@@ -20,7 +20,7 @@ struct Cluster
 	uint firstIndex;
 	int vertexOffset;
 
-	uint viewId;
+	uint viewMask;
 
 	int padding1;
 	int padding2;
@@ -59,8 +59,37 @@ layout(binding = 1, std430) readonly buffer MaterialBlock
 
 
 
+#if defined(FRAGMENT_LISTS)
+// Fragments behind the opaque depth must not take up nodes
+layout(early_fragment_tests) in;
+
+struct Node
+{
+	uint color;
+	float depth;
+	uint next;
+};
+
+layout(binding = 4, std430) writeonly buffer NodeBuffer
+{
+	Node nodes[];
+};
+
+layout(binding = 5, std430) buffer NodeCount
+{
+	uint nodeCount;
+};
+
+layout(binding = 0, r32ui) uniform coherent uimage2D headImage;
+
+uniform uint nodeCapacity;
+#elif defined(SORTED_BLEND)
+// Premultiplied, blended with GL_ONE, GL_ONE_MINUS_SRC_ALPHA in back to front cluster order
+layout (location = 0) out vec4 accum;
+#else
 layout (location = 0) out vec4 accum;
 layout (location = 1) out float reveal;
+#endif
 
 
 
@@ -83,9 +112,21 @@ void main()
 	add lighting calcs here
 	*/
 
+#if defined(FRAGMENT_LISTS)
+	uint node = atomicAdd(nodeCount, 1u);
+	if (node < nodeCapacity)
+	{
+		nodes[node].color = packUnorm4x8(clamp(outColor, 0.0f, 1.0f));
+		nodes[node].depth = gl_FragCoord.z;
+		nodes[node].next = imageAtomicExchange(headImage, ivec2(gl_FragCoord.xy), node);
+	}
+#elif defined(SORTED_BLEND)
+	accum = vec4(outColor.rgb * outColor.a, outColor.a);
+#else
 	float weight = clamp(pow(min(1.0, outColor.a * 10.0) + 0.01, 3.0) * 1e8 *
 		pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
 	
 	accum = vec4(outColor.rgb * outColor.a, outColor.a) * weight;
 	reveal = outColor.a;
+#endif
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #version 430 core
 #extension GL_ARB_bindless_texture : require
 
+// Compiled twice. Without ALPHA_MASK there's no discard, so depth can be tested before shading
+#ifndef ALPHA_MASK
+layout (early_fragment_tests) in;
+#endif
+
 in VsOut
 {
 	vec3 norm;
@@ -20,7 +25,7 @@ struct Cluster
 	uint firstIndex;
 	int vertexOffset;
 
-	uint viewId;
+	uint viewMask;
 	int padding1;
 	int padding2;
 };
@@ -99,13 +104,12 @@ void main()
 		outColor = materials[materialIndex].colorFactor;
 	}
 
-	if (materials[materialIndex].alphaMask)
+#ifdef ALPHA_MASK
+	if (outColor.a < materials[materialIndex].alphaCutoff)
 	{
-		if (outColor.a < materials[materialIndex].alphaCutoff)
-		{
-			discard;
-		}
+		discard;
 	}
+#endif
 
 	outNorm = vec4(normalize(fsIn.norm), 0.0f);
 	if (materials[materialIndex].hasNormalTex)
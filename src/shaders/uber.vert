@@ -1,4 +1,7 @@
 #version 430 core
+#ifdef PER_CLUSTER_DRAWS
+#extension GL_ARB_shader_draw_parameters : require
+#endif
 
 struct Cluster
 {
@@ -11,7 +14,7 @@ struct Cluster
 	uint firstIndex;
 	int vertexOffset;
 
-	uint viewId;
+	uint viewMask;
 	int padding1;
 	int padding2;
 };
@@ -47,15 +50,25 @@ out VsOut
 } vsOut;
 
 uniform mat4 transform;
+
+// The depth prepass and the shading pass must produce bit identical depth for GL_EQUAL
+invariant gl_Position;
 //uniform mat4 model;
 uniform mat4 view;
 uniform vec3 camPos;
 
 void main()
 {
+#ifdef PER_CLUSTER_DRAWS
+	// One draw per cluster from the original IBO. baseVertex is the cluster's vertexOffset, so gl_VertexID already includes it
+	uint clusterId = gl_BaseInstanceARB;
+	vsOut.clusterId = clusterId;
+	Vertex vertex = vertices[gl_VertexID];
+#else
 	uint clusterId = bitfieldExtract(gl_VertexID, 7, 25);
 	vsOut.clusterId = clusterId;
 	Vertex vertex = vertices[bitfieldExtract(gl_VertexID, 0, 7) + clusters[clusterId].vertexOffset];
+#endif
 	//Vertex vertex = vertices[gl_VertexID];
 
 	gl_Position = transform * transforms[clusters[clusterId].transformIndex] * vec4(vertex.pos, 1.0f);
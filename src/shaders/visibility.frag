@@ -0,0 +1,113 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+// Visibility buffer geometry pass. Only writes which triangle covers the pixel, shading happens once per pixel
+// in visibility_resolve.frag. The id is the triangle's position in the write IBO, whose (clusterId << 7) | index
+// encoding gives the cluster back. 0 means empty, so the id is offset by one.
+// Compiled twice, like uber.frag. Without ALPHA_MASK depth is tested before the fragment shader runs.
+// With PER_CLUSTER_DRAWS every draw is a single cluster, so the id is (clusterId << 7) | triangle instead.
+
+#ifndef ALPHA_MASK
+layout (early_fragment_tests) in;
+#endif
+
+in VsOut
+{
+	vec3 norm;
+	vec2 uv;
+	vec3 camPosMinusWorldVert;
+	flat uint clusterId;
+} fsIn;
+
+struct Cluster
+{
+	vec4 boundingSphere;
+
+	uint transformIndex;
+	int materialIndex;
+
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+
+	uint viewMask;
+	int padding1;
+	int padding2;
+};
+layout(binding = 0, std430) readonly buffer ClusterBuffer
+{
+	Cluster clusters[];
+};
+
+struct Material
+{
+	vec4 colorFactor;
+
+	uvec2 baseColorTex;
+	uvec2 metallicRoughnessTex;
+	uvec2 normalTex;
+
+	float metallicFactor;
+	float roughnessFactor;
+
+	bool hasColorTex;
+	bool hasMetallicRoughnessTex;
+	bool hasNormalTex;
+
+	bool alphaMask;
+	float alphaCutoff;
+	bool alphaBlend;
+
+	uvec2 padding;
+};
+
+layout (binding = 1, std430) readonly buffer MaterialBlock
+{
+	Material materials[];
+};
+
+struct IndirectDraw
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (binding = 4, std430) readonly buffer IndirectDrawBuffer
+{
+	IndirectDraw indirectDraws[];
+};
+
+// The command of mIndirectDrawBuffer being drawn. gl_PrimitiveID restarts at 0 for every draw
+uniform uint drawCommand;
+
+layout (location = 0) out uint outPrimitive;
+
+
+
+void main()
+{
+	// Alpha testing is the only material work that can't be deferred
+#ifdef ALPHA_MASK
+	int materialIndex = clusters[fsIn.clusterId].materialIndex;
+
+	float alpha = materials[materialIndex].colorFactor.a;
+	if (materials[materialIndex].hasColorTex)
+	{
+		alpha *= texture(sampler2D(materials[materialIndex].baseColorTex), fsIn.uv).a;
+	}
+
+	if (alpha < materials[materialIndex].alphaCutoff)
+	{
+		discard;
+	}
+#endif
+
+#ifdef PER_CLUSTER_DRAWS
+	outPrimitive = ((fsIn.clusterId << 7) | uint(gl_PrimitiveID)) + 1u;
+#else
+	outPrimitive = indirectDraws[drawCommand].firstIndex / 3 + uint(gl_PrimitiveID) + 1u;
+#endif
+}
\ No newline at end of file
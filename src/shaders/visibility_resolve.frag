@@ -0,0 +1,227 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+// Visibility buffer material pass. Rebuilds the triangle under each pixel from the write IBO, interpolates its
+// attributes with analytic perspective-correct barycentrics and writes the same color & normal as uber.frag.
+// With PER_CLUSTER_DRAWS the ids come from per cluster draws and the triangle is read from the original IBO instead.
+
+layout (binding = 0) uniform usampler2D visibility;
+
+struct Cluster
+{
+	vec4 boundingSphere;
+
+	uint transformIndex;
+	int materialIndex;
+
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+
+	uint viewMask;
+	int padding1;
+	int padding2;
+};
+layout(binding = 0, std430) readonly buffer ClusterBuffer
+{
+	Cluster clusters[];
+};
+
+struct Material
+{
+	vec4 colorFactor;
+
+	uvec2 baseColorTex;
+	uvec2 metallicRoughnessTex;
+	uvec2 normalTex;
+
+	float metallicFactor;
+	float roughnessFactor;
+
+	bool hasColorTex;
+	bool hasMetallicRoughnessTex;
+	bool hasNormalTex;
+
+	bool alphaMask;
+	float alphaCutoff;
+	bool alphaBlend;
+
+	uvec2 padding;
+};
+
+layout (binding = 1, std430) readonly buffer MaterialBlock
+{
+	Material materials[];
+};
+
+struct Vertex
+{
+	vec3 pos;
+	float u;
+	vec3 normal;
+	float v;
+};
+
+layout(binding = 2, std430) readonly buffer VertexBuffer
+{
+	Vertex vertices[];
+};
+
+layout(binding = 3, std430) readonly buffer TransformBuffer
+{
+	mat4 transforms[];
+};
+
+// The IBO the geometry pass drew from
+layout(binding = 4, std430) readonly buffer IndexBuffer
+{
+#ifdef PER_CLUSTER_DRAWS
+	uint packedIndices[]; // Bytes, 4 per uint
+#else
+	uint writeIndices[];
+#endif
+};
+
+uniform mat4 transform;
+
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out vec4 outNorm;
+
+
+
+struct Barycentrics
+{
+	vec3 lambda;
+	vec3 ddx;
+	vec3 ddy;
+};
+
+// Perspective-correct barycentrics and their screen space derivatives, after
+// "The Filtered and Culled Visibility Buffer", Wolfgang Engel. 2016
+Barycentrics getBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 ndc, vec2 screenSize)
+{
+	Barycentrics result;
+
+	vec3 invW = 1.0f / vec3(clip0.w, clip1.w, clip2.w);
+
+	vec2 ndc0 = clip0.xy * invW.x;
+	vec2 ndc1 = clip1.xy * invW.y;
+	vec2 ndc2 = clip2.xy * invW.z;
+
+	float invDet = 1.0f / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+	result.ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+	result.ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+
+	float ddxSum = dot(result.ddx, vec3(1.0f));
+	float ddySum = dot(result.ddy, vec3(1.0f));
+
+	vec2 delta = ndc - ndc0;
+	float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+	float interpW = 1.0f / interpInvW;
+
+	result.lambda.x = interpW * (invW.x + delta.x * result.ddx.x + delta.y * result.ddy.x);
+	result.lambda.y = interpW * (delta.x * result.ddx.y + delta.y * result.ddy.y);
+	result.lambda.z = interpW * (delta.x * result.ddx.z + delta.y * result.ddy.z);
+
+	// NDC -> pixels
+	result.ddx *= 2.0f / screenSize.x;
+	result.ddy *= 2.0f / screenSize.y;
+	ddxSum *= 2.0f / screenSize.x;
+	ddySum *= 2.0f / screenSize.y;
+
+	float interpWDdx = 1.0f / (interpInvW + ddxSum);
+	float interpWDdy = 1.0f / (interpInvW + ddySum);
+
+	result.ddx = interpWDdx * (result.lambda * interpInvW + result.ddx) - result.lambda;
+	result.ddy = interpWDdy * (result.lambda * interpInvW + result.ddy) - result.lambda;
+
+	return result;
+}
+
+// Same as uber.frag's, with the screen space derivatives passed in since neighbouring pixels can
+// belong to other triangles
+mat3 cotangentFrame(vec3 N, vec3 dp1, vec3 dp2, vec2 duv1, vec2 duv2)
+{
+	vec3 dp2perp = cross(dp2, N);
+	vec3 dp1perp = cross(N, dp1);
+	vec3 T = dp2perp * duv1.x + dp1perp * duv2.x;
+	vec3 B = dp2perp * duv1.y + dp1perp * duv2.y;
+
+	float invmax = inversesqrt(max(dot(T, T), dot(B, B)));
+	return mat3(T * invmax, B * invmax, N);
+}
+
+void main()
+{
+	ivec2 coords = ivec2(gl_FragCoord.xy);
+
+	uint primitive = texelFetch(visibility, coords, 0).r;
+	if (primitive == 0)
+	{
+		discard;
+	}
+	primitive -= 1;
+
+#ifdef PER_CLUSTER_DRAWS
+	uint clusterId = bitfieldExtract(primitive, 7, 25);
+	uint firstIndex = clusters[clusterId].firstIndex + bitfieldExtract(primitive, 0, 7) * 3;
+	uint encodedIndices[3];
+	for (uint i = 0; i < 3; i++)
+	{
+		encodedIndices[i] = bitfieldExtract(packedIndices[(firstIndex + i) / 4], int((firstIndex + i) % 4) * 8, 8);
+	}
+#else
+	uint encodedIndices[3] = uint[3](writeIndices[primitive * 3], writeIndices[primitive * 3 + 1], writeIndices[primitive * 3 + 2]);
+
+	uint clusterId = bitfieldExtract(encodedIndices[0], 7, 25);
+#endif
+	mat4 model = transforms[clusters[clusterId].transformIndex];
+	int materialIndex = clusters[clusterId].materialIndex;
+
+	vec3 worldPos[3];
+	vec4 clipPos[3];
+	vec3 normals[3];
+	vec2 uvs[3];
+	for (int i = 0; i < 3; i++)
+	{
+		Vertex vertex = vertices[bitfieldExtract(encodedIndices[i], 0, 7) + clusters[clusterId].vertexOffset];
+
+		worldPos[i] = (model * vec4(vertex.pos, 1.0f)).xyz;
+		clipPos[i] = transform * vec4(worldPos[i], 1.0f);
+		normals[i] = vertex.normal;
+		uvs[i] = vec2(vertex.u, vertex.v);
+	}
+
+	vec2 screenSize = vec2(textureSize(visibility, 0));
+	vec2 ndc = (vec2(coords) + 0.5f) / screenSize * 2.0f - 1.0f;
+
+	Barycentrics bary = getBarycentrics(clipPos[0], clipPos[1], clipPos[2], ndc, screenSize);
+
+	vec2 uv = bary.lambda.x * uvs[0] + bary.lambda.y * uvs[1] + bary.lambda.z * uvs[2];
+	vec2 uvDdx = bary.ddx.x * uvs[0] + bary.ddx.y * uvs[1] + bary.ddx.z * uvs[2];
+	vec2 uvDdy = bary.ddy.x * uvs[0] + bary.ddy.y * uvs[1] + bary.ddy.z * uvs[2];
+
+	if (materials[materialIndex].hasColorTex)
+	{
+		outColor = textureGrad(sampler2D(materials[materialIndex].baseColorTex), uv, uvDdx, uvDdy) * materials[materialIndex].colorFactor;
+	}
+	else
+	{
+		outColor = materials[materialIndex].colorFactor;
+	}
+
+	mat3 normalTransform = inverse(transpose(mat3(model)));
+	vec3 normal = normalize(normalTransform * (bary.lambda.x * normals[0] + bary.lambda.y * normals[1] + bary.lambda.z * normals[2]));
+
+	outNorm = vec4(normal, 0.0f);
+	if (materials[materialIndex].hasNormalTex)
+	{
+		vec3 posDdx = bary.ddx.x * worldPos[0] + bary.ddx.y * worldPos[1] + bary.ddx.z * worldPos[2];
+		vec3 posDdy = bary.ddy.x * worldPos[0] + bary.ddy.y * worldPos[1] + bary.ddy.z * worldPos[2];
+
+		vec3 map = textureGrad(sampler2D(materials[materialIndex].normalTex), uv, uvDdx, uvDdy).rgb;
+		map = map * 2.0f - 1.0f;
+		mat3 tbn = cotangentFrame(normal, posDdx, posDdy, uvDdx, uvDdy);
+		outNorm = vec4(normalize(tbn * map), 1.0f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "cascaded_shadow_map.hpp"
+
+#include "../camera/camera.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm> // for max & min
+#include <cmath>
+
+CascadedShadowMap::CascadedShadowMap(int resolution, int cascadeCount)
+	: mResolution{ resolution }
+	, mCascadeCount{ std::min(cascadeCount, maxCascades) }
+{
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &mTexture);
+	glTextureStorage3D(mTexture, 1, GL_DEPTH_COMPONENT32F, mResolution, mResolution, mCascadeCount);
+	glTextureParameteri(mTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(mTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(mTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(mTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(mTexture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(mTexture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	glCreateFramebuffers(1, &mFbo);
+	glNamedFramebufferTextureLayer(mFbo, GL_DEPTH_ATTACHMENT, mTexture, 0, 0);
+	glNamedFramebufferDrawBuffer(mFbo, GL_NONE);
+	glNamedFramebufferReadBuffer(mFbo, GL_NONE);
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	glDeleteFramebuffers(1, &mFbo);
+	glDeleteTextures(1, &mTexture);
+}
+
+void CascadedShadowMap::update(const glm::mat4& view, const glm::mat4& proj, float zNear, const glm::vec3& lightDirection)
+{
+	const glm::mat4 inverseView{ glm::inverse(view) };
+
+	const float tanHalfX{ 1.0f / proj[0][0] };
+	const float tanHalfY{ 1.0f / proj[1][1] };
+
+	const glm::vec3 up{ std::abs(lightDirection.y) > 0.99f ? glm::vec3{ 0.0f, 0.0f, 1.0f } : glm::vec3{ 0.0f, 1.0f, 0.0f } };
+
+	float sliceNear{ zNear };
+	for (int i{ 0 }; i < mCascadeCount; ++i)
+	{
+		float t{ static_cast<float>(i + 1) / mCascadeCount };
+		float uniformSplit{ zNear + (mShadowDistance - zNear) * t };
+		float logSplit{ zNear * std::pow(mShadowDistance / zNear, t) };
+		float sliceFar{ uniformSplit + (logSplit - uniformSplit) * mSplitLambda };
+
+		glm::vec3 corners[8]{};
+		for (int n{ 0 }; n < 8; ++n)
+		{
+			float depth{ (n & 4) ? sliceFar : sliceNear };
+			glm::vec4 viewCorner{ ((n & 1) ? 1.0f : -1.0f) * tanHalfX * depth, ((n & 2) ? 1.0f : -1.0f) * tanHalfY * depth, -depth, 1.0f };
+			corners[n] = glm::vec3{ inverseView * viewCorner };
+		}
+
+		glm::vec3 center{ 0.0f };
+		for (const auto& corner : corners)
+		{
+			center += corner / 8.0f;
+		}
+
+		float radius{ 0.0f };
+		for (const auto& corner : corners)
+		{
+			radius = std::max(radius, glm::length(corner - center));
+		}
+
+		// A bounding sphere keeps the projection size constant as the camera rotates, which avoids shimmering
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		glm::mat4 lightView{ glm::lookAt(center + lightDirection * radius, center, up) };
+
+		// Casters between the light and the near plane still land in the map through GL_DEPTH_CLAMP
+		glm::mat4 lightProj{ glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, radius * 2.0f) };
+
+		// Snap to whole texels so that moving the camera doesn't make edges crawl
+		glm::vec4 origin{ lightProj * lightView * glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f } };
+		origin *= mResolution * 0.5f;
+		glm::vec2 offset{ glm::round(glm::vec2{ origin }) - glm::vec2{ origin } };
+		offset *= 2.0f / mResolution;
+		lightProj[3][0] += offset.x;
+		lightProj[3][1] += offset.y;
+
+		mCascades[i].viewProj = lightProj * lightView;
+		mCascades[i].frustum = Camera::getFrustum(mCascades[i].viewProj);
+		mCascades[i].splitDepth = sliceFar;
+
+		sliceNear = sliceFar;
+	}
+}
\ No newline at end of file
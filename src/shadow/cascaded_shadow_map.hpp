@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../camera/camera.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <array>
+
+// Directional light shadows split into cascades that each fit a slice of the camera frustum.
+// Owns the depth texture array (one layer per cascade) and the framebuffer used to render into it.
+class CascadedShadowMap final
+{
+public:
+
+	static constexpr int maxCascades{ 4 };
+
+	struct Cascade
+	{
+		glm::mat4 viewProj{ 1.0f };
+		Camera::Frustum frustum{};
+
+		// View space distance where this cascade ends
+		float splitDepth{};
+	};
+
+	CascadedShadowMap() = default;
+	CascadedShadowMap(int resolution, int cascadeCount = maxCascades);
+
+	CascadedShadowMap(const CascadedShadowMap&) = delete;
+	CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+	~CascadedShadowMap();
+
+	// lightDirection points towards the light. Only the projection's x & y scales are used,
+	// so this works with the infinite reverse-Z projection
+	void update(const glm::mat4& view, const glm::mat4& proj, float zNear, const glm::vec3& lightDirection);
+
+	int mResolution{ 0 };
+	int mCascadeCount{ 0 };
+
+	float mShadowDistance{ 150.0f };
+
+	// Blend between uniform (0) and logarithmic (1) split placement
+	float mSplitLambda{ 0.8f };
+
+	std::array<Cascade, maxCascades> mCascades{};
+
+	GLuint mTexture{};
+	GLuint mFbo{};
+
+private:
+
+};
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "fragment_lists.hpp"
+
+#include "glad/glad.h"
+
+#include <algorithm> // for max & min
+#include <cstddef> // for size_t
+
+FragmentLists::FragmentLists(GLuint headTexture, int width, int height, std::size_t budgetBytes)
+	: mWidth{ width }
+	, mHeight{ height }
+	, mHeadTexture{ headTexture }
+{
+	// The head pointers are part of the budget
+	std::size_t headBytes{ static_cast<std::size_t>(mWidth) * mHeight * sizeof(GLuint) };
+	std::size_t nodeBytes{ budgetBytes > headBytes ? budgetBytes - headBytes : 0 };
+	mNodeCapacity = static_cast<GLuint>(std::min<std::size_t>(std::max<std::size_t>(nodeBytes / sizeof(Node), 1), endOfList - 1));
+
+	glCreateBuffers(1, &mNodesSsbo);
+	glNamedBufferStorage(mNodesSsbo, static_cast<GLsizeiptr>(mNodeCapacity) * sizeof(Node), nullptr, GL_NONE);
+
+	glCreateBuffers(1, &mNodeCountSsbo);
+	glNamedBufferStorage(mNodeCountSsbo, sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+FragmentLists::~FragmentLists()
+{
+	glDeleteBuffers(1, &mNodesSsbo);
+	glDeleteBuffers(1, &mNodeCountSsbo);
+}
+
+void FragmentLists::reset()
+{
+	GLuint end{ endOfList };
+	glClearTexImage(mHeadTexture, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &end);
+
+	GLuint zero{ 0 };
+	glClearNamedBufferData(mNodeCountSsbo, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef> // for std::size_t
+
+// Per pixel linked lists of transparent fragments for order independent transparency. transparent.frag appends
+// every fragment to a shared node pool and links it to its pixel's head, then oit_resolve.frag sorts the nearest
+// layers of each list and blends them. The pool has a fixed size, so fragments past the budget are dropped
+class FragmentLists final
+{
+public:
+
+	// Matches the Node struct in transparent.frag & oit_resolve.frag
+	struct Node
+	{
+		GLuint color{}; // packUnorm4x8
+		float depth{};
+		GLuint next{};
+	};
+
+	// Marks the end of a list in mHeadTexture and Node::next
+	static constexpr GLuint endOfList{ 0xFFFFFFFF };
+
+	// headTexture is a width x height GL_R32UI texture owned by the caller, so it can come from a render target pool
+	FragmentLists(GLuint headTexture, int width, int height, std::size_t budgetBytes);
+
+	FragmentLists(const FragmentLists&) = delete;
+	FragmentLists& operator=(const FragmentLists&) = delete;
+
+	~FragmentLists();
+
+	// Empties every list. Call before drawing the transparent clusters
+	void reset();
+
+	int mWidth{ 0 };
+	int mHeight{ 0 };
+
+	GLuint mNodeCapacity{ 0 };
+
+	GLuint mHeadTexture{}; // Index of each pixel's last appended node
+	GLuint mNodesSsbo{};
+	GLuint mNodeCountSsbo{}; // Keeps counting past mNodeCapacity, so it also tells how many fragments were dropped
+};
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm> // for clamp & max
+#include <cmath>
+
+namespace
+{
+	// Render targets are sized in multiples of this, which keeps downsampled Hi-Z levels from getting uneven
+	constexpr int sizeGranularity{ 8 };
+
+	int getScaledSize(int size, float scale)
+	{
+		if (scale >= 1.0f)
+		{
+			return size;
+		}
+
+		int scaled{ static_cast<int>(std::round(size * scale / sizeGranularity)) * sizeGranularity };
+		return std::clamp(scaled, sizeGranularity, size);
+	}
+}
+
+DynamicResolution::DynamicResolution(int outputWidth, int outputHeight)
+	: mOutputWidth{ outputWidth }
+	, mOutputHeight{ outputHeight }
+{
+}
+
+bool DynamicResolution::update(float gpuFrameTime)
+{
+	if (mFramesSinceChange < mSettleFrames)
+	{
+		++mFramesSinceChange;
+		return false;
+	}
+
+	// Spikes are let through unsmoothed, since they're what the scale has to react to
+	mSmoothedFrameTime = gpuFrameTime > mSmoothedFrameTime ? gpuFrameTime : mSmoothedFrameTime * 0.9f + gpuFrameTime * 0.1f;
+
+	float newScale{ mScale };
+	if (mSmoothedFrameTime > mTargetFrameTime)
+	{
+		// GPU time roughly follows the pixel count, i.e. the square of the scale
+		float idealScale{ mScale * std::sqrt(mTargetFrameTime / mSmoothedFrameTime) };
+		newScale = std::floor(idealScale / mScaleStep) * mScaleStep;
+		mFramesUnderBudget = 0;
+	}
+	else if (mSmoothedFrameTime < mTargetFrameTime * (1.0f - mHeadroom))
+	{
+		if (++mFramesUnderBudget >= mIncreaseDelay)
+		{
+			newScale = mScale + mScaleStep;
+			mFramesUnderBudget = 0;
+		}
+	}
+	else
+	{
+		mFramesUnderBudget = 0;
+	}
+
+	return setScale(newScale);
+}
+
+bool DynamicResolution::setScale(float scale)
+{
+	scale = std::clamp(scale, mMinScale, mMaxScale);
+
+	int oldWidth{ getRenderWidth() };
+	int oldHeight{ getRenderHeight() };
+	mScale = scale;
+
+	if (oldWidth == getRenderWidth() && oldHeight == getRenderHeight())
+	{
+		return false;
+	}
+
+	mFramesSinceChange = 0;
+	mFramesUnderBudget = 0;
+	mSmoothedFrameTime = 0.0f;
+	return true;
+}
+
+bool DynamicResolution::setOutputSize(int outputWidth, int outputHeight)
+{
+	int oldWidth{ getRenderWidth() };
+	int oldHeight{ getRenderHeight() };
+	mOutputWidth = outputWidth;
+	mOutputHeight = outputHeight;
+
+	return oldWidth != getRenderWidth() || oldHeight != getRenderHeight();
+}
+
+int DynamicResolution::getRenderWidth() const
+{
+	return getScaledSize(mOutputWidth, mScale);
+}
+
+int DynamicResolution::getRenderHeight() const
+{
+	return getScaledSize(mOutputHeight, mScale);
+}
\ No newline at end of file
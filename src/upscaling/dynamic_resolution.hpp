@@ -0,0 +1,51 @@
+#pragma once
+
+// Picks the internal render resolution each frame so the GPU frame time stays under a budget. The scale moves in
+// fixed steps, so the render targets only get rebuilt when the load really changed. Over budget frames react at
+// once to absorb load spikes, while scaling back up waits for a run of frames with headroom
+class DynamicResolution final
+{
+public:
+
+	DynamicResolution(int outputWidth, int outputHeight);
+
+	// Feeds one measured GPU frame time. Returns true when the render resolution changed
+	bool update(float gpuFrameTime);
+
+	// Skips the controller, e.g. when dynamic resolution is disabled
+	bool setScale(float scale);
+
+	// Keeps the scale. Returns true when the render resolution changed
+	bool setOutputSize(int outputWidth, int outputHeight);
+
+	int getRenderWidth() const;
+	int getRenderHeight() const;
+
+	int mOutputWidth{ 0 };
+	int mOutputHeight{ 0 };
+
+	float mTargetFrameTime{ 16.6f };
+
+	float mMinScale{ 0.5f };
+	float mMaxScale{ 1.0f };
+
+	// Per axis, so every step is a noticeable change in pixel count
+	float mScaleStep{ 0.05f };
+
+	// Frames under budget needed before the scale goes up a step
+	int mIncreaseDelay{ 30 };
+
+	// Frames ignored after a change. Timer queries are read a frame late, so the first few still measure the old size
+	int mSettleFrames{ 3 };
+
+	// The upper part of the budget that counts as headroom, so the scale doesn't flip back and forth around the target
+	float mHeadroom{ 0.15f };
+
+	float mScale{ 1.0f };
+	float mSmoothedFrameTime{ 0.0f };
+
+private:
+
+	int mFramesUnderBudget{ 0 };
+	int mFramesSinceChange{ 0 };
+};
\ No newline at end of file
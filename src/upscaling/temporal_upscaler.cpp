@@ -0,0 +1,110 @@
+#include "temporal_upscaler.hpp"
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+namespace
+{
+	float halton(int index, int base)
+	{
+		float result{ 0.0f };
+		float fraction{ 1.0f / base };
+		while (index > 0)
+		{
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+
+		return result;
+	}
+}
+
+TemporalUpscaler::TemporalUpscaler(int outputWidth, int outputHeight)
+	: mOutputWidth{ outputWidth }
+	, mOutputHeight{ outputHeight }
+{
+	createHistory();
+}
+
+TemporalUpscaler::~TemporalUpscaler()
+{
+	deleteHistory();
+}
+
+glm::vec2 TemporalUpscaler::getJitter() const
+{
+	// Halton starts at 1, since index 0 is the pixel corner on both axes
+	int index{ mFrameIndex % jitterPhases + 1 };
+	return glm::vec2{ halton(index, 2), halton(index, 3) } - 0.5f;
+}
+
+glm::mat4 TemporalUpscaler::jitterProjection(const glm::mat4& proj, const glm::vec2& jitter, int renderWidth, int renderHeight)
+{
+	// Scaled by clip w through the projection's w row, so the offset is the same in NDC at every depth
+	glm::mat4 jitteredProj{ proj };
+	glm::vec2 ndcOffset{ jitter.x * 2.0f / renderWidth, jitter.y * 2.0f / renderHeight };
+	jitteredProj[2][0] += ndcOffset.x * proj[2][3];
+	jitteredProj[2][1] += ndcOffset.y * proj[2][3];
+
+	return jitteredProj;
+}
+
+void TemporalUpscaler::advance(const glm::mat4& viewProj)
+{
+	mPreviousViewProj = viewProj;
+	mHistoryValid = true;
+	++mFrameIndex;
+}
+
+void TemporalUpscaler::invalidate()
+{
+	mHistoryValid = false;
+}
+
+void TemporalUpscaler::resize(int outputWidth, int outputHeight)
+{
+	mOutputWidth = outputWidth;
+	mOutputHeight = outputHeight;
+
+	deleteHistory();
+	createHistory();
+	invalidate();
+}
+
+GLuint TemporalUpscaler::getHistoryTexture() const
+{
+	return mHistoryTextures[mFrameIndex % 2];
+}
+
+GLuint TemporalUpscaler::getHistoryTarget() const
+{
+	return mHistoryTextures[(mFrameIndex + 1) % 2];
+}
+
+GLuint TemporalUpscaler::getHistoryTargetFbo() const
+{
+	return mHistoryFbos[(mFrameIndex + 1) % 2];
+}
+
+void TemporalUpscaler::createHistory()
+{
+	glCreateTextures(GL_TEXTURE_2D, 2, mHistoryTextures);
+	glCreateFramebuffers(2, mHistoryFbos);
+	for (int i{ 0 }; i < 2; ++i)
+	{
+		glTextureStorage2D(mHistoryTextures[i], 1, GL_RGBA16F, mOutputWidth, mOutputHeight);
+		glTextureParameteri(mHistoryTextures[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(mHistoryTextures[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(mHistoryTextures[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(mHistoryTextures[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glNamedFramebufferTexture(mHistoryFbos[i], GL_COLOR_ATTACHMENT0, mHistoryTextures[i], 0);
+	}
+}
+
+void TemporalUpscaler::deleteHistory()
+{
+	glDeleteFramebuffers(2, mHistoryFbos);
+	glDeleteTextures(2, mHistoryTextures);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+// Temporal upscaling from the internal render resolution to the output resolution. Every frame the projection is
+// jittered by a different subpixel offset, and temporal_upscale.frag accumulates the jittered samples into a history
+// kept at output resolution. History is reprojected with motion vectors reconstructed from depth and the previous
+// frame's view projection, which covers all motion since scene transforms are static.
+// Owns the two history textures, which swap roles every frame
+class TemporalUpscaler final
+{
+public:
+
+	// Length of the Halton(2, 3) jitter sequence
+	static constexpr int jitterPhases{ 16 };
+
+	TemporalUpscaler(int outputWidth, int outputHeight);
+
+	TemporalUpscaler(const TemporalUpscaler&) = delete;
+	TemporalUpscaler& operator=(const TemporalUpscaler&) = delete;
+
+	~TemporalUpscaler();
+
+	// This frame's offset in render target pixels, within [-0.5, 0.5]
+	glm::vec2 getJitter() const;
+
+	// Shifts everything rendered with the projection by jitter pixels. Works with the infinite reverse-Z projection
+	static glm::mat4 jitterProjection(const glm::mat4& proj, const glm::vec2& jitter, int renderWidth, int renderHeight);
+
+	// Call after temporal_upscale.frag wrote into getHistoryTarget(). viewProj is unjittered
+	void advance(const glm::mat4& viewProj);
+
+	// Drops the history, e.g. after the upscaler was off for a while
+	void invalidate();
+
+	// Recreates the history at the new output resolution, which also drops it
+	void resize(int outputWidth, int outputHeight);
+
+	GLuint getHistoryTexture() const;
+	GLuint getHistoryTarget() const;
+	GLuint getHistoryTargetFbo() const;
+
+	int mOutputWidth{ 0 };
+	int mOutputHeight{ 0 };
+
+	// Weight of the current frame's sample when it's blended into the history
+	float mCurrentFrameWeight{ 0.1f };
+
+	glm::mat4 mPreviousViewProj{ 1.0f };
+	bool mHistoryValid{ false };
+
+	GLuint mHistoryTextures[2]{};
+	GLuint mHistoryFbos[2]{};
+
+private:
+
+	void createHistory();
+	void deleteHistory();
+
+	int mFrameIndex{ 0 };
+};
\ No newline at end of file
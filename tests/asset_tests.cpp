@@ -0,0 +1,762 @@
+#include "camera/camera.hpp"
+#include "culling/cluster_bvh.hpp"
+#include "culling/frustum_culler.hpp"
+#include "culling/occlusion_buffer.hpp"
+#include "jobs/job_system.hpp"
+#include "lighting/light_grid.hpp"
+#include "model/image_decoder.hpp"
+#include "model/ktx2_image.hpp"
+#include "model/load_arena.hpp"
+#include "model/mesh_codec.hpp"
+#include "model/meshlet_builder.hpp"
+#include "model/model_asset.hpp"
+#include "model/transform_kernel.hpp"
+#include "profiling/culling_benchmark.hpp"
+#include "profiling/light_benchmark.hpp"
+#include "profiling/load_benchmark.hpp"
+#include "profiling/load_profiler.hpp"
+#include "profiling/memory_usage.hpp"
+#include "scene/scene_generator.hpp"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <algorithm> // for all_of, count, equal & find
+#include <atomic>
+#include <cmath>
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstring> // for memcmp, memcpy & memset
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <utility> // for pair
+#include <vector>
+
+// Checks on everything that builds a ModelAsset, run without a GL context. Takes a directory for the generated
+// scenes: asset_tests <scratch directory>
+
+
+
+namespace
+{
+	int failureCount{ 0 };
+
+	void check(bool condition, const std::string& description)
+	{
+		if (!condition)
+		{
+			std::cerr << "FAILED: " << description << '\n';
+			++failureCount;
+		}
+	}
+
+	void testGeneratedScene(JobSystem& jobSystem, const std::filesystem::path& path)
+	{
+		SceneGenerator::Settings settings{};
+		settings.meshCount = 4;
+		settings.trianglesPerMesh = 500;
+		settings.nodeDepth = 3;
+		settings.instanceCount = 20;
+		settings.materialCount = 3;
+		settings.textureCount = 2;
+		settings.textureSize = 64;
+
+		std::ostringstream log{};
+		check(SceneGenerator::write(log, path, settings), "write " + path.filename().string());
+
+		const std::string name{ path.filename().string() + ": " };
+		ModelAsset asset{ jobSystem, path, 0, 0, 0, 0, path.parent_path() };
+
+		check(asset.mMeshes.size() == settings.meshCount, name + "mesh count");
+		check(asset.mMaterials.size() == settings.materialCount, name + "material count");
+		check(asset.mMaterialTextures.size() == settings.materialCount, name + "material texture count");
+		check(asset.mTextures.size() == settings.textureCount, name + "texture count");
+		check(asset.mImageSources.size() == settings.textureCount, name + "image count");
+
+		// One primitive per mesh, so a transform per instance
+		check(asset.mGlobalTransforms.size() == settings.instanceCount, name + "transform count");
+		check(asset.mTransformScales.size() == asset.mGlobalTransforms.size(), name + "a scale per transform");
+		check(asset.mPrimitiveCount == static_cast<int>(settings.meshCount), name + "primitive count");
+		check(asset.mClusters.size() >= settings.instanceCount, name + "cluster count");
+
+		// Rebuilding replaces the uniforms rather than appending to them
+		const std::vector<ModelAsset::Cluster> clusters{ asset.mClusters };
+		asset.buildPrimitiveUniforms(jobSystem, 0);
+		check(asset.mClusters.size() == clusters.size() && asset.mGlobalTransforms.size() == settings.instanceCount
+			&& std::memcmp(asset.mClusters.data(), clusters.data(), clusters.size() * sizeof(ModelAsset::Cluster)) == 0,
+			name + "rebuilding primitive uniforms gives the same clusters");
+		check(asset.mMeshlets.size() == asset.mMeshletRanges.size(), name + "a range per meshlet");
+
+		const ModelAsset::NodeTable& nodes{ asset.mNodes };
+		bool breadthFirst{ nodes.levelOffsets.size() == static_cast<std::size_t>(settings.nodeDepth) + 1
+			&& nodes.levelOffsets.back() == static_cast<int>(nodes.size()) };
+		for (std::size_t i{ 0 }; i < nodes.size(); ++i)
+		{
+			breadthFirst = breadthFirst && nodes.parents[i] < static_cast<int>(i);
+			for (int child{ nodes.firstChildren[i] }; child < nodes.firstChildren[i] + nodes.childCounts[i]; ++child)
+			{
+				breadthFirst = breadthFirst && nodes.parents[child] == static_cast<int>(i);
+			}
+		}
+		check(breadthFirst, name + "node table is breadth-first with contiguous children");
+
+		bool clustersInRange{ true };
+		for (const auto& cluster : asset.mClusters)
+		{
+			clustersInRange = clustersInRange && cluster.transformIndex < asset.mGlobalTransforms.size()
+				&& cluster.firstIndex + cluster.indexCount <= asset.mIndices.size()
+				&& cluster.vertexOffset >= 0 && static_cast<std::size_t>(cluster.vertexOffset) < asset.mVertices.size()
+				&& cluster.materialIndex < static_cast<int>(settings.materialCount);
+
+			for (std::size_t i{ 0 }; clustersInRange && i < cluster.indexCount; ++i)
+			{
+				clustersInRange = static_cast<std::size_t>(cluster.vertexOffset) + asset.mIndices[cluster.firstIndex + i] < asset.mVertices.size();
+			}
+		}
+		check(clustersInRange, name + "clusters point inside the vertex, index, transform & material arrays");
+
+		std::vector<bool> failedImages{};
+		const ImageDecoder::Stats stats{ ImageDecoder::decodeAll(jobSystem, asset.mImageSources, &failedImages) };
+		check(stats.failedImages == 0, name + "images decode");
+		check(stats.decodedBytes == settings.textureCount * settings.textureSize * settings.textureSize * 3, name + "decoded RGB bytes");
+
+		const MeshCodec::BenchmarkResults codec{ MeshCodec::benchmark(jobSystem, asset.mVertices.data(),
+			sizeof(ModelAsset::Vertex), asset.mIndices.data(), asset.mMeshletRanges) };
+		check(codec.matches, name + "meshlets survive a mesh codec round trip");
+
+		asset.releaseSources();
+		check(asset.mImageSources.empty(), name + "releaseSources");
+	}
+
+	void testJobSystem(int threadCount)
+	{
+		JobSystem jobSystem{ threadCount };
+		const std::string name{ std::to_string(threadCount) + " threads: " };
+		check(jobSystem.getThreadCount() == threadCount, name + "thread count");
+
+		// A chain where every job depends on the previous one, queued all at once
+		constexpr int chainLength{ 200 };
+		std::vector<JobSystem::Counter> counters(chainLength);
+		std::vector<int> order(chainLength, -1);
+		std::atomic<int> nextPosition{ 0 };
+		for (int i{ 0 }; i < chainLength; ++i)
+		{
+			jobSystem.run([&order, &nextPosition, i] { order[i] = nextPosition++; }, &counters[i], i > 0 ? &counters[i - 1] : nullptr);
+		}
+		jobSystem.wait(counters.back());
+
+		bool inOrder{ true };
+		for (int i{ 0 }; i < chainLength; ++i)
+		{
+			inOrder = inOrder && order[i] == i;
+		}
+		check(inOrder, name + "dependent jobs run after what they depend on");
+
+		// Jobs that each wait on a parallelFor of their own, so workers wait inside jobs
+		constexpr std::size_t outerCount{ 8 };
+		constexpr std::size_t innerCount{ 1000 };
+		std::vector<std::atomic<int>> hits(outerCount * innerCount);
+		JobSystem::Counter outer{ 0 };
+		for (std::size_t job{ 0 }; job < outerCount; ++job)
+		{
+			jobSystem.run([&, job] {
+				jobSystem.parallelFor(innerCount, 7, [&](std::size_t first, std::size_t last) {
+					for (std::size_t i{ first }; i < last; ++i)
+					{
+						++hits[job * innerCount + i];
+					}
+					});
+				}, &outer);
+		}
+		jobSystem.wait(outer);
+
+		check(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& hit) { return hit.load() == 1; }),
+			name + "a parallelFor nested in jobs covers every index once");
+
+		// The default grain size
+		std::vector<std::atomic<int>> flatHits(12345);
+		jobSystem.parallelFor(flatHits.size(), 0, [&](std::size_t first, std::size_t last) {
+			for (std::size_t i{ first }; i < last; ++i)
+			{
+				++flatHits[i];
+			}
+			});
+		check(std::all_of(flatHits.begin(), flatHits.end(), [](const std::atomic<int>& hit) { return hit.load() == 1; }),
+			name + "parallelFor covers every index once");
+	}
+
+	// Streams written out by hand from the EXT_meshopt_compression spec, rather than by our encoder, so a mistake made
+	// the same way in both halves of MeshCodec can't cancel out
+	void testMeshCodecFixtures()
+	{
+		// Version 0 index codec: an edge FIFO hit, then a free triangle with one explicit index, then three explicit
+		const unsigned char indexStream[]{ 0xe0, 0xf0, 0x10, 0xfe, 0xff, 0xf0, 0x0c, 0xff, 0x02, 0x02, 0x02,
+			0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00 };
+		const std::uint32_t expectedIndices[]{ 0, 1, 2, 2, 1, 3, 4, 6, 5, 7, 8, 9 };
+
+		std::uint32_t indices[12]{};
+		check(MeshCodec::decodeIndexBuffer(indices, 12, sizeof(std::uint32_t), indexStream, sizeof(indexStream)),
+			"index fixture decodes");
+		check(std::equal(std::begin(indices), std::end(indices), std::begin(expectedIndices)), "index fixture matches");
+
+		std::uint16_t shortIndices[12]{};
+		check(MeshCodec::decodeIndexBuffer(shortIndices, 12, sizeof(std::uint16_t), indexStream, sizeof(indexStream))
+			&& std::equal(std::begin(shortIndices), std::end(shortIndices), std::begin(expectedIndices)),
+			"index fixture decodes to 16 bit indices");
+		check(!MeshCodec::decodeIndexBuffer(indices, 12, sizeof(std::uint32_t), indexStream, sizeof(indexStream) - 1),
+			"truncated index stream is rejected");
+
+		// A quad of quantized positions, normals & texcoords, one block of 2 bit groups with escaped bytes
+		struct Vertex
+		{
+			std::uint16_t position[3];
+			std::uint8_t normal[2];
+			std::uint16_t texcoord[2];
+		};
+		static_assert(sizeof(Vertex) == 12);
+
+		// Per byte of the vertex: a group header, then 16 packed 2 bit zigzag deltas and the escaped ones that don't fit.
+		// The 32 byte tail holds the first vertex's baseline, all zero
+		const unsigned char vertexStream[85]{ 0xa0,
+			0x01, 0x3f, 0x00, 0x00, 0x00, 0x58, 0x57, 0x58, 0x01, 0x26, 0x00, 0x00, 0x00, // x
+			0x01, 0x0c, 0x00, 0x00, 0x00, 0x58, 0x01, 0x08, 0x00, 0x00, 0x00, // y
+			0x00, 0x00, 0x00, 0x00, // z & normal
+			0x01, 0x3f, 0x00, 0x00, 0x00, 0x17, 0x18, 0x17, 0x01, 0x26, 0x00, 0x00, 0x00, // u
+			0x01, 0x0c, 0x00, 0x00, 0x00, 0x17, 0x01, 0x08, 0x00, 0x00, 0x00 }; // v
+		const Vertex expectedVertices[4]{
+			{ { 0, 0, 0 }, { 0, 0 }, { 0, 0 } },
+			{ { 300, 0, 0 }, { 0, 0 }, { 500, 0 } },
+			{ { 0, 300, 0 }, { 0, 0 }, { 0, 500 } },
+			{ { 300, 300, 0 }, { 0, 0 }, { 500, 500 } } };
+
+		Vertex vertices[4]{};
+		check(MeshCodec::decodeVertexBuffer(vertices, 4, sizeof(Vertex), vertexStream, sizeof(vertexStream)),
+			"vertex fixture decodes");
+		check(std::memcmp(vertices, expectedVertices, sizeof(vertices)) == 0, "vertex fixture matches");
+		check(!MeshCodec::decodeVertexBuffer(vertices, 4, sizeof(Vertex), vertexStream, sizeof(vertexStream) - 1),
+			"truncated vertex stream is rejected");
+	}
+
+	void testLoadArena()
+	{
+		LoadArena arena{ LoadArena::getArraySize<int>(100) + LoadArena::getArraySize<double>(10) };
+		std::span<int> ints{ arena.allocateArray<int>(100) };
+		std::span<double> doubles{ arena.allocateArray<double>(10) };
+		check(ints.size() == 100 && doubles.size() == 10, "arena arrays have the requested size");
+		check(reinterpret_cast<std::uintptr_t>(doubles.data()) % alignof(double) == 0, "arena arrays are aligned");
+		check(arena.getUsedBytes() == arena.getCapacity(), "arrays sized up front fill the capacity exactly");
+
+		std::pmr::vector<int> overflow(1000, 1, &arena);
+		check(arena.getUsedBytes() > arena.getCapacity(), "allocations past the capacity overflow");
+
+		arena.reset();
+		check(arena.getUsedBytes() == 0, "reset frees everything");
+		check(arena.getCapacity() >= LoadArena::getArraySize<int>(1000), "reset grows the capacity to what overflowed");
+
+		// The arena build must give the same meshlets as the plain one
+		std::vector<std::uint32_t> indices{};
+		std::vector<glm::vec3> positions{};
+		for (std::uint32_t y{ 0 }; y < 16; ++y)
+		{
+			for (std::uint32_t x{ 0 }; x < 16; ++x)
+			{
+				positions.push_back({ static_cast<float>(x), static_cast<float>(y), static_cast<float>((x * y) % 3) });
+				if (x < 15 && y < 15)
+				{
+					indices.insert(indices.end(), { y * 16 + x, y * 16 + x + 1, (y + 1) * 16 + x, y * 16 + x + 1, (y + 1) * 16 + x + 1, (y + 1) * 16 + x });
+				}
+			}
+		}
+
+		std::vector<std::uint32_t> plainIndices{ indices };
+		std::vector<glm::vec3> plainPositions{ positions };
+		std::size_t plainVertexCount{ positions.size() };
+		const MeshletBuilder::Meshlets plain{ MeshletBuilder::build(plainIndices, plainPositions.data(), plainVertexCount, sizeof(glm::vec3), {}) };
+
+		const MeshletBuilder::StorageSize size{ MeshletBuilder::getStorageSize(indices.size(), {}) };
+		const MeshletBuilder::MeshletSpans storage
+		{
+			.meshlets{ arena.allocateArray<meshopt_Meshlet>(size.meshletCount) },
+			.vertices{ arena.allocateArray<unsigned int>(size.vertexCount) },
+			.triangles{ arena.allocateArray<unsigned char>(size.triangleByteCount) },
+			.bounds{ arena.allocateArray<meshopt_Bounds>(size.meshletCount) },
+		};
+
+		LoadArena scratch{};
+		std::size_t vertexCount{ positions.size() };
+		const MeshletBuilder::MeshletSpans built{ MeshletBuilder::build(indices, positions.data(), vertexCount, sizeof(glm::vec3), {},
+			storage, &scratch) };
+
+		check(built.meshlets.size() == plain.meshlets.size() && vertexCount == plainVertexCount
+			&& std::equal(built.vertices.begin(), built.vertices.end(), plain.vertices.begin(), plain.vertices.end())
+			&& std::equal(built.triangles.begin(), built.triangles.end(), plain.triangles.begin(), plain.triangles.end()),
+			"meshlets built in an arena match");
+	}
+
+	void testTransformKernel()
+	{
+		const glm::vec3 translation{ 1.0f, -2.0f, 3.0f };
+		const glm::quat rotation{ glm::angleAxis(0.7f, glm::normalize(glm::vec3{ 1.0f, 2.0f, -0.5f })) };
+		const glm::vec3 scale{ 2.0f, 0.5f, 3.0f };
+
+		const glm::mat4 composed{ TransformKernel::composeTrs(translation, { rotation.x, rotation.y, rotation.z, rotation.w }, scale) };
+		const glm::mat4 expected{ glm::translate(glm::mat4{ 1.0f }, translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4{ 1.0f }, scale) };
+		bool composeMatches{ true };
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			for (int n{ 0 }; n < 4; ++n)
+			{
+				composeMatches = composeMatches && std::abs(composed[i][n] - expected[i][n]) < 1e-5f;
+			}
+		}
+		check(composeMatches, "TRS composed directly matches three matrices multiplied");
+		check(std::abs(TransformKernel::getMaxScale(composed) - 3.0f) < 1e-5f, "max scale is the largest axis scale");
+
+		const glm::mat4 product{ TransformKernel::multiply(expected, composed) };
+		const glm::mat4 glmProduct{ expected * composed };
+		check(std::memcmp(&product, &glmProduct, sizeof(glm::mat4)) == 0, "SIMD multiply matches glm");
+
+		// Two roots with a wide level under them, wider than a grain so it's split across jobs
+		const int wideCount{ static_cast<int>(TransformKernel::grainSize) * 3 };
+		std::vector<glm::mat4> locals{};
+		std::vector<int> parents{ -1, -1 };
+		std::vector<int> levelOffsets{ 0, 2, 2 + wideCount, 2 + wideCount * 2 };
+		for (int i{ 0 }; i < 2 + wideCount * 2; ++i)
+		{
+			locals.push_back(TransformKernel::composeTrs({ static_cast<float>(i % 7), 1.0f, 0.0f }, { 0.0f, std::sin(i * 0.01f), 0.0f, std::cos(i * 0.01f) }, glm::vec3{ 1.01f }));
+			if (i >= 2)
+			{
+				parents.push_back(i < 2 + wideCount ? i % 2 : i - wideCount);
+			}
+		}
+
+		// Its own threads, so the level is split even on a single core machine
+		JobSystem jobSystem{ 4 };
+		std::vector<glm::mat4> serial(locals.size());
+		std::vector<glm::mat4> parallel(locals.size());
+		TransformKernel::evaluateRange(locals, parents, serial, 0, locals.size());
+		TransformKernel::evaluate(jobSystem, locals, parents, levelOffsets, parallel);
+
+		bool parentsFirst{ true };
+		for (std::size_t i{ 0 }; i < locals.size(); ++i)
+		{
+			const glm::mat4 expectedGlobal{ parents[i] == -1 ? locals[i] : serial[parents[i]] * locals[i] };
+			parentsFirst = parentsFirst && std::memcmp(&serial[i], &expectedGlobal, sizeof(glm::mat4)) == 0;
+		}
+		check(parentsFirst, "evaluated transforms are the parent's times the local one");
+		check(std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(glm::mat4)) == 0, "levels in parallel match one pass");
+	}
+
+	void testClusterBvh()
+	{
+		const std::vector<glm::vec4> city{ CullingBenchmark::generateCity(20000) };
+
+		ClusterBvh bvh{};
+		bvh.build(city);
+		check(bvh.mLevelNodeCounts.size() <= ClusterBvh::maxLevels, "the BVH fits bvh_cull.comp's levels");
+
+		std::vector<GLuint> clusters{ bvh.mClusterIndices };
+		std::sort(clusters.begin(), clusters.end());
+		bool everyClusterOnce{ clusters.size() == city.size() };
+		for (std::size_t i{ 0 }; i < clusters.size() && everyClusterOnce; ++i)
+		{
+			everyClusterOnce = clusters[i] == i;
+		}
+		check(everyClusterOnce, "every cluster is in exactly one BVH leaf");
+
+		const glm::mat4 proj{ glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.25f, 10000.0f) };
+		bool cullsMatch{ true };
+		for (const auto& view : CullingBenchmark::getDefaultViews(city))
+		{
+			const Camera::Frustum frustum{ Camera::getFrustum(proj * glm::lookAt(view.position, view.target, glm::vec3{ 0.0f, 1.0f, 0.0f })) };
+
+			std::vector<GLuint> bvhVisible{};
+			std::vector<GLuint> flatVisible{};
+			bvh.cull(frustum, bvhVisible);
+			ClusterBvh::cullFlat(frustum, city, flatVisible);
+			std::sort(bvhVisible.begin(), bvhVisible.end());
+
+			cullsMatch = cullsMatch && bvhVisible == flatVisible && !flatVisible.empty() && flatVisible.size() < city.size();
+		}
+		check(cullsMatch, "BVH culling finds the same clusters as testing every one");
+	}
+
+	void testFrustumCuller()
+	{
+		// Not a multiple of the chunk size, nor of 32, so the last chunk is short and ends in padding lanes
+		const std::size_t clusterCount{ FrustumCuller::chunkSize * 2 + 1234 + 7 };
+
+		std::mt19937 generator{ 3 };
+		std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> radius{ 0.0f, 5.0f };
+		std::vector<glm::vec4> spheres(clusterCount);
+		for (auto& sphere : spheres)
+		{
+			sphere = { position(generator), position(generator), position(generator), radius(generator) };
+		}
+
+		// Spheres right on a plane, where rounding differences between the paths would show
+		const glm::mat4 proj{ glm::perspective(glm::radians(60.0f), 1.5f, 0.25f, 1000.0f) };
+		const glm::mat4 view{ glm::lookAt(glm::vec3{ 0.0f, 10.0f, 60.0f }, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+		const Camera::Frustum frustum{ Camera::getFrustum(proj * view) };
+		for (std::size_t i{ 0 }; i < 64; ++i)
+		{
+			const glm::vec3 center{ glm::vec3{ spheres[i] } };
+			const float distance{ glm::dot(glm::vec3{ frustum.left }, center) + frustum.left.w };
+			spheres[i].w = std::abs(distance);
+		}
+
+		JobSystem jobSystem{ 4 };
+		FrustumCuller culler{};
+		culler.setClusters(spheres, std::vector<GLuint>(clusterCount, 0));
+		culler.updateWorldSpheres(jobSystem, { glm::mat4{ 1.0f } });
+
+		std::vector<std::uint32_t> scalar{};
+		culler.cullScalar(frustum, scalar);
+
+		std::vector<GLuint> flat{};
+		ClusterBvh::cullFlat(frustum, spheres, flat);
+		std::vector<GLuint> scalarClusters{};
+		for (std::size_t i{ 0 }; i < scalar.size() * 32; ++i)
+		{
+			if (scalar[i / 32] & (std::uint32_t{ 1 } << (i % 32)))
+			{
+				scalarClusters.push_back(static_cast<GLuint>(i));
+			}
+		}
+		check(scalarClusters == flat && !flat.empty() && flat.size() < clusterCount,
+			"structure-of-arrays scalar culling matches the sphere/plane test");
+
+		std::vector<FrustumCuller::Path> paths{ FrustumCuller::Path::scalar, FrustumCuller::Path::sse };
+		if (FrustumCuller::getBestPath() == FrustumCuller::Path::avx2)
+		{
+			paths.push_back(FrustumCuller::Path::avx2);
+		}
+		for (auto path : paths)
+		{
+			std::vector<std::uint32_t> bits{};
+			culler.cull(jobSystem, frustum, bits, path);
+			check(bits == scalar, "FrustumCuller path " + std::to_string(static_cast<int>(path)) + " matches cullScalar");
+		}
+	}
+
+	void testOcclusionBuffer()
+	{
+		// The renderer's infinite reverse-Z projection, with the camera at the origin looking down -z
+		constexpr float zNear{ 0.25f };
+		const float f{ 1.0f / std::tan(glm::radians(75.0f) / 2.0f) };
+		const glm::mat4 proj{
+			f / (16.0f / 9.0f), 0.0f, 0.0f, 0.0f,
+			0.0f, f, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, -1.0f,
+			0.0f, 0.0f, zNear, 0.0f };
+
+		// A 10x10 quad 10 units away
+		constexpr float quadDistance{ 10.0f };
+		const std::vector<glm::vec3> quad{
+			{ -5.0f, -5.0f, -quadDistance }, { 5.0f, -5.0f, -quadDistance }, { 5.0f, 5.0f, -quadDistance },
+			{ -5.0f, -5.0f, -quadDistance }, { 5.0f, 5.0f, -quadDistance }, { -5.0f, 5.0f, -quadDistance } };
+
+		std::mt19937 generator{ 4 };
+		std::uniform_real_distribution<float> lateral{ -6.0f, 6.0f };
+		std::uniform_real_distribution<float> distance{ 1.0f, 30.0f };
+		std::uniform_real_distribution<float> radius{ 0.05f, 3.0f };
+
+		for (auto [width, height] : { std::pair{ 64, 36 }, std::pair{ 256, 144 } })
+		{
+			OcclusionBuffer buffer{ width, height };
+			buffer.setOccluders(quad);
+			buffer.rasterize(proj);
+
+			const std::string name{ std::to_string(width) + "x" + std::to_string(height) + ": " };
+			auto isOccluded{ [&](const glm::vec4& sphere) { return buffer.isSphereOccluded(sphere, proj[0][0], proj[1][1], zNear); } };
+
+			check(isOccluded({ 0.0f, 0.0f, -20.0f, 1.0f }) && isOccluded({ 3.0f, -3.0f, -40.0f, 2.0f }),
+				name + "a quad hides spheres behind it");
+			check(!isOccluded({ 0.0f, 0.0f, -5.0f, 1.0f }) && !isOccluded({ 0.0f, 0.0f, -quadDistance - 0.5f, 1.0f }),
+				name + "a quad doesn't hide spheres in front of it or crossing it");
+			check(!isOccluded({ 10.0f, 0.0f, -20.0f, 1.0f }) && !isOccluded({ 0.0f, 14.0f, -20.0f, 2.0f }),
+				name + "a quad doesn't hide spheres reaching past its edges");
+
+			// Nothing with any part nearer than the quad is ever hidden, wherever it is on screen
+			bool neverHidesNearer{ true };
+			for (int i{ 0 }; i < 10000; ++i)
+			{
+				const glm::vec4 sphere{ lateral(generator), lateral(generator), -distance(generator), radius(generator) };
+				if (-sphere.z - sphere.w < quadDistance)
+				{
+					neverHidesNearer = neverHidesNearer && !isOccluded(sphere);
+				}
+			}
+			check(neverHidesNearer, name + "a quad never hides a sphere that's partly in front of it");
+		}
+	}
+
+	void testLightGrid()
+	{
+		LightGrid grid{};
+		grid.setProjection(glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.25f, 1000.0f), 0.25f);
+
+		auto getFroxel{ [](int x, int y, int z) { return static_cast<std::size_t>((z * LightGrid::tilesY + y) * LightGrid::tilesX + x); } };
+		auto contains{ [](const std::vector<GLuint>& counts, const std::vector<GLuint>& indices, std::size_t froxel, GLuint light) {
+			auto first{ indices.cbegin() + static_cast<std::ptrdiff_t>(froxel) * LightGrid::maxLightsPerFroxel };
+			return std::find(first, first + counts[froxel], light) != first + counts[froxel];
+		} };
+
+		// A point light of radius 0 on the depth boundary between slices 10 & 11, on the screen center line between
+		// tiles 7 & 8. Like light_cull.comp, touching a froxel's bounds counts, so all four froxels have it
+		const float sliceDepth{ grid.mFroxelBounds[getFroxel(7, 4, 10)].min.z };
+		check(sliceDepth == grid.mFroxelBounds[getFroxel(7, 4, 11)].max.z, "neighbouring slices share their boundary depth");
+
+		JobSystem jobSystem{ 4 };
+		grid.mLights = { { .position{ 0.0f, 0.0f, sliceDepth }, .radius{ 0.0f } } };
+
+		std::vector<GLuint> counts{};
+		std::vector<GLuint> indices{};
+		grid.binLights(jobSystem, glm::mat4{ 1.0f }, counts, indices);
+		check(contains(counts, indices, getFroxel(7, 4, 10), 0) && contains(counts, indices, getFroxel(8, 4, 10), 0)
+			&& contains(counts, indices, getFroxel(7, 4, 11), 0) && contains(counts, indices, getFroxel(8, 4, 11), 0),
+			"a light on a froxel boundary is binned into the froxels on both sides");
+		check(!contains(counts, indices, getFroxel(7, 4, 12), 0) && !contains(counts, indices, getFroxel(7, 4, 9), 0),
+			"a light on a froxel boundary isn't binned past it");
+
+		// More lights than a froxel has room for, all in the middle of one froxel. The first ones are kept, in order
+		const LightGrid::FroxelBounds& bounds{ grid.mFroxelBounds[getFroxel(3, 2, 16)] };
+		const glm::vec3 center{ glm::vec3{ bounds.min + bounds.max } * 0.5f };
+		grid.mLights.assign(LightGrid::maxLightsPerFroxel + 72, { .position{ center }, .radius{ 0.01f } });
+
+		const std::size_t overflowing{ grid.binLights(jobSystem, glm::mat4{ 1.0f }, counts, indices) };
+		const std::size_t full{ getFroxel(3, 2, 16) };
+		bool keepsFirst{ counts[full] == LightGrid::maxLightsPerFroxel };
+		for (GLuint i{ 0 }; keepsFirst && i < LightGrid::maxLightsPerFroxel; ++i)
+		{
+			keepsFirst = indices[full * LightGrid::maxLightsPerFroxel + i] == i;
+		}
+		check(keepsFirst, "a full froxel keeps its first maxLightsPerFroxel lights in order");
+		// Froxel AABBs overlap their neighbours a little, so the lights fill more than the one froxel
+		const auto fullFroxels{ std::count(counts.begin(), counts.end(), static_cast<GLuint>(LightGrid::maxLightsPerFroxel)) };
+		check(overflowing >= 1 && overflowing == static_cast<std::size_t>(fullFroxels), "every froxel dropping lights is counted");
+
+		grid.mLights.resize(LightGrid::maxLightsPerFroxel);
+		check(grid.binLights(jobSystem, glm::mat4{ 1.0f }, counts, indices) == 0, "a froxel that's just full doesn't overflow");
+
+		// Random lights, on several threads, against the light-major reference
+		const glm::mat4 view{ glm::lookAt(glm::vec3{ 5.0f, 2.0f, 10.0f }, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+		grid.mLights = LightGrid::generateRandomLights(2000, { 0.0f, 0.0f, 0.0f, 60.0f });
+		const std::size_t randomOverflowing{ grid.binLights(jobSystem, view, counts, indices) };
+
+		std::vector<GLuint> referenceCounts{};
+		std::vector<GLuint> referenceIndices{};
+		const std::size_t referenceOverflowing{ LightBenchmark::binLightsReference(grid, view, referenceCounts, referenceIndices) };
+
+		bool matches{ counts == referenceCounts && randomOverflowing == referenceOverflowing };
+		for (std::size_t froxel{ 0 }; matches && froxel < LightGrid::froxelCount; ++froxel)
+		{
+			auto first{ indices.cbegin() + static_cast<std::ptrdiff_t>(froxel) * LightGrid::maxLightsPerFroxel };
+			matches = std::equal(first, first + counts[froxel],
+				referenceIndices.cbegin() + static_cast<std::ptrdiff_t>(froxel) * LightGrid::maxLightsPerFroxel);
+		}
+		check(matches, "binLights matches the light-major reference");
+	}
+
+	// A KTX2 file of an 8x8 BC1 texture with two levels, written field by field from the KTX2 spec. Level 1's 8 bytes
+	// are stored before level 0's 32, like the smallest-first order tools write
+	std::vector<unsigned char> makeBc1Ktx2()
+	{
+		std::vector<unsigned char> file(80 + 2 * 24 + 44 + 8 + 32, 0);
+		auto write32{ [&](std::size_t offset, std::uint32_t value) { std::memcpy(file.data() + offset, &value, sizeof(value)); } };
+		auto write64{ [&](std::size_t offset, std::uint64_t value) { std::memcpy(file.data() + offset, &value, sizeof(value)); } };
+
+		constexpr unsigned char identifier[12]{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		std::memcpy(file.data(), identifier, sizeof(identifier));
+		write32(12, 131); // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		write32(16, 1); // typeSize
+		write32(20, 8);
+		write32(24, 8);
+		write32(36, 1); // faceCount
+		write32(40, 2); // levelCount
+
+		// Data format descriptor, just its total size. Ignored for BC formats
+		write32(48, 128);
+		write32(52, 44);
+		write32(128, 44);
+
+		write64(80, 180); // level 0
+		write64(88, 32);
+		write64(96, 32);
+		write64(104, 172); // level 1
+		write64(112, 8);
+		write64(120, 8);
+
+		for (std::size_t i{ 172 }; i < file.size(); ++i)
+		{
+			file[i] = static_cast<unsigned char>(i);
+		}
+
+		return file;
+	}
+
+	void testKtx2()
+	{
+		std::vector<unsigned char> file{ makeBc1Ktx2() };
+
+		const std::optional<Ktx2Image> image{ Ktx2Image::parse(file.data(), file.size(), file.size()) };
+		check(image && image->mWidth == 8 && image->mHeight == 8 && image->mInternalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+			&& !image->mHasAlpha && image->mLevels.size() == 2, "a BC1 KTX2 file parses");
+		if (image)
+		{
+			check(image->mLevels[0].uploadSize == 32 && image->mLevels[1].uploadSize == 8 && image->mLevels[1].uploadOffset == 32
+				&& image->getUploadSize() == 40, "KTX2 levels are packed from level 0");
+
+			std::vector<unsigned char> upload(image->getUploadSize());
+			check(image->writeLevels(file.data(), file.size(), upload.data())
+				&& std::equal(upload.begin(), upload.begin() + 32, file.begin() + 180)
+				&& std::equal(upload.begin() + 32, upload.end(), file.begin() + 172), "KTX2 levels are copied as stored");
+
+			check(!image->writeLevels(file.data(), file.size() - 1, upload.data()), "writing KTX2 levels from a truncated file fails");
+		}
+
+		auto parses{ [](std::vector<unsigned char> bytes) { return Ktx2Image::parse(bytes.data(), bytes.size(), bytes.size()).has_value(); } };
+		auto withLevel{ [&](std::uint64_t fileOffset, std::uint64_t fileSize) {
+			std::vector<unsigned char> bytes{ makeBc1Ktx2() };
+			std::memcpy(bytes.data() + 104, &fileOffset, sizeof(fileOffset));
+			std::memcpy(bytes.data() + 112, &fileSize, sizeof(fileSize));
+			return bytes;
+		} };
+
+		check(!parses(withLevel(172, 16)), "a KTX2 level of the wrong size is rejected");
+		check(!parses(withLevel(file.size() - 4, 8)) && !parses(withLevel(file.size() + 8, 8))
+			&& !parses(withLevel(~std::uint64_t{ 0 } - 4, 8)), "a KTX2 level past the end of the file is rejected");
+
+		std::vector<unsigned char> basis{ makeBc1Ktx2() };
+		std::memset(basis.data() + 12, 0, 4);
+		check(!parses(basis), "Basis Universal KTX2 files are rejected");
+	}
+
+	void testLoadProfiler()
+	{
+		LoadProfiler profiler{};
+		for (int i{ 0 }; i < 2; ++i)
+		{
+			LoadProfiler::Scope stage{ &profiler, "stage" };
+			std::vector<int> values(1000);
+			check(values.size() == 1000, "allocation isn't optimized away");
+		}
+		{
+			LoadProfiler::Scope stage{ nullptr, "ignored" };
+		}
+
+		check(profiler.mStages.size() == 1, "stages with the same name add up");
+		check(!profiler.mStages.empty() && profiler.mStages[0].allocationCount >= 2, "allocations are counted");
+		check(!profiler.mStages.empty() && profiler.mStages[0].allocatedBytes >= 2 * 1000 * sizeof(int), "allocated bytes are counted");
+		check(!profiler.mStages.empty() && profiler.mStages[0].peakHeapBytes >= 1000 * sizeof(int), "heap peak is tracked");
+
+		// Over-aligned types go through the align_val_t overloads
+		struct alignas(64) Aligned
+		{
+			float values[16];
+		};
+
+		LoadProfiler alignedProfiler{};
+		{
+			LoadProfiler::Scope stage{ &alignedProfiler, "aligned" };
+			std::vector<Aligned> values(100);
+			check(reinterpret_cast<std::uintptr_t>(values.data()) % alignof(Aligned) == 0, "aligned new is aligned");
+		}
+
+		check(!alignedProfiler.mStages.empty() && alignedProfiler.mStages[0].allocationCount >= 1, "aligned allocations are counted");
+		check(!alignedProfiler.mStages.empty() && alignedProfiler.mStages[0].allocatedBytes >= 100 * sizeof(Aligned),
+			"aligned bytes are counted");
+
+		const std::size_t liveBytes{ getLiveHeapBytes() };
+		bool blocksLive{ false };
+		{
+			std::vector<Aligned> values(100);
+			blocksLive = getLiveHeapBytes() >= liveBytes + 100 * sizeof(Aligned);
+		}
+		// Compared before check() builds its description string, which is itself a heap allocation
+		const bool blocksFreed{ getLiveHeapBytes() == liveBytes };
+		check(blocksLive, "aligned blocks are live");
+		check(blocksFreed, "aligned frees are subtracted");
+	}
+
+	void testBenchmarkJson(const std::filesystem::path& directory)
+	{
+		LoadBenchmark::Results results{ .label{ "a \"quoted\" label" }, .path{ "C:\\models\\scene.glb" }, .iterations{ 3 },
+			.threadCount{ 4 }, .totalWallTime{ 12.5 }, .totalAllocationCount{ 100 }, .totalAllocatedBytes{ 4096 } };
+		results.stages.push_back({ .name{ "loadMeshes" }, .medianWallTime{ 10.0 }, .minWallTime{ 9.0 }, .allocationCount{ 80 } });
+		results.stages.push_back({ .name{ "loadNodes" }, .medianWallTime{ 2.0 }, .minWallTime{ 1.5 }, .allocationCount{ 20 } });
+
+		const std::filesystem::path path{ directory / "results.json" };
+		{
+			std::ofstream file{ path };
+			LoadBenchmark::writeJson(file, results);
+		}
+
+		std::optional<LoadBenchmark::Results> read{ LoadBenchmark::readJson(path) };
+		check(read.has_value(), "results JSON parses");
+		if (!read)
+		{
+			return;
+		}
+
+		check(read->label == results.label && read->path == results.path, "strings survive JSON");
+		check(read->iterations == 3 && read->threadCount == 4 && read->totalAllocationCount == 100, "totals survive JSON");
+		check(read->stages.size() == 2 && read->stages[0].name == "loadMeshes" && read->stages[0].allocationCount == 80
+			&& read->stages[1].medianWallTime == 2.0, "stages survive JSON");
+
+		std::ostringstream out{};
+		check(LoadBenchmark::compare(out, results, *read, 0.1f), "a run doesn't regress against itself");
+
+		LoadBenchmark::Results slower{ results };
+		slower.stages[0].medianWallTime *= 2.0;
+		check(!LoadBenchmark::compare(out, slower, results, 0.1f), "a stage twice as slow regresses");
+
+		LoadBenchmark::Results moreAllocations{ results };
+		moreAllocations.stages[1].allocationCount *= 2;
+		check(!LoadBenchmark::compare(out, moreAllocations, results, 0.1f), "twice the allocations regresses");
+	}
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	const std::filesystem::path directory{ std::filesystem::absolute(argc >= 2 ? argv[1] : "asset_tests_data") };
+	std::filesystem::create_directories(directory);
+
+	JobSystem jobSystem{};
+
+	testGeneratedScene(jobSystem, directory / "scene.glb");
+	testGeneratedScene(jobSystem, directory / "scene.gltf");
+	testJobSystem(1);
+	testJobSystem(4);
+	testMeshCodecFixtures();
+	testLoadArena();
+	testTransformKernel();
+	testClusterBvh();
+	testFrustumCuller();
+	testOcclusionBuffer();
+	testLightGrid();
+	testKtx2();
+	testLoadProfiler();
+	testBenchmarkJson(directory);
+
+	if (failureCount != 0)
+	{
+		std::cerr << failureCount << " checks failed\n";
+		return 1;
+	}
+
+	std::cout << "All checks passed\n";
+	return 0;
+}
\ No newline at end of file